@@ -69,6 +69,8 @@ class TERRAIN_PT_game_terrain_chunk(TerrainButtonsPanel, Panel):
         col = row.column()
         col.prop(terrain, "max_level")
         col.prop(terrain, "min_physics_level")
+        col.prop(terrain, "use_heightfield_physics")
+        col.prop(terrain, "use_collision_tiles")
         col.prop(terrain, "width")
 
         col = row.column()
@@ -94,6 +96,10 @@ class TERRAIN_PT_game_terrain_mesh(TerrainButtonsPanel, Panel):
         col = row.column()
         col.prop(terrain, "chunk_size")
         col.prop(terrain, "vertex_subdivision")
+        col.prop(terrain, "build_budget")
+        col.prop(terrain, "morph_range")
+        col.prop(terrain, "morph_time")
+        col.prop(terrain, "use_occluder")
 
         row.column().prop(terrain, "material")
 
@@ -143,9 +149,33 @@ class TERRAIN_PT_game_terrain_cache(TerrainButtonsPanel, Panel):
 
         terrain = context.terrain
 
-        layout.active = terrain.use_cache
         row = layout.row()
-        row.prop(terrain, "cache_refresh_time")
+        row.active = terrain.use_cache
+        row.prop(terrain, "cache_memory")
+        layout.prop(terrain, "memory_budget")
+
+class TERRAIN_PT_game_terrain_tile_store(TerrainButtonsPanel, Panel):
+    bl_label = "Tile Store"
+    COMPAT_ENGINES = {'BLENDER_RENDER', 'BLENDER_GAME'}
+
+    @classmethod
+    def poll(cls, context):
+        scene = context.scene
+        return (scene.terrain)
+
+    def draw_header(self, context):
+        scene = context.scene
+        terrain = scene.terrain
+        if terrain:
+            self.layout.prop(terrain, "use_tile_store", text="")
+
+    def draw(self, context):
+        layout = self.layout
+
+        terrain = context.terrain
+
+        layout.active = terrain.use_tile_store
+        layout.prop(terrain, "tile_store_path", text="")
 
 class TERRAIN_UL_zoneslots(UIList):
     def draw_item(self, context, layout, data, item, icon, active_data, active_propname, index):
@@ -78,10 +78,14 @@ Terrain *add_terrain(Main *bmain, const char *name)
 	terrain->objectdistance = 100.0;
 	terrain->chunksize = 10.0;
 	terrain->marginfactor = 2.0f;
+	terrain->buildbudget = 4.0f;
+	terrain->morphrange = 0.3f;
+	terrain->morphtime = 0.5f;
 	terrain->minphysicslevel = 0;
 	terrain->debugtimeframe = 100;
-	terrain->cacherefreshtime = 100;
+	terrain->cachememory = 32;
 	terrain->active_zoneindex = 0;
+	BLI_strncpy(terrain->tilestorepath, "//terrain_tiles/", sizeof(terrain->tilestorepath));
 
 	return terrain;
 }
@@ -460,6 +460,21 @@ int BLI_mempool_count(BLI_mempool *pool)
 	return (int)pool->totused;
 }
 
+/**
+ * Return the number of elements the allocated chunks can hold, used or not.
+ */
+int BLI_mempool_count_reserved(BLI_mempool *pool)
+{
+	BLI_mempool_chunk *mpchunk;
+	unsigned int totchunk = 0;
+
+	for (mpchunk = pool->chunks; mpchunk; mpchunk = mpchunk->next) {
+		totchunk++;
+	}
+
+	return (int)(totchunk * pool->pchunk);
+}
+
 void *BLI_mempool_findelem(BLI_mempool *pool, unsigned int index)
 {
 	BLI_assert(pool->flag & BLI_MEMPOOL_ALLOW_ITER);
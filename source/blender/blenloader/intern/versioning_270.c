@@ -50,6 +50,7 @@
 #include "DNA_linestyle_types.h"
 #include "DNA_actuator_types.h"
 #include "DNA_view3d_types.h"
+#include "DNA_terrain_types.h"
 
 #include "DNA_genfile.h"
 
@@ -867,5 +868,13 @@ void blo_do_versions_270(FileData *fd, Library *UNUSED(lib), Main *main)
 				}
 			}
 		}
+
+		if (!DNA_struct_elem_find(fd->filesdna, "Terrain", "int", "cachememory")) {
+			Terrain *terrain;
+
+			for (terrain = main->terrain.first; terrain; terrain = terrain->id.next) {
+				terrain->cachememory = 32;
+			}
+		}
 	}
 }
@@ -92,21 +92,39 @@ typedef struct Terrain {
 	float chunksize;
 	float marginfactor;
 
-	int pad;
+	/* Temps maximum en millisecondes de construction des chunks par frame, 0 pour aucune limite. */
+	float buildbudget;
+	/* La fraction de la distance d'un niveau pendant laquelle les vertices se transforment vers le niveau parent. */
+	float morphrange;
+	/* Temps en secondes de transition d'un chunk nouvellement subdivisé vers sa forme finale. */
+	float morphtime;
 
 	int debugmode;
 	int debugtimeframe;
 
 	int flag;
-	int cacherefreshtime;
+	/* Taille maximale du cache de vertices en mégaoctets. */
+	int cachememory;
 
 	int minphysicslevel;
 	int active_zoneindex;
 
+	/* Mémoire maximale du terrain en mégaoctets : meshs, vertices, physique et cache, 0 pour aucune limite. */
+	int memorybudget;
+	int pad;
+
+	/* Dossier du stockage sur disque des vertices calculés par les zones. */
+	char tilestorepath[1024]; /* 1024 = FILE_MAX */
+
 	ListBase zones;
 } Terrain;
 
-#define TERRAIN_USE_CACHE	(1 << 0)
+#define TERRAIN_USE_CACHE			(1 << 0)
+#define TERRAIN_USE_TILE_STORE		(1 << 1)
+/* #define TERRAIN_BAKE_TILE_STORE		(1 << 2) */ /* deprecated, baked by blenderplayer */
+#define TERRAIN_USE_HEIGHTFIELD		(1 << 3)
+#define TERRAIN_USE_COLLISION_TILES	(1 << 4)
+#define TERRAIN_OCCLUDER			(1 << 5)
 
 #define TERRAIN_ZONE_MESH						(1 << 0)
 #define TERRAIN_ZONE_PERLIN_NOISE				(1 << 1)
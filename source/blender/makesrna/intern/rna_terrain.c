@@ -313,7 +313,8 @@ void RNA_def_terrain(BlenderRNA *brna)
 	RNA_def_property_int_sdna(prop, NULL, "vertexsubdivision");
 	RNA_def_property_range(prop, 4, 32);
 	RNA_def_property_ui_range(prop, 4, 32, 2, 0);
-	RNA_def_property_ui_text(prop, "Vertex Subdivision", "");
+	RNA_def_property_ui_text(prop, "Vertex Subdivision",
+	                         "Number of faces along a chunk side, rounded up to a power of two");
 
 	prop = RNA_def_property(srna, "width", PROP_INT, PROP_NONE);
 	RNA_def_property_int_sdna(prop, NULL, "width");
@@ -340,6 +341,31 @@ void RNA_def_terrain(BlenderRNA *brna)
 	RNA_def_property_range(prop, 1.0f, FLT_MAX);
 	RNA_def_property_ui_text(prop, "Margin Factor", "");
 
+	prop = RNA_def_property(srna, "build_budget", PROP_FLOAT, PROP_NONE);
+	RNA_def_property_float_sdna(prop, NULL, "buildbudget");
+	RNA_def_property_range(prop, 0.0f, 1000.0f);
+	RNA_def_property_ui_range(prop, 0.0f, 100.0f, 10, 1);
+	RNA_def_property_ui_text(prop, "Build Budget",
+	                         "Maximum time in milliseconds spent building chunk meshes per frame, 0 for no limit");
+
+	prop = RNA_def_property(srna, "morph_range", PROP_FLOAT, PROP_FACTOR);
+	RNA_def_property_float_sdna(prop, NULL, "morphrange");
+	RNA_def_property_range(prop, 0.0f, 1.0f);
+	RNA_def_property_ui_text(prop, "Morph Range",
+	                         "Fraction of the distance of a level where vertexes blend to the parent level, 0 to disable");
+
+	prop = RNA_def_property(srna, "morph_time", PROP_FLOAT, PROP_TIME);
+	RNA_def_property_float_sdna(prop, NULL, "morphtime");
+	RNA_def_property_range(prop, 0.0f, 10.0f);
+	RNA_def_property_ui_text(prop, "Morph Time",
+	                         "Time in seconds for a subdivided chunk to blend from its parent shape, 0 to disable");
+
+	prop = RNA_def_property(srna, "use_occluder", PROP_BOOLEAN, PROP_NONE);
+	RNA_def_property_boolean_sdna(prop, NULL, "flag", TERRAIN_OCCLUDER);
+	RNA_def_property_ui_text(prop, "Occluder",
+	                         "Use the chunks as occluders for the occlusion culling of the scene, "
+	                         "hidden objects and chunks are not rendered");
+
 	prop = RNA_def_property(srna, "material", PROP_POINTER, PROP_NONE);
 	RNA_def_property_pointer_sdna(prop, NULL, "material");
 	RNA_def_property_struct_type(prop, "Material");
@@ -349,7 +375,20 @@ void RNA_def_terrain(BlenderRNA *brna)
 	prop = RNA_def_property(srna, "min_physics_level", PROP_INT, PROP_NONE);
 	RNA_def_property_int_sdna(prop, NULL, "minphysicslevel");
 	RNA_def_property_range(prop, 0, 16);
-	RNA_def_property_ui_text(prop, "Min Physics Level", "");
+	RNA_def_property_ui_text(prop, "Min Physics Level",
+	                         "Minimum level of the chunks with a physics shape, or level of the collision tiles");
+
+	prop = RNA_def_property(srna, "use_heightfield_physics", PROP_BOOLEAN, PROP_NONE);
+	RNA_def_property_boolean_sdna(prop, NULL, "flag", TERRAIN_USE_HEIGHTFIELD);
+	RNA_def_property_ui_text(prop, "Heightfield Physics",
+	                         "Use heightfield collision shapes for the chunks instead of triangle meshes, "
+	                         "they are not rebuilt when the joints of a chunk change");
+
+	prop = RNA_def_property(srna, "use_collision_tiles", PROP_BOOLEAN, PROP_NONE);
+	RNA_def_property_boolean_sdna(prop, NULL, "flag", TERRAIN_USE_COLLISION_TILES);
+	RNA_def_property_ui_text(prop, "Collision Tiles",
+	                         "Create heightfield tiles of the min physics level around dynamic objects "
+	                         "instead of using the render chunks for physics");
 
 	prop = RNA_def_property(srna, "debug_draw_boxes", PROP_BOOLEAN, PROP_NONE);
 	RNA_def_property_boolean_sdna(prop, NULL, "debugmode", DEBUG_DRAW_BOXES);
@@ -384,10 +423,29 @@ void RNA_def_terrain(BlenderRNA *brna)
 	RNA_def_property_boolean_sdna(prop, NULL, "flag", TERRAIN_USE_CACHE);
 	RNA_def_property_ui_text(prop, "Use Cache", "");
 
-	prop = RNA_def_property(srna, "cache_refresh_time", PROP_INT, PROP_NONE);
-	RNA_def_property_int_sdna(prop, NULL, "cacherefreshtime");
-	RNA_def_property_range(prop, 0, 100000);
-	RNA_def_property_ui_text(prop, "Cache Refresh Time", "");
+	prop = RNA_def_property(srna, "cache_memory", PROP_INT, PROP_NONE);
+	RNA_def_property_int_sdna(prop, NULL, "cachememory");
+	RNA_def_property_range(prop, 1, 4096);
+	RNA_def_property_ui_text(prop, "Cache Memory",
+	                         "Maximum memory in megabytes used by the vertex cache, least used vertexes are evicted first");
+
+	prop = RNA_def_property(srna, "memory_budget", PROP_INT, PROP_NONE);
+	RNA_def_property_int_sdna(prop, NULL, "memorybudget");
+	RNA_def_property_range(prop, 0, 65536);
+	RNA_def_property_ui_text(prop, "Memory Budget",
+	                         "Maximum memory in megabytes used by the terrain meshes, vertexes, physics shapes and cache, "
+	                         "chunks out of the camera view are evicted first, 0 for no limit");
+
+	prop = RNA_def_property(srna, "use_tile_store", PROP_BOOLEAN, PROP_NONE);
+	RNA_def_property_boolean_sdna(prop, NULL, "flag", TERRAIN_USE_TILE_STORE);
+	RNA_def_property_ui_text(prop, "Use Tile Store",
+	                         "Save the vertexes computed by the zones on disk and reuse them at the next game start, "
+	                         "run blenderplayer with \"-g terrain_bake = 1\" to compute the whole terrain ahead of time");
+
+	prop = RNA_def_property(srna, "tile_store_path", PROP_STRING, PROP_DIRPATH);
+	RNA_def_property_string_sdna(prop, NULL, "tilestorepath");
+	RNA_def_property_ui_text(prop, "Tile Store Path",
+	                         "Directory of the tile store, a sub directory is used for each set of terrain and zone parameters");
 
 	rna_def_terrain_zone(brna);
 
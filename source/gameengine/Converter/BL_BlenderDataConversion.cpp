@@ -99,6 +99,8 @@
 #include "KX_SoftBodyDeformer.h"
 #include "BLI_utildefines.h"
 #include "BLI_listbase.h"
+#include "BLI_path_util.h"
+#include "BLI_string.h"
 
 #include "KX_WorldInfo.h"
 
@@ -1141,7 +1143,8 @@ RAS_MeshObject* BL_ConvertMesh(Mesh* mesh, Object* blenderobj, KX_Scene* scene,
 
 	// pre calculate texture generation
 	// However, we want to delay this if we're libloading so we can make sure we have the right scene.
-	if (!libloading) {
+	// Headless engines have no GL context to upload textures and shaders to.
+	if (!libloading && !converter->GetKetsjiEngine()->GetHeadless()) {
 		for (list<RAS_MeshMaterial>::iterator mit = meshobj->GetFirstMaterial();
 			mit != meshobj->GetLastMaterial(); ++ mit) {
 			mit->m_bucket->GetPolyMaterial()->OnConstruction();
@@ -1783,6 +1786,11 @@ static KX_Terrain *convert_terrain(Terrain *terrain, KX_Scene* scene, KX_Blender
 	RAS_MaterialBucket *bucket = material_from_mesh(material, NULL,
 													NULL, NULL, NULL, 0, rgb, uvs, NULL, scene, converter, true);
 
+	// Le dossier du stockage sur disque est relatif au fichier du terrain.
+	char tilestorepath[FILE_MAX];
+	BLI_strncpy(tilestorepath, terrain->tilestorepath[0] ? terrain->tilestorepath : "//terrain_tiles/", sizeof(tilestorepath));
+	BLI_path_abs(tilestorepath, ID_BLEND_PATH(G.main, &terrain->id));
+
 	// Creation du terrain.
 	KX_Terrain *kxterrain = new KX_Terrain(scene,
 										   KX_Scene::m_callbacks,
@@ -1790,20 +1798,31 @@ static KX_Terrain *convert_terrain(Terrain *terrain, KX_Scene* scene, KX_Blender
 										   material,
 										   terrain->maxlevel,
 										   terrain->minphysicslevel,
+										   terrain->flag & TERRAIN_USE_HEIGHTFIELD,
+										   terrain->flag & TERRAIN_USE_COLLISION_TILES,
 										   terrain->vertexsubdivision,
 										   terrain->width, 
 										   terrain->cameradistance,
 										   terrain->objectdistance,
 										   terrain->chunksize,
 										   terrain->marginfactor,
+										   terrain->buildbudget,
+										   terrain->morphrange,
+										   terrain->morphtime,
+										   terrain->flag & TERRAIN_OCCLUDER,
 										   terrain->debugmode,
 										   terrain->debugtimeframe,
 										   terrain->flag & TERRAIN_USE_CACHE,
-										   terrain->cacherefreshtime);
+										   terrain->cachememory,
+										   terrain->memorybudget,
+										   terrain->flag & TERRAIN_USE_TILE_STORE,
+										   tilestorepath);
 
 	// Si on n'initialise pas les masques et groupes de collisions, les collisions peuvent être aléatoire.
 	kxterrain->SetUserCollisionMask(0xffff);
 	kxterrain->SetUserCollisionGroup(0xffff);
+	// Les vertices sont construits dans les threads de travail du moteur.
+	kxterrain->SetTaskScheduler(converter->GetKetsjiEngine()->GetTaskScheduler());
 
 	// Conversion de toutes les zones et ajout des ces zones dans le terrain.
 	for (TerrainZone *zone = (TerrainZone *)terrain->zones.first; zone; zone = (TerrainZone *)zone->next) {
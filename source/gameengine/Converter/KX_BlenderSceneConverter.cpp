@@ -234,6 +234,7 @@ void KX_BlenderSceneConverter::ConvertScene(KX_Scene *destinationscene, RAS_IRas
 	// hook for registration function during conversion.
 	m_currentScene = destinationscene;
 	destinationscene->SetSceneConverter(this);
+	destinationscene->SetTaskScheduler(m_ketsjiEngine->GetTaskScheduler());
 
 	// This doesn't really seem to do anything except cause potential issues
 	// when doing threaded conversion, so it's disabled for now.
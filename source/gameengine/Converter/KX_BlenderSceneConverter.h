@@ -171,6 +171,8 @@ public:
 
 	struct Scene* GetBlenderSceneForName(const STR_String& name);
 
+	class KX_KetsjiEngine *GetKetsjiEngine() { return m_ketsjiEngine; }
+
 //	struct Main* GetMain() { return m_maggie; }
 	struct Main*		  GetMainDynamicPath(const char *path);
 	vector<struct Main*> &GetMainDynamic();
@@ -51,6 +51,27 @@
 
 // initialize static member variables
 SCA_PythonController* SCA_PythonController::m_sCurrentController = NULL;
+SCA_ProfileCallbacks SCA_PythonController::m_sProfileCallbacks = {NULL, NULL, NULL, NULL};
+
+/* Closes the profiler zone of a script whatever the way Trigger returns. */
+class SCA_ScriptProfileZone
+{
+	bool m_active;
+
+public:
+	SCA_ScriptProfileZone(const char *name)
+		:m_active(name != NULL)
+	{
+		if (m_active)
+			SCA_PythonController::m_sProfileCallbacks.beginZone(name);
+	}
+
+	~SCA_ScriptProfileZone()
+	{
+		if (m_active)
+			SCA_PythonController::m_sProfileCallbacks.endZone();
+	}
+};
 
 
 SCA_PythonController::SCA_PythonController(SCA_IObject* gameobj, int mode)
@@ -62,7 +83,8 @@ SCA_PythonController::SCA_PythonController(SCA_IObject* gameobj, int mode)
 	m_function_argc(0),
 	m_bModified(true),
 	m_debug(false),
-	m_mode(mode)
+	m_mode(mode),
+	m_profileName(NULL)
 #ifdef WITH_PYTHON
 	, m_pythondictionary(NULL)
 #endif
@@ -148,6 +170,7 @@ void SCA_PythonController::SetScriptText(const STR_String& text)
 void SCA_PythonController::SetScriptName(const STR_String& name)
 {
 	m_scriptName = name;
+	m_profileName = NULL;
 }
 
 
@@ -385,6 +408,12 @@ bool SCA_PythonController::Import()
 
 void SCA_PythonController::Trigger(SCA_LogicManager* logicmgr)
 {
+	// the script name isn't static, the profiler keeps its own copy
+	const bool profile = (m_sProfileCallbacks.isEnabled && m_sProfileCallbacks.isEnabled());
+	if (profile && !m_profileName)
+		m_profileName = m_sProfileCallbacks.internName(m_scriptName.ReadPtr());
+	SCA_ScriptProfileZone zone(profile ? m_profileName : NULL);
+
 	m_sCurrentController = this;
 	m_sCurrentLogicManager = logicmgr;
 	
@@ -40,6 +40,23 @@
 #include <vector>
 
 class SCA_IObject;
+
+/**
+ * Profiler hooks used by the python controllers, the profiler belongs to the
+ * engine which registers them. Scripts aren't profiled without them.
+ */
+struct SCA_ProfileCallbacks
+{
+	/// Returns true if the zones are recorded.
+	bool (*isEnabled)();
+	/// Returns a copy of the name living until the end of the program.
+	const char *(*internName)(const char *name);
+	/// Opens a zone on the calling thread.
+	void (*beginZone)(const char *name);
+	/// Closes the last zone opened on the calling thread.
+	void (*endZone)();
+};
+
 class SCA_PythonController : public SCA_IController
 {
 	Py_Header
@@ -56,6 +73,7 @@ class SCA_PythonController : public SCA_IController
  protected:
 	STR_String				m_scriptText;
 	STR_String				m_scriptName;
+	const char*				m_profileName;	/* m_scriptName interned by the profiler at the first profiled run */
 #ifdef WITH_PYTHON
 	PyObject*				m_pythondictionary;	/* for SCA_PYEXEC_SCRIPT only */
 	PyObject*				m_pythonfunction;	/* for SCA_PYEXEC_MODULE only */
@@ -71,6 +89,7 @@ class SCA_PythonController : public SCA_IController
 	};
 
 	static SCA_PythonController* m_sCurrentController; // protected !!!
+	static SCA_ProfileCallbacks m_sProfileCallbacks;
 
 	//for debugging
 	//virtual	CValue*		AddRef();
@@ -88,6 +107,8 @@ class SCA_PythonController : public SCA_IController
 	void	SetNamespace(PyObject*	pythondictionary);
 #endif
 	void	SetDebug(bool debug) { m_debug = debug; }
+	static void SetProfileCallbacks(const SCA_ProfileCallbacks& callbacks)
+		{ m_sProfileCallbacks = callbacks; }
 	void	AddTriggeredSensor(class SCA_ISensor* sensor)
 		{ m_triggeredSensors.push_back(sensor); }
 	bool	IsTriggered(class SCA_ISensor* sensor);
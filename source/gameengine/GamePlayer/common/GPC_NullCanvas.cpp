@@ -0,0 +1,81 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Contributor(s): none yet.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file gameengine/GamePlayer/common/GPC_NullCanvas.cpp
+ *  \ingroup player
+ */
+
+#include "GPC_NullCanvas.h"
+
+GPC_NullCanvas::GPC_NullCanvas(int width, int height)
+	:m_width(width),
+	m_height(height)
+{
+	m_displayarea.m_x1 = 0;
+	m_displayarea.m_y1 = 0;
+	m_displayarea.m_x2 = width;
+	m_displayarea.m_y2 = height;
+
+	m_viewport[0] = 0;
+	m_viewport[1] = 0;
+	m_viewport[2] = width;
+	m_viewport[3] = height;
+
+	m_mousestate = MOUSE_NORMAL;
+}
+
+GPC_NullCanvas::~GPC_NullCanvas()
+{
+}
+
+float GPC_NullCanvas::GetMouseNormalizedX(int x)
+{
+	return float(x) / m_width;
+}
+
+float GPC_NullCanvas::GetMouseNormalizedY(int y)
+{
+	return float(y) / m_height;
+}
+
+void GPC_NullCanvas::SetViewPort(int x1, int y1, int x2, int y2)
+{
+	/* Same convention as GPC_Canvas, both pixels are included. */
+	m_viewport[0] = x1;
+	m_viewport[1] = y1;
+	m_viewport[2] = x2 - x1 + 1;
+	m_viewport[3] = y2 - y1 + 1;
+}
+
+void GPC_NullCanvas::UpdateViewPort(int x1, int y1, int x2, int y2)
+{
+	m_viewport[0] = x1;
+	m_viewport[1] = y1;
+	m_viewport[2] = x2;
+	m_viewport[3] = y2;
+}
+
+void GPC_NullCanvas::GetDisplayDimensions(int &width, int &height)
+{
+	width = m_width;
+	height = m_height;
+}
@@ -79,6 +79,7 @@ extern "C"
 #include "RAS_OpenGLRasterizer.h"
 #include "RAS_ListRasterizer.h"
 #include "RAS_GLExtensionManager.h"
+#include "RAS_NullRasterizer.h"
 #include "KX_PythonInit.h"
 #include "KX_PyConstraintBinding.h"
 #include "BL_Material.h" // MAXTEX
@@ -87,6 +88,7 @@ extern "C"
 #include "NG_LoopBackNetworkDeviceInterface.h"
 
 #include "GPC_MouseDevice.h"
+#include "GPC_NullCanvas.h"
 #include "GPG_Canvas.h" 
 #include "GPG_KeyboardDevice.h"
 #include "GPG_System.h"
@@ -99,6 +101,17 @@ extern "C"
 #include "GHOST_IWindow.h"
 #include "GHOST_Rect.h"
 
+#include "KX_Camera.h"
+#include "KX_Scene.h"
+#include "KX_Terrain.h"
+
+#include "PIL_time.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
 #ifdef WITH_AUDASPACE
 #  include AUD_DEVICE_H
 #endif
@@ -121,6 +134,7 @@ GPG_Application::GPG_Application(GHOST_ISystem* system)
 	  m_engineInitialized(0), 
 	  m_engineRunning(0), 
 	  m_isEmbedded(false),
+	  m_headless(false),
 	  m_ketsjiengine(0),
 	  m_kxsystem(0), 
 	  m_keyboard(0), 
@@ -148,7 +162,8 @@ GPG_Application::~GPG_Application(void)
 	}
 
 	exitEngine();
-	fSystem->disposeWindow(m_mainWindow);
+	if (fSystem && m_mainWindow)
+		fSystem->disposeWindow(m_mainWindow);
 }
 
 
@@ -423,6 +438,121 @@ bool GPG_Application::startFullScreen(
 
 
 
+bool GPG_Application::startHeadless(int width, int height)
+{
+	bool success;
+
+	m_headless = true;
+	if (width > 0 && height > 0) {
+		m_startScene->gm.xplay = width;
+		m_startScene->gm.yplay = height;
+	}
+
+	success = initEngine(NULL, RAS_IRasterizer::RAS_STEREO_NOSTEREO);
+	if (success) {
+		success = startEngine();
+	}
+	return success;
+}
+
+/// Turns a profile label as "GPU Latency:" into a JSON key as "gpu_latency".
+static std::string benchmark_category_key(const char *label)
+{
+	std::string key;
+	for (const char *c = label; *c; ++c) {
+		if (*c == ':')
+			continue;
+		key += (*c == ' ') ? '_' : (char)tolower(*c);
+	}
+	return key;
+}
+
+bool GPG_Application::runBenchmark(int frames, const char *camerapath, const char *outputpath)
+{
+	if (!m_engineRunning)
+		return false;
+
+	/* Each camera key is a line of "x y z rx ry rz", euler angles in radians. */
+	std::vector<MT_Point3> camerapositions;
+	std::vector<MT_Vector3> camerarotations;
+	if (camerapath) {
+		FILE *fp = fopen(camerapath, "r");
+		if (!fp) {
+			printf("error: could not open camera path '%s'\n", camerapath);
+			return false;
+		}
+		float x, y, z, rx, ry, rz;
+		while (fscanf(fp, "%f %f %f %f %f %f", &x, &y, &z, &rx, &ry, &rz) == 6) {
+			camerapositions.push_back(MT_Point3(x, y, z));
+			camerarotations.push_back(MT_Vector3(rx, ry, rz));
+		}
+		fclose(fp);
+	}
+
+	int frame;
+	const double starttime = PIL_check_seconds_timer();
+	for (frame = 0; frame < frames && !m_exitRequested; ++frame) {
+		if (!camerapositions.empty()) {
+			KX_Camera *camera = m_kxStartScene->GetActiveCamera();
+			if (camera) {
+				const unsigned int key = frame % camerapositions.size();
+				camera->NodeSetLocalPosition(camerapositions[key]);
+				camera->NodeSetLocalOrientation(MT_Matrix3x3(camerarotations[key]));
+				camera->NodeUpdateGS(0.0);
+			}
+		}
+		EngineNextFrame();
+	}
+	const double totaltime = PIL_check_seconds_timer() - starttime;
+
+	FILE *out = outputpath ? fopen(outputpath, "w") : stdout;
+	if (!out) {
+		printf("error: could not write benchmark output '%s'\n", outputpath);
+		return false;
+	}
+
+	fprintf(out, "{\n");
+	fprintf(out, "\t\"frames\": %i,\n", frame);
+	fprintf(out, "\t\"total_time\": %f,\n", totaltime);
+	fprintf(out, "\t\"categories\": {\n");
+	const int numcategories = KX_KetsjiEngine::GetProfileCategoryCount();
+	for (int i = 0; i < numcategories; ++i) {
+		const double time = m_ketsjiengine->GetProfileTotalTime(i);
+		fprintf(out, "\t\t\"%s\": {\"total\": %f, \"average_ms\": %f}%s\n",
+		        benchmark_category_key(KX_KetsjiEngine::GetProfileLabel(i)).c_str(),
+		        time, (frame > 0) ? time * 1000.0 / frame : 0.0,
+		        (i < numcategories - 1) ? "," : "");
+	}
+	fprintf(out, "\t}\n");
+	fprintf(out, "}\n");
+
+	if (out != stdout)
+		fclose(out);
+
+	return true;
+}
+
+bool GPG_Application::bakeTerrains()
+{
+	if (!m_engineRunning)
+		return false;
+
+	bool baked = false;
+	KX_SceneList *scenes = m_ketsjiengine->CurrentScenes();
+	for (KX_SceneList::iterator it = scenes->begin(); it != scenes->end(); ++it) {
+		KX_Terrain *terrain = (*it)->GetTerrain();
+		if (!terrain)
+			continue;
+
+		if (terrain->BakeTileStore())
+			baked = true;
+		else
+			printf("warning: the terrain of scene '%s' doesn't use a tile store\n", (*it)->GetName().ReadPtr());
+	}
+
+	return baked;
+}
+
 bool GPG_Application::StartGameEngine(int stereoMode)
 {
 	bool success = initEngine(m_mainWindow, stereoMode);
@@ -523,7 +653,7 @@ bool GPG_Application::processEvent(GHOST_IEvent* event)
 			if (m_canvas) {
 				GHOST_Rect bnds;
 				window->getClientBounds(bnds);
-				m_canvas->Resize(bnds.getWidth(), bnds.getHeight());
+				((GPG_Canvas *)m_canvas)->Resize(bnds.getWidth(), bnds.getHeight());
 				m_ketsjiengine->Resize();
 			}
 			}
@@ -562,8 +692,10 @@ bool GPG_Application::initEngine(GHOST_IWindow* window, const int stereoMode)
 {
 	if (!m_engineInitialized)
 	{
-		GPU_init();
-		bgl::InitExtensions(true);
+		if (!m_headless) {
+			GPU_init();
+			bgl::InitExtensions(true);
+		}
 
 		// get and set the preferences
 		SYS_SystemHandle syshandle = SYS_GetSystem();
@@ -581,20 +713,30 @@ bool GPG_Application::initEngine(GHOST_IWindow* window, const int stereoMode)
 
 		bool fixed_framerate= (SYS_GetCommandLineInt(syshandle, "fixedtime", (gm->flag & GAME_ENABLE_ALL_FRAMES)) != 0);
 		bool frameRate = (SYS_GetCommandLineInt(syshandle, "show_framerate", 0) != 0);
-		bool useLists = (SYS_GetCommandLineInt(syshandle, "displaylists", gm->flag & GAME_DISPLAY_LISTS) != 0) && GPU_display_list_support();
+		bool useLists = !m_headless && (SYS_GetCommandLineInt(syshandle, "displaylists", gm->flag & GAME_DISPLAY_LISTS) != 0) && GPU_display_list_support();
 		bool nodepwarnings = (SYS_GetCommandLineInt(syshandle, "ignore_deprecation_warnings", 1) != 0);
 		bool restrictAnimFPS = (gm->flag & GAME_RESTRICT_ANIM_UPDATES) != 0;
 
-		if (GLEW_ARB_multitexture && GLEW_VERSION_1_1)
-			m_blendermat = (SYS_GetCommandLineInt(syshandle, "blender_material", 1) != 0);
-
-		if (GPU_glsl_support())
-			m_blenderglslmat = (SYS_GetCommandLineInt(syshandle, "blender_glsl_material", 1) != 0);
-		else if (m_globalSettings->matmode == GAME_MAT_GLSL)
-			m_blendermat = false;
+		if (m_headless) {
+			// no GL to query, blender materials are converted but never constructed
+			m_blendermat = true;
+			m_blenderglslmat = false;
+		}
+		else {
+			if (GLEW_ARB_multitexture && GLEW_VERSION_1_1)
+				m_blendermat = (SYS_GetCommandLineInt(syshandle, "blender_material", 1) != 0);
+
+			if (GPU_glsl_support())
+				m_blenderglslmat = (SYS_GetCommandLineInt(syshandle, "blender_glsl_material", 1) != 0);
+			else if (m_globalSettings->matmode == GAME_MAT_GLSL)
+				m_blendermat = false;
+		}
 
 		// create the canvas, rasterizer and rendertools
-		m_canvas = new GPG_Canvas(window);
+		if (m_headless)
+			m_canvas = new GPC_NullCanvas(m_startScene->gm.xplay, m_startScene->gm.yplay);
+		else
+			m_canvas = new GPG_Canvas(window);
 		if (!m_canvas)
 			return false;
 
@@ -609,7 +751,9 @@ bool GPG_Application::initEngine(GHOST_IWindow* window, const int stereoMode)
 		
 		//Don't use displaylists with VBOs
 		//If auto starts using VBOs, make sure to check for that here
-		if (useLists && gm->raster_storage != RAS_STORE_VBO)
+		if (m_headless)
+			m_rasterizer = new RAS_NullRasterizer(m_canvas);
+		else if (useLists && gm->raster_storage != RAS_STORE_VBO)
 			m_rasterizer = new RAS_ListRasterizer(m_canvas, false, gm->raster_storage);
 		else
 			m_rasterizer = new RAS_OpenGLRasterizer(m_canvas, gm->raster_storage);
@@ -659,7 +803,9 @@ bool GPG_Application::initEngine(GHOST_IWindow* window, const int stereoMode)
 		(void)nodepwarnings;
 #endif
 
-		m_ketsjiengine->SetUseFixedTime(fixed_framerate);
+		m_ketsjiengine->SetHeadless(m_headless);
+		// headless runs advance one logic tick per frame, independent of the wall clock
+		m_ketsjiengine->SetUseFixedTime(fixed_framerate || m_headless);
 		m_ketsjiengine->SetTimingDisplay(frameRate, profile, properties);
 		m_ketsjiengine->SetRestrictAnimationFPS(restrictAnimFPS);
 
@@ -741,7 +887,7 @@ bool GPG_Application::startEngine(void)
 #endif // WITH_PYTHON
 
 		//initialize Dome Settings
-		if (m_startScene->gm.stereoflag == STEREO_DOME)
+		if (!m_headless && m_startScene->gm.stereoflag == STEREO_DOME)
 			m_ketsjiengine->InitDome(m_startScene->gm.dome.res, m_startScene->gm.dome.mode, m_startScene->gm.dome.angle, m_startScene->gm.dome.resbuf, m_startScene->gm.dome.tilt, m_startScene->gm.dome.warptext);
 
 		// initialize 3D Audio Settings
@@ -762,7 +908,7 @@ bool GPG_Application::startEngine(void)
 		m_ketsjiengine->AddScene(m_kxStartScene);
 		
 		// Create a timer that is used to kick the engine
-		if (!m_frameTimer) {
+		if (m_system && !m_frameTimer) {
 			m_frameTimer = m_system->installTimer(0, kTimerFreq, frameTimerProc, m_mainWindow);
 		}
 		m_rasterizer->Init();
@@ -828,7 +974,7 @@ void GPG_Application::EngineNextFrame()
 		
 		// kick the engine
 		bool renderFrame = m_ketsjiengine->NextFrame();
-		if (renderFrame && m_mainWindow)
+		if (renderFrame && (m_mainWindow || m_headless))
 		{
 			// render the frame
 			m_ketsjiengine->Render();
@@ -881,7 +1027,8 @@ void GPG_Application::exitEngine()
 		m_canvas = 0;
 	}
 
-	GPU_exit();
+	if (!m_headless)
+		GPU_exit();
 
 #ifdef WITH_PYTHON
 	// Call this after we're sure nothing needs Python anymore (e.g., destructors)
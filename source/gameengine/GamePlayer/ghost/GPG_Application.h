@@ -49,7 +49,7 @@ class GHOST_ISystem;
 class GHOST_ITimerTask;
 class GHOST_IWindow;
 class GPC_MouseDevice;
-class GPG_Canvas;
+class RAS_ICanvas;
 class GPG_KeyboardDevice;
 class GPG_System;
 struct Main;
@@ -79,6 +79,28 @@ public:
 	bool startScreenSaverPreview(HWND parentWindow,
 	                             const bool stereoVisual, const int stereoMode, const GHOST_TUns16 samples=0);
 #endif
+	/**
+	 * Starts the engine without any window or GL context, the scene is
+	 * updated but nothing is drawn.
+	 * \param width	Width of the virtual canvas.
+	 * \param height	Height of the virtual canvas.
+	 */
+	bool startHeadless(int width, int height);
+
+	/**
+	 * Runs a fixed number of frames and writes the engine profile as JSON.
+	 * \param frames		Number of frames to run.
+	 * \param camerapath	Optional file of "x y z rx ry rz" lines applied to the
+	 *					active camera before each frame (looped), may be NULL.
+	 * \param outputpath	File the JSON report is written to, stdout if NULL.
+	 */
+	bool runBenchmark(int frames, const char *camerapath, const char *outputpath);
+
+	/**
+	 * Computes the whole terrain of every scene using a tile store and writes
+	 * it on disk, so the game never computes these vertexes at run time.
+	 */
+	bool bakeTerrains();
 
 	virtual	bool processEvent(GHOST_IEvent* event);
 	int getExitRequested(void);
@@ -147,6 +169,8 @@ protected:
 	bool m_engineRunning;
 	/** Running on embedded window */
 	bool m_isEmbedded;
+	/** Running without window nor GL context */
+	bool m_headless;
 
 	/** the gameengine itself */
 	KX_KetsjiEngine* m_ketsjiengine;
@@ -157,7 +181,7 @@ protected:
 	/** The game engine's mouse abstraction. */
 	GPC_MouseDevice* m_mouse;
 	/** The game engine's canvas abstraction. */
-	GPG_Canvas* m_canvas;
+	RAS_ICanvas* m_canvas;
 	/** the rasterizer */
 	RAS_IRasterizer* m_rasterizer;
 	/** Converts Blender data files. */
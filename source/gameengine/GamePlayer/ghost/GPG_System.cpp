@@ -35,15 +35,20 @@
 #include <assert.h>
 #include "GHOST_ISystem.h"
 
+#include "PIL_time.h"
+
 GPG_System::GPG_System(GHOST_ISystem* system)
 : m_system(system)
 {
-	assert(m_system);
 }
 
 
 double GPG_System::GetTimeInSeconds()
 {
+	/* No GHOST system when running headless. */
+	if (!m_system)
+		return PIL_check_seconds_timer();
+
 	GHOST_TInt64 millis = (GHOST_TInt64)m_system->getMilliSeconds();
 	double time = (double)millis;
 	time /= 1000.0f;
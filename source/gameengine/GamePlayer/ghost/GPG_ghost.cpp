@@ -279,12 +279,18 @@ static void usage(const char* program, bool isBlenderPlayer)
 	printf("       show_profile                   0         Show profiling information\n");
 	printf("       blender_material               0         Enable material settings\n");
 	printf("       ignore_deprecation_warnings    1         Ignore deprecation warnings\n");
+	printf("       benchmark_frames               0         Run this many frames without window nor GL, then quit\n");
+	printf("       benchmark_output                         JSON profile output file (default: stdout)\n");
+	printf("       benchmark_camera_path                    File of \"x y z rx ry rz\" camera keys, one per frame\n");
+	printf("       terrain_bake                   0         Compute the terrain tile stores without window nor GL, then quit\n");
 	printf("\n");
 	printf("  - : all arguments after this are ignored, allowing python to access them from sys.argv\n");
 	printf("\n");
 	printf("example: %s -w 320 200 10 10 -g noaudio %s%s\n", program, example_pathname, example_filename);
 	printf("example: %s -g show_framerate = 0 %s%s\n", program, example_pathname, example_filename);
-	printf("example: %s -i 232421 -m 16 %s%s\n\n", program, example_pathname, example_filename);
+	printf("example: %s -i 232421 -m 16 %s%s\n", program, example_pathname, example_filename);
+	printf("example: %s -g benchmark_frames = 1000 -g benchmark_output = profile.json %s%s\n", program, example_pathname, example_filename);
+	printf("example: %s -g terrain_bake = 1 %s%s\n\n", program, example_pathname, example_filename);
 }
 
 static void get_filename(int argc, char **argv, char *filename)
@@ -399,6 +405,59 @@ static int GPG_PyNextFrame(void *state0)
 	}
 }
 
+/* Runs the game without window nor GL, either to bake the terrains if
+ * bakeTerrain is set, or to benchmark a number of frames. */
+static bool GPG_RunHeadless(int argc, int argc_py_clamped, char **argv, bool bakeTerrain, int frames,
+                            const char *camerapath, const char *outputpath)
+{
+	char filename[FILE_MAX];
+	bool success = false;
+
+	get_filename(argc_py_clamped, argv, filename);
+	if (filename[0])
+		BLI_path_cwd(filename, sizeof(filename));
+
+	BlendFileData *bfd = load_game_data(BKE_appdir_program_path(), filename[0] ? filename : NULL);
+	if (!bfd)
+		return false;
+
+	Main *maggie = bfd->main;
+	Scene *scene = bfd->curscene;
+	G.main = maggie;
+	G.fileflags = bfd->fileflags;
+
+	GlobalSettings gs;
+	gs.matmode = scene->gm.matmode;
+	gs.glslflag = scene->gm.flag;
+
+	//Seg Fault; icon.c gIcons == 0
+	BKE_icons_init(1);
+
+	// this bracket is needed for app to get out of scope before the blend data is freed
+	{
+		GPG_Application app(NULL);
+		app.SetGameEngineData(maggie, scene, &gs, argc, argv);
+#ifdef WITH_PYTHON
+		setGamePythonPath(G.main->name);
+#endif
+		if (app.startHeadless(scene->gm.xplay, scene->gm.yplay)) {
+			if (bakeTerrain)
+				success = app.bakeTerrains();
+			else
+				success = app.runBenchmark(frames, camerapath, outputpath);
+			app.StopGameEngine();
+		}
+	}
+
+	BLO_blendfiledata_free(bfd);
+	/* G.main == bfd->main, it gets referenced in free_nodesystem so we can't have a dangling pointer */
+	G.main = NULL;
+
+	BKE_icons_free();
+
+	return success;
+}
+
 int main(int argc, char** argv)
 {
 	int i;
@@ -825,6 +884,27 @@ int main(int argc, char** argv)
 		return 0;
 	}
 
+	const int benchmarkFrames = SYS_GetCommandLineInt(syshandle, "benchmark_frames", 0);
+	const bool terrainBake = SYS_GetCommandLineInt(syshandle, "terrain_bake", 0);
+
+	if (terrainBake) {
+		if (!GPG_RunHeadless(argc, argc_py_clamped, argv, true, 0, NULL, NULL)) {
+			error = true;
+			printf("error: terrain bake failed.\n");
+		}
+	}
+	else if (benchmarkFrames > 0) {
+		const char *camerapath = SYS_GetCommandLineString(syshandle, "benchmark_camera_path", "");
+		const char *outputpath = SYS_GetCommandLineString(syshandle, "benchmark_output", "");
+
+		if (!GPG_RunHeadless(argc, argc_py_clamped, argv, false, benchmarkFrames,
+		                     camerapath[0] ? camerapath : NULL, outputpath[0] ? outputpath : NULL))
+		{
+			error = true;
+			printf("error: benchmark failed.\n");
+		}
+	}
+	else
 #ifdef WIN32
 	if (scr_saver_mode != SCREEN_SAVER_MODE_CONFIGURATION)
 #endif
@@ -56,15 +56,6 @@ extern "C" {
 #include "BKE_library.h"
 #include "BKE_global.h"
 
-#include "BLI_threads.h" // for lock
-
-/* Lock to solve animation thread issues.
- * A spin lock is better than a mutex in case of short wait 
- * because spin lock stop the thread by a loop contrary to mutex
- * which switch all memory, process.
- */ 
-static SpinLock BL_ActionLock;
-
 BL_Action::BL_Action(class KX_GameObject* gameobj)
 :
 	m_action(NULL),
@@ -84,7 +75,8 @@ BL_Action::BL_Action(class KX_GameObject* gameobj)
 	m_blendmode(ACT_BLEND_BLEND),
 	m_ipo_flags(0),
 	m_done(true),
-	m_calc_localtime(true)
+	m_calc_localtime(true),
+	m_requestIpo(false)
 {
 }
 
@@ -508,23 +500,42 @@ void BL_Action::Update(float curtime)
 		}
 	}
 
-	BLI_spin_lock(&BL_ActionLock);
-	/* This function is not thread safe because of recursive scene graph transform
-	 * updates on children. e.g: If an object and one of its children is animated,
-	 * the both can write transform at the same time. A thread lock avoid problems. */
+	/* The IPO update writes the transforms of the object and its children,
+	 * which can be animated in other threads, it's deferred to UpdateIPOs. */
+	m_requestIpo = true;
+}
+
+void BL_Action::UpdateIPOs()
+{
+	if (!m_requestIpo)
+		return;
+
 	m_obj->UpdateIPO(m_localframe, m_ipo_flags & ACT_IPOFLAG_CHILD);
-	BLI_spin_unlock(&BL_ActionLock);
+	EndIPOs();
+}
 
-	if (m_done)
-		ClearControllerList();
+bool BL_Action::CanEvaluateIPOs()
+{
+	return !m_requestIpo || !(m_ipo_flags & ACT_IPOFLAG_CHILD);
 }
 
-void BL_Action::InitLock()
+void BL_Action::EvaluateIPOs()
 {
-	BLI_spin_init(&BL_ActionLock);
+	if (!m_requestIpo)
+		return;
+
+	SG_Node *node = m_obj->GetSGNode();
+	node->SetSimulatedTime(m_localframe, false);
+	node->UpdateControllers(m_localframe);
 }
 
-void BL_Action::EndLock()
+void BL_Action::EndIPOs()
 {
-	BLI_spin_end(&BL_ActionLock);
+	if (!m_requestIpo)
+		return;
+
+	m_requestIpo = false;
+
+	if (m_done)
+		ClearControllerList();
 }
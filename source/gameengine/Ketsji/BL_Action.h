@@ -69,6 +69,8 @@ private:
 
 	bool m_done;
 	bool m_calc_localtime;
+	/// Set by Update() when the IPO frame must be applied by UpdateIPOs().
+	bool m_requestIpo;
 
 	void ClearControllerList();
 	void InitIPO();
@@ -98,9 +100,32 @@ public:
 	 */
 	bool IsDone();
 	/**
-	 * Update the action's frame, etc.
+	 * Update the action's frame, etc. Only the action data and the pose or shape
+	 * of its object are written, so actions of different objects can be updated
+	 * in parallel.
 	 */
 	void Update(float curtime);
+	/**
+	 * Apply the IPO frame computed by Update() to the object transform, this
+	 * recursively updates the children and is not thread safe.
+	 */
+	void UpdateIPOs();
+	/**
+	 * True if the IPO frame can be applied by EvaluateIPOs(), the action must
+	 * not apply its IPOs to the children of the object.
+	 */
+	bool CanEvaluateIPOs();
+	/**
+	 * Apply the IPO frame computed by Update() to the controllers of the object
+	 * node only, the world transform is left to the caller. Only the object is
+	 * written when its controllers are thread safe.
+	 */
+	void EvaluateIPOs();
+	/**
+	 * End the IPO request once it's applied, done by UpdateIPOs() or by the
+	 * caller of EvaluateIPOs() after the world transform update.
+	 */
+	void EndIPOs();
 
 	// Accessors
 	float GetFrame();
@@ -136,11 +161,6 @@ public:
 		ACT_IPOFLAG_CHILD = 8,
 	};
 
-	/// Initialize a lock for animation thread issues.
-	static void InitLock();
-	/// Finalize a lock for animation thread issues.
-	static void EndLock();
-
 #ifdef WITH_CXX_GUARDEDALLOC
 	MEM_CXX_CLASS_ALLOC_FUNCS("GE:BL_Action")
 #endif
@@ -162,3 +162,37 @@ void BL_ActionManager::Update(float curtime)
 		}
 	}
 }
+
+void BL_ActionManager::UpdateIPOs()
+{
+	BL_ActionMap::iterator it;
+	for (it = m_layers.begin(); it != m_layers.end(); ++it)
+	{
+		it->second->UpdateIPOs();
+	}
+}
+
+bool BL_ActionManager::EvaluateIPOs()
+{
+	BL_ActionMap::iterator it;
+	for (it = m_layers.begin(); it != m_layers.end(); ++it)
+	{
+		if (!it->second->CanEvaluateIPOs())
+			return false;
+	}
+
+	for (it = m_layers.begin(); it != m_layers.end(); ++it)
+	{
+		it->second->EvaluateIPOs();
+	}
+	return true;
+}
+
+void BL_ActionManager::EndIPOs()
+{
+	BL_ActionMap::iterator it;
+	for (it = m_layers.begin(); it != m_layers.end(); ++it)
+	{
+		it->second->EndIPOs();
+	}
+}
@@ -124,6 +124,23 @@ public:
 	 */
 	void Update(float);
 
+	/**
+	 * Apply the IPO frames of the actions updated by Update()
+	 */
+	void UpdateIPOs();
+
+	/**
+	 * Apply the IPO frames of the actions updated by Update() to the controllers
+	 * of the object node only, see BL_Action::EvaluateIPOs().
+	 * \return False if nothing was done because an action must use UpdateIPOs().
+	 */
+	bool EvaluateIPOs();
+
+	/**
+	 * End the IPO requests applied by EvaluateIPOs()
+	 */
+	void EndIPOs();
+
 #ifdef WITH_CXX_GUARDEDALLOC
 	MEM_CXX_CLASS_ALLOC_FUNCS("GE:BL_ActionManager")
 #endif
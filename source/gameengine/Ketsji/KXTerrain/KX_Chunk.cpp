@@ -1,30 +1,40 @@
 #include "KX_Terrain.h"
 #include "KX_Chunk.h"
+#include "KX_ChunkCache.h"
+#include "KX_TerrainPool.h"
 #include "KX_ChunkMotionState.h"
 
 #include "KX_Camera.h"
-#include "KX_PythonInit.h"
+#include "KX_Profiler.h"
 
 #include "RAS_IRasterizer.h"
 #include "RAS_MaterialBucket.h"
 #include "RAS_MeshObject.h"
 #include "RAS_Polygon.h"
+#include "RAS_TexVert.h"
 #include "RAS_IPolygonMaterial.h"
 
 #include "PHY_IPhysicsController.h"
+#include "PHY_IOcclusionBuffer.h"
 #ifdef WITH_BULLET
 #include "CcdPhysicsEnvironment.h"
 #include "CcdPhysicsController.h"
 #include "CcdGraphicController.h"
+
+#include "BulletCollision/CollisionShapes/btHeightfieldTerrainShape.h"
 #endif
 
 #include "BLI_math.h"
 #include "MT_assert.h"
 
+#include "atomic_ops.h"
+
 #include "DNA_material_types.h"
 #include "DNA_terrain_types.h"
 
 #include <stdio.h>
+#include <new>
+#include <vector>
 
 #define DEBUG(msg) std::cout << msg << std::endl;
 #define DEBUG_HEADER(msg) DEBUG("====================== " << msg << " ======================");
@@ -41,79 +51,16 @@ double KX_Chunk::vertexAddingTime = 0.0;
 double KX_Chunk::vertexCreatingTime = 0.0;
 double KX_Chunk::polyAddingTime = 0.0;
 double KX_Chunk::physicsCreatingTime = 0.0;
-
-// La colonne opposée.
-static KX_Chunk::COLUMN_TYPE OppositeColumn(KX_Chunk::COLUMN_TYPE columnType)
-{
-	if (columnType == KX_Chunk::COLUMN_LEFT)
-		return KX_Chunk::COLUMN_RIGHT;
-	else if (columnType == KX_Chunk::COLUMN_RIGHT)
-		return KX_Chunk::COLUMN_LEFT;
-	else if (columnType == KX_Chunk::COLUMN_FRONT)
-		return KX_Chunk::COLUMN_BACK;
-	else if (columnType == KX_Chunk::COLUMN_BACK)
-		return KX_Chunk::COLUMN_FRONT;
-	return KX_Chunk::COLUMN_NONE;
-}
-
-static KX_Chunk::COLUMN_TYPE BackColumn(KX_Chunk::COLUMN_TYPE columnType)
-{
-	if (columnType == KX_Chunk::COLUMN_LEFT)
-		return KX_Chunk::COLUMN_BACK;
-	else if (columnType == KX_Chunk::COLUMN_RIGHT)
-		return KX_Chunk::COLUMN_BACK;
-	else if (columnType == KX_Chunk::COLUMN_FRONT)
-		return KX_Chunk::COLUMN_RIGHT;
-	else if (columnType == KX_Chunk::COLUMN_BACK)
-		return KX_Chunk::COLUMN_RIGHT;
-	return KX_Chunk::COLUMN_NONE;
-}
-
-static KX_Chunk::COLUMN_TYPE FrontColumn(KX_Chunk::COLUMN_TYPE columnType)
-{
-	return OppositeColumn(BackColumn(columnType));
-}
-
-// L'axe d'alignement de la colonne.
-static unsigned short ColumnAxis(KX_Chunk::COLUMN_TYPE columnType)
-{
-	if (columnType == KX_Chunk::COLUMN_LEFT || columnType == KX_Chunk::COLUMN_RIGHT)
-		return 1; // alignée sur y donc vers le haut.
-	else if (columnType == KX_Chunk::COLUMN_FRONT || columnType == KX_Chunk::COLUMN_BACK)
-		return 0; // alignée sur x donc a l'horizontale.
-	return 3;
-}
-
-// Déplace un point d'une valeur precise vers le centre ou à l'opossé.
-static void MoveVectorToCenterColumn(KX_Chunk::COLUMN_TYPE columnType, short &x, short &y, short length)
-{
-	if (columnType == KX_Chunk::COLUMN_LEFT)
-		x += length;
-	else if (columnType == KX_Chunk::COLUMN_RIGHT)
-		x -= length;
-	else if (columnType == KX_Chunk::COLUMN_BACK)
-		y -= length;
-	else if (columnType == KX_Chunk::COLUMN_FRONT)
-		y += length;
-}
-
-// Déplace un point d'une valeur precise vers le debut de la colonne.
-static void MoveVectorFrontColumn(KX_Chunk::COLUMN_TYPE columnType, short &x, short &y, short length)
-{
-	if (columnType == KX_Chunk::COLUMN_LEFT || columnType == KX_Chunk::COLUMN_RIGHT)
-		y -= length;
-	else if (columnType == KX_Chunk::COLUMN_FRONT || columnType == KX_Chunk::COLUMN_BACK)
-		x -= length;
-}
-
-// Déplace un point d'une valeur precise vers la fin de la colonne.
-static void MoveVectorBackColumn(KX_Chunk::COLUMN_TYPE columnType, short &x, short &y, short length)
-{
-	if (columnType == KX_Chunk::COLUMN_LEFT || columnType == KX_Chunk::COLUMN_RIGHT)
-		y += length;
-	else if (columnType == KX_Chunk::COLUMN_FRONT || columnType == KX_Chunk::COLUMN_BACK)
-		x += length;
-}
+unsigned int KX_Chunk::vertexesQueueDepth = 0;
+unsigned int KX_Chunk::meshQueueDepth = 0;
+unsigned int KX_Chunk::deferredMeshBuilds = 0;
+unsigned int KX_Chunk::meshBuilds = 0;
+double KX_Chunk::buildLatencyTime = 0.0;
+double KX_Chunk::maxBuildLatencyTime = 0.0;
+unsigned int KX_Chunk::morphUpdates = 0;
+unsigned int KX_Chunk::occludedChunks = 0;
+unsigned int KX_Chunk::chunkEvictions = 0;
+unsigned int KX_Chunk::chunkRefreshes = 0;
 
 void KX_Chunk::ResetTime()
 {
@@ -124,6 +71,20 @@ void KX_Chunk::ResetTime()
 	vertexCreatingTime = 0.0;
 	polyAddingTime = 0.0;
 	physicsCreatingTime = 0.0;
+	vertexesQueueDepth = 0;
+	meshQueueDepth = 0;
+	deferredMeshBuilds = 0;
+	meshBuilds = 0;
+	buildLatencyTime = 0.0;
+	maxBuildLatencyTime = 0.0;
+	morphUpdates = 0;
+	occludedChunks = 0;
+	chunkEvictions = 0;
+	chunkRefreshes = 0;
+	KX_ChunkCache::cacheHits = 0;
+	KX_ChunkCache::cacheMisses = 0;
+	KX_ChunkCache::cacheEvictions = 0;
+	KX_ChunkCache::cacheInvalidations = 0;
 }
 
 void KX_Chunk::PrintTime()
@@ -145,6 +106,27 @@ void KX_Chunk::PrintTime()
 		<< "\t Active Chunks Count : \t" << m_chunkActive << std::endl
 		<< "\t Active Nodes Count : \t" << KX_ChunkNode::m_activeNode << std::endl
 		<< std::endl;
+	std::cout << "Build Queue Stats : " << std::endl
+		<< "\t Max Vertexes Queue Depth : \t" << vertexesQueueDepth << std::endl
+		<< "\t Max Mesh Queue Depth : \t" << meshQueueDepth << std::endl
+		<< "\t Deferred Mesh Builds : \t" << deferredMeshBuilds << std::endl
+		<< "\t Mesh Builds : \t\t" << meshBuilds << std::endl
+		<< "\t Average Build Latency : \t" << (meshBuilds ? buildLatencyTime / meshBuilds : 0.0) << std::endl
+		<< "\t Max Build Latency : \t\t" << maxBuildLatencyTime << std::endl
+		<< "\t Morph Updates : \t\t" << morphUpdates << std::endl
+		<< "\t Occluded Chunks : \t\t" << occludedChunks << std::endl
+		<< "\t Chunk Evictions : \t\t" << chunkEvictions << std::endl
+		<< "\t Chunk Refreshes : \t\t" << chunkRefreshes << std::endl
+		<< std::endl;
+	const unsigned int cacheRequests = KX_ChunkCache::cacheHits + KX_ChunkCache::cacheMisses;
+	std::cout << "Cache Stats : " << std::endl
+		<< "\t Cache Hits : \t\t" << KX_ChunkCache::cacheHits << std::endl
+		<< "\t Cache Misses : \t\t" << KX_ChunkCache::cacheMisses << std::endl
+		<< "\t Cache Hit Ratio : \t\t" << (cacheRequests ? (float)KX_ChunkCache::cacheHits / cacheRequests * 100.0f : 0.0f) << "%" << std::endl
+		<< "\t Cache Evictions : \t\t" << KX_ChunkCache::cacheEvictions << std::endl
+		<< "\t Cache Invalidations : \t" << KX_ChunkCache::cacheInvalidations << std::endl
+		<< "\t Cache Memory : \t\t" << KX_ChunkCache::cacheMemory / 1024 << " KB" << std::endl
+		<< std::endl;
 }
 
 /** Vertex utilisé pour la construction du mesh du chunk
@@ -169,22 +151,18 @@ struct KX_Chunk::Vertex
 	float absolutePos[2]; // 4 * 3 = 12
 
 	/// L'indice de creation du vertice, utilisé lors de la construction du mesh.
-	unsigned char origIndex; // 1
+	unsigned short origIndex; // 2
 
 	/// L'indice du vertex dans le mesh
 	short vertIndex; // 2
 
-	/** Le vertice peut être utilisé dans le mesh ?
-	 * Très utile pour les jointures, lorsque le vertice est
-	 * invalide on passe au suivant et ainsi créant la jointure.
-	 */
-	bool valid; // 1
-
-	bool validNormal;
-
 	/// La normale du vertice.
 	float normal[3]; // 4 * 3 = 12
-	// 32 octets
+
+	/** La hauteur du vertice dans le maillage du niveau parent, interpolée
+	 * entre les vertices voisins si le vertice n'existe pas dans le parent.
+	 */
+	float morphHeight; // 4
 
 	Vertex(VertexZoneInfo *info,
 		   short relx, short rely,
@@ -192,9 +170,7 @@ struct KX_Chunk::Vertex
 		   unsigned int origindex)
 		:vertexInfo(info),
 		origIndex(origindex),
-		vertIndex(-1),
-		valid(true),
-		validNormal(false)
+		vertIndex(-1)
 	{
 		info->AddRef();
 		relativePos[0] = relx;
@@ -206,28 +182,65 @@ struct KX_Chunk::Vertex
 		normal[0] = 0.0f;
 		normal[1] = 0.0f;
 		normal[2] = -1.0f;
+
+		morphHeight = info->height;
 	}
 
 	~Vertex()
 	{
 		vertexInfo->Release();
 	}
-
-	void SetValid(bool v)
-	{
-		valid = v;
-	}
 };
 
+unsigned int KX_Chunk::GetVertexesMemorySize(unsigned short vertexCount)
+{
+	return sizeof(Vertex) * vertexCount * vertexCount;
+}
+
+KX_Chunk::Vertex *KX_Chunk::GetVertex(unsigned short x, unsigned short y) const
+{
+	return &m_vertexesBlock[x * m_vertexCount + y];
+}
+
 KX_Chunk::KX_Chunk(KX_ChunkNode *node, RAS_MaterialBucket *bucket)
 	:m_node(node),
+	m_terrain(node->GetTerrain()),
+	m_relativePos(node->GetRelativePos()),
+	m_relativeSize(node->GetRelativeSize()),
+	m_vertexCount(m_terrain->GetVertexCount()),
+	m_polyCount(m_terrain->GetPolyCount()),
 	m_bucket(bucket),
 	m_meshObj(NULL),
 	m_physicsController(NULL),
+	m_heights(NULL),
+	m_borderHeights(NULL),
+	m_physicsHeights(NULL),
 	m_visible(true),
+	m_vertexesBlock(NULL),
 	m_hasVertexes(false),
-	m_onConstruct(false)
+	m_onConstruct(false),
+	m_vertexesState(VERTEXES_NONE),
+	m_vertexesCanceled(0),
+	m_vertexCreatingTime(0.0),
+	m_normalComputingTime(0.0),
+	m_buildRequestTime(KX_Terrain::GetTime()),
+	m_buildPriority(0.0f),
+	m_morphStartTime(-1.0),
+	m_morphed(false),
+	m_occluderResolution(min_ii(OCCLUDER_RESOLUTION, m_polyCount)),
+	m_occluded(false),
+	m_meshMemory(0),
+	m_physicsMemory(0),
+	m_evicted(false),
+	m_lastUsedFrame(0),
+	m_invalidated(false),
+	m_refreshQueued(false),
+	m_heightsModified(false)
 {
+	// Le chunk du noeud parent est affiché jusqu'à la fin de la construction de ce chunk.
+	KX_ChunkNode *parentNode = m_node->GetParentNode();
+	m_useTimeMorph = (parentNode && parentNode->GetChunk() && parentNode->GetChunk()->GetMeshReady());
+
 	for (unsigned short columnIndex = COLUMN_LEFT; columnIndex <= COLUMN_BACK; ++columnIndex) {
 		// Initialisation des niveaux de jointure.
 		m_lastHasJoint[columnIndex] = 0;
@@ -238,29 +251,11 @@ KX_Chunk::KX_Chunk(KX_ChunkNode *node, RAS_MaterialBucket *bucket)
 	m_chunkActive++;
 
 	const MT_Point2& nodepos = m_node->GetRealPos();
-	const KX_ChunkNode::Point2D& relativePos = m_node->GetRelativePos();
-	const unsigned short halfrelativesize = m_node->GetRelativeSize() / 2.0f;
 
 	m_meshMatrix[0] = 1.0f; m_meshMatrix[4] = 0.0f; m_meshMatrix[8] = 0.0f; m_meshMatrix[12] = nodepos.x();
 	m_meshMatrix[1] = 0.0f; m_meshMatrix[5] = 1.0f; m_meshMatrix[9] = 0.0f; m_meshMatrix[13] = nodepos.y();
 	m_meshMatrix[2] = 0.0f; m_meshMatrix[6] = 0.0f; m_meshMatrix[10] = 1.0f; m_meshMatrix[14] = 0.0f;
 	m_meshMatrix[3] = 0.0f; m_meshMatrix[7] = 0.0f; m_meshMatrix[11] = 0.0f; m_meshMatrix[15] = 1.0f;
-
-	// Initialisation des noeuds parent de ce noeud et du noeud de adjacent.
-	m_parentJointNodes[COLUMN_LEFT] = m_node->GetAdjacentParentNode(-1, 0);
-	m_parentJointNodes[COLUMN_RIGHT] = m_node->GetAdjacentParentNode(1, 0);
-	m_parentJointNodes[COLUMN_FRONT] = m_node->GetAdjacentParentNode(0, -1);
-	m_parentJointNodes[COLUMN_BACK] = m_node->GetAdjacentParentNode(0, 1);
-
-	// Initialisation de la position de 4 noeud adjacent.
-	m_jointNodePosition[COLUMN_LEFT][0] = relativePos.x - halfrelativesize - 1;
-	m_jointNodePosition[COLUMN_RIGHT][0] = relativePos.x + halfrelativesize + 1;
-	m_jointNodePosition[COLUMN_FRONT][0] = relativePos.x;
-	m_jointNodePosition[COLUMN_BACK][0] = relativePos.x;
-	m_jointNodePosition[COLUMN_LEFT][1] = relativePos.y;
-	m_jointNodePosition[COLUMN_RIGHT][1] = relativePos.y;
-	m_jointNodePosition[COLUMN_FRONT][1] = relativePos.y - halfrelativesize - 1;
-	m_jointNodePosition[COLUMN_BACK][1] = relativePos.y + halfrelativesize + 1;
 }
 
 KX_Chunk::~KX_Chunk()
@@ -268,16 +263,31 @@ KX_Chunk::~KX_Chunk()
 	DestructMesh();
 
 	if (m_hasVertexes) {
-		for (unsigned short i = 0; i < VERTEX_COUNT; ++i) {
-			for (unsigned short j = 0; j < VERTEX_COUNT; ++j) {
-				delete m_vertexes[i][j];
+		for (unsigned short i = 0; i < m_vertexCount; ++i) {
+			for (unsigned short j = 0; j < m_vertexCount; ++j) {
+				GetVertex(i, j)->~Vertex();
 			}
 		}
 	}
 
+	// Le bloc est rendu à l'allocateur pour les prochains chunks.
+	if (m_vertexesBlock) {
+		m_terrain->GetVertexPool()->Free(m_vertexesBlock);
+	}
+
 	if (m_physicsController)
 		delete m_physicsController;
 
+	// La forme physique lit les hauteurs jusqu'à sa suppression.
+	if (m_physicsHeights && m_physicsHeights != m_heights)
+		delete[] m_physicsHeights;
+
+	if (m_heights)
+		delete[] m_heights;
+
+	if (m_borderHeights)
+		delete[] m_borderHeights;
+
 	m_chunkActive--;
 }
 
@@ -302,52 +312,112 @@ void KX_Chunk::DestructMesh()
 	}
 }
 
+void KX_Chunk::SetVertexesScheduled()
+{
+	m_vertexesState = VERTEXES_SCHEDULED;
+	m_refreshQueued = false;
+}
+
+void KX_Chunk::CancelVertexes()
+{
+	atomic_cas_uint32(&m_vertexesCanceled, 0, 1);
+}
+
+KX_Chunk::VERTEXES_STATE KX_Chunk::GetVertexesState() const
+{
+	/* L'addition atomique de zero sert de barrière mémoire, tout ce qui a
+	 * était écrit par le thread de travail avant de changer l'état est visible.
+	 */
+	return (VERTEXES_STATE)atomic_add_uint32((unsigned int *)&m_vertexesState, 0);
+}
+
+bool KX_Chunk::GetUseMeshPhysics() const
+{
+#ifdef WITH_BULLET
+	return !m_terrain->GetUseCollisionTiles() && m_node->GetLevel() >= m_terrain->GetMinPhysicsLevel() &&
+		   !m_terrain->GetUseHeightfieldPhysics();
+#else
+	return false;
+#endif
+}
+
 void KX_Chunk::ConstructPhysicsController()
 {
+	KX_PROFILE_ZONE("Chunk ConstructPhysicsController");
+
 	KX_Terrain *terrain = m_node->GetTerrain();
 
-	if (m_node->GetLevel() < terrain->GetMinPhysicsLevel())
+	/* Avec les tuiles de collision les formes physiques ne dépendent
+	 * pas des chunks de rendu.
+	 */
+	if (terrain->GetUseCollisionTiles() || m_node->GetLevel() < terrain->GetMinPhysicsLevel())
 		return;
 
 #ifdef WITH_BULLET
-	Material *material = terrain->GetBlenderMaterial();
-
 	CcdPhysicsController *phyCtrl = (CcdPhysicsController *)m_physicsController;
-	CcdPhysicsEnvironment *phyEnv = (CcdPhysicsEnvironment *)terrain->GetScene()->GetPhysicsEnvironment();
 
-	CcdShapeConstructionInfo *shapeInfo = phyCtrl ? 
-				phyCtrl->GetShapeInfo() : new CcdShapeConstructionInfo();
+	CcdShapeConstructionInfo *shapeInfo = NULL;
+	btCollisionShape *shape = NULL;
+	// La position en hauteur de l'origine de la forme physique.
+	float offsetZ = 0.0f;
 
-	shapeInfo->m_shapeType = PHY_SHAPE_MESH;
-	// On met a jour le mesh de la forme physique.
-	shapeInfo->UpdateMesh(NULL, m_meshObj);
+	if (terrain->GetUseHeightfieldPhysics()) {
+		/* Le champ de hauteur ne dépend pas des jointures, il est construit une seule
+		 * fois sauf si une zone a modifié les hauteurs du chunk ou si les vertices
+		 * ont été reconstruits dans un nouveau tableau après une éviction.
+		 */
+		if (phyCtrl) {
+			if (!m_heightsModified && m_physicsHeights == m_heights) {
+				return;
+			}
+			// La position du champ de hauteur dépend aussi des hauteurs, on recréer le controlleur.
+			delete phyCtrl;
+			phyCtrl = NULL;
+			m_physicsController = NULL;
+			// Les anciennes hauteurs ne sont plus lues par aucune forme.
+			if (m_physicsHeights != m_heights) {
+				delete[] m_physicsHeights;
+			}
+		}
 
-	// Puis on créer la forme physique.
-	btCollisionShape *shape = shapeInfo->CreateBulletShape(0.0f);
+		// La forme lit les hauteurs des vertices sans copie.
+		m_physicsHeights = m_heights;
 
-	// Si le controlleur physique n'existe pas alors on le créer.
-	if (!phyCtrl) {
-		CcdConstructionInfo ci;
+		const float interval = terrain->GetChunkSize() * m_relativeSize / m_polyCount;
+		shape = terrain->NewHeightfieldShape(m_physicsHeights, interval, m_minVertexHeight, m_maxVertexHeight);
+		offsetZ = (m_minVertexHeight + m_maxVertexHeight) / 2.0f;
+
+		// Les hauteurs sont comptées avec les vertices.
+		m_physicsMemory = sizeof(btHeightfieldTerrainShape);
+	}
+	else {
+		shapeInfo = phyCtrl ? phyCtrl->GetShapeInfo() : new CcdShapeConstructionInfo();
 
-		ci.m_collisionShape = shape;
-		ci.m_shapeInfo = shapeInfo;
-		ci.m_MotionState = new KX_ChunkMotionState(m_node);
-		ci.m_physicsEnv = phyEnv;
-		ci.m_fh_damping = material->xyfrict;
-		ci.m_fh_distance = material->fhdist;
-		ci.m_fh_spring = material->fh;
-		ci.m_friction = material->friction;
-		ci.m_restitution = material->reflect;
-		ci.m_collisionFilterMask = CcdConstructionInfo::AllFilter ^ CcdConstructionInfo::StaticFilter;
-		ci.m_collisionFilterGroup = CcdConstructionInfo::StaticFilter;
+		shapeInfo->m_shapeType = PHY_SHAPE_MESH;
+		// On met a jour le mesh de la forme physique.
+		shapeInfo->UpdateMesh(NULL, m_meshObj);
 
-		phyCtrl = new CcdPhysicsController(ci);
-		phyCtrl->SetNewClientInfo(terrain->getClientInfo());
+		// Puis on créer la forme physique.
+		shape = shapeInfo->CreateBulletShape(0.0f);
+
+		/* Les vertices et les faces copiés par la forme plus une estimation de l'arbre
+		 * de collision : environ deux noeuds quantifiés de 16 octets par triangle.
+		 */
+		const unsigned int triangleCount = shapeInfo->m_triFaceArray.size() / 3;
+		m_physicsMemory = shapeInfo->m_vertexArray.size() * sizeof(btScalar) +
+						  (shapeInfo->m_triFaceArray.size() + shapeInfo->m_polygonIndexArray.size()) * sizeof(int) +
+						  triangleCount * 32;
+	}
 
-		// Puis on l'ajoute dans l'environnement physique.
-		phyEnv->AddCcdPhysicsController(phyCtrl);
+	// Si le controlleur physique n'existe pas alors on le créer.
+	if (!phyCtrl) {
+		const MT_Point2& realPos = m_node->GetRealPos();
+		phyCtrl = (CcdPhysicsController *)terrain->NewPhysicsController(shape, shapeInfo,
+																		MT_Point3(realPos.x(), realPos.y(), offsetZ));
 
-		shapeInfo->Release();
+		if (shapeInfo) {
+			shapeInfo->Release();
+		}
 	}
 	else {
 		/* Sinon si le controlleur physique existe déjà on remplace juste
@@ -360,135 +430,85 @@ void KX_Chunk::ConstructPhysicsController()
 #endif
 }
 
-KX_Chunk::Vertex *KX_Chunk::NewVertex(unsigned short relx, unsigned short rely)
+KX_Chunk::Vertex *KX_Chunk::NewVertex(unsigned short relx, unsigned short rely, VertexZoneInfo *info)
 {
-	KX_Terrain *terrain = m_node->GetTerrain();
+	KX_Terrain *terrain = m_terrain;
 	//La taille "réelle" du chunk
 	const float size = terrain->GetChunkSize();
 
-	const unsigned short relativesize = m_node->GetRelativeSize();
+	const unsigned short relativesize = m_relativeSize;
 	//Calcul de l'intervalle entre deux points
-	const float interval = size * relativesize / POLY_COUNT;
+	const float interval = size * relativesize / m_polyCount;
 	// la motie de la largeur du chunk
 	const float width = size / 2 * relativesize;
 
-	const KX_ChunkNode::Point2D terrainVertexPos = GetTerrainRelativeVertexPosition(relx, rely);
-	// toutes les informations sur le vertice dut au zone : la hauteur, sa couleur
-	VertexZoneInfo *info = terrain->GetVertexInfo(terrainVertexPos.x, terrainVertexPos.y);
-	const float vertz = info->height;
-
-	if (m_requestCreateBox) {
-		m_maxVertexHeight = vertz;
-		m_minVertexHeight = vertz;
-		m_requestCreateBox = false;
-	}
-	else {
-		m_maxVertexHeight = max_ff(m_maxVertexHeight, vertz);
-		m_minVertexHeight = min_ff(m_minVertexHeight, vertz);
-	}
+	ExtendHeightBox(info->height);
 
 	const float vertx = relx * interval - width;
 	const float verty = rely * interval - width;
-	Vertex *vertex = new Vertex(info, relx, rely, vertx, verty, m_originVertexIndex++);
+	Vertex *vertex = new(&m_vertexesBlock[relx * m_vertexCount + rely]) Vertex(info, relx, rely, vertx, verty, m_originVertexIndex++);
 	info->Release();
 
 	return vertex;
 }
 
-/* Cette fonction permet d'acceder à un vertice comme si ils étaient
- * stockés dans un tableau à deux dimension pour les x et y.
- * C'est très utile pour le calcule des normales.
- */
-KX_Chunk::Vertex *KX_Chunk::GetVertexByChunkRelativePosition(short x, short y) const
+void KX_Chunk::ExtendHeightBox(float height)
 {
-	if (x < 0 || y < 0 || x > POLY_COUNT || y > POLY_COUNT) {
-		return NULL;
+	if (m_requestCreateBox) {
+		m_maxVertexHeight = height;
+		m_minVertexHeight = height;
+		m_requestCreateBox = false;
+	}
+	else {
+		m_maxVertexHeight = max_ff(m_maxVertexHeight, height);
+		m_minVertexHeight = min_ff(m_minVertexHeight, height);
 	}
-	return m_vertexes[x][y];
-}
-
-KX_Chunk::Vertex *KX_Chunk::GetVertexByTerrainRelativePosition(int x, int y) const
-{
-	const unsigned short size = m_node->GetRelativeSize();
-	const unsigned short halfsize = size / 2;
-
-	/* Le facteur pour passer de la position d'un noeud à celle d'un vertice absolue,
-	 * 2 = la taille minimun d'un noeud.
-	 */
-	const float scale = ((float)POLY_COUNT) / 2.0f;
-
-	const KX_ChunkNode::Point2D nodepos = m_node->GetRelativePos();
-
-	// le bas du chunk par rapport au terrain * 2 pour les vertices
-	const int bottomx = nodepos.x * scale - size;
-	const int bottomy = nodepos.y * scale - size;
-
-	const unsigned short diffx = (x - bottomx) / halfsize;
-	const unsigned short diffy = (y - bottomy) / halfsize;
-
-	return GetVertexByChunkRelativePosition(diffx, diffy);
 }
 
-KX_ChunkNode::Point2D KX_Chunk::GetTerrainRelativeVertexPosition(unsigned short x, unsigned short y) const
+KX_ChunkNode::Point2D KX_Chunk::GetTerrainRelativeVertexPosition(short x, short y) const
 {
-	const unsigned short size = m_node->GetRelativeSize();
+	const unsigned short size = m_relativeSize;
 	const unsigned short halfsize = size / 2;
 
 	/* Le facteur pour passer de la position d'un noeud à celle d'un vertice absolue,
 	 * 2 = la taille minimun d'un noeud.
 	 */
-	const float scale = ((float)POLY_COUNT) / 2.0f;
+	const float scale = ((float)m_polyCount) / 2.0f;
 
-	const KX_ChunkNode::Point2D nodepos = m_node->GetRelativePos();
+	const KX_ChunkNode::Point2D& nodepos = m_relativePos;
 
+	// la moitié de la largeur du chunk en vertices
+	const int halfwidth = size * m_polyCount / 4;
 	// le bas du chunk par rapport au terrain * 2 pour les vertices
-	const int bottomx = nodepos.x * scale - size;
-	const int bottomy = nodepos.y * scale - size;
+	const int bottomx = nodepos.x * scale - halfwidth;
+	const int bottomy = nodepos.y * scale - halfwidth;
 
 	return KX_ChunkNode::Point2D(bottomx + x * halfsize, bottomy + y * halfsize);
 }
 
-/* On calcule la normale approximative d'un vertice. Pour cela on
- * fait la normale d'un quadrilatère de quatre point autour du vertice
- *
- *      1
- *      |
- *      |
- * 2−−−−C−−−−0
- *      |
- *      |
- *      3
- * C : centre du quadrilatère soit le vertice envoyé
- *
- * Ces quatre points doivent être des vertices déjà existant.
+/* Les vertices d'indice pair existent aussi dans le chunk parent, les autres sont
+ * sur une arête du maillage parent, ceux d'indices impairs en x et y sont sur la
+ * diagonale de la face comme dans ConstructPolygones.
  */
-void KX_Chunk::SetNormal(Vertex *vertexCenter) const
+void KX_Chunk::ComputeMorphHeights()
 {
-	// le quadrilatère
-	float quad[4][3];
-
-	/* Si le vertice n'est pas un vertice adjacent il suffit de
-	 * recupérer les 4 vertice autour.
-	 */
-	// la position relative du vertice
-	const unsigned short relx = vertexCenter->relativePos[0];
-	const unsigned short rely = vertexCenter->relativePos[1];
-
-	// on trouve les 4 vertices adjacents
-	Vertex *vertexes[4] = {
-		GetVertexByChunkRelativePosition(relx + 1, rely),
-		GetVertexByChunkRelativePosition(relx, rely + 1),
-		GetVertexByChunkRelativePosition(relx - 1, rely),
-		GetVertexByChunkRelativePosition(relx, rely - 1)
-	};
-	// Puis pour chaque vertice on copie sa position en 3d
-	for (unsigned short i = 0; i < 4; ++i) {
-		quad[i][0] = vertexes[i]->absolutePos[0];
-		quad[i][1] = vertexes[i]->absolutePos[1];
-		quad[i][2] = vertexes[i]->vertexInfo->height;
+	for (unsigned short x = 0; x < m_vertexCount; ++x) {
+		for (unsigned short y = 0; y < m_vertexCount; ++y) {
+			Vertex *vertex = GetVertex(x, y);
+			const bool oddx = (x % 2);
+			const bool oddy = (y % 2);
+
+			if (oddx && oddy) {
+				vertex->morphHeight = (GetVertex(x - 1, y - 1)->vertexInfo->height + GetVertex(x + 1, y + 1)->vertexInfo->height) / 2.0f;
+			}
+			else if (oddx) {
+				vertex->morphHeight = (GetVertex(x - 1, y)->vertexInfo->height + GetVertex(x + 1, y)->vertexInfo->height) / 2.0f;
+			}
+			else if (oddy) {
+				vertex->morphHeight = (GetVertex(x, y - 1)->vertexInfo->height + GetVertex(x, y + 1)->vertexInfo->height) / 2.0f;
+			}
+		}
 	}
-
-	normal_quad_v3(vertexCenter->normal, quad[0], quad[1], quad[2], quad[3]);
 }
 
 void KX_Chunk::AddMeshPolygonVertexes(Vertex *v1, Vertex *v2, Vertex *v3, bool reverse)
@@ -496,7 +516,7 @@ void KX_Chunk::AddMeshPolygonVertexes(Vertex *v1, Vertex *v2, Vertex *v3, bool r
 	double starttime;
 	double endtime;
 
-	starttime = KX_GetActiveEngine()->GetRealTime();
+	starttime = KX_Terrain::GetTime();
 
 	RAS_Polygon* poly = m_meshObj->AddPolygon(m_bucket, 3);
 
@@ -504,9 +524,9 @@ void KX_Chunk::AddMeshPolygonVertexes(Vertex *v1, Vertex *v2, Vertex *v3, bool r
 	poly->SetCollider(true);
 	poly->SetTwoside(true);
 
-	endtime = KX_GetActiveEngine()->GetRealTime();
+	endtime = KX_Terrain::GetTime();
 	polyAddingTime += endtime - starttime;
-	starttime = KX_GetActiveEngine()->GetRealTime();
+	starttime = KX_Terrain::GetTime();
 
 	const MT_Vector4 tangent(0.0f, 0.0f, 0.0f, 0.0f);
 
@@ -534,9 +554,9 @@ void KX_Chunk::AddMeshPolygonVertexes(Vertex *v1, Vertex *v2, Vertex *v3, bool r
 		m_meshObj->AddPolygonVertex(poly, 2, v3->vertIndex);
 	}
 
-	endtime = KX_GetActiveEngine()->GetRealTime();
+	endtime = KX_Terrain::GetTime();
 	vertexAddingTime += endtime - starttime;
-	starttime = KX_GetActiveEngine()->GetRealTime();
+	starttime = KX_Terrain::GetTime();
 }
 
 void KX_Chunk::ConstructVertexes()
@@ -544,6 +564,14 @@ void KX_Chunk::ConstructVertexes()
 	double starttime;
 	double endtime;
 
+	/* Le chunk a était supprimé avant que la construction commence,
+	 * on indique juste qu'il peut être détruit.
+	 */
+	if (atomic_add_uint32(&m_vertexesCanceled, 0)) {
+		atomic_cas_uint32(&m_vertexesState, VERTEXES_SCHEDULED, VERTEXES_READY);
+		return;
+	}
+
 	/* Schéma global de l'organisation des faces dans le chunk
 	 * Attention la colonne "BACK" est inversé avec la colonne "FRONT"
 	 * 
@@ -571,7 +599,7 @@ void KX_Chunk::ConstructVertexes()
 	 * u = unique, vertice independant
 	 */
 
-	starttime = KX_GetActiveEngine()->GetRealTime();
+	starttime = KX_Terrain::GetTime();
 
 	/* On met à zero le numéro actuelle de vertices, à chaque fois que l'on ajoute un vertice
 	 * cette variable est incrementé de 1, puis on la reutilise pour allouer le tableau de vertices
@@ -581,547 +609,412 @@ void KX_Chunk::ConstructVertexes()
 
 	m_requestCreateBox = true;
 
-	/** On construit tous les vertices et on stocke leur numero dans des colonnes et 
-	 * dans le tableau de tous les vertices
-	 */
-	for(unsigned short columnIndex = 0; columnIndex < VERTEX_COUNT; ++columnIndex) {
-		for(unsigned short vertexIndex = 0; vertexIndex < VERTEX_COUNT ; ++vertexIndex) {
-			// on créer un vertice temporaire, ces donné seront reutilisé lors de la création des polygones
-			Vertex *vertex = NewVertex(columnIndex, vertexIndex);
-			m_vertexes[columnIndex][vertexIndex] = vertex;
-
-			if (columnIndex == 0) {
-				m_columns[COLUMN_LEFT][vertexIndex] = vertex;
-			}
-			else if (columnIndex == POLY_COUNT) {
-				m_columns[COLUMN_RIGHT][vertexIndex] = vertex;
-			}
+	m_vertexesBlock = (Vertex *)m_terrain->GetVertexPool()->Alloc();
 
-			if (vertexIndex == 0) {
-				m_columns[COLUMN_BACK][columnIndex] = vertex;
-			}
-			else if (vertexIndex == POLY_COUNT) {
-				m_columns[COLUMN_FRONT][columnIndex] = vertex;
+	/* La grille des vertices est entourée d'une bordure d'un vertice appartenant aux
+	 * chunks voisins de même taille, ses hauteurs servent au calcul des normales.
+	 */
+	const unsigned short paddedCount = m_vertexCount + 2;
+	const unsigned int vertexCount = paddedCount * paddedCount;
+	std::vector<VertexZoneInfo *> infos(vertexCount);
+	GetPaddedVertexInfos(&infos[0]);
+
+	m_heights = new float[m_vertexCount * m_vertexCount];
+	m_borderHeights = new float[m_vertexCount * 4];
+
+	// On construit tous les vertices dans le bloc, seules les hauteurs de la bordure sont gardées.
+	for(unsigned short columnIndex = 0; columnIndex < paddedCount; ++columnIndex) {
+		for(unsigned short vertexIndex = 0; vertexIndex < paddedCount ; ++vertexIndex) {
+			VertexZoneInfo *info = infos[columnIndex * paddedCount + vertexIndex];
+			SetPaddedHeight(columnIndex - 1, vertexIndex - 1, info->height);
+			if (columnIndex == 0 || vertexIndex == 0 || columnIndex == (paddedCount - 1) || vertexIndex == (paddedCount - 1)) {
+				info->Release();
+				continue;
 			}
+			// on créer un vertice temporaire, ces donné seront reutilisé lors de la création des polygones
+			NewVertex(columnIndex - 1, vertexIndex - 1, info);
 		}
 	}
 
-	endtime = KX_GetActiveEngine()->GetRealTime();
-	vertexCreatingTime += endtime - starttime;
-	starttime = KX_GetActiveEngine()->GetRealTime();
+	endtime = KX_Terrain::GetTime();
+	m_vertexCreatingTime = endtime - starttime;
+	starttime = KX_Terrain::GetTime();
 
-	for (unsigned short columnIndex = 1; columnIndex < VERTEX_COUNT_INTERN; ++columnIndex) {
-		for (unsigned short vertexIndex = 1; vertexIndex < VERTEX_COUNT_INTERN; ++vertexIndex) {
-			SetNormal(m_vertexes[columnIndex][vertexIndex]);
-		}
-	}
+	ComputeNormals();
+
+	ComputeMorphHeights();
 
-	endtime = KX_GetActiveEngine()->GetRealTime();
-	normalComputingTime += endtime - starttime;
+	endtime = KX_Terrain::GetTime();
+	m_normalComputingTime = endtime - starttime;
+
+	m_hasVertexes = true;
+	// Les vertices sont maintenant utilisables par le thread principal.
+	atomic_cas_uint32(&m_vertexesState, VERTEXES_SCHEDULED, VERTEXES_READY);
 }
 
-/* On accede au vertice dans le chunk voisin le plus proche et alignée
- * au vertice referent.
- */
-void KX_Chunk::GetCoorespondingVertexesFromChunk(KX_ChunkNode *jointNode, Vertex *origVertex, COLUMN_TYPE columnType, 
-												 Vertex **coExternVertex, Vertex **coInternVertex)
+void KX_Chunk::GetPaddedVertexInfos(VertexZoneInfo **r_infos) const
 {
-	// La position du vertice par rapport au terrain
-	KX_ChunkNode::Point2D terrainVertexPos = GetTerrainRelativeVertexPosition(origVertex->relativePos[0], origVertex->relativePos[1]);
-
-	if (GetVertexByTerrainRelativePosition(terrainVertexPos.x, terrainVertexPos.y) != origVertex) {
-		DEBUG("can't refind the same vertex by terrain position");
-	}
-	KX_Chunk *jointChunk = jointNode->GetChunk();
-	if (!jointChunk) {
-		return;
+	const unsigned short paddedCount = m_vertexCount + 2;
+	const unsigned int vertexCount = paddedCount * paddedCount;
+	std::vector<int> terrainVertexX(vertexCount);
+	std::vector<int> terrainVertexY(vertexCount);
+
+	for (unsigned short columnIndex = 0; columnIndex < paddedCount; ++columnIndex) {
+		for (unsigned short vertexIndex = 0; vertexIndex < paddedCount; ++vertexIndex) {
+			const KX_ChunkNode::Point2D terrainVertexPos = GetTerrainRelativeVertexPosition(columnIndex - 1, vertexIndex - 1);
+			terrainVertexX[columnIndex * paddedCount + vertexIndex] = terrainVertexPos.x;
+			terrainVertexY[columnIndex * paddedCount + vertexIndex] = terrainVertexPos.y;
+		}
 	}
 
-	/** Ce vertice est à la même position que celui entrain de calculer la normale.
-	 * Donc pour optimiser on copiera la normale.
+	/* toutes les informations sur les vertices dut aux zones : la hauteur, la couleur,
+	 * calculées pour toute la grille du chunk et sa bordure en une fois.
 	 */
-	Vertex *externVertex = jointChunk->GetVertexByTerrainRelativePosition(terrainVertexPos.x, terrainVertexPos.y);
-
-	bool debugErrors = m_node->GetTerrain()->GetDebugMode() & DEBUG_ERRORS;
-	if (!externVertex) {
-		if (debugErrors) {
-			DEBUG("Error : none extern coresponding vertex");
-		}
-		return;
-	}
+	m_terrain->GetVertexInfos(vertexCount, &terrainVertexX[0], &terrainVertexY[0], r_infos);
+}
 
-	if (coExternVertex)
-		(*coExternVertex) = externVertex;
+/* Les normales sont calculées par différences centrées sur la grille entourée de sa
+ * bordure, une seule passe sur un tableau contigu sans accès aux chunks voisins.
+ * Deux chunks de même taille utilisent les mêmes hauteurs pour leurs vertices communs
+ * et ont donc les mêmes normales sur leurs bords.
+ */
+void KX_Chunk::ComputeNormals()
+{
+	KX_PROFILE_ZONE("Chunk ComputeNormals");
 
-	if (externVertex->vertexInfo->pos[0] != origVertex->vertexInfo->pos[0] || 
-		externVertex->vertexInfo->pos[1] != origVertex->vertexInfo->pos[1])
-	{
-// 		if (debugErrors) {
-			DEBUG("Error : wrong extern coresponding vertex, " << 
-				origVertex->vertexInfo->pos[0] << ", " << origVertex->vertexInfo->pos[1] << ", " <<
-				externVertex->vertexInfo->pos[0] << ", " << externVertex->vertexInfo->pos[1]
-			);
-// 		}
-		return;
-	}
+	const float factor = GetNormalFactor(m_polyCount, m_terrain->GetChunkSize(), m_relativeSize);
 
-	if (coInternVertex) {
-		if (!externVertex) {
-			if (debugErrors) {
-				DEBUG("Error : can't compute intern vertex");
-			}
-			return;
+	for (unsigned short x = 0; x < m_vertexCount; ++x) {
+		Vertex *column = GetVertex(x, 0);
+		for (unsigned short y = 0; y < m_vertexCount; ++y) {
+			ComputeGridNormal(m_heights, m_borderHeights, m_vertexCount, x, y, factor, column[y].normal);
 		}
-
-		const COLUMN_TYPE opposedColumn = OppositeColumn(columnType);
-		// la colonne adjacent au bas de la colonne opposée.
-		const COLUMN_TYPE backColumn = BackColumn(opposedColumn);
-		// la colonne adjacent au bas de la colonne opposée.
-		const COLUMN_TYPE frontColumn = FrontColumn(opposedColumn);
-
-		const unsigned short frontColumnVertexRatio = jointChunk->GetColumnVertexInterval(frontColumn);
-		const unsigned short backColumnVertexRatio = jointChunk->GetColumnVertexInterval(backColumn);
-
-		short x = externVertex->relativePos[0];
-		short y = externVertex->relativePos[1];
-
-		const unsigned short vertexIndex = (ColumnAxis(opposedColumn) == 0) ? x : y;
-
-		const bool onFront = (vertexIndex == 0);
-		const bool onBack = (vertexIndex == POLY_COUNT);
-
-		// Le decalage en vertice par rapport a terrain.
-		const unsigned short vertexRatio = onFront ? frontColumnVertexRatio : (onBack ? backColumnVertexRatio : 1);
-
-		// Puis on decale cette position vers l'interieur.
-		MoveVectorToCenterColumn(opposedColumn, x, y, vertexRatio);
-		(*coInternVertex) = jointChunk->GetVertexByChunkRelativePosition(x, y);
 	}
 }
 
-void KX_Chunk::ComputeColumnJointVertexNormal(COLUMN_TYPE columnType, bool reverse)
+float KX_Chunk::GetNormalFactor(unsigned short polyCount, float chunkSize, unsigned short relativeSize)
 {
-	// Passage du vertice au noeud, 4 = nombre de noeuds adjacents par une ligne.
-	const float scaleVertexToNode = 4.0f / POLY_COUNT;
-	// La colonne adjacente au sommet de cette colonne.
-	const COLUMN_TYPE backColumn = BackColumn(columnType);
-	// La colonne adjacente au bas de cette colonne.
-	const COLUMN_TYPE frontColumn = FrontColumn(columnType);
-	// Le numero de noeud sur les colonnes adjacentes.
-	const unsigned short backFrontNodeIndex = (columnType == COLUMN_LEFT || columnType == COLUMN_FRONT) ?
-											  1 : (POLY_COUNT * scaleVertexToNode);
-	// Le noeud adjacent au haut de la colonne.
-	KX_ChunkNode *backNode = m_jointNode[backColumn][backFrontNodeIndex];
-	// Le noeud adjacent au bas de la colonne.
-	KX_ChunkNode *frontNode = m_jointNode[frontColumn][backFrontNodeIndex];
-
-	// Le ratio de vertices sur une jointure 2/5 4/5 ect…
-	const unsigned short vertexRatio = GetColumnVertexInterval(columnType);
-	// Le ratio de vertices pour la colonne frontal.
-	const unsigned short frontVertexRatio = GetColumnVertexInterval(frontColumn);
-	// Le ratio de vertices pour la colonne arrière.
-	const unsigned short backVertexRatio = GetColumnVertexInterval(backColumn);
-
-	for (unsigned short vertexIndex = (columnType == COLUMN_LEFT || columnType == COLUMN_RIGHT) ? 0 : 1;
-		 vertexIndex < ((columnType == COLUMN_LEFT || columnType == COLUMN_RIGHT) ? VERTEX_COUNT : POLY_COUNT);
-		 ++vertexIndex)
-	{
-		Vertex *vertex = m_columns[columnType][vertexIndex];
-		/*if (!vertex->valid || vertex->validNormal) {
-			DEBUG("invalid vertex");
-			continue;
-		}*/
-
-		/* Le 1er et 2eme vertice utilise le même chunk.
-		 * 
-		 * ----
-		 * |  /| -- Ce chunk et commun a la colonne que de un point
-		 * |C5 |    mais sont vertice commun doit avoir la même normale.
-		 * ----v4
-		 * |  /|
-		 * |C4\|
-		 * ----v3
-		 * |  /|
-		 * |C3 |
-		 * ----v2
-		 * |  /|
-		 * |C2 |
-		 * ----v1
-		 * |  /|
-		 * |C1 |
-		 * ----v0
-		 * |  /| -- Même chose ici.
-		 * |C0 |
-		 * ----
-		 */
-
-		const unsigned short nodeIndex = vertexIndex > VERTEX_COUNT_INTERN ? 4 : vertexIndex * scaleVertexToNode + 1;
-		KX_ChunkNode *jointNode = m_jointNode[columnType][nodeIndex];
-		if (!jointNode) {
-			vertex->normal[0] = 0.0f;
-			vertex->normal[1] = 0.0f;
-			vertex->normal[2] = 1.0f;
-			continue;
-		}
-
-		bool debugErrors = m_node->GetTerrain()->GetDebugMode() & DEBUG_ERRORS;
+	/* La taille relative d'un niveau est le double de celle du niveau suivant, le facteur
+	 * d'un chunk est donc exactement la moitié de celui de ses enfants.
+	 */
+	return polyCount / (2.0f * chunkSize * relativeSize);
+}
 
-		if (std::abs(jointNode->GetLevel() - m_node->GetLevel()) > 2) {
-			if (debugErrors) {
-				DEBUG("Error : more than to level difference between to joint nodes (joint node)");
-			}
-			continue;
-		}
-		if (frontNode && std::abs(frontNode->GetLevel() - m_node->GetLevel()) > 2) {
-			if (debugErrors) {
-				DEBUG("Error : more than to level difference between to joint nodes (front node)");
-			}
-			continue;
-		}
-		if (backNode && std::abs(backNode->GetLevel() - m_node->GetLevel()) > 2) {
-			if (debugErrors) {
-				DEBUG("Error : more than to level difference between to joint nodes (back node)");
-			}
-			continue;
-		}
+void KX_Chunk::ComputeCenteredNormal(float left, float right, float front, float back, float factor, float r_normal[3])
+{
+	r_normal[0] = (left - right) * factor;
+	r_normal[1] = (front - back) * factor;
+	r_normal[2] = 1.0f;
+	normalize_v3(r_normal);
+}
 
-		// Les 4 vertices du quadrilatère.
-		Vertex *quadVertexes[4] = {NULL, NULL, NULL, NULL};
-		/* Les 4 potentielles vertices coorespondant dans les chunks voisins,
-		 * ces vertice utiliseront la même normale.
-		 */
-		Vertex *coVertexes[4] = {NULL, NULL, NULL, NULL};
-
-		// Le quadrilatère utilisé pour calculer la normale.
-		float quad[4][3];
-
-		// La position du vertice central dans le chunk.
-		const unsigned short vertx = vertex->relativePos[0];
-		const unsigned short verty = vertex->relativePos[1];
-
-		// Le vertice est à une extremitée du chunk.
-		const bool onEdge = (vertx == 0 || vertx == POLY_COUNT || verty == 0 || verty == POLY_COUNT);
-
-		const bool onColumnFront = (vertexIndex == 0);
-		const bool onColumnBack = (vertexIndex == POLY_COUNT);
-		// Le vertice est a une extremitée de la colonne.
-		const bool onColumnEdge = (onColumnFront || onColumnBack);
-
-		/* iteration des 4 vertices autour :
-		 *
-		 *        v3       sens de la colonne
-		 *        |        ^ back
-		 *        |        |
-		 * v2-----v-----v0 |
-		 *        |        |----------> vers le centre du chunk
-		 *        |        |
-		 *        v1       | front
-		 * 
-		 * - v0 est toujours vers l'interieur du chunk sont calcul est le plus simple.
-		 * - v1 et avant v dans la colonne donc entre 0 et 3, entre 1 et 3 le vertice est à
-		 * l'interieur du chunk et à 0 il est à l'exterieur.
-		 * - v3 et après v dans la colonne donc entre 1 et 4, entre 1 et 3 le vertice est à
-		 * l'interieur du chunk et à 4 il est à l'exterieur.
-		 * - v2 et toujours à l'exterieur du chunk.
-		 */
+float KX_Chunk::GetPaddedHeight(const float *heights, const float *borderHeights, unsigned short vertexCount, int x, int y)
+{
+	if (x < 0) {
+		return borderHeights[y];
+	}
+	else if (x == vertexCount) {
+		return borderHeights[vertexCount + y];
+	}
+	else if (y < 0) {
+		return borderHeights[vertexCount * 2 + x];
+	}
+	else if (y == vertexCount) {
+		return borderHeights[vertexCount * 3 + x];
+	}
+	return heights[y * vertexCount + x];
+}
 
-		// Calcul de v0.
-		{
-			short x = vertx;
-			short y = verty;
-			/* On accede au vertice plus proche du centre de 1 unité si il n'y a pas
-			 * de joint sinon du ratio de vertice sur la jointure.
-			 */
-			MoveVectorToCenterColumn(columnType, x, y, onColumnFront ? frontVertexRatio : (onColumnBack ? backVertexRatio : 1));
-			// On acced finalement au vertice le plus simplement possible.
-			quadVertexes[0] = GetVertexByChunkRelativePosition(x, y);
-		}
+void KX_Chunk::ComputeGridNormal(const float *heights, const float *borderHeights, unsigned short vertexCount,
+								 unsigned short x, unsigned short y, float factor, float r_normal[3])
+{
+	ComputeCenteredNormal(GetPaddedHeight(heights, borderHeights, vertexCount, x - 1, y),
+						  GetPaddedHeight(heights, borderHeights, vertexCount, x + 1, y),
+						  GetPaddedHeight(heights, borderHeights, vertexCount, x, y - 1),
+						  GetPaddedHeight(heights, borderHeights, vertexCount, x, y + 1),
+						  factor, r_normal);
+}
 
-		// Calcul de v1.
-		{
-			short x = vertx;
-			short y = verty;
+void KX_Chunk::SetPaddedHeight(int x, int y, float height)
+{
+	const bool borderx = (x < 0 || x == m_vertexCount);
+	const bool bordery = (y < 0 || y == m_vertexCount);
 
+	// Les coins de la bordure ne servent à aucune normale.
+	if (borderx && bordery) {
+		return;
+	}
+	else if (x < 0) {
+		m_borderHeights[y] = height;
+	}
+	else if (x == m_vertexCount) {
+		m_borderHeights[m_vertexCount + y] = height;
+	}
+	else if (y < 0) {
+		m_borderHeights[m_vertexCount * 2 + x] = height;
+	}
+	else if (y == m_vertexCount) {
+		m_borderHeights[m_vertexCount * 3 + x] = height;
+	}
+	else {
+		m_heights[y * m_vertexCount + x] = height;
+	}
+}
 
-			if (vertexIndex > 0) {
-				/* si le vertice n'est pas sur les extremitées on accede simplement au
-				 * vertice avant.
-				 */
-				MoveVectorFrontColumn(columnType, x, y, onEdge ? vertexRatio : 1);
-				quadVertexes[1] = GetVertexByChunkRelativePosition(x, y);
+/* Un vertice gardé sur un bord joint à un chunk moins subdivisé est aussi un vertice
+ * de ce chunk, sa normale est calculée avec l'écart entre vertices de ce chunk pour
+ * être identique des deux côtés. Les hauteurs nécessaires sont en dehors de la
+ * bordure et sont demandées au terrain, elles sont en général dans le cache.
+ */
+void KX_Chunk::ComputeJointVertexesNormal()
+{
+	// Les intervalles des bords x = 0, x = m_polyCount, y = 0 et y = m_polyCount comme dans ConstructPolygones.
+	const unsigned short intervals[4] = {
+		GetColumnVertexInterval(COLUMN_LEFT),
+		GetColumnVertexInterval(COLUMN_RIGHT),
+		GetColumnVertexInterval(COLUMN_FRONT),
+		GetColumnVertexInterval(COLUMN_BACK)
+	};
 
-			}
-			else if (frontNode)
-				GetCoorespondingVertexesFromChunk(frontNode, vertex, frontColumn, coVertexes, quadVertexes + 1);
-		}
+	const unsigned short halfsize = m_relativeSize / 2;
+	const float factor = GetNormalFactor(m_polyCount, m_terrain->GetChunkSize(), m_relativeSize);
 
-		// Calcul de v2
-		{
-			if (jointNode)
-				GetCoorespondingVertexesFromChunk(jointNode, vertex, columnType, coVertexes + 1, quadVertexes + 2);
-		}
+	std::vector<Vertex *> vertexes;
+	std::vector<unsigned short> ratios;
+	std::vector<int> x;
+	std::vector<int> y;
 
-		// Calcul de v3.
-		{
-			short x = vertx;
-			short y = verty;
-
-			if (vertexIndex < POLY_COUNT) {
-				/* si le vertice n'est pas sur les extremitées on accede simplement au
-				 * vertice après.
-				 */
-				MoveVectorBackColumn(columnType, x, y, onEdge ? vertexRatio : 1);
-				quadVertexes[3] = GetVertexByChunkRelativePosition(x, y);
+	for (unsigned short vx = 0; vx < m_vertexCount; ++vx) {
+		for (unsigned short vy = 0; vy < m_vertexCount; vy += ((vx == 0 || vx == m_polyCount) ? 1 : m_polyCount)) {
+			// Un vertice de coin prend le plus grand intervalle de ses deux bords.
+			unsigned short ratio = 1;
+			if (vx == 0) {
+				ratio = max_ii(ratio, intervals[0]);
 			}
-			else if (backNode && backNode->GetChunk())
-				GetCoorespondingVertexesFromChunk(backNode, vertex, backColumn, coVertexes + 2, quadVertexes + 3);
-		}
-
-		/** Si le vertice client et sur une extremitées il a alors 3 equivalent
-		 * (si il y'a tous les chunks autour de la colonne). On accede alors
-		 * a ce vertice equivalent.
-		 */
-		if (onColumnEdge) {
-			KX_ChunkNode *node = m_jointNode[columnType][onColumnFront ? 0 : 5];
-			if (node && node->GetChunk())
-				GetCoorespondingVertexesFromChunk(node, vertex, columnType, coVertexes + 3, NULL);
-		}
-
-		// On cherche les nombre de vertices trouvés.
-		unsigned short vertexesFound = 0;
-		for (unsigned short i = 0; i < 4; ++i) {
-			if (quadVertexes[i]) {
-				++vertexesFound;
+			else if (vx == m_polyCount) {
+				ratio = max_ii(ratio, intervals[1]);
 			}
-		}
-
-		if (vertexesFound < 2) {
-			vertex->normal[0] = 0.0f;
-			vertex->normal[1] = 0.0f;
-			vertex->normal[2] = 1.0f;
-		}
-		else if (vertexesFound == 2 || vertexesFound == 3) {
-			vertex->validNormal = true;
-
-			// Si on a que 2 vertices on ajoute le vertice du centre.
-			if (vertexesFound == 2) {
-				quad[0][0] = vertex->vertexInfo->pos[0];
-				quad[0][1] = vertex->vertexInfo->pos[1];
-				quad[0][2] = vertex->vertexInfo->height;
+			if (vy == 0) {
+				ratio = max_ii(ratio, intervals[2]);
 			}
-
-			unsigned short j = 0;
-			for (unsigned short i = 0; i < 4; ++i) {
-				if (quadVertexes[i]) {
-					quad[j][0] = quadVertexes[i]->vertexInfo->pos[0];
-					quad[j][1] = quadVertexes[i]->vertexInfo->pos[1];
-					quad[j][2] = quadVertexes[i]->vertexInfo->height;
-					++j;
-				}
+			else if (vy == m_polyCount) {
+				ratio = max_ii(ratio, intervals[3]);
 			}
 
-			if (reverse)
-				normal_tri_v3(vertex->normal, quad[0], quad[1], quad[2]);
-			else
-				normal_tri_v3(vertex->normal, quad[2], quad[1], quad[0]);
-		}
-		else if (vertexesFound == 4) {
-			vertex->validNormal = true;
-
-			for (unsigned short i = 0; i < 4; ++i) {
-				quad[i][0] = quadVertexes[i]->vertexInfo->pos[0];
-				quad[i][1] = quadVertexes[i]->vertexInfo->pos[1];
-				quad[i][2] = quadVertexes[i]->vertexInfo->height;
+			Vertex *vertex = GetVertex(vx, vy);
+			if (ratio == 1) {
+				// La normale a pu être remplacée par une jointure précédente.
+				ComputeGridNormal(m_heights, m_borderHeights, m_vertexCount, vx, vy, factor, vertex->normal);
+				continue;
 			}
 
-			if (reverse)
-				normal_quad_v3(vertex->normal, quad[0], quad[1], quad[2], quad[3]);
-			else
-				normal_quad_v3(vertex->normal, quad[3], quad[2], quad[1], quad[0]);
-		}
-
-		// On copie la normale et l'état de la normale dans tous les vertices coorespondant.
-		for (unsigned short i = 0; i < 4; ++i) {
-			Vertex *coVertex = coVertexes[i];
-			if (!coVertex)
+			// Le vertice est sauté par la jointure.
+			if ((vx % ratio) != 0 || (vy % ratio) != 0) {
 				continue;
+			}
 
-			coVertex->normal[0] = vertex->normal[0];
-			coVertex->normal[1] = vertex->normal[1];
-			coVertex->normal[2] = vertex->normal[2];
-
-			coVertex->validNormal = vertex->validNormal;
+			vertexes.push_back(vertex);
+			ratios.push_back(ratio);
+
+			const KX_ChunkNode::Point2D pos = GetTerrainRelativeVertexPosition(vx, vy);
+			const int offset = ratio * halfsize;
+			x.push_back(pos.x - offset);
+			y.push_back(pos.y);
+			x.push_back(pos.x + offset);
+			y.push_back(pos.y);
+			x.push_back(pos.x);
+			y.push_back(pos.y - offset);
+			x.push_back(pos.x);
+			y.push_back(pos.y + offset);
 		}
 	}
-}
 
-void KX_Chunk::UpdateColumnVertexesNormal(COLUMN_TYPE columnType)
-{
-	if (!m_meshObj || m_onConstruct) {
+	const unsigned int count = vertexes.size();
+	if (count == 0) {
 		return;
 	}
 
-	for (unsigned short vertexIndex = 0; vertexIndex < VERTEX_COUNT; ++vertexIndex) {
-		Vertex *vertex = m_columns[columnType][vertexIndex];
-		if (!vertex->valid)
-			continue;
-
-		RAS_TexVert *rasvert = m_meshObj->GetVertex(0, vertex->vertIndex);
-		rasvert->SetNormal(MT_Vector3(vertex->normal));
-	}
-	m_meshObj->SetMeshModified(true);
-}
-
-void KX_Chunk::ComputeJointVertexesNormal()
-{
-	GetJointColumnNodes();
+	std::vector<VertexZoneInfo *> infos(count * 4);
+	m_terrain->GetVertexInfos(count * 4, &x[0], &y[0], &infos[0]);
 
-	ComputeColumnJointVertexNormal(COLUMN_LEFT, false);
-	ComputeColumnJointVertexNormal(COLUMN_RIGHT, true);
-	ComputeColumnJointVertexNormal(COLUMN_FRONT, true);
-	ComputeColumnJointVertexNormal(COLUMN_BACK, false);
+	for (unsigned int i = 0; i < count; ++i) {
+		VertexZoneInfo **samples = &infos[i * 4];
+		/* L'intervalle est une puissance de deux, factor / ratio est exactement le facteur
+		 * du chunk voisin, la normale est identique à la sienne.
+		 */
+		ComputeCenteredNormal(samples[0]->height, samples[1]->height, samples[2]->height, samples[3]->height,
+							  factor / ratios[i], vertexes[i]->normal);
 
-	for (unsigned short columnIndex = COLUMN_LEFT; columnIndex <= COLUMN_BACK; ++columnIndex) {
-		for (unsigned short nodeIndex = 0; nodeIndex < 6; ++nodeIndex) {
-			KX_ChunkNode *node = m_jointNode[columnIndex][nodeIndex];
-			if (node && node->GetChunk()) {
-				node->GetChunk()->UpdateColumnVertexesNormal(OppositeColumn((COLUMN_TYPE)columnIndex));
-			}
+		for (unsigned short j = 0; j < 4; ++j) {
+			samples[j]->Release();
 		}
 	}
 }
 
 void KX_Chunk::InvalidateJointVertexesAndIndexes()
 {
-	// Invalidation des normales, de l'index ect.
-	for(unsigned short columnIndex = 0; columnIndex < VERTEX_COUNT; ++columnIndex) {
-		for(unsigned short vertexIndex = 0; vertexIndex < VERTEX_COUNT; ++vertexIndex) {
-			Vertex *vertex = m_vertexes[columnIndex][vertexIndex];
-			vertex->vertIndex = -1;
-			vertex->validNormal = false;
-		}
-	}
-
-	// Invalidation de certain vertices de jointures.
-	for (unsigned short columnIndex = COLUMN_LEFT; columnIndex <= COLUMN_BACK; ++columnIndex) {
-		for (unsigned short vertexIndex = (columnIndex == COLUMN_LEFT || columnIndex == COLUMN_RIGHT) ? 0 : 1;
-			 vertexIndex < ((columnIndex == COLUMN_LEFT || columnIndex == COLUMN_RIGHT) ? VERTEX_COUNT : POLY_COUNT);
-			 ++vertexIndex)
-		{
-			Vertex *vertex = m_columns[columnIndex][vertexIndex];
-			vertex->SetValid(vertexIndex % GetColumnVertexInterval((COLUMN_TYPE)columnIndex));
+	/* Invalidation de l'index, les vertices de jointures sautés
+	 * par le modèle de polygones garderont un index invalide.
+	 */
+	for(unsigned short columnIndex = 0; columnIndex < m_vertexCount; ++columnIndex) {
+		for(unsigned short vertexIndex = 0; vertexIndex < m_vertexCount; ++vertexIndex) {
+			GetVertex(columnIndex, vertexIndex)->vertIndex = -1;
 		}
 	}
 }
 
-void KX_Chunk::ConstructPolygones()
+/** Construit la liste des indices des triangles d'un chunk pour une
+ * configuration de jointures. Le centre de la grille est triangulé normalement,
+ * chaque bord est une bande entre la colonne externe où on ne garde qu'un
+ * vertice sur intervals[i] et la colonne interne complète, ce qui évite les
+ * trous avec les chunks adjacents moins subdivisés.
+ * Les bords sont dans l'ordre : x = 0, x = polyCount, y = 0, y = polyCount.
+ * Les indices sont ceux du bloc de vertices : x * vertexCount + y.
+ */
+void KX_Chunk::ConstructPolygonTemplate(unsigned short polyCount, const unsigned short intervals[4], std::vector<unsigned short>& indices)
 {
-	// on redimensione la liste des vertice partagés
-	m_meshObj->m_sharedvertex_map.resize(m_originVertexIndex);
+	const unsigned short vertexCount = polyCount + 1;
+
+	indices.clear();
+	indices.reserve(polyCount * polyCount * 6);
 
-	// puis on construit les polygones pour le centre et les jointures
-	// on lit toutes les colonnes pour créer des faces
-	for (unsigned int columnIndex = 0; columnIndex < POLY_COUNT; ++columnIndex) {
-		for (unsigned int vertexIndex = 0; vertexIndex < POLY_COUNT; ++vertexIndex) {
-			Vertex *firstVertex = m_vertexes[vertexIndex][columnIndex];
-			Vertex *secondVertex = m_vertexes[vertexIndex + 1][columnIndex];
-			Vertex *thirdVertex = m_vertexes[vertexIndex + 1][columnIndex + 1];
-			Vertex *fourthVertex = m_vertexes[vertexIndex][columnIndex + 1];
+	// Le centre de la grille, sans les bandes de bord.
+	for (unsigned int x = 1; x < (polyCount - 1); ++x) {
+		for (unsigned int y = 1; y < (polyCount - 1); ++y) {
+			const unsigned short first = x * vertexCount + y;
+			const unsigned short second = (x + 1) * vertexCount + y;
+			const unsigned short third = (x + 1) * vertexCount + y + 1;
+			const unsigned short fourth = x * vertexCount + y + 1;
 
 			// création du premier triangle
-			AddMeshPolygonVertexes(firstVertex, secondVertex, thirdVertex, false);
+			indices.push_back(first);
+			indices.push_back(second);
+			indices.push_back(third);
 			// création du deuxieme triangle
-			AddMeshPolygonVertexes(firstVertex, thirdVertex, fourthVertex, false);
+			indices.push_back(first);
+			indices.push_back(third);
+			indices.push_back(fourth);
 		}
 	}
-}
 
-/** Cette fonction trouve tous les noeuds adjacent au noeud de ce chunk.
- */
-void KX_Chunk::GetJointColumnNodes()
-{
-	KX_Terrain* terrain = m_node->GetTerrain();
-
-	const KX_ChunkNode::Point2D& nodepos = m_node->GetRelativePos();
-	const float relativesize = m_node->GetRelativeSize();
-	// La moitié de la taille du noeud parent.
-	const float halfrelativesize = relativesize / 2.0f;
-
-	// Les positions des noeuds adjacents, 4 par colonne.
-	float jointNodesPositions[4][4][2];
-
-	// On calcule la position de ces 16 noeuds.
-	for (unsigned short nodeIndex = 0; nodeIndex < 4; ++nodeIndex) {
-		// De gauche a droite.
-		{
-			const float y = nodepos.y - halfrelativesize + (halfrelativesize / 2.0f * nodeIndex) + halfrelativesize / 4.0f;
-			{
-				const float x = nodepos.x - (halfrelativesize * 1.25);
-				jointNodesPositions[COLUMN_LEFT][nodeIndex][0] = x;
-				jointNodesPositions[COLUMN_LEFT][nodeIndex][1] = y;
+	std::vector<unsigned short> outer;
+	std::vector<unsigned short> inner;
+	for (unsigned short side = 0; side < 4; ++side) {
+		const unsigned short interval = intervals[side];
+
+		// La colonne externe avec un vertice sur interval, la colonne interne sans ses extremités.
+		outer.clear();
+		for (unsigned short t = 0; t <= polyCount; t += interval) {
+			outer.push_back(t);
+		}
+		inner.clear();
+		for (unsigned short t = 1; t < polyCount; ++t) {
+			inner.push_back(t);
+		}
+
+		/* On avance sur les deux colonnes en même temps en créant à chaque
+		 * pas un triangle avec deux vertices d'une colonne et un de l'autre.
+		 */
+		unsigned short i = 0;
+		unsigned short j = 0;
+		while (i < (outer.size() - 1) || j < (inner.size() - 1)) {
+			unsigned short t[3];
+			unsigned short depth[3];
+			if (j == (inner.size() - 1) || (i < (outer.size() - 1) && outer[i + 1] <= inner[j + 1])) {
+				t[0] = outer[i]; depth[0] = 0;
+				t[1] = outer[i + 1]; depth[1] = 0;
+				t[2] = inner[j]; depth[2] = 1;
+				++i;
 			}
-			{
-				const float x = nodepos.x + (halfrelativesize * 1.25);
-				jointNodesPositions[COLUMN_RIGHT][nodeIndex][0] = x;
-				jointNodesPositions[COLUMN_RIGHT][nodeIndex][1] = y;
+			else {
+				t[0] = outer[i]; depth[0] = 0;
+				t[1] = inner[j]; depth[1] = 1;
+				t[2] = inner[j + 1]; depth[2] = 1;
+				++j;
 			}
-		}
 
-		// De bas en haut.
-		{
-			const float x = nodepos.x - halfrelativesize + (halfrelativesize / 2.0f * nodeIndex) + halfrelativesize / 4.0f;
-			{
-				const float y = nodepos.y - (halfrelativesize * 1.25);
-				jointNodesPositions[COLUMN_FRONT][nodeIndex][0] = x;
-				jointNodesPositions[COLUMN_FRONT][nodeIndex][1] = y;
+			int pos[3][2];
+			for (unsigned short k = 0; k < 3; ++k) {
+				switch (side) {
+					case 0:
+						pos[k][0] = depth[k];
+						pos[k][1] = t[k];
+						break;
+					case 1:
+						pos[k][0] = polyCount - depth[k];
+						pos[k][1] = t[k];
+						break;
+					case 2:
+						pos[k][0] = t[k];
+						pos[k][1] = depth[k];
+						break;
+					case 3:
+						pos[k][0] = t[k];
+						pos[k][1] = polyCount - depth[k];
+						break;
+				}
 			}
-			{
-				const float y = nodepos.y + (halfrelativesize * 1.25);
-				jointNodesPositions[COLUMN_BACK][nodeIndex][0] = x;
-				jointNodesPositions[COLUMN_BACK][nodeIndex][1] = y;
+
+			// Tous les triangles sont dans le même sens que ceux du centre.
+			const int area = (pos[1][0] - pos[0][0]) * (pos[2][1] - pos[0][1]) -
+							 (pos[1][1] - pos[0][1]) * (pos[2][0] - pos[0][0]);
+			if (area < 0) {
+				std::swap(pos[1][0], pos[2][0]);
+				std::swap(pos[1][1], pos[2][1]);
+			}
+
+			for (unsigned short k = 0; k < 3; ++k) {
+				indices.push_back(pos[k][0] * vertexCount + pos[k][1]);
 			}
 		}
 	}
+}
 
-	for (unsigned short columnIndex = COLUMN_LEFT; columnIndex <= COLUMN_BACK; ++columnIndex) {
-		for (unsigned short nodeIndex = 0; nodeIndex < 4; ++nodeIndex) {
-			// Le parent du noeud de ce chunk et du futur noeud adjacent.
-			KX_ChunkNode *parent = m_parentJointNodes[columnIndex];
+void KX_Chunk::ConstructPolygones()
+{
+	// on redimensione la liste des vertice partagés
+	m_meshObj->m_sharedvertex_map.resize(m_originVertexIndex);
 
-			// Il peut ne pas avoir de noeud parent si le noeud et sur le bord du terrain.
-			if (!parent) {
-				m_jointNode[columnIndex][nodeIndex + 1] = NULL;
-				continue;
-			}
+	/* Les colonnes en y = 0 et y = m_polyCount sont jointes
+	 * respectivement aux noeuds "FRONT" et "BACK".
+	 */
+	const unsigned short intervals[4] = {
+		GetColumnVertexInterval(COLUMN_LEFT),
+		GetColumnVertexInterval(COLUMN_RIGHT),
+		GetColumnVertexInterval(COLUMN_FRONT),
+		GetColumnVertexInterval(COLUMN_BACK)
+	};
 
-			KX_ChunkNode *jointNode = m_jointNode[columnIndex][nodeIndex + 1] = parent->GetNodeRelativePosition(
-				jointNodesPositions[columnIndex][nodeIndex][0],
-				jointNodesPositions[columnIndex][nodeIndex][1]);
+	// Le modèle est partagé par tous les chunks du terrain ayant les mêmes jointures.
+	RAS_IndexArray *indexarray = m_terrain->GetPolygonTemplate(intervals);
+	const unsigned int vertexCount = m_vertexCount * m_vertexCount;
 
-			/* Si le noeud adjacent est plus grand que le noeud de ce chunk, 
-			 * alors ce noeud est adjacent a toute la colonne.
-			 */
-			if (jointNode && jointNode->GetRelativeSize() >= relativesize) {
-				m_jointNode[columnIndex][1] = m_jointNode[columnIndex][2] = jointNode;
-				m_jointNode[columnIndex][3] = m_jointNode[columnIndex][4] = jointNode;
-				break;
-			}
+	/* Sans forme physique utilisant les polygones, tous les vertices du bloc sont
+	 * ajoutés dans l'ordre du bloc et le mesh est dessiné directement avec les indices
+	 * du modèle, sans polygones ni copie des indices.
+	 */
+	if (!GetUseMeshPhysics() && vertexCount < RAS_DisplayArray::BUCKET_MAX_VERTEX) {
+		const double starttime = KX_Terrain::GetTime();
+
+		const MT_Vector4 tangent(0.0f, 0.0f, 0.0f, 0.0f);
+
+		m_meshObj->AddMeshMaterial(m_bucket, 3);
+		for (unsigned int i = 0; i < vertexCount; ++i) {
+			Vertex *vertex = &m_vertexesBlock[i];
+			vertex->vertIndex = m_meshObj->AddVertex(m_bucket, MT_Point3(vertex->absolutePos[0], vertex->absolutePos[1], vertex->vertexInfo->height),
+					vertex->vertexInfo->m_uvs, tangent, 0, vertex->normal, false, vertex->origIndex, 3);
+			MT_assert(vertex->vertIndex == (short)i);
 		}
+		m_meshObj->SetSharedIndexArray(m_bucket, indexarray);
+
+		vertexAddingTime += KX_Terrain::GetTime() - starttime;
+		return;
 	}
-	// Les noeuds speciaux de coins.
-	{
-		// Coin bas-gauche.
-		m_jointNode[COLUMN_LEFT][0] = m_jointNode[COLUMN_FRONT][0] = terrain->GetNodeRelativePosition(
-			nodepos.x - (halfrelativesize * 1.25), nodepos.y - (halfrelativesize * 1.25));
-		// Coin bas-droite.
-		m_jointNode[COLUMN_RIGHT][0] = m_jointNode[COLUMN_FRONT][5] = terrain->GetNodeRelativePosition(
-			nodepos.x + (halfrelativesize * 1.25), nodepos.y - (halfrelativesize * 1.25));
-		// Coin haut-gauche.
-		m_jointNode[COLUMN_BACK][0] = m_jointNode[COLUMN_LEFT][5] = terrain->GetNodeRelativePosition(
-			nodepos.x - (halfrelativesize * 1.25), nodepos.y + (halfrelativesize * 1.25));
-		// Coin haut-droite.
-		m_jointNode[COLUMN_RIGHT][5] = m_jointNode[COLUMN_BACK][5] = terrain->GetNodeRelativePosition(
-			nodepos.x + (halfrelativesize * 1.25), nodepos.y + (halfrelativesize * 1.25));
+
+	const std::vector<unsigned short>& indices = indexarray->m_index;
+	for (unsigned int i = 0, size = indices.size(); i < size; i += 3) {
+		AddMeshPolygonVertexes(&m_vertexesBlock[indices[i]], &m_vertexesBlock[indices[i + 1]],
+							   &m_vertexesBlock[indices[i + 2]], false);
 	}
 }
 
@@ -1133,26 +1026,33 @@ bool KX_Chunk::GetJointNodesChanged()
 {
 	// Les noeuds de jointure ont-ils changé ?
 	bool jointChanged = false;
-	for (unsigned short columnIndex = COLUMN_LEFT; columnIndex <= COLUMN_BACK; ++columnIndex) {
-		// On accede au parent du noeud adjacent.
-		KX_ChunkNode *parent = m_parentJointNodes[columnIndex];
-		if (!parent) {
-			continue;
-		}
+	// La direction du noeud adjacent de chaque colonne.
+	static const short jointDirections[4][2] = {
+		{-1, 0}, // COLUMN_LEFT
+		{1, 0}, // COLUMN_RIGHT
+		{0, -1}, // COLUMN_FRONT
+		{0, 1} // COLUMN_BACK
+	};
 
+	for (unsigned short columnIndex = COLUMN_LEFT; columnIndex <= COLUMN_BACK; ++columnIndex) {
 		KX_ChunkNodeProxy *jointNodeProxy = m_jointNodeProxy[columnIndex];
 		// Si le proxy existe et n'est pas modifié on passe à la colonne suivante.
 		if (jointNodeProxy && !jointNodeProxy->IsModified()) {
 			continue;
 		}
 
-		// Sinon on cherche le noeud adjacent.
-		KX_ChunkNode *jointNode = parent->GetNodeRelativePosition(m_jointNodePosition[columnIndex][0], m_jointNodePosition[columnIndex][1]);
-		if (!jointNode) {
+		/* Sinon on cherche le noeud adjacent dans l'index des noeuds. Un noeud invisible
+		 * n'est pas utilisé car il peut avoir une grande difference de niveau avec ce noeud.
+		 */
+		KX_ChunkNode *jointNode = m_node->GetAdjacentNode(jointDirections[columnIndex][0], jointDirections[columnIndex][1]);
+		if (!jointNode || jointNode->GetCulledState() == KX_Camera::OUTSIDE) {
 			continue;
 		}
 
-		const unsigned short jointLevel = m_node->GetLevel() - jointNode->GetLevel();
+		/* Un noeud adjacent plus subdivisé s'adapte à ce chunk,
+		 * seule la différence avec un noeud moins subdivisé compte.
+		 */
+		const unsigned short jointLevel = max_ii(m_node->GetLevel() - jointNode->GetLevel(), 0);
 		// Si le niveau de jointure a changé on met jointChanged a vrai et copions le niveau. 
 		if (jointLevel != m_lastHasJoint[columnIndex]) {
 			jointChanged = true;
@@ -1177,14 +1077,19 @@ bool KX_Chunk::GetJointNodesChanged()
  */
 void KX_Chunk::UpdateMesh()
 {
-	if (GetJointNodesChanged() || !m_meshObj) {
-		m_onConstruct = true;
-		meshRecreation++;
-
-		// Si les vertices ne sont pas déjà créés on les créés.
-		if (!m_hasVertexes) {
-			ConstructVertexes();
-			m_hasVertexes = true;
+	// Les vertices ne sont pas encore construits par le thread de travail.
+	if (!GetVertexesReady()) {
+		return;
+	}
+
+	if (GetJointNodesChanged() || !m_meshObj || m_heightsModified) {
+		// Le mesh peut déjà attendre sa construction depuis une frame précédente.
+		if (!m_onConstruct) {
+			m_onConstruct = true;
+			meshRecreation++;
+			if (m_meshObj) {
+				m_buildRequestTime = KX_Terrain::GetTime();
+			}
 		}
 
 		/* On valide ou invalide les vertices externes pour pouvoir
@@ -1198,27 +1103,46 @@ void KX_Chunk::UpdateMesh()
 
 void KX_Chunk::EndUpdateMesh()
 {
+	KX_PROFILE_ZONE("Chunk EndUpdateMesh");
+
 	double starttime;
 	double endtime;
 
 	if (m_onConstruct) {
+		/* Première construction du mesh, on ajoute les temps mesurés par
+		 * le thread de travail aux statistiques.
+		 */
+		if (!m_meshObj) {
+			vertexCreatingTime += m_vertexCreatingTime;
+			normalComputingTime += m_normalComputingTime;
+		}
+
 		// Recreation du mesh.
 		DestructMesh();
 		ConstructMesh();
 
-		starttime = KX_GetActiveEngine()->GetRealTime();
+		starttime = KX_Terrain::GetTime();
 
 		// Calcule des normales.
 		ComputeJointVertexesNormal();
 
-		endtime = KX_GetActiveEngine()->GetRealTime();
+		endtime = KX_Terrain::GetTime();
 		normalComputingTime += endtime - starttime;
 
 		// Construction des polygones.
 		ConstructPolygones();
 
+		m_meshMemory = m_meshObj->NumVertices(m_bucket->GetPolyMaterial()) * sizeof(RAS_TexVert) +
+					   m_meshObj->NumPolygons() * sizeof(RAS_Polygon);
+
 		// Et enfin on créer un mesh de rendu pour cet objet.
 		m_meshObj->AddMeshUser(this, &m_meshSlots, NULL);
+		// Le nouveau mesh utilise la hauteur réelle des vertices.
+		m_morphed = false;
+
+		if (m_terrain->GetOccluder()) {
+			ComputeOccluderHeights();
+		}
 
 		/** On initialize toutes les informations pour le rendu :
 		 * matrice de rotation, couleur, visibilité, et client.
@@ -1240,56 +1164,215 @@ void KX_Chunk::EndUpdateMesh()
 			ms->m_clientObj = NULL;
 		}
 
-		starttime = KX_GetActiveEngine()->GetRealTime();
+		starttime = KX_Terrain::GetTime();
 
 		// On créer la forme physique du chunk.
 		ConstructPhysicsController();
+		m_heightsModified = false;
 
-		endtime = KX_GetActiveEngine()->GetRealTime();
+		endtime = KX_Terrain::GetTime();
 		physicsCreatingTime += endtime - starttime;
 		m_onConstruct = false;
+
+		const double latency = endtime - m_buildRequestTime;
+		buildLatencyTime += latency;
+		if (latency > maxBuildLatencyTime) {
+			maxBuildLatencyTime = latency;
+		}
+		++meshBuilds;
 	}
 }
 
-void KX_Chunk::RenderMesh(RAS_IRasterizer *rasty, KX_Camera *cam)
+void KX_Chunk::UpdateMorph(const MT_Point3& cameraPosition, double time)
 {
-	const MT_Point3 realPos = MT_Point3(m_node->GetRealPos().x(), m_node->GetRealPos().y(), 0.);
-// 	const MT_Point3 camPos = cam->NodeGetWorldPosition();
-// 	const MT_Vector3 norm = (camPos - realPos).normalized() * sqrt(m_node->GetRadius2());
+	// Les vertices peuvent être en cours de rafraichissement dans un thread de travail.
+	if (!m_meshObj || !m_visible || !GetVertexesReady()) {
+		return;
+	}
 
-	/*KX_RasterizerDrawDebugLine(realPos + MT_Point3(0.0, 0.0, m_minVertexHeight + 1.0),
-							   realPos + MT_Point3(0.0, 0.0, m_maxVertexHeight - 1.0), MT_Vector3(1., 0., 0.));*/
+	// Le noeud principal n'a pas de niveau parent vers lequel se transformer.
+	KX_ChunkNode *parentNode = m_node->GetParentNode();
+	if (!parentNode) {
+		return;
+	}
 
-#if 0
-	for (unsigned short columnIndex = COLUMN_LEFT; columnIndex <= COLUMN_BACK; ++columnIndex) {
-		for (unsigned short vertexIndex = (columnIndex == COLUMN_LEFT || columnIndex == COLUMN_RIGHT) ? 0 : 1;
-			 vertexIndex < ((columnIndex == COLUMN_LEFT || columnIndex == COLUMN_RIGHT) ? VERTEX_COUNT : POLY_COUNT);
-			 ++vertexIndex)
-		{
-			Vertex *vertex = m_columns[columnIndex]->GetExternVertex(vertexIndex);
-			if (!vertex->validNormal)
+	const KX_Terrain *terrain = m_terrain;
+	const float morphRange = terrain->GetMorphRange();
+	const float morphTime = terrain->GetMorphTime();
+
+	/* Un chunk issu d'une subdivision commence avec la forme de son parent
+	 * dès son premier affichage puis prend sa forme réelle.
+	 */
+	float timeMorph = 0.0f;
+	if (m_useTimeMorph && morphTime > 0.0f) {
+		if (m_morphStartTime < 0.0) {
+			m_morphStartTime = time;
+		}
+		timeMorph = 1.0f - (float)((time - m_morphStartTime) / morphTime);
+		if (timeMorph <= 0.0f) {
+			timeMorph = 0.0f;
+			m_useTimeMorph = false;
+		}
+	}
+
+	/* Le noeud parent n'est plus subdivisé quand sa distance moins son rayon et sa
+	 * marge dépasse la distance maximale du niveau, tous les vertices sont alors au
+	 * moins à cette distance plus la marge et doivent avoir la forme du parent.
+	 */
+	const float morphEnd = terrain->GetLevelMaxDistance(m_node->GetLevel()) +
+						   parentNode->GetRadiusMargin() * terrain->GetMarginFactor();
+	const float morphStart = morphEnd - morphRange * terrain->GetCameraMaxDistance() / terrain->GetMaxLevel();
+	const bool useDistanceMorph = (morphRange > 0.0f && morphEnd > morphStart);
+
+	// Aucun vertice n'est dans la zone de transition et le mesh est déjà à sa hauteur réelle.
+	const float maxDistance = m_node->GetCenter().distance(cameraPosition) + m_node->GetRadius();
+	if (!m_morphed && timeMorph == 0.0f && (!useDistanceMorph || maxDistance < morphStart)) {
+		return;
+	}
+
+	const MT_Point2& realPos = m_node->GetRealPos();
+	bool morphed = false;
+
+	for (unsigned short x = 0; x < m_vertexCount; ++x) {
+		for (unsigned short y = 0; y < m_vertexCount; ++y) {
+			Vertex *vertex = GetVertex(x, y);
+			// Le vertice n'est pas utilisé par le mesh à cause des jointures.
+			if (vertex->vertIndex == -1) {
 				continue;
+			}
 
-// 			if (m_node->GetRelativeSize() != 4 /*|| vertexIndex != 2*/)
-// 				continue;
+			const float height = vertex->vertexInfo->height;
+			float factor = 0.0f;
+			if (useDistanceMorph) {
+				const MT_Point3 position(realPos.x() + vertex->absolutePos[0], realPos.y() + vertex->absolutePos[1], height);
+				factor = ((float)position.distance(cameraPosition) - morphStart) / (morphEnd - morphStart);
+				CLAMP(factor, 0.0f, 1.0f);
+			}
 
-			MT_Point3 vertPos(vertex->absolutePos[0], vertex->absolutePos[1], vertex->vertexInfo->height);
-			vertPos += realPos;
-			KX_RasterizerDrawDebugLine(vertPos, vertPos + (MT_Point3(vertex->normal) * 20), MT_Vector3(1., 0., 1.));
+			/* Les vertices des bords ne suivent pas la transition dans le temps pour
+			 * rester à la même hauteur que ceux des chunks adjacents plus anciens.
+			 */
+			if (x != 0 && y != 0 && x != m_polyCount && y != m_polyCount) {
+				factor = max_ff(factor, timeMorph);
+			}
+
+			const float morphHeight = height + (vertex->morphHeight - height) * factor;
+			morphed = morphed || (morphHeight != height);
 
 			RAS_TexVert *rasvert = m_meshObj->GetVertex(0, vertex->vertIndex);
-			if (rasvert)
-				KX_RasterizerDrawDebugLine(vertPos + (MT_Point3(rasvert->getNormal()) * 20), vertPos + (MT_Point3(rasvert->getNormal()) * 60), MT_Vector3(1., 0., 0.));
-
-			MT_Vector3 color(0.25f, 0.25f, 0.0f);
-			color *= m_node->GetRelativeSize(); //vertexIndex + 1;
-			KX_RasterizerDrawDebugLine(MT_Point3(vertex->quad[0]), MT_Point3(vertex->quad[1]), color);
-			KX_RasterizerDrawDebugLine(MT_Point3(vertex->quad[1]), MT_Point3(vertex->quad[2]), color);
-			KX_RasterizerDrawDebugLine(MT_Point3(vertex->quad[2]), MT_Point3(vertex->quad[3]), color);
-			KX_RasterizerDrawDebugLine(MT_Point3(vertex->quad[3]), MT_Point3(vertex->quad[0]), color);
+			rasvert->SetXYZ(MT_Point3(vertex->absolutePos[0], vertex->absolutePos[1], morphHeight));
+		}
+	}
+
+	m_meshObj->SetMeshModified(true);
+	m_morphed = morphed;
+	++morphUpdates;
+}
+
+void KX_Chunk::ComputeOccluderHeights()
+{
+	const unsigned short resolution = m_occluderResolution;
+	const unsigned short step = m_polyCount / resolution;
+
+	/* La hauteur minimale de chaque case de la grille, le mesh affiché est entre la hauteur
+	 * réelle et la hauteur de transition des vertices.
+	 */
+	float cellHeights[OCCLUDER_RESOLUTION * OCCLUDER_RESOLUTION];
+	for (unsigned short i = 0; i < resolution; ++i) {
+		for (unsigned short j = 0; j < resolution; ++j) {
+			float minHeight = FLT_MAX;
+			for (unsigned short x = i * step; x <= (i + 1) * step; ++x) {
+				for (unsigned short y = j * step; y <= (j + 1) * step; ++y) {
+					const Vertex *vertex = GetVertex(x, y);
+					minHeight = min_fff(minHeight, vertex->vertexInfo->height, vertex->morphHeight);
+				}
+			}
+			cellHeights[i * resolution + j] = minHeight;
 		}
 	}
-#endif
+
+	/* Chaque vertice du maillage d'occlusion prend le minimum des cases qui le touchent,
+	 * les triangles restent ainsi sous toutes les faces qu'ils couvrent.
+	 */
+	for (unsigned short i = 0; i <= resolution; ++i) {
+		for (unsigned short j = 0; j <= resolution; ++j) {
+			float minHeight = FLT_MAX;
+			for (unsigned short ci = max_ii(i - 1, 0); ci <= min_ii(i, resolution - 1); ++ci) {
+				for (unsigned short cj = max_ii(j - 1, 0); cj <= min_ii(j, resolution - 1); ++cj) {
+					minHeight = min_ff(minHeight, cellHeights[ci * resolution + cj]);
+				}
+			}
+			m_occluderHeights[i * (resolution + 1) + j] = minHeight;
+		}
+	}
+}
+
+void KX_Chunk::AddOccluder(PHY_IOcclusionBuffer *buffer)
+{
+	const unsigned short resolution = m_occluderResolution;
+	const unsigned short step = m_polyCount / resolution;
+
+	buffer->SetModelMatrix(m_meshMatrix);
+
+	for (unsigned short i = 0; i < resolution; ++i) {
+		for (unsigned short j = 0; j < resolution; ++j) {
+			const Vertex *v1 = GetVertex(i * step, j * step);
+			const Vertex *v2 = GetVertex((i + 1) * step, j * step);
+			const Vertex *v3 = GetVertex((i + 1) * step, (j + 1) * step);
+			const Vertex *v4 = GetVertex(i * step, (j + 1) * step);
+
+			const float p1[3] = {v1->absolutePos[0], v1->absolutePos[1], m_occluderHeights[i * (resolution + 1) + j]};
+			const float p2[3] = {v2->absolutePos[0], v2->absolutePos[1], m_occluderHeights[(i + 1) * (resolution + 1) + j]};
+			const float p3[3] = {v3->absolutePos[0], v3->absolutePos[1], m_occluderHeights[(i + 1) * (resolution + 1) + j + 1]};
+			const float p4[3] = {v4->absolutePos[0], v4->absolutePos[1], m_occluderHeights[i * (resolution + 1) + j + 1]};
+
+			buffer->AppendOccluder(p1, p2, p3);
+			buffer->AppendOccluder(p1, p3, p4);
+		}
+	}
+}
+
+void KX_Chunk::UpdateOcclusion(PHY_IOcclusionBuffer *buffer)
+{
+	if (!m_visible || !m_meshObj) {
+		m_occluded = false;
+		return;
+	}
+
+	const MT_Point3 *box = m_node->GetBox();
+	MT_Point3 minPoint = box[0];
+	MT_Point3 maxPoint = box[0];
+	for (unsigned short i = 1; i < 8; ++i) {
+		for (unsigned short axis = 0; axis < 3; ++axis) {
+			minPoint[axis] = min_ff(minPoint[axis], box[i][axis]);
+			maxPoint[axis] = max_ff(maxPoint[axis], box[i][axis]);
+		}
+	}
+
+	m_occluded = !buffer->QueryBox((minPoint + maxPoint) * 0.5f, (maxPoint - minPoint) * 0.5f);
+	if (m_occluded) {
+		++occludedChunks;
+	}
+}
+
+void KX_Chunk::ComputeBuildPriority(const MT_Point3& cameraPosition)
+{
+	m_buildPriority = m_node->GetProjectedError(cameraPosition);
+
+	// Les chunks en dehors du champ de la camera ne servent qu'à la physique.
+	if (m_node->GetCulledState() == KX_Camera::OUTSIDE) {
+		m_buildPriority *= 0.25f;
+	}
+}
+
+void KX_Chunk::RenderMesh(RAS_IRasterizer *rasty, KX_Camera *cam)
+{
+	const MT_Point3 realPos = MT_Point3(m_node->GetRealPos().x(), m_node->GetRealPos().y(), 0.);
+// 	const MT_Point3 camPos = cam->NodeGetWorldPosition();
+// 	const MT_Vector3 norm = (camPos - realPos).normalized() * sqrt(m_node->GetRadius2());
+
+	/*KX_RasterizerDrawDebugLine(realPos + MT_Point3(0.0, 0.0, m_minVertexHeight + 1.0),
+							   realPos + MT_Point3(0.0, 0.0, m_maxVertexHeight - 1.0), MT_Vector3(1., 0., 0.));*/
 
 	if (!m_visible)
 		return;
@@ -1303,6 +1386,167 @@ void KX_Chunk::RenderMesh(RAS_IRasterizer *rasty, KX_Camera *cam)
 
 unsigned short KX_Chunk::GetColumnVertexInterval(COLUMN_TYPE columnType) const
 {
-	unsigned short jointLevel = m_lastHasJoint[columnType];
-	return jointLevel > 0 ? jointLevel * 2 : 1;
+	const unsigned short jointLevel = m_lastHasJoint[columnType];
+	return jointLevel > 0 ? min_ii(1 << jointLevel, m_polyCount) : 1;
+}
+
+unsigned int KX_Chunk::GetVertexesMemory() const
+{
+	if (!m_hasVertexes) {
+		return 0;
+	}
+
+	// Le bloc de vertices, les hauteurs de la grille et celles de sa bordure.
+	return GetVertexesMemorySize(m_vertexCount) + (m_vertexCount + 4) * m_vertexCount * sizeof(float);
+}
+
+void KX_Chunk::Evict()
+{
+	DestructMesh();
+	m_meshObj = NULL;
+	m_meshMemory = 0;
+
+	// Les vertices rendent leurs informations au cache qui pourra les supprimer.
+	if (m_hasVertexes) {
+		for (unsigned short i = 0; i < m_vertexCount; ++i) {
+			for (unsigned short j = 0; j < m_vertexCount; ++j) {
+				GetVertex(i, j)->~Vertex();
+			}
+		}
+		m_hasVertexes = false;
+	}
+
+	if (m_vertexesBlock) {
+		m_terrain->GetVertexPool()->Free(m_vertexesBlock);
+		m_vertexesBlock = NULL;
+	}
+
+	// La forme physique en champ de hauteur est gardée avec ses hauteurs.
+	if (m_heights) {
+		if (m_heights == m_physicsHeights) {
+			m_physicsMemory += m_vertexCount * m_vertexCount * sizeof(float);
+		}
+		else {
+			delete[] m_heights;
+		}
+		m_heights = NULL;
+	}
+
+	if (m_borderHeights) {
+		delete[] m_borderHeights;
+		m_borderHeights = NULL;
+	}
+
+	m_vertexesState = VERTEXES_NONE;
+
+	// Les jointures sont recherchées à nouveau à la reconstruction du mesh.
+	for (unsigned short columnIndex = COLUMN_LEFT; columnIndex <= COLUMN_BACK; ++columnIndex) {
+		if (m_jointNodeProxy[columnIndex]) {
+			m_jointNodeProxy[columnIndex]->Release();
+			m_jointNodeProxy[columnIndex] = NULL;
+		}
+		m_lastHasJoint[columnIndex] = 0;
+	}
+
+	m_morphed = false;
+	m_occluded = false;
+	m_evicted = true;
+	// Les vertices seront reconstruits avec les zones actuelles.
+	m_invalidated = false;
+
+	++chunkEvictions;
+}
+
+void KX_Chunk::Restore()
+{
+	m_evicted = false;
+	m_buildRequestTime = KX_Terrain::GetTime();
+}
+
+void KX_Chunk::InvalidateArea(float minx, float miny, float maxx, float maxy)
+{
+	/* Un chunk sans vertices les calculera avec les zones actuelles, de même
+	 * qu'un rafraichissement pas encore envoyé à un thread de travail.
+	 */
+	if (GetVertexesState() == VERTEXES_NONE || m_refreshQueued) {
+		return;
+	}
+
+	/* Les normales utilisent la bordure d'un vertice et les vertices de jointure
+	 * des hauteurs éloignées de l'intervalle de la jointure.
+	 */
+	const float interval = m_terrain->GetChunkSize() * m_relativeSize / m_polyCount;
+	unsigned short ratio = 1;
+	for (unsigned short columnIndex = COLUMN_LEFT; columnIndex <= COLUMN_BACK; ++columnIndex) {
+		ratio = max_ii(ratio, GetColumnVertexInterval((COLUMN_TYPE)columnIndex));
+	}
+
+	const float halfsize = m_terrain->GetChunkSize() * m_relativeSize / 2.0f + interval * ratio;
+	const MT_Point2& realPos = m_node->GetRealPos();
+
+	if (realPos.x() - halfsize <= maxx && minx <= realPos.x() + halfsize &&
+		realPos.y() - halfsize <= maxy && miny <= realPos.y() + halfsize)
+	{
+		m_invalidated = true;
+	}
+}
+
+void KX_Chunk::QueueRefreshVertexes()
+{
+	m_invalidated = false;
+	m_refreshQueued = true;
+
+	++chunkRefreshes;
+}
+
+void KX_Chunk::RefreshVertexes()
+{
+	// Le chunk a était supprimé avant que le rafraichissement commence.
+	if (atomic_add_uint32(&m_vertexesCanceled, 0)) {
+		atomic_cas_uint32(&m_vertexesState, VERTEXES_SCHEDULED, VERTEXES_READY);
+		return;
+	}
+
+	const unsigned short paddedCount = m_vertexCount + 2;
+	const unsigned int vertexCount = paddedCount * paddedCount;
+	std::vector<VertexZoneInfo *> infos(vertexCount);
+	GetPaddedVertexInfos(&infos[0]);
+
+	m_requestCreateBox = true;
+
+	/* La forme physique lit les hauteurs actuelles jusqu'à sa reconstruction dans
+	 * EndUpdateMesh, les nouvelles sont écrites dans un autre tableau.
+	 */
+	if (m_heights == m_physicsHeights) {
+		m_heights = new float[m_vertexCount * m_vertexCount];
+	}
+
+	/* Les vertices prennent les nouvelles informations, les anciennes peuvent être
+	 * encore lues par un thread de travail et ne sont jamais modifiées.
+	 */
+	for (unsigned short columnIndex = 0; columnIndex < paddedCount; ++columnIndex) {
+		for (unsigned short vertexIndex = 0; vertexIndex < paddedCount; ++vertexIndex) {
+			const unsigned int index = columnIndex * paddedCount + vertexIndex;
+			VertexZoneInfo *info = infos[index];
+			SetPaddedHeight(columnIndex - 1, vertexIndex - 1, info->height);
+
+			if (columnIndex == 0 || vertexIndex == 0 || columnIndex == (paddedCount - 1) || vertexIndex == (paddedCount - 1)) {
+				info->Release();
+				continue;
+			}
+
+			Vertex *vertex = GetVertex(columnIndex - 1, vertexIndex - 1);
+			vertex->vertexInfo->Release();
+			vertex->vertexInfo = info;
+			ExtendHeightBox(info->height);
+		}
+	}
+
+	ComputeNormals();
+	ComputeMorphHeights();
+
+	// Le mesh, le maillage d'occlusion et la forme physique sont reconstruits dans EndUpdateMesh.
+	m_heightsModified = true;
+	// Les vertices sont de nouveau utilisables par le thread principal.
+	atomic_cas_uint32(&m_vertexesState, VERTEXES_SCHEDULED, VERTEXES_READY);
 }
@@ -24,21 +24,23 @@
 #ifndef __KX_CHUNK_H__
 #define __KX_CHUNK_H__
 
+#include <vector>
+
 #include "SG_QList.h"
 #include "KX_ChunkNode.h"
 
-#define VERTEX_COUNT 5
-#define VERTEX_COUNT_INTERN (VERTEX_COUNT - 2)
-
-#define POLY_COUNT (VERTEX_COUNT - 1)
-#define POLY_COUNT_INTERN (VERTEX_COUNT_INTERN - 1)
-
+class KX_Terrain;
+class VertexZoneInfo;
 class KX_ChunkNode;
 class KX_ChunkNodeProxy;
 class RAS_MeshObject;
 class RAS_MaterialBucket;
 class RAS_IRasterizer;
 class PHY_IPhysicsController;
+class PHY_IOcclusionBuffer;
+
+/// Le nombre de faces en largeur du maillage d'occlusion d'un chunk.
+#define OCCLUDER_RESOLUTION 4
 
 class KX_Chunk
 {
@@ -61,10 +63,57 @@ public:
 	static double physicsCreatingTime;
 	/// Le nombre de chunks actifs.
 	static unsigned int m_chunkActive;
+	/// Le nombre maximal de chunks attendant un thread pour construire leurs vertices.
+	static unsigned int vertexesQueueDepth;
+	/// Le nombre maximal de meshs reportés à la frame suivante faute de temps.
+	static unsigned int meshQueueDepth;
+	/// Le nombre total de constructions de mesh reportées.
+	static unsigned int deferredMeshBuilds;
+	/// Le nombre de meshs construits.
+	static unsigned int meshBuilds;
+	/// Le temps total entre la demande de construction d'un mesh et sa fin.
+	static double buildLatencyTime;
+	/// Le temps maximal entre la demande de construction d'un mesh et sa fin.
+	static double maxBuildLatencyTime;
+	/// Le nombre de mises à jour des vertices du mesh pour la transition entre niveaux.
+	static unsigned int morphUpdates;
+	/// Le nombre de chunks cachés par l'occlusion culling.
+	static unsigned int occludedChunks;
+	/// Le nombre de chunks dont le mesh et les vertices sont supprimés pour respecter le budget mémoire.
+	static unsigned int chunkEvictions;
+	/// Le nombre de chunks dont les vertices sont recalculés après une modification des zones.
+	static unsigned int chunkRefreshes;
 
 	static void ResetTime();
 	static void PrintTime();
 
+	/// La taille du bloc contenant tous les vertices d'un chunk.
+	static unsigned int GetVertexesMemorySize(unsigned short vertexCount);
+	/** Construit les indices des triangles d'un chunk de polyCount faces en largeur
+	 * avec un vertice sur intervals[i] pour chacun des bords x = 0, x = polyCount,
+	 * y = 0 et y = polyCount.
+	 */
+	static void ConstructPolygonTemplate(unsigned short polyCount, const unsigned short intervals[4],
+										 std::vector<unsigned short>& indices);
+	/** L'inverse de deux fois l'écart réel entre deux vertices d'un chunk de polyCount
+	 * faces en largeur et de taille relative relativeSize.
+	 */
+	static float GetNormalFactor(unsigned short polyCount, float chunkSize, unsigned short relativeSize);
+	/** La normale par différences centrées d'un vertice à partir des hauteurs de ses voisins
+	 * en x - 1 (left), x + 1 (right), y - 1 (front) et y + 1 (back), factor est l'inverse
+	 * de deux fois l'écart entre le vertice et ses voisins.
+	 */
+	static void ComputeCenteredNormal(float left, float right, float front, float back, float factor, float r_normal[3]);
+	/** La hauteur d'une grille de vertexCount * vertexCount hauteurs rangées [y * vertexCount + x]
+	 * entourée d'une bordure de 4 * vertexCount hauteurs : la colonne x = -1, la colonne
+	 * x = vertexCount, la ligne y = -1 puis la ligne y = vertexCount. x et y sont entre -1
+	 * et vertexCount, les coins de la bordure ne sont pas stockés.
+	 */
+	static float GetPaddedHeight(const float *heights, const float *borderHeights, unsigned short vertexCount, int x, int y);
+	/// La normale d'un vertice de la grille à partir de la grille et de sa bordure.
+	static void ComputeGridNormal(const float *heights, const float *borderHeights, unsigned short vertexCount,
+								  unsigned short x, unsigned short y, float factor, float r_normal[3]);
+
 	struct Vertex;
 
 	enum COLUMN_TYPE {
@@ -75,10 +124,29 @@ public:
 		COLUMN_NONE=4,
 	};
 
+	/// L'état de la construction des vertices dans un thread de travail.
+	enum VERTEXES_STATE {
+		VERTEXES_NONE=0,
+		VERTEXES_SCHEDULED=1,
+		VERTEXES_READY=2,
+	};
+
 private:
 	/// Le noeud parent.
 	KX_ChunkNode *m_node;
 
+	/** Le terrain, la position et la taille relative du noeud, copiés pour que
+	 * la construction des vertices n'accède pas au noeud qui peut être
+	 * détruit pendant ce temps.
+	 */
+	KX_Terrain *m_terrain;
+	const KX_ChunkNode::Point2D m_relativePos;
+	const unsigned short m_relativeSize;
+
+	/// Le nombre de vertices et de faces en largeur, le même pour tous les chunks du terrain.
+	const unsigned short m_vertexCount;
+	const unsigned short m_polyCount;
+
 	/// Le materiaux utilisé par le mesh, on le passe a la construction du mesh.
 	RAS_MaterialBucket *m_bucket;
 	/// Le mesh de construction.
@@ -90,34 +158,94 @@ private:
 
 	/// Le controlleur physique.
 	PHY_IPhysicsController *m_physicsController;
+	/** Les hauteurs des vertices ligne par ligne : heights[y * m_vertexCount + x].
+	 * C'est l'ordre lu par btHeightfieldTerrainShape, la forme physique en champ
+	 * de hauteur utilise directement ce tableau sans le copier.
+	 */
+	float *m_heights;
+	/** Les hauteurs de la bordure d'un vertice autour de la grille, appartenant aux
+	 * chunks voisins de même taille : les colonnes x = -1 et x = m_vertexCount puis
+	 * les lignes y = -1 et y = m_vertexCount. Elles servent au calcul des normales.
+	 */
+	float *m_borderHeights;
+	/** Le tableau de hauteurs lu par la forme physique en champ de hauteur, NULL
+	 * pour une forme en maillage. C'est m_heights sauf entre un rafraichissement
+	 * ou une éviction des vertices et la reconstruction de la forme, où la forme
+	 * garde ses anciennes hauteurs.
+	 */
+	float *m_physicsHeights;
 
 	/// Le chunk est visible ?
 	bool m_visible;
 
-	/// on stocke les colonnes pour un reconstruction plus rapide
-	Vertex *m_columns[4][VERTEX_COUNT];
-	Vertex *m_vertexes[VERTEX_COUNT][VERTEX_COUNT];
+	/** Le bloc contenant tous les vertices colonne par colonne, alloué par
+	 * l'allocateur du terrain.
+	 */
+	Vertex *m_vertexesBlock;
 	bool m_hasVertexes;
 	bool m_onConstruct;
 
+	/// L'état de la construction des vertices, modifié avec des opérations atomiques.
+	unsigned int m_vertexesState;
+	/// Si vrai la construction des vertices est annulée car le chunk va être supprimé.
+	unsigned int m_vertexesCanceled;
+
+	/** Les temps de construction des vertices et des normales mesurés dans le
+	 * thread de travail, ajoutés aux statistiques par le thread principal.
+	 */
+	double m_vertexCreatingTime;
+	double m_normalComputingTime;
+
+	/// Le temps de la demande de construction du mesh, pour mesurer la latence.
+	double m_buildRequestTime;
+	/** La priorité de construction du chunk, plus elle est grande plus le chunk
+	 * est construit tôt. Calculée à partir de l'erreur projetée du noeud.
+	 */
+	float m_buildPriority;
+
+	/** Vrai si le chunk est créé par la subdivision d'un noeud dont le chunk
+	 * est affiché, il commence alors avec la forme de son parent.
+	 */
+	bool m_useTimeMorph;
+	/// Le temps auquel le chunk est affiché pour la première fois, négatif avant.
+	double m_morphStartTime;
+	/// Vrai si des vertices du mesh ne sont pas à leur hauteur réelle.
+	bool m_morphed;
+
+	/** Les hauteurs du maillage d'occlusion, une grille de OCCLUDER_RESOLUTION faces
+	 * en largeur toujours sous la surface affichée pour ne jamais cacher ce qui est visible.
+	 */
+	float m_occluderHeights[(OCCLUDER_RESOLUTION + 1) * (OCCLUDER_RESOLUTION + 1)];
+	/// Le nombre de faces en largeur du maillage d'occlusion, au plus le nombre de faces du chunk.
+	unsigned short m_occluderResolution;
+	/// Le chunk est caché par les occluders de la scène et n'est pas rendu.
+	bool m_occluded;
+
+	/// La mémoire estimée du mesh de rendu et de la forme physique en octets.
+	unsigned int m_meshMemory;
+	unsigned int m_physicsMemory;
+	/** Le mesh et les vertices sont supprimés pour respecter le budget mémoire,
+	 * seule la forme physique est gardée.
+	 */
+	bool m_evicted;
+	/// La dernière frame où le noeud du chunk était dans le champ de la camera.
+	unsigned int m_lastUsedFrame;
+
+	/** Une zone a modifié les hauteurs sous le chunk, ses vertices doivent être
+	 * recalculés dès qu'ils sont construits.
+	 */
+	bool m_invalidated;
+	/// Le rafraichissement des vertices attend dans la liste des chunks à construire du terrain.
+	bool m_refreshQueued;
+	/// Les hauteurs ont changées depuis la dernière construction du mesh et de la forme physique.
+	bool m_heightsModified;
+
 	float m_maxVertexHeight;
 	float m_minVertexHeight;
 	bool m_requestCreateBox;
 
-	KX_ChunkNode *m_parentJointNodes[4];
-
 	/// Les dernières jointures.
 	unsigned short m_lastHasJoint[4]; // TODO renommer et utiliser 1 comme valeur par default
-	/* Tous les noeuds autour, jusqu'a 6 par côté dont 2 adjacents par un point, soit 16 noeuds.
-	 * pour les colonnes de gauche et droite les chunks sont de haut en bas
-	 * et de gauche a droite pour le colonnes de haut et bas.
-	 */
-	KX_ChunkNode *m_jointNode[4][6];
-
-	/* La position des noeuds de jointure, on les stoque
-	 * pour optimizer.
-	 */
-	float m_jointNodePosition[4][2];
 
 	/// Les proxys de 4 noeuds adjacents.
 	KX_ChunkNodeProxy *m_jointNodeProxy[4];
@@ -131,33 +259,91 @@ private:
 	void DestructMesh();
 
 	void ConstructPhysicsController();
+	/// Vrai si la forme physique du chunk est construite à partir des polygones du mesh.
+	bool GetUseMeshPhysics() const;
 
-	void ConstructVertexes();
+	/// Calcule les normales de tous les vertices à partir des hauteurs avec bordure.
+	void ComputeNormals();
+	/// Recalcule les normales des vertices de bords en fonction des jointures.
 	void ComputeJointVertexesNormal();
-	void ComputeColumnJointVertexNormal(COLUMN_TYPE columnType, bool reverse);
-	Vertex *GetVertexByChunkRelativePosition(short x, short y) const;
-	Vertex *GetVertexByTerrainRelativePosition(int x, int y) const;
-	KX_ChunkNode::Point2D GetTerrainRelativeVertexPosition(unsigned short x, unsigned short y) const;
-	void GetCoorespondingVertexesFromChunk(KX_ChunkNode *jointNode, Vertex *origVertex, COLUMN_TYPE columnType, 
-										   Vertex **coExternVertex, Vertex **coInternVertex);
-	Vertex *NewVertex(unsigned short relx, unsigned short rely);
+	/// Change la hauteur d'un vertice de la grille ou de sa bordure, x et y entre -1 et m_vertexCount.
+	void SetPaddedHeight(int x, int y, float height);
+	Vertex *GetVertex(unsigned short x, unsigned short y) const;
+	/// La position relative au terrain d'un vertice, x et y peuvent être en dehors du chunk.
+	KX_ChunkNode::Point2D GetTerrainRelativeVertexPosition(short x, short y) const;
+	Vertex *NewVertex(unsigned short relx, unsigned short rely, VertexZoneInfo *info);
+	/// Étend les hauteurs minimale et maximale du chunk à une hauteur de vertice.
+	void ExtendHeightBox(float height);
+	/** Calcule les informations de toute la grille du chunk et de sa bordure
+	 * rangées colonne par colonne.
+	 */
+	void GetPaddedVertexInfos(VertexZoneInfo **r_infos) const;
 
 	void InvalidateJointVertexesAndIndexes();
 
 	void ConstructPolygones();
 	void AddMeshPolygonVertexes(Vertex *v1, Vertex *v2, Vertex *v3, bool reverse);
 
-	void SetNormal(Vertex *vertexCenter) const;
+	/// Calcule la hauteur de chaque vertice dans le maillage du niveau parent.
+	void ComputeMorphHeights();
+	/// Calcule les hauteurs du maillage d'occlusion à partir des vertices.
+	void ComputeOccluderHeights();
 
 	/// \section Gestion des noeuds de jointures.
-	void GetJointColumnNodes();
 	bool GetJointNodesChanged();
 
 public:
 	KX_Chunk(KX_ChunkNode *node, RAS_MaterialBucket *m_bucket);
 	virtual ~KX_Chunk();
 
-	void UpdateColumnVertexesNormal(COLUMN_TYPE columnType);
+	/** Construction des vertices et des normales internes, appelée
+	 * depuis un thread de travail.
+	 */
+	void ConstructVertexes();
+
+	/// Indique que la construction des vertices est envoyée à un thread de travail.
+	void SetVertexesScheduled();
+	/// Annule la construction des vertices si elle n'a pas déjà commencée.
+	void CancelVertexes();
+	VERTEXES_STATE GetVertexesState() const;
+
+	/// Vrai si les vertices ont été construits, même si un thread de travail les rafraichit.
+	inline bool GetHasVertexes() const
+	{
+		return m_hasVertexes;
+	}
+
+	/// Vrai si les vertices sont construits et utilisables par le thread principal.
+	inline bool GetVertexesReady() const
+	{
+		return GetVertexesState() == VERTEXES_READY && m_hasVertexes;
+	}
+
+	/** Vrai si le mesh de rendu est construit, un ancien mesh en attente de
+	 * reconstruction reste affichable.
+	 */
+	inline bool GetMeshReady() const
+	{
+		return m_meshObj != NULL;
+	}
+
+	/// Vrai si le mesh attend d'être construit dans EndUpdateMesh.
+	inline bool GetMeshOnConstruct() const
+	{
+		return m_onConstruct;
+	}
+
+	/// Calcule la priorité de construction en fonction de la position de la camera.
+	void ComputeBuildPriority(const MT_Point3& cameraPosition);
+	inline float GetBuildPriority() const
+	{
+		return m_buildPriority;
+	}
+
+	/** Déplace les vertices du mesh entre leur hauteur réelle et celle du niveau parent
+	 * en fonction de leur distance à la camera et du temps depuis la création du chunk.
+	 */
+	void UpdateMorph(const MT_Point3& cameraPosition, double time);
 
 	/// creation du mesh avec joint des vertices du chunk avec ceux d'à cotés si neccesaire
 	void UpdateMesh();
@@ -179,6 +365,73 @@ public:
 		m_visible = visible;
 	}
 
+	inline bool GetOccluded() const
+	{
+		return m_occluded;
+	}
+
+	/// Dessine le maillage d'occlusion du chunk dans le tampon d'occlusion.
+	void AddOccluder(PHY_IOcclusionBuffer *buffer);
+	/// Teste si la boite du chunk est cachée dans le tampon d'occlusion.
+	void UpdateOcclusion(PHY_IOcclusionBuffer *buffer);
+
+	/// \section Gestion du budget mémoire.
+
+	/// La mémoire des vertices construits en octets.
+	unsigned int GetVertexesMemory() const;
+	inline unsigned int GetMeshMemory() const
+	{
+		return m_meshMemory;
+	}
+	inline unsigned int GetPhysicsMemory() const
+	{
+		return m_physicsMemory;
+	}
+
+	/** Supprime le mesh et les vertices du chunk, seule la forme physique est gardée.
+	 * Le chunk ne doit pas être en construction.
+	 */
+	void Evict();
+	/// Annule la suppression, les vertices doivent ensuite être reconstruits.
+	void Restore();
+	inline bool GetEvicted() const
+	{
+		return m_evicted;
+	}
+
+	inline unsigned int GetLastUsedFrame() const
+	{
+		return m_lastUsedFrame;
+	}
+	inline void SetLastUsedFrame(unsigned int frame)
+	{
+		m_lastUsedFrame = frame;
+	}
+
+	/// \section Modification des zones.
+
+	/** Marque le chunk comme invalide si ses vertices construits ou en construction
+	 * touchent le rectangle, en coordonnées réelles.
+	 */
+	void InvalidateArea(float minx, float miny, float maxx, float maxy);
+	inline bool GetInvalidated() const
+	{
+		return m_invalidated;
+	}
+	/** Indique que le rafraichissement des vertices attend son tour comme une
+	 * construction, les vertices restent utilisables jusqu'à son envoi.
+	 */
+	void QueueRefreshVertexes();
+	inline bool GetRefreshQueued() const
+	{
+		return m_refreshQueued;
+	}
+	/** Recalcule les informations et les normales des vertices puis demande
+	 * la reconstruction du mesh, appelée depuis un thread de travail comme
+	 * ConstructVertexes, les vertices doivent être construits.
+	 */
+	void RefreshVertexes();
+
 	inline unsigned short GetJointLevel(COLUMN_TYPE columnType) const
 	{
 		return m_lastHasJoint[columnType];
@@ -29,274 +29,281 @@
  */
 
 #include "KX_ChunkCache.h"
-#include "KX_Terrain.h"
 #include "KX_TerrainZone.h"
 
-KX_ChunkCache::KX_ChunkCache(unsigned short level, int x, int y, unsigned short size,
-							 bool allvertexesx, bool allvertexesy, KX_Terrain *terrain)
-	:m_level(level),
-	m_size(size),
-	m_pos(KX_ChunkNode::Point2D(x, y)),
-	m_allVertexesX(allvertexesx),
-	m_allVertexesY(allvertexesy),
-	m_accesCount(0),
-	m_terrain(terrain),
-	m_subChunkCache(NULL)
-{
-	unsigned short columnXSize = (m_allVertexesX ? VERTEX_COUNT : POLY_COUNT);
-	m_columnsX[0] = (VertexZoneInfo **)malloc(sizeof(VertexZoneInfo *) * columnXSize);
-	m_columnsX[1] = (VertexZoneInfo **)malloc(sizeof(VertexZoneInfo *) * columnXSize);
+#include "atomic_ops.h"
 
-	unsigned short columnYSize = (m_allVertexesY ? VERTEX_COUNT_INTERN : POLY_COUNT_INTERN);
-	m_columnsY[0] = (VertexZoneInfo **)malloc(sizeof(VertexZoneInfo *) * columnYSize);
-	m_columnsY[1] = (VertexZoneInfo **)malloc(sizeof(VertexZoneInfo *) * columnYSize);
+#include <stdint.h>
+#include <stdlib.h>
+#include <math.h>
 
-	for (unsigned short vertexIndex = 0; vertexIndex < columnXSize; ++vertexIndex) {
-		m_columnsX[0][vertexIndex] = NULL;
-		m_columnsX[1][vertexIndex] = NULL;
-	}
-	for (unsigned short vertexIndex = 0; vertexIndex < columnYSize; ++vertexIndex) {
-		m_columnsY[0][vertexIndex] = NULL;
-		m_columnsY[1][vertexIndex] = NULL;
+/// La taille initiale de la table.
+#define CACHE_MIN_CAPACITY 1024
+
+unsigned int KX_ChunkCache::cacheHits = 0;
+unsigned int KX_ChunkCache::cacheMisses = 0;
+unsigned int KX_ChunkCache::cacheEvictions = 0;
+unsigned int KX_ChunkCache::cacheInvalidations = 0;
+size_t KX_ChunkCache::cacheMemory = 0;
+
+KX_ChunkCache::KX_ChunkCache(size_t maxMemory)
+	:m_capacity(CACHE_MIN_CAPACITY),
+	m_count(0),
+	m_clockHand(0)
+{
+	/* La table est agrandie quand elle est à moitié pleine, on compte donc
+	 * deux emplacements par vertice.
+	 */
+	m_maxCount = maxMemory / (sizeof(VertexZoneInfo) + sizeof(Entry) * 2);
+	if (m_maxCount < CACHE_MIN_CAPACITY / 2) {
+		m_maxCount = CACHE_MIN_CAPACITY / 2;
 	}
+
+	m_entries = (Entry *)calloc(m_capacity, sizeof(Entry));
+	UpdateMemoryStats();
 }
 
 KX_ChunkCache::~KX_ChunkCache()
 {
-	unsigned short columnXSize = (m_allVertexesX ? VERTEX_COUNT : POLY_COUNT);
-	for (unsigned short vertexIndex = 0; vertexIndex < columnXSize; ++vertexIndex) {
-		if (m_columnsX[0][vertexIndex]) {
-			m_columnsX[0][vertexIndex]->Release();
-		}
-		if (m_columnsX[1][vertexIndex]) {
-			m_columnsX[1][vertexIndex]->Release();
+	for (unsigned int i = 0; i < m_capacity; ++i) {
+		if (m_entries[i].info) {
+			m_entries[i].info->Release();
 		}
 	}
 
-	unsigned short columnYSize = (m_allVertexesY ? VERTEX_COUNT_INTERN : POLY_COUNT_INTERN);
-	for (unsigned short vertexIndex = 0; vertexIndex < columnYSize; ++vertexIndex) {
-		if (m_columnsY[0][vertexIndex]) {
-			m_columnsY[0][vertexIndex]->Release();
-		}
-		if (m_columnsY[1][vertexIndex]) {
-			m_columnsY[1][vertexIndex]->Release();
-		}
-	}
-
-	free(m_columnsX[0]);
-	free(m_columnsX[1]);
-	free(m_columnsY[0]);
-	free(m_columnsY[1]);
-
-	DestructSubChunkCache();
+	free(m_entries);
+	cacheMemory = 0;
 }
 
-void KX_ChunkCache::ConstructSubChunkCache()
+unsigned int KX_ChunkCache::Hash(int x, int y) const
 {
-	if (!m_subChunkCache) {
-		m_subChunkCache = (KX_ChunkCache **)malloc(sizeof(KX_ChunkCache *) * 4);
-
-		unsigned short newsize = m_size / 2;
-		const unsigned short chunkinterval = m_size / 4;
-		unsigned short newlevel = m_level + 1;
-
-		m_subChunkCache[0] = new KX_ChunkCache(newlevel, m_pos.x - chunkinterval, m_pos.y - chunkinterval,
-											   newsize, false, false, m_terrain);
-		m_subChunkCache[1] = new KX_ChunkCache(newlevel, m_pos.x + chunkinterval, m_pos.y - chunkinterval,
-											   newsize, m_allVertexesX, false, m_terrain);
-		m_subChunkCache[2] = new KX_ChunkCache(newlevel, m_pos.x - chunkinterval, m_pos.y + chunkinterval,
-											   newsize, false, m_allVertexesY, m_terrain);
-		m_subChunkCache[3] = new KX_ChunkCache(newlevel, m_pos.x + chunkinterval, m_pos.y + chunkinterval,
-											   newsize, m_allVertexesX, m_allVertexesY, m_terrain);
-	}
+	unsigned int hash = ((unsigned int)x * 0x9E3779B1u) ^ ((unsigned int)y * 0x85EBCA77u);
+	hash ^= hash >> 15;
+	return hash & (m_capacity - 1);
 }
 
-void KX_ChunkCache::DestructSubChunkCache()
+unsigned int KX_ChunkCache::FindSlot(int x, int y) const
 {
-	if (m_subChunkCache) {
-		delete m_subChunkCache[0];
-		delete m_subChunkCache[1];
-		delete m_subChunkCache[2];
-		delete m_subChunkCache[3];
-		free(m_subChunkCache);
-		m_subChunkCache = NULL;
+	unsigned int index = Hash(x, y);
+	// La table n'est jamais pleine, on trouve toujours un emplacement libre.
+	while (m_entries[index].info && (m_entries[index].x != x || m_entries[index].y != y)) {
+		index = (index + 1) & (m_capacity - 1);
 	}
+	return index;
 }
 
-VertexZoneInfo *KX_ChunkCache::GetVertexZoneInfo(int x, int y)
+void KX_ChunkCache::Grow()
 {
-	const unsigned short interval = m_size / POLY_COUNT;
-	const unsigned short halfsize = m_size / 2;
-	const short bottomx = m_pos.x - halfsize;
-	const short bottomy = m_pos.y - halfsize;
-	const float relx = ((float)(x - bottomx)) / interval;
-	const float rely = ((float)(y - bottomy)) / interval;
-
-	VertexZoneInfo *vertexInfo = NULL;
-
-	// Ceci permet de savoir si le noeud est fréquement utilisé.
-	++m_accesCount;
-
-	// Le vertice est hors du chunk.
-	if (relx < 0.0f || rely < 0.0f ||
-		relx > 4.0f || rely > 4.0f ||
-		(!m_allVertexesX && relx == 4.0f) ||
-		(!m_allVertexesY && rely == 4.0f))
-	{
-		return NULL;
-	}
+	Entry *oldEntries = m_entries;
+	const unsigned int oldCapacity = m_capacity;
 
-	const bool alignedX = fmod(relx, 1.0f) == 0.0f;
-	const bool alignedY = fmod(rely, 1.0f) == 0.0f;
-	const bool pairX = fmod(relx, 2.0f) == 0.0f;
-	const bool pairY = fmod(rely, 2.0f) == 0.0f;
+	m_capacity *= 2;
+	m_entries = (Entry *)calloc(m_capacity, sizeof(Entry));
+	m_clockHand = 0;
 
-	/* Le vertice est entre les colonnes de ce chunk,
-	 * on doit donc subdiviser le noeud.
-	 */
-	if (!alignedX || !alignedY) {
-		ConstructSubChunkCache();
-		for (unsigned short i = 0; i < 4; ++i) {
-			vertexInfo = m_subChunkCache[i]->GetVertexZoneInfo(x, y);
-			if (vertexInfo) {
-				return vertexInfo;
-			}
+	for (unsigned int i = 0; i < oldCapacity; ++i) {
+		const Entry& entry = oldEntries[i];
+		if (entry.info) {
+			m_entries[FindSlot(entry.x, entry.y)] = entry;
 		}
-		// Totalement improbable.
-		return NULL;
 	}
 
-	/* Le point est aligné sur les colonnes en X, donc
-	 * rely = 1 ou rely = 3.
-	 * Il suffit juste de trouver la bonne colonne en x et
-	 * d'acceder au vertice avec comme indice relx
+	free(oldEntries);
+}
+
+void KX_ChunkCache::RemoveEntry(unsigned int index)
+{
+	const unsigned int mask = m_capacity - 1;
+
+	m_entries[index].info = NULL;
+	--m_count;
+
+	/* Suppression sans marqueur : les vertices suivants qui ne sont plus
+	 * accessibles depuis leur emplacement idéal sont décalés dans le trou.
 	 */
-	if (!pairY) {
-		// rely / 2 donne 0 ou 1, car rely = 1 ou = 3.
-		const unsigned short columnIndex = (int)(rely / 2.0f);
-		const unsigned short vertexIndex = (int)(relx);
-
-		vertexInfo = m_columnsX[columnIndex][vertexIndex];
-		// Le point n'a pas encore était créé.
-		if (!vertexInfo) {
-			m_columnsX[columnIndex][vertexIndex] = vertexInfo = m_terrain->NewVertexInfo(x, y);
+	unsigned int next = (index + 1) & mask;
+	while (m_entries[next].info) {
+		const unsigned int ideal = Hash(m_entries[next].x, m_entries[next].y);
+		// Le trou est entre l'emplacement idéal et l'emplacement actuel.
+		if (((next - ideal) & mask) >= ((next - index) & mask)) {
+			m_entries[index] = m_entries[next];
+			m_entries[next].info = NULL;
+			index = next;
 		}
+		next = (next + 1) & mask;
 	}
-	/* Le point est aligné seulement sur les colonnes en Y, donc
-	 * relx = 1 ou relx = 3 mais rely != 1 ou rely != 3
-	 * Il suffit juste de prendre le vertice dans la bonne
-	 * colonne en y avec pour indice rely / 2.
+}
+
+void KX_ChunkCache::Evict()
+{
+	/* On passe d'abord les vertices récemment utilisés ou encore utilisés
+	 * par des chunks, les supprimer ne libérerait aucune mémoire. Après
+	 * deux tours de table on supprime le vertice sous l'aiguille.
 	 */
-	else if (!pairX) {
-		const unsigned short columnIndex = (int)(relx / 2.0f);
-		const unsigned short vertexIndex = (int)(rely / 2.0f);
-
-		vertexInfo = m_columnsY[columnIndex][vertexIndex];
-		// Le point n'a pas encore était créé.
-		if (!vertexInfo) {
-			m_columnsY[columnIndex][vertexIndex] = vertexInfo = m_terrain->NewVertexInfo(x, y);
+	for (unsigned int step = 0; step < m_capacity * 2; ++step) {
+		Entry& entry = m_entries[m_clockHand];
+		if (entry.info) {
+			if (!entry.referenced && atomic_add_uint32(&entry.info->refcount, 0) == 1) {
+				break;
+			}
+			entry.referenced = false;
 		}
+		m_clockHand = (m_clockHand + 1) & (m_capacity - 1);
 	}
 
-	return vertexInfo;
-}
-
-void KX_ChunkCache::Refresh()
-{
-	if (m_accesCount == 0) {
-		DestructSubChunkCache();
+	while (!m_entries[m_clockHand].info) {
+		m_clockHand = (m_clockHand + 1) & (m_capacity - 1);
 	}
 
-	m_accesCount = 0;
+	m_entries[m_clockHand].info->Release();
+	RemoveEntry(m_clockHand);
+	++cacheEvictions;
 }
 
-KX_ChunkRootCache::KX_ChunkRootCache(unsigned short size, KX_Terrain *terrain)
-	:m_size(size),
-	m_terrain(terrain)
+void KX_ChunkCache::UpdateMemoryStats() const
 {
+	cacheMemory = GetMemoryUsage();
 }
 
-KX_ChunkRootCache::~KX_ChunkRootCache()
+VertexZoneInfo *KX_ChunkCache::GetVertexZoneInfo(int x, int y)
 {
+	Entry& entry = m_entries[FindSlot(x, y)];
+	if (!entry.info) {
+		++cacheMisses;
+		return NULL;
+	}
+
+	++cacheHits;
+	entry.referenced = true;
+	return entry.info;
 }
 
-void KX_ChunkRootCache::Construct()
+VertexZoneInfo *KX_ChunkCache::AddVertexZoneInfo(int x, int y, VertexZoneInfo *info)
 {
-	const unsigned short interval = m_size / POLY_COUNT;
-	const unsigned short halfsize = m_size / 2;
-
-	// Le tronc du cache génére automatiquement tous ses points.
-	for (unsigned short columnIndex = 0; columnIndex < VERTEX_COUNT; ++columnIndex) {
-		for (unsigned short vertexIndex = 0; vertexIndex < VERTEX_COUNT; ++vertexIndex) {
-			const int x = columnIndex * interval - halfsize;
-			const int y = vertexIndex * interval - halfsize;
-			m_columns[columnIndex][vertexIndex] = m_terrain->NewVertexInfo(x, y);
-		}
+	unsigned int index = FindSlot(x, y);
+
+	// Un autre thread a déjà créé ce vertice.
+	if (m_entries[index].info) {
+		return m_entries[index].info;
 	}
 
-	const unsigned short newsize = m_size / 2;
-	const unsigned short newlevel = 1;
-	const unsigned short chunkinterval = m_size / 4;
+	if (m_count >= m_maxCount) {
+		Evict();
+		// La suppression a pu déplacer les vertices.
+		index = FindSlot(x, y);
+	}
+	else if ((m_count + 1) * 2 > m_capacity) {
+		Grow();
+		index = FindSlot(x, y);
+	}
+
+	Entry& entry = m_entries[index];
+	entry.x = x;
+	entry.y = y;
+	entry.info = info;
+	entry.referenced = true;
+	info->AddRef();
+	++m_count;
+
+	UpdateMemoryStats();
 
-	m_subChunkCache[0] = new KX_ChunkCache(newlevel, -chunkinterval, -chunkinterval, newsize, false, false, m_terrain);
-	m_subChunkCache[1] = new KX_ChunkCache(newlevel,  chunkinterval, -chunkinterval, newsize, true, false, m_terrain);
-	m_subChunkCache[2] = new KX_ChunkCache(newlevel, -chunkinterval,  chunkinterval, newsize, false, true, m_terrain);
-	m_subChunkCache[3] = new KX_ChunkCache(newlevel,  chunkinterval,  chunkinterval, newsize, true, true, m_terrain);
+	return info;
 }
 
-void KX_ChunkRootCache::Destruct()
+unsigned int KX_ChunkCache::Trim(unsigned int count)
 {
-	for (unsigned short columnIndex = 0; columnIndex < VERTEX_COUNT; ++columnIndex) {
-		for (unsigned short vertexIndex = 0; vertexIndex < VERTEX_COUNT; ++vertexIndex) {
-			if (m_columns[columnIndex][vertexIndex]) {
-				m_columns[columnIndex][vertexIndex]->Release();
+	unsigned int evicted = 0;
+
+	/* Même parcours que Evict mais sans jamais supprimer un vertice encore
+	 * utilisé par un chunk, sa mémoire ne serait pas libérée.
+	 */
+	for (unsigned int step = 0; step < m_capacity * 2 && evicted < count && m_count > 0; ++step) {
+		Entry& entry = m_entries[m_clockHand];
+		if (entry.info && atomic_add_uint32(&entry.info->refcount, 0) == 1) {
+			if (!entry.referenced) {
+				entry.info->Release();
+				// Un vertice suivant peut être décalé à cet emplacement, on ne déplace pas l'aiguille.
+				RemoveEntry(m_clockHand);
+				++cacheEvictions;
+				++evicted;
+				continue;
 			}
+			entry.referenced = false;
 		}
+		m_clockHand = (m_clockHand + 1) & (m_capacity - 1);
 	}
 
-	for (unsigned short i = 0; i < 4; ++i) {
-		delete m_subChunkCache[i];
-	}
+	UpdateMemoryStats();
+
+	return evicted;
 }
 
-VertexZoneInfo *KX_ChunkRootCache::GetVertexZoneInfo(int x, int y)
+unsigned int KX_ChunkCache::RemoveArea(int minx, int miny, int maxx, int maxy, int step)
 {
-	VertexZoneInfo *vertexInfo = NULL;
-
-	const unsigned short interval = m_size / POLY_COUNT;
-	const unsigned short halfsize = m_size / 2;
-	/* Si le vertice est sur cette grille relx et rely seront :
-	 * 0.0, 1.0, 2.0, 3.0
-	 * Sinon il le vertice est dans un grille d'un sous noeud.
-	 */
-	const float relx = ((float)(x + halfsize)) / interval;
-	const float rely = ((float)(y + halfsize)) / interval;
-
-	const bool alignedX = fmod(relx, 1.0f) == 0.0f;
-	const bool alignedY = fmod(rely, 1.0f) == 0.0f;
+	unsigned int removed = 0;
+
+	// On aligne le rectangle sur les positions possibles des vertices.
+	minx = (int)ceilf((float)minx / step) * step;
+	miny = (int)ceilf((float)miny / step) * step;
+	maxx = (int)floorf((float)maxx / step) * step;
+	maxy = (int)floorf((float)maxy / step) * step;
+	if (minx > maxx || miny > maxy) {
+		return 0;
+	}
 
-	/* Le vertice est entre les colonnes de ce chunk,
-	 * on doit donc subdiviser le noeud.
-	 */
-	if (!alignedX || !alignedY) {
-		for (unsigned short i = 0; i < 4; ++i) {
-			vertexInfo = m_subChunkCache[i]->GetVertexZoneInfo(x, y);
-			if (vertexInfo) {
-				return vertexInfo;
+	// Le nombre de positions peut dépasser 32 bits pour une grande zone.
+	const uint64_t positions = (uint64_t)(((int64_t)maxx - minx) / step + 1) *
+	                           (uint64_t)(((int64_t)maxy - miny) / step + 1);
+
+	// Pour une petite zone on cherche chaque position, sinon on parcourt toute la table.
+	if (positions < m_capacity) {
+		for (int x = minx; x <= maxx; x += step) {
+			for (int y = miny; y <= maxy; y += step) {
+				const unsigned int index = FindSlot(x, y);
+				if (m_entries[index].info) {
+					m_entries[index].info->Release();
+					RemoveEntry(index);
+					++removed;
+				}
 			}
 		}
-		// Totalement improbable.
-		return NULL;
+	}
+	else {
+		for (unsigned int i = 0; i < m_capacity;) {
+			const Entry& entry = m_entries[i];
+			if (entry.info && minx <= entry.x && entry.x <= maxx && miny <= entry.y && entry.y <= maxy) {
+				entry.info->Release();
+				// Un vertice suivant peut être décalé à cet emplacement, on le teste à nouveau.
+				RemoveEntry(i);
+				++removed;
+				continue;
+			}
+			++i;
+		}
 	}
 
-	vertexInfo = m_columns[(int)relx][(int)rely];
+	cacheInvalidations += removed;
+	UpdateMemoryStats();
 
-	return vertexInfo;
+	return removed;
 }
 
-void KX_ChunkRootCache::Refresh()
+size_t KX_ChunkCache::GetMemoryUsage() const
 {
-	for (unsigned short i = 0; i < 4; ++i) {
-		m_subChunkCache[i]->Refresh();
-	}
-}
\ No newline at end of file
+	return m_count * sizeof(VertexZoneInfo) + m_capacity * sizeof(Entry);
+}
+
+size_t KX_ChunkCache::GetTableMemoryUsage() const
+{
+	return m_capacity * sizeof(Entry);
+}
+
+unsigned int KX_ChunkCache::GetCapacity() const
+{
+	return m_capacity;
+}
+
+unsigned int KX_ChunkCache::GetCount() const
+{
+	return m_count;
+}
@@ -24,105 +24,98 @@
 #ifndef __KX_CHUNK_CACHE_H__
 #define __KX_CHUNK_CACHE_H__
 
-#include "KX_Chunk.h" // for VERTEX_COUNT
-#include "KX_ChunkNode.h" // for Point2D
+#include <stddef.h>
 
 class VertexZoneInfo;
-class KX_Terrain;
 
+/** Cache des vertices du terrain : une table de hachage à adressage ouvert
+ * indexée par la position relative entière des vertices.
+ * Quand la mémoire utilisée dépasse la limite, les vertices les moins
+ * utilisés sont supprimés avec l'algorithme de l'horloge.
+ * Le cache n'est pas protégé, l'appelant doit utiliser un verrou.
+ */
 class KX_ChunkCache
 {
-private:
-	/* 
-	 * 5 vertices en x a un intervale de 1 en x et 2 en y.
-	 * 3 vertices en y a un intervale de 2 en y et 2 en x.
-	 * 
-	 * () = optionelle, seulement dans le cas d'un chunk de cache complètement
-	 * en bas et/ou a droite.
-	 * 
-	 *         (y0.2)         (y1.2)
-	 *           |               |
-	 *           |               |
-	 * x1.0----x1.1----x1.2----x1.3----(x1.4)
-	 *           |               |
-	 *           |               |
-	 *         y0.1            y1.1
-	 *           |               |
-	 *           |               |
-	 * x0.0----x1.1----x0.2----x0.3----(x0.4)
-	 *           |               |
-	 *           |               |
-	 *         y0.0            y1.0
-	 */
-
-	VertexZoneInfo **m_columnsX[2];
-	VertexZoneInfo **m_columnsY[2];
-
-	const unsigned short m_level;
-	/// La taille du chunk = décalage entre les vertices.
-	const unsigned short m_size;
-
-	KX_ChunkNode::Point2D m_pos;
-
-	/** Le nombre de vertices utilisés en X, entre
-	 * VERTEX_COUNT et (VERTEX_COUNT - 1)
-	 */
-	const bool m_allVertexesX;
-
-	/** Le nombre de vertices utilisés en Y, entre
-	 * VERTEX_COUNT_INTERN et (VERTEX_COUNT_INTERN - 1)
-	 */
-	const bool m_allVertexesY;
-
-	unsigned int m_accesCount;
-
-	KX_Terrain *m_terrain;
-
-	/// Les 4 sous chunks de cache.
-	KX_ChunkCache **m_subChunkCache;
+public:
+	/// Variables utilisées pour faire des statistiques.
+
+	/// Le nombre de vertices trouvés dans le cache.
+	static unsigned int cacheHits;
+	/// Le nombre de vertices absents du cache.
+	static unsigned int cacheMisses;
+	/// Le nombre de vertices supprimés pour respecter la limite de mémoire.
+	static unsigned int cacheEvictions;
+	/// Le nombre de vertices supprimés car une zone les a modifiés.
+	static unsigned int cacheInvalidations;
+	/// La mémoire utilisée par le cache en octets.
+	static size_t cacheMemory;
 
-	void ConstructSubChunkCache();
-	void DestructSubChunkCache();
+private:
+	struct Entry
+	{
+		int x;
+		int y;
+		/// Le vertice, NULL si l'emplacement est libre.
+		VertexZoneInfo *info;
+		/// Vrai si le vertice a était utilisé depuis le dernier passage de l'horloge.
+		bool referenced;
+	};
+
+	Entry *m_entries;
+	/// La taille de la table, toujours une puissance de deux.
+	unsigned int m_capacity;
+	/// Le nombre de vertices dans la table.
+	unsigned int m_count;
+	/// Le nombre maximum de vertices pour respecter la limite de mémoire.
+	unsigned int m_maxCount;
+	/// La position de l'aiguille de l'horloge dans la table.
+	unsigned int m_clockHand;
+
+	unsigned int Hash(int x, int y) const;
+	/// Renvoie l'indice de l'emplacement du vertice ou du premier emplacement libre.
+	unsigned int FindSlot(int x, int y) const;
+	/// Double la taille de la table et replace tous les vertices.
+	void Grow();
+	/// Supprime le vertice de l'emplacement en décalant les vertices suivants.
+	void RemoveEntry(unsigned int index);
+	/// Supprime un vertice peu utilisé.
+	void Evict();
+	void UpdateMemoryStats() const;
 
 public:
-	KX_ChunkCache(unsigned short level, int x, int y, unsigned short size, 
-				  bool allvertexesx, bool allvertexesy, KX_Terrain *terrain);
+	/// \param maxMemory La mémoire maximale utilisée par le cache en octets.
+	KX_ChunkCache(size_t maxMemory);
 	virtual ~KX_ChunkCache();
 
-	/** Cherche un vertice coorespondant a cette position.
-	 * Cas :
-	 *     - Si le vertice est dans ce chunk :
-	 *         - Si le vertice existe on le renvoie.
-	 *         - Si le vertice n'existe pas on le crée et on le renvoie.
-	 *     - Si le vertice n'est pas compris dans ce chunk :
-	 *         - On subdivise le chunk en 4 sous chunks et on rappelle cette fonction.
+	/** Renvoie le vertice à cette position ou NULL si il n'a pas encore
+	 * était créé ou qu'il a était supprimé.
 	 */
 	VertexZoneInfo *GetVertexZoneInfo(int x, int y);
+	/** Ajoute un vertice créé en dehors du cache, si un autre vertice
+	 * a déjà était ajouté à cette position on renvoie ce dernier.
+	 */
+	VertexZoneInfo *AddVertexZoneInfo(int x, int y, VertexZoneInfo *info);
 
-	void Refresh();
-};
-
-class KX_ChunkRootCache
-{
-private:
-	VertexZoneInfo *m_columns[VERTEX_COUNT][VERTEX_COUNT];
-
-	const unsigned short m_size;
-
-	KX_Terrain *m_terrain;
-
-	/// Les 4 sous chunks de cache.
-	KX_ChunkCache *m_subChunkCache[4];
-
-public:
-	KX_ChunkRootCache(unsigned short size, KX_Terrain *terrain);
-	virtual ~KX_ChunkRootCache();
-
-	void Construct();
-	void Destruct();
-
-	VertexZoneInfo *GetVertexZoneInfo(int x, int y);
+	/** Supprime jusqu'à count vertices utilisés uniquement par le cache, les moins
+	 * récemment utilisés en premier. Renvoie le nombre de vertices supprimés.
+	 */
+	unsigned int Trim(unsigned int count);
 
-	void Refresh();
+	/** Supprime tous les vertices compris dans un rectangle de positions relatives,
+	 * bornes incluses. step est l'intervalle entre deux vertices du niveau le plus fin,
+	 * les positions des vertices en sont toujours des multiples.
+	 * Renvoie le nombre de vertices supprimés.
+	 */
+	unsigned int RemoveArea(int minx, int miny, int maxx, int maxy, int step);
+
+	/// La mémoire utilisée par le cache en octets.
+	size_t GetMemoryUsage() const;
+	/// La mémoire utilisée par la table seule, sans les vertices.
+	size_t GetTableMemoryUsage() const;
+	/// La taille de la table, RemoveArea parcourt toute la table pour une zone d'au moins autant de positions.
+	unsigned int GetCapacity() const;
+	/// Le nombre de vertices dans la table.
+	unsigned int GetCount() const;
 };
+
 #endif // __KX_CHUNK_CACHE_H__
@@ -29,10 +29,9 @@
  */
 
 #include "KX_ChunkMotionState.h"
-#include "KX_ChunkNode.h"
 
-KX_ChunkMotionState::KX_ChunkMotionState(KX_ChunkNode *node)
-	:m_node(node)
+KX_ChunkMotionState::KX_ChunkMotionState(const MT_Point3& position)
+	:m_position(position)
 {
 }
 
@@ -42,10 +41,9 @@ KX_ChunkMotionState::~KX_ChunkMotionState()
 
 void KX_ChunkMotionState::GetWorldPosition(float &posX, float &posY, float &posZ)
 {
-	const MT_Point2& pos = m_node->GetRealPos();
-	posX = pos.x();
-	posY = pos.y();
-	posZ = 0.0f;
+	posX = m_position.x();
+	posY = m_position.y();
+	posZ = m_position.z();
 }
 
 void KX_ChunkMotionState::GetWorldScaling(float &scaleX, float &scaleY, float &scaleZ)
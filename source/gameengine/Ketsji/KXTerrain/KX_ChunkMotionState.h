@@ -33,15 +33,18 @@
 #define __KX_CHUNK_MOTION_STATE_H__
 
 #include "PHY_IMotionState.h"
+#include "MT_Point3.h"
 
-class KX_ChunkNode;
-
+/** L'état de mouvement d'une forme physique fixe du terrain, utilisé par
+ * les chunks et les tuiles de collision.
+ */
 class KX_ChunkMotionState : public PHY_IMotionState
 {
 private:
-	KX_ChunkNode *m_node;
+	/// La position de l'origine de la forme physique.
+	MT_Point3 m_position;
 public:
-	KX_ChunkMotionState(KX_ChunkNode *node);
+	KX_ChunkMotionState(const MT_Point3& position);
 	virtual ~KX_ChunkMotionState();
 
 	virtual void GetWorldPosition(float &posX, float &posY, float &posZ);
@@ -102,10 +102,16 @@ KX_ChunkNode::KX_ChunkNode(KX_ChunkNode *parentNode,
 
 	// Initialisation du proxy, on ne fait pas de AddRef car m_refCount est a 1 par defaut.
 	m_proxy = new KX_ChunkNodeProxy(this);
+
+	const Point2D gridPos = GetGridPos();
+	m_terrain->GetNodeMap().AddNode(this, m_level, gridPos.x, gridPos.y);
 }
 
 KX_ChunkNode::~KX_ChunkNode()
 {
+	const Point2D gridPos = GetGridPos();
+	m_terrain->GetNodeMap().RemoveNode(this, m_level, gridPos.x, gridPos.y);
+
 	DestructNodes();
 	DestructChunk();
 	--m_activeNode;
@@ -134,9 +140,9 @@ void KX_ChunkNode::DestructNodes()
 
 	if (m_nodeList) {
 		for (unsigned short i = 0; i < 4; ++i)
-			delete m_nodeList[i];
+			m_nodeList[i].~KX_ChunkNode();
 
-		free(m_nodeList);
+		m_terrain->FreeNodeList(m_nodeList);
 		m_nodeList = NULL;
 	}
 }
@@ -166,71 +172,55 @@ void KX_ChunkNode::DisableChunkVisibility()
 	}
 }
 
-bool KX_ChunkNode::NeedCreateNodes(CListValue *objects, KX_Camera *culledcam) const
+void KX_ChunkNode::DisableSubNodesChunkVisibility()
 {
-	bool needcreatenode = false;
-
-	for (unsigned int i = 0; i < objects->GetCount(); ++i) {
-		KX_GameObject *object = (KX_GameObject *)objects->GetValue(i);
-
-		bool iscamera = (object->GetGameObjectType() == SCA_IObject::OBJ_CAMERA);
-		/* Si l'objet n'est pas visible, n'utilise pas une forme physique, n'est pas
-		 * dynamique ou est en pause.
-		 */
-		if (!object->GetVisible() || 
-			!object->GetPhysicsController() ||
-			!object->GetPhysicsController()->IsDynamic() || 
-			object->GetPhysicsController()->IsSuspended())
-		{
-			// Si ce n'est pas une camera on passe.
-			if (!iscamera)
-				continue;
-
-			KX_Camera *cam = (KX_Camera *)object;
-			// Si la camera n'est pas active on passe aussi.
-			if (cam != culledcam && !cam->GetViewport()) {
-				continue;
-			}
+	if (m_nodeList) {
+		for (unsigned short i = 0; i < 4; ++i) {
+			m_nodeList[i].DisableChunkVisibility();
+			m_nodeList[i].DisableSubNodesChunkVisibility();
 		}
+	}
+}
 
-		const float objradius = object->GetSGNode()->Radius();
-		float distance = GetCenter().distance(object->NodeGetWorldPosition()) - objradius;
-		distance -= m_radius + (iscamera ? m_radiusMargin * m_terrain->GetMarginFactor() : m_radius);
+bool KX_ChunkNode::IsChunkTreeReady() const
+{
+	/* Un chunk supprimé par le budget mémoire est en dehors du champ de la
+	 * camera, il n'a rien à afficher.
+	 */
+	if (m_chunk) {
+		return m_chunk->GetMeshReady() || m_chunk->GetEvicted();
+	}
 
-		unsigned short newlevel = m_terrain->GetSubdivision(distance, iscamera);
+	// Un noeud sans chunk ni sous noeuds n'a rien à afficher.
+	return IsSubNodesChunkTreeReady();
+}
 
-		needcreatenode = (newlevel > m_level);
-		if (needcreatenode)
-			break;
+bool KX_ChunkNode::IsSubNodesChunkTreeReady() const
+{
+	if (m_nodeList) {
+		for (unsigned short i = 0; i < 4; ++i) {
+			if (!m_nodeList[i].IsChunkTreeReady()) {
+				return false;
+			}
+		}
 	}
 
-	return needcreatenode;
+	return true;
 }
 
-bool KX_ChunkNode::InNode(CListValue *objects) const
+bool KX_ChunkNode::NeedCreateNodes() const
 {
-	bool innode = false;
-
-	for (unsigned int i = 0; i < objects->GetCount(); ++i) {
-		KX_GameObject *object = (KX_GameObject *)objects->GetValue(i);
-
-		// Les même type de conditions que dans NeedCreateNodes.
-		if (!object->GetVisible() ||
-			!object->GetPhysicsController() ||
-			!object->GetPhysicsController()->IsDynamic() || 
-			object->GetPhysicsController()->IsSuspended())
-		{
-			continue;
-		}
+	return m_terrain->GetLodDrivers().NeedSubdivision(GetCenter(), m_radius, m_radiusMargin, m_level);
+}
 
-		const float objradius = object->GetSGNode()->Radius();
-		const float objdistance = GetCenter().distance(object->NodeGetWorldPosition()) - m_radius - objradius;
-		innode = (objdistance < 0.0f);
-		if (innode)
-			break;
+bool KX_ChunkNode::InNode() const
+{
+	// Les objets dynamiques utilisent les tuiles de collision.
+	if (m_terrain->GetUseCollisionTiles()) {
+		return false;
 	}
 
-	return innode;
+	return m_terrain->GetLodDrivers().TouchDynamic(GetCenter(), m_radius);
 }
 
 void KX_ChunkNode::MarkCulled(KX_Camera* culledcam)
@@ -250,6 +240,14 @@ MT_Point3 KX_ChunkNode::GetCenter() const
 	return MT_Point3(m_realPos.x(), m_realPos.y(), (m_maxBoxHeight + m_minBoxHeight) / 2.0f);
 }
 
+float KX_ChunkNode::GetProjectedError(const MT_Point3& point) const
+{
+	// On évite une division par zero quand le point est dans le noeud.
+	const float distance = GetCenter().distance(point) - m_radius;
+	const float mindistance = m_radius * 0.01f;
+	return m_radius / ((distance > mindistance) ? distance : mindistance);
+}
+
 short KX_ChunkNode::IsCameraVisible(KX_Camera *cam)
 {
 	/*if (!m_onConstruct) {
@@ -262,7 +260,7 @@ short KX_ChunkNode::IsCameraVisible(KX_Camera *cam)
 	return cam->BoxInsideFrustum(m_box);
 }
 
-void KX_ChunkNode::CalculateVisible(KX_Camera *culledcam, CListValue *objects)
+void KX_ChunkNode::CalculateVisible(KX_Camera *culledcam)
 {
 	// Renitialisation du proxy, on annule l'état modifié (si vrai).
 	m_proxy->SetModified(false);
@@ -276,31 +274,54 @@ void KX_ChunkNode::CalculateVisible(KX_Camera *culledcam, CListValue *objects)
 
 	// Si le noeud est visible.
 	if (m_culledState != KX_Camera::OUTSIDE) {
+		// Le chunk revient dans le champ de la camera, on reconstruit son mesh.
+		if (m_chunk && m_chunk->GetEvicted()) {
+			m_terrain->RestoreChunk(m_chunk);
+		}
+
 		/* Le noeud est a une distance suffisante d'un des objets dans 
-		 * la liste requise pour une subdivision.
+		 * la liste requise pour une subdivision. Au delà du budget mémoire
+		 * on ne créer plus de nouveaux noeuds.
 		 */
-		if (NeedCreateNodes(objects, culledcam)) {
+		if ((m_nodeList || !m_terrain->GetMemoryExceeded()) && NeedCreateNodes()) {
 			// Donc on subdivise les noeuds.
 			ConstructNodes();
-			// Et supprimons le chunk.
-			DestructChunk();
 
 			// Puis on fais la même chose avec nos nouveaux noeuds.
 			for (unsigned short i = 0; i < 4; ++i)
-				m_nodeList[i]->CalculateVisible(culledcam, objects);
+				m_nodeList[i].CalculateVisible(culledcam);
+
+			/* On garde l'ancien chunk affiché tant que les chunks des sous
+			 * noeuds sont en construction.
+			 */
+			if (m_chunk && !IsSubNodesChunkTreeReady()) {
+				m_chunk->SetVisible(true);
+				DisableSubNodesChunkVisibility();
+			}
+			// Sinon supprimons le chunk.
+			else {
+				DestructChunk();
+			}
 		}
 		// Sinon si aucun des objets n'est assez près.
 		else {
-			// On détruit les anciens noeuds.
-			DestructNodes();
-			// Et créons le chunk.
+			// On créer le chunk.
 			ConstructChunk();
+			/* Et détruisons les anciens noeuds si le chunk est prêt, sinon
+			 * on garde les chunks des sous noeuds affichés.
+			 */
+			if (m_nodeList && !m_chunk->GetMeshReady()) {
+				DisableChunkVisibility();
+			}
+			else {
+				DestructNodes();
+			}
 		}
 	}
 	// Si le noeud est invisible.
 	else {
 		// Si un des objets a sa position dans la zone recouverte par le noeud.
-		if (InNode(objects)) {
+		if (InNode()) {
 			/* Le seul moyen d'eviter de subdiviser à l'infinie les noeud.
 			 * Pour le cas où le noeud est visible GetSubdivision fait cette condition.
 			 */
@@ -312,7 +333,7 @@ void KX_ChunkNode::CalculateVisible(KX_Camera *culledcam, CListValue *objects)
 
 				// Puis on fais la même chose avec nos nouveau noeuds.
 				for (unsigned short i = 0; i < 4; ++i)
-					m_nodeList[i]->CalculateVisible(culledcam, objects);
+					m_nodeList[i].CalculateVisible(culledcam);
 			}
 			else {
 				ConstructChunk();
@@ -436,7 +457,7 @@ void KX_ChunkNode::DrawDebugInfo(short mode)
 
 	if (m_nodeList) {
 		for (unsigned int i = 0; i < 4; ++i)
-			m_nodeList[i]->DrawDebugInfo(mode);
+			m_nodeList[i].DrawDebugInfo(mode);
 	}
 }
 
@@ -462,7 +483,8 @@ void KX_ChunkNode::ExtendFrustumBoxHeights(float max, float min)
 		m_maxBoxHeight = max;
 		m_boxModified = true;
 	}
-	else if (min < m_minBoxHeight) {
+	// Une modification du terrain peut étendre la boite dans les deux sens.
+	if (min < m_minBoxHeight) {
 		m_minBoxHeight = min;
 		m_boxModified = true;
 	}
@@ -474,22 +496,22 @@ void KX_ChunkNode::ExtendFrustumBoxHeights(float max, float min)
 
 void KX_ChunkNode::GetFrustumBoxHeightsSampling()
 {
-	static const short relativeVertexesPos[5][2] = {
-		{-POLY_COUNT / 2, -POLY_COUNT / 2}, // bas-gauche
-		{ POLY_COUNT / 2, -POLY_COUNT / 2}, // bas-droite
-		{-POLY_COUNT / 2,  POLY_COUNT / 2}, // haut-gauche
-		{ POLY_COUNT / 2,  POLY_COUNT / 2}, // haut-droite
-		{ 0,               0} // centre
+	/* Le facteur pour passer de la position d'un noeud à celle d'un vertice absolue,
+	 * 2 = la taille minimun d'un noeud.
+	 */
+	const int scale = m_terrain->GetPolyCount() / 2;
+
+	const int relativeVertexesPos[5][2] = {
+		{-scale, -scale}, // bas-gauche
+		{ scale, -scale}, // bas-droite
+		{-scale,  scale}, // haut-gauche
+		{ scale,  scale}, // haut-droite
+		{ 0,      0} // centre
 	};
 
 	// la motie de la largeur du chunk
 	const unsigned short halfrelativesize = m_relativeSize / 2;
 
-	/* Le facteur pour passer de la position d'un noeud à celle d'un vertice absolue,
-	 * 2 = la taille minimun d'un noeud.
-	 */
-	const unsigned short scale = POLY_COUNT / 2;
-
 	for (unsigned short i = 0; i < 5; ++i) {
 		// le bas du chunk par rapport au terrain * 2 pour les vertices
 		const int x = m_relativePos.x * scale + relativeVertexesPos[i][0] * halfrelativesize;
@@ -515,89 +537,59 @@ KX_ChunkNode *KX_ChunkNode::GetNodeRelativePosition(float x, float y)
 	// La motié de la largeur.
 	const unsigned short relativewidth = m_relativeSize / 2;
 
-	/* Si le noeud est invisble on ne doit pas l'utiliser car il peut y
-	 * avoir de grandes differences de niveau entre un noeud et son noeud
-	 * adjacent invisible, ce qui peut causer des problèmes lors de la
-	 * création des jointures d'un chunk.
-	 */
-	if(m_culledState != KX_Camera::OUTSIDE &&
-	  (m_relativePos.x - relativewidth) < x && x < (m_relativePos.x + relativewidth) &&
-	  (m_relativePos.y - relativewidth) < y && y < (m_relativePos.y + relativewidth))
+	if (x <= (m_relativePos.x - relativewidth) || (m_relativePos.x + relativewidth) <= x ||
+		y <= (m_relativePos.y - relativewidth) || (m_relativePos.y + relativewidth) <= y)
 	{
-		if (m_nodeList) {
-			for (unsigned short i = 0; i < 4; ++i) {
-				KX_ChunkNode *ret = m_nodeList[i]->GetNodeRelativePosition(x, y);
-				if (ret) {
-					return ret;
-				}
-			}
-		}
-		else {
-			return this;
-		}
+		return NULL;
 	}
-	return NULL;
-}
-
-KX_ChunkNode *KX_ChunkNode::GetAdjacentParentNode(short x, short y) const
-{
-	const unsigned short halfrelativesize = m_relativeSize / 2;
-	const unsigned int halfterrainwidth = m_terrain->GetWidth() / 2;
 
-	KX_ChunkNode *parent = m_parentNode;
-
-	if (x != 0) {
-		int nodelevelposX = (m_relativePos.x - halfrelativesize + halfterrainwidth) / 2;
-		if (x == -1) {
-			nodelevelposX -= halfrelativesize;
-		}
-
-		if (nodelevelposX < 0 || nodelevelposX > (halfterrainwidth - m_relativeSize)) {
+	/* On descend directement dans le sous noeud contenant la position
+	 * plutôt que d'essayer les 4 sous noeuds récursivement.
+	 */
+	KX_ChunkNode *node = this;
+	while (true) {
+		/* Si le noeud est invisble on ne doit pas l'utiliser car il peut y
+		 * avoir de grandes differences de niveau entre un noeud et son noeud
+		 * adjacent invisible, ce qui peut causer des problèmes lors de la
+		 * création des jointures d'un chunk.
+		 */
+		if (node->m_culledState == KX_Camera::OUTSIDE) {
 			return NULL;
 		}
 
-		unsigned short size = m_relativeSize;
-
-		// Tant que non ne vas pas au dessus du noeud tronc.
-		while (parent) {
-			// Si i % s == s - 1 ça signifie qu'il faut passer au niveau superieur.
-			if ((nodelevelposX % size) == (size - halfrelativesize) && parent->GetParentNode()) {
-				// On accede au parent du dernier noeud parent.
-				parent = parent->GetParentNode();
-				size *= 2;
-			}
-			else {
-				break;
-			}
-		}
-	}
-	else if (y != 0) {
-		int nodelevelposY = (m_relativePos.y - halfrelativesize + halfterrainwidth) / 2;
-		if (y == -1) {
-			nodelevelposY -= halfrelativesize;
+		if (!node->m_nodeList) {
+			return node;
 		}
 
-		if (nodelevelposY < 0 || nodelevelposY > (halfterrainwidth - m_relativeSize)) {
+		const Point2D& pos = node->m_relativePos;
+		// Une position sur la limite entre deux sous noeuds n'appartient à aucun.
+		if (x == pos.x || y == pos.y) {
 			return NULL;
 		}
 
-		unsigned short size = m_relativeSize;
-
-		// Tant que non ne vas pas au dessus du noeud tronc.
-		while (parent) {
-			// Si i % s == s - 1 ça signifie qu'il faut passer au niveau superieur.
-			if ((nodelevelposY % size) == (size - halfrelativesize) && parent->GetParentNode()) {
-				// On accede au parent du dernier noeud parent.
-				parent = parent->GetParentNode();
-				size *= 2;
-			}
-			else {
-				break;
-			}
-		}
+		// Les sous noeuds sont rangés en x puis en y, voir KX_Terrain::NewNodeList.
+		node = &node->m_nodeList[((x > pos.x) ? 1 : 0) + ((y > pos.y) ? 2 : 0)];
 	}
+}
+
+KX_ChunkNode::Point2D KX_ChunkNode::GetGridPos() const
+{
+	return GetGridPos(m_relativePos, m_relativeSize, m_terrain->GetWidth());
+}
 
-	return parent;
+KX_ChunkNode::Point2D KX_ChunkNode::GetGridPos(const Point2D& relativePos, unsigned short relativeSize, unsigned short terrainWidth)
+{
+	// Le coin du noeud par rapport au coin du terrain divisé par la taille des noeuds de ce niveau.
+	const int halfterrainwidth = terrainWidth / 2;
+	const int halfrelativesize = relativeSize / 2;
+	return Point2D((relativePos.x - halfrelativesize + halfterrainwidth) / relativeSize,
+				   (relativePos.y - halfrelativesize + halfterrainwidth) / relativeSize);
+}
+
+KX_ChunkNode *KX_ChunkNode::GetAdjacentNode(short x, short y) const
+{
+	const Point2D gridPos = GetGridPos();
+	return m_terrain->GetNodeMap().GetNodeOrParent(m_level, gridPos.x + x, gridPos.y + y);
 }
 
 bool operator<(const KX_ChunkNode::Point2D& pos1, const KX_ChunkNode::Point2D& pos2)
@@ -89,25 +89,37 @@ private:
 	 * noeud a était modifié (sudivisé ou detruit).
 	 */
 	KX_ChunkNodeProxy *m_proxy;
-	/// Tableau de 4 sous noeuds.
-	KX_ChunkNode **m_nodeList;
+	/** Tableau de 4 sous noeuds contigus alloués par le terrain,
+	 * rangés en x puis en y.
+	 */
+	KX_ChunkNode *m_nodeList;
 	/// Le chunk ou objet avec mesh et physique.
 	KX_Chunk *m_chunk;
 
 	/// Le terrain utilisé comme usine à chunks.
 	KX_Terrain *m_terrain;
 
-	bool NeedCreateNodes(CListValue *objects, KX_Camera *culledcam) const;
-	bool InNode(CListValue *objects) const;
+	/// Vrai si un des objets de KX_Terrain::GetLodDrivers demande la subdivision du noeud.
+	bool NeedCreateNodes() const;
+	/// Vrai si un objet dynamique touche le noeud.
+	bool InNode() const;
 	void DestructNodes();
 	void ConstructNodes();
 	void DestructChunk();
 	void ConstructChunk();
 	void DisableChunkVisibility();
+	/// Rend invisible les chunks de tous les sous noeuds.
+	void DisableSubNodesChunkVisibility();
 
-	void MarkCulled(KX_Camera *culldecam);
+	/** Vrai si les meshs des chunks de ce noeud ou de ses sous noeuds
+	 * sont construits, utilisé pour garder l'ancien niveau de détail
+	 * affiché tant que le nouveau n'est pas prêt.
+	 */
+	bool IsChunkTreeReady() const;
+	/// Vrai si les chunks de tous les sous noeuds sont prêts.
+	bool IsSubNodesChunkTreeReady() const;
 
-	MT_Point3 GetCenter() const;
+	void MarkCulled(KX_Camera *culldecam);
 
 public:
 	KX_ChunkNode(KX_ChunkNode *parentNode,
@@ -117,10 +129,13 @@ public:
 				 KX_Terrain* terrain);
 	virtual ~KX_ChunkNode();
 
+	/// Le centre de la boite du noeud.
+	MT_Point3 GetCenter() const;
+
 	/// Teste si le noeud est visible par une camera.
 	short IsCameraVisible(KX_Camera *cam);
 	/// Teste si le noeud est visible et créer des sous noeuds si besoin.
-	void CalculateVisible(KX_Camera *culledcam, CListValue *objects);
+	void CalculateVisible(KX_Camera *culledcam);
 	/// Draw debug info for culling box
 	void DrawDebugInfo(short mode);
 
@@ -137,13 +152,29 @@ public:
 	 */
 	void GetFrustumBoxHeightsSampling();
 
+	/** Renvoie le noeud final visible contenant une position relative,
+	 * ou NULL si un des noeuds traversés est invisible.
+	 */
 	KX_ChunkNode *GetNodeRelativePosition(float x, float y);
 
-	/** Renvoie le noeud parent du noeud adjacent qu'on veut trouver.
+	/** L'erreur projetée du noeud vue depuis un point : le rapport entre son
+	 * rayon et sa distance au point. Utilisée pour la priorité de construction.
+	 */
+	float GetProjectedError(const MT_Point3& point) const;
+
+	/** Renvoie le noeud adjacent de même niveau ou, si il n'existe pas, le
+	 * plus proche de ses parents existant. NULL en dehors du terrain.
 	 * \param x Le position du en x noeud ajecent par rapport a ce noeud : -1 / 0 / 1.
 	 * \param y Comme l'argument x mais pour en y.
 	 */
-	KX_ChunkNode *GetAdjacentParentNode(short x, short y) const;
+	KX_ChunkNode *GetAdjacentNode(short x, short y) const;
+
+	/// La position du noeud dans la grille des noeuds de son niveau.
+	Point2D GetGridPos() const;
+	/** La position dans la grille des noeuds de son niveau d'un noeud de taille relative
+	 * relativeSize centré en relativePos sur un terrain de largeur relative terrainWidth.
+	 */
+	static Point2D GetGridPos(const Point2D& relativePos, unsigned short relativeSize, unsigned short terrainWidth);
 
 	inline KX_Terrain *GetTerrain() const
 	{
@@ -201,6 +232,16 @@ public:
 		return m_parentNode;
 	}
 
+	inline float GetRadius() const
+	{
+		return m_radius;
+	}
+
+	inline float GetRadiusMargin() const
+	{
+		return m_radiusMargin;
+	}
+
 	static unsigned int m_activeNode;
 };
 
@@ -0,0 +1,176 @@
+ /*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Contributor(s): none yet.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file gameengine/Ketsji/KXTerrain/KX_ChunkNodeMap.cpp
+ *  \ingroup ketsji
+ */
+
+#include "KX_ChunkNodeMap.h"
+
+#include "BLI_utildefines.h"
+
+#include <stdlib.h>
+
+/// La taille initiale de la table.
+#define NODE_MAP_MIN_CAPACITY 256
+
+/// Intercale un bit nul entre chacun des 16 premiers bits de value.
+static uint32_t morton_part1by1(uint32_t value)
+{
+	value &= 0x0000FFFF;
+	value = (value | (value << 8)) & 0x00FF00FF;
+	value = (value | (value << 4)) & 0x0F0F0F0F;
+	value = (value | (value << 2)) & 0x33333333;
+	value = (value | (value << 1)) & 0x55555555;
+	return value;
+}
+
+KX_ChunkNodeMap::KX_ChunkNodeMap()
+	:m_capacity(NODE_MAP_MIN_CAPACITY),
+	m_count(0)
+{
+	m_entries = (Entry *)calloc(m_capacity, sizeof(Entry));
+}
+
+KX_ChunkNodeMap::~KX_ChunkNodeMap()
+{
+	// Les noeuds se retirent eux même de la table à leur destruction.
+	BLI_assert(m_count == 0);
+	free(m_entries);
+}
+
+uint64_t KX_ChunkNodeMap::GetKey(unsigned short level, unsigned int x, unsigned int y)
+{
+	return ((uint64_t)level << 32) | (morton_part1by1(x) | (morton_part1by1(y) << 1));
+}
+
+unsigned int KX_ChunkNodeMap::Hash(uint64_t key) const
+{
+	uint64_t hash = key * 0x9E3779B97F4A7C15ull;
+	hash ^= hash >> 32;
+	return (unsigned int)hash & (m_capacity - 1);
+}
+
+unsigned int KX_ChunkNodeMap::FindSlot(uint64_t key) const
+{
+	unsigned int index = Hash(key);
+	// La table n'est jamais pleine, on trouve toujours un emplacement libre.
+	while (m_entries[index].node && m_entries[index].key != key) {
+		index = (index + 1) & (m_capacity - 1);
+	}
+	return index;
+}
+
+void KX_ChunkNodeMap::Grow()
+{
+	Entry *oldEntries = m_entries;
+	const unsigned int oldCapacity = m_capacity;
+
+	m_capacity *= 2;
+	m_entries = (Entry *)calloc(m_capacity, sizeof(Entry));
+
+	for (unsigned int i = 0; i < oldCapacity; ++i) {
+		const Entry& entry = oldEntries[i];
+		if (entry.node) {
+			m_entries[FindSlot(entry.key)] = entry;
+		}
+	}
+
+	free(oldEntries);
+}
+
+void KX_ChunkNodeMap::AddNode(KX_ChunkNode *node, unsigned short level, unsigned int x, unsigned int y)
+{
+	if ((m_count + 1) * 2 > m_capacity) {
+		Grow();
+	}
+
+	const uint64_t key = GetKey(level, x, y);
+	Entry& entry = m_entries[FindSlot(key)];
+	BLI_assert(!entry.node);
+
+	entry.key = key;
+	entry.node = node;
+	++m_count;
+}
+
+void KX_ChunkNodeMap::RemoveNode(KX_ChunkNode *node, unsigned short level, unsigned int x, unsigned int y)
+{
+	const unsigned int mask = m_capacity - 1;
+	unsigned int index = FindSlot(GetKey(level, x, y));
+
+	if (m_entries[index].node != node) {
+		return;
+	}
+
+	m_entries[index].node = NULL;
+	--m_count;
+
+	/* Suppression sans marqueur : les noeuds suivants qui ne sont plus
+	 * accessibles depuis leur emplacement idéal sont décalés dans le trou.
+	 */
+	unsigned int next = (index + 1) & mask;
+	while (m_entries[next].node) {
+		const unsigned int ideal = Hash(m_entries[next].key);
+		// Le trou est entre l'emplacement idéal et l'emplacement actuel.
+		if (((next - ideal) & mask) >= ((next - index) & mask)) {
+			m_entries[index] = m_entries[next];
+			m_entries[next].node = NULL;
+			index = next;
+		}
+		next = (next + 1) & mask;
+	}
+}
+
+KX_ChunkNode *KX_ChunkNodeMap::GetNode(unsigned short level, unsigned int x, unsigned int y) const
+{
+	return m_entries[FindSlot(GetKey(level, x, y))].node;
+}
+
+KX_ChunkNode *KX_ChunkNodeMap::GetNodeOrParent(unsigned short level, int x, int y) const
+{
+	// Le nombre de noeuds en largeur à ce niveau.
+	const int nodecount = 1 << (level - 1);
+	if (x < 0 || y < 0 || x >= nodecount || y >= nodecount) {
+		return NULL;
+	}
+
+	/* Si le noeud de ce niveau n'existe pas, le premier de ses parents existant
+	 * est forcement un noeud final, un parent est à la position de grille
+	 * divisée par deux au niveau précédent.
+	 */
+	for (; level > 0; --level) {
+		KX_ChunkNode *node = GetNode(level, x, y);
+		if (node) {
+			return node;
+		}
+		x >>= 1;
+		y >>= 1;
+	}
+
+	return NULL;
+}
+
+size_t KX_ChunkNodeMap::GetMemoryUsage() const
+{
+	return m_capacity * sizeof(Entry);
+}
@@ -0,0 +1,88 @@
+ /*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Contributor(s): none yet.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+#ifndef __KX_CHUNK_NODE_MAP_H__
+#define __KX_CHUNK_NODE_MAP_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+class KX_ChunkNode;
+
+/** Index de tous les noeuds du terrain : une table de hachage à adressage
+ * ouvert dont la clé est le niveau d'un noeud et le code de Morton de sa
+ * position dans la grille des noeuds de ce niveau. On trouve ainsi un noeud
+ * adjacent en temps constant sans parcourir le QuadTree.
+ * La table est utilisée uniquement par le thread principal.
+ */
+class KX_ChunkNodeMap
+{
+private:
+	struct Entry
+	{
+		uint64_t key;
+		/// Le noeud, NULL si l'emplacement est libre.
+		KX_ChunkNode *node;
+	};
+
+	Entry *m_entries;
+	/// La taille de la table, toujours une puissance de deux.
+	unsigned int m_capacity;
+	/// Le nombre de noeuds dans la table.
+	unsigned int m_count;
+
+	unsigned int Hash(uint64_t key) const;
+	/// Renvoie l'indice de l'emplacement du noeud ou du premier emplacement libre.
+	unsigned int FindSlot(uint64_t key) const;
+	/// Double la taille de la table et replace tous les noeuds.
+	void Grow();
+
+public:
+	KX_ChunkNodeMap();
+	~KX_ChunkNodeMap();
+
+	/** La clé d'un noeud : son niveau dans les 32 bits de poids fort et le code
+	 * de Morton de sa position x, y dans la grille de son niveau.
+	 */
+	static uint64_t GetKey(unsigned short level, unsigned int x, unsigned int y);
+
+	/// Ajoute un noeud à sa position de grille, la table ne lit jamais le noeud.
+	void AddNode(KX_ChunkNode *node, unsigned short level, unsigned int x, unsigned int y);
+	void RemoveNode(KX_ChunkNode *node, unsigned short level, unsigned int x, unsigned int y);
+	/// Renvoie le noeud de ce niveau à cette position de grille ou NULL si il n'existe pas.
+	KX_ChunkNode *GetNode(unsigned short level, unsigned int x, unsigned int y) const;
+	/** Renvoie le noeud de ce niveau à cette position de grille ou, si il n'existe pas,
+	 * le plus proche de ses parents existant. La grille du niveau 1 est la racine seule,
+	 * NULL en dehors de la grille.
+	 */
+	KX_ChunkNode *GetNodeOrParent(unsigned short level, int x, int y) const;
+
+	inline unsigned int GetCount() const
+	{
+		return m_count;
+	}
+
+	/// La mémoire utilisée par la table en octets.
+	size_t GetMemoryUsage() const;
+};
+
+#endif  // __KX_CHUNK_NODE_MAP_H__
@@ -0,0 +1,48 @@
+ /*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Contributor(s): none yet.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+#ifndef __KX_IDEFORMABLE_TERRAIN_H__
+#define __KX_IDEFORMABLE_TERRAIN_H__
+
+class VertexZoneInfo;
+
+/** Le terrain vu par KX_TerrainDeformation : la lecture des vertices calculés
+ * par les zones et l'invalidation des zones modifiées. Implémentée par KX_Terrain.
+ */
+class KX_IDeformableTerrain
+{
+public:
+	virtual ~KX_IDeformableTerrain()
+	{
+	}
+
+	/** Les informations de plusieurs vertices à la fois.
+	 * \param x Les positions en x relatives au terrain.
+	 * \param y Les positions en y relatives au terrain.
+	 * \param r_infos Les informations de chaque vertice, à libérer avec Release.
+	 */
+	virtual void GetVertexInfos(unsigned int count, const int *x, const int *y, VertexZoneInfo **r_infos) const = 0;
+	/// Invalide les vertices d'un rectangle en coordonnées réelles.
+	virtual void InvalidateArea(float minx, float miny, float maxx, float maxy) = 0;
+};
+
+#endif  // __KX_IDEFORMABLE_TERRAIN_H__
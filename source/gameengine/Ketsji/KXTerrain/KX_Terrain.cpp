@@ -24,16 +24,46 @@
 #include "KX_Terrain.h"
 #include "KX_Chunk.h"
 #include "KX_ChunkCache.h"
+#include "KX_TerrainPool.h"
+#include "KX_TerrainTileStore.h"
+#include "KX_TerrainCollisionTiles.h"
+#include "KX_TerrainDeformation.h"
+#include "KX_ChunkMotionState.h"
 
 #include "KX_Camera.h"
-#include "KX_PythonInit.h"
 #include "KX_Scene.h"
+#include "KX_PyMath.h"
+#include "KX_Profiler.h"
+
+#include "SG_Node.h"
 
 #include "RAS_IRasterizer.h"
+#include "RAS_MaterialBucket.h"
+
+#include "PHY_IPhysicsController.h"
 
 #include "DNA_terrain_types.h"
 #include "DNA_material_types.h"
 
+#ifdef WITH_BULLET
+#include "CcdPhysicsEnvironment.h"
+#include "CcdPhysicsController.h"
+
+#include "BulletCollision/CollisionShapes/btHeightfieldTerrainShape.h"
+#endif
+
+#include "BLI_task.h"
+#include "BLI_math.h"
+extern "C" {
+#include "BLI_hash_mm2a.h"
+#include "PIL_time.h"
+}
+
+#include "atomic_ops.h"
+
+#include <algorithm>
+#include <new>
+
 #define DEBUG(msg) // std::cout << "Debug (" << __func__ << ", " << this << ") : " << msg << std::endl;
 
 KX_Terrain::KX_Terrain(void *sgReplicationInfo,
@@ -42,37 +72,69 @@ KX_Terrain::KX_Terrain(void *sgReplicationInfo,
 					   Material *material,
 					   unsigned short maxLevel,
 					   unsigned short minPhysicsLevel,
+					   bool useHeightfieldPhysics,
+					   bool useCollisionTiles,
 					   unsigned short vertexSubdivision,
 					   unsigned short width,
 					   float cameraMaxDistance,
 					   float objectMaxDistance,
 					   float chunkSize,
 					   float marginFactor,
+					   float buildBudget,
+					   float morphRange,
+					   float morphTime,
+					   bool occluder,
 					   short debugMode,
 					   unsigned short debugTimeFrame,
 					   bool useCache,
-					   unsigned short cacheRefreshTime)
+					   unsigned int cacheMemory,
+					   unsigned int memoryBudget,
+					   bool useTileStore,
+					   const std::string& tileStorePath)
 	:KX_GameObject(sgReplicationInfo, callbacks),
 	m_bucket(bucket),
 	m_material(material),
 	m_maxChunkLevel(maxLevel),
 	m_minPhysicsLevel(minPhysicsLevel),
+	m_useHeightfieldPhysics(useHeightfieldPhysics),
+	m_useCollisionTiles(useCollisionTiles),
+	m_collisionTiles(NULL),
 	m_vertexSubdivision(vertexSubdivision),
 	m_width(width),
 	m_cameraMaxDistance(cameraMaxDistance),
 	m_objectMaxDistance(objectMaxDistance),
 	m_chunkSize(chunkSize),
 	m_marginFactor(marginFactor),
+	m_buildBudget(buildBudget),
+	m_morphRange(morphRange),
+	m_morphTime(morphTime),
+	m_occluder(occluder),
 	m_debugMode(debugMode),
 	m_debugTimeFrame(debugTimeFrame),
 	m_construct(false),
 	m_debugFrame(0),
+	m_nodeTree(NULL),
+	m_scheduledChunkCount(0),
+	m_lodDrivers(maxLevel, cameraMaxDistance, objectMaxDistance, marginFactor),
 	m_useCache(useCache),
-	m_cacheRefreshTime(cacheRefreshTime),
-	m_cacheFrame(0)
+	m_cacheMemory(cacheMemory),
+	m_chunkCache(NULL),
+	m_memoryBudget(memoryBudget),
+	m_memoryExceeded(false),
+	m_frame(0),
+	m_useTileStore(useTileStore),
+	m_tileStorePath(tileStorePath),
+	m_tileStore(NULL),
+	m_deformation(NULL),
+	m_taskPool(NULL),
+	m_taskScheduler(NULL)
 {
 	SetName("Terrain");
 
+	for (unsigned short i = 0; i < MEMORY_MAX; ++i) {
+		m_memoryUsage[i] = 0;
+	}
+
 	unsigned int realmaxlevel = 0;
 	for (unsigned int i = 1; i < m_width; i *= 2) {
 		++realmaxlevel;
@@ -83,7 +145,28 @@ KX_Terrain::KX_Terrain(void *sgReplicationInfo,
 		m_maxChunkLevel = realmaxlevel;
 	}
 
-	m_chunkRootCache = new KX_ChunkRootCache(m_width * (POLY_COUNT / 2), this);
+	// Les jointures demandent un nombre de faces divisible par 4 à tous les niveaux.
+	m_polyCount = 4;
+	while (m_polyCount < m_vertexSubdivision) {
+		m_polyCount *= 2;
+	}
+
+	if (m_polyCount != m_vertexSubdivision) {
+		std::cout << "Warning: vertex subdivision must be a power of two greater than 4, using : " << m_polyCount << std::endl;
+	}
+	m_vertexCount = m_polyCount + 1;
+
+	m_vertexInfoPool = new KX_TerrainPool(sizeof(VertexZoneInfo), 512);
+	// Environ 1600 vertices par bloc de l'allocateur quelque soit la taille des chunks.
+	m_vertexPool = new KX_TerrainPool(KX_Chunk::GetVertexesMemorySize(m_vertexCount),
+									  std::max(1600 / (m_vertexCount * m_vertexCount), 4));
+	m_nodePool = new KX_TerrainPool(sizeof(KX_ChunkNode) * 4, 64);
+
+	BLI_spin_init(&m_cacheLock);
+	m_invalidationCount = 0;
+
+	// Les modifications sont gardées quand le terrain est détruit puis reconstruit.
+	m_deformation = new KX_TerrainDeformation(this, std::max(m_width >> m_maxChunkLevel, 1), GetQueryCellSize());
 }
 
 KX_Terrain::~KX_Terrain()
@@ -92,68 +175,260 @@ KX_Terrain::~KX_Terrain()
 
 	for (unsigned short i = 0; i < m_zoneMeshList.size(); ++i)
 		delete m_zoneMeshList[i];
+
+	delete m_deformation;
+
+	// Tous les chunks et le cache sont supprimés, les allocateurs sont vides.
+	delete m_vertexInfoPool;
+	delete m_vertexPool;
+	delete m_nodePool;
+
+	BLI_spin_end(&m_cacheLock);
+}
+
+/// La tache executée dans un thread de travail pour construire les vertices d'un chunk.
+static void construct_chunk_vertexes_task(TaskPool *pool, void *taskdata, int UNUSED(threadid))
+{
+	KX_Terrain *terrain = (KX_Terrain *)BLI_task_pool_userdata(pool);
+	KX_Chunk *chunk = (KX_Chunk *)taskdata;
+	terrain->ConstructChunkVertexes(chunk);
+}
+
+/// Trie les chunks du plus prioritaire au moins prioritaire.
+static bool chunk_build_priority_greater(KX_Chunk *chunk1, KX_Chunk *chunk2)
+{
+	return chunk1->GetBuildPriority() > chunk2->GetBuildPriority();
+}
+
+double KX_Terrain::GetTime()
+{
+	return PIL_check_seconds_timer();
 }
 
 void KX_Terrain::Construct()
 {
 	DEBUG("Construct terrain");
 
-	m_chunkRootCache->Construct();
+	m_taskPool = BLI_task_pool_create(m_taskScheduler, this);
+
+	if (m_useCache) {
+		m_chunkCache = new KX_ChunkCache((size_t)m_cacheMemory * 1024 * 1024);
+	}
+
+	/* Les zones utilisant des objets changent pendant le jeu, leurs vertices
+	 * ne peuvent pas être stockés sur le disque.
+	 */
+	bool dynamicZones = false;
+	for (unsigned short i = 0; i < m_zoneMeshList.size(); ++i) {
+		dynamicZones |= m_zoneMeshList[i]->GetUseObjects();
+	}
+
+	if (m_useTileStore && dynamicZones) {
+		std::cout << "Warning: terrain tile store disabled, a zone uses objects" << std::endl;
+	}
+	else if (m_useTileStore) {
+		m_tileStore = new KX_TerrainTileStore(m_tileStorePath, GetTileStoreKey());
+	}
+
 	m_nodeTree = new KX_ChunkNode(NULL, 0, 0, m_width, 1, this);
+
+	if (m_useCollisionTiles) {
+		m_collisionTiles = new KX_TerrainCollisionTiles(this, std::max(std::min(m_minPhysicsLevel, m_maxChunkLevel), (unsigned short)1));
+	}
+
 	m_construct = true;
 }
 
 void KX_Terrain::Destruct()
 {
 	DEBUG("Destruct terrain");
+
+	// On attend la fin de toutes les constructions de chunks en cours.
+	if (m_taskPool) {
+		BLI_task_pool_work_and_wait(m_taskPool);
+		BLI_task_pool_free(m_taskPool);
+		m_taskPool = NULL;
+	}
+
 	// destruction du noeud principal
 	if (m_nodeTree)
 		delete m_nodeTree;
 
-	m_chunkRootCache->Destruct();
-	delete m_chunkRootCache;
+	if (m_collisionTiles) {
+		delete m_collisionTiles;
+		m_collisionTiles = NULL;
+	}
+
+	if (m_chunkCache) {
+		delete m_chunkCache;
+		m_chunkCache = NULL;
+	}
+
+	// Les tuiles modifiées sont écrites sur le disque à la suppression.
+	if (m_tileStore) {
+		delete m_tileStore;
+		m_tileStore = NULL;
+	}
 
 	ScheduleEuthanasyChunks();
+
+	// Les meshs des chunks encore existants gardent leurs propres références.
+	for (std::map<uint64_t, RAS_IndexArray *>::iterator it = m_polygonTemplates.begin(); it != m_polygonTemplates.end(); ++it) {
+		it->second->Release();
+	}
+	m_polygonTemplates.clear();
 }
 
-void KX_Terrain::CalculateVisibleChunks(KX_Camera* culledcam)
+void KX_Terrain::CalculateVisibleChunks(KX_Camera* culledcam, CListValue *objects)
 {
+	KX_PROFILE_ZONE("Terrain CalculateVisibleChunks");
+
 	if (!m_construct)
 		Construct();
 
-	CListValue *objects = KX_GetActiveScene()->GetObjectList();
+	m_cameraPosition = culledcam->NodeGetWorldPosition();
+
+	// Les zones invalident les vertices sous les objets qui ont bougés.
+	for (unsigned short i = 0; i < m_zoneMeshList.size(); ++i) {
+		m_zoneMeshList[i]->UpdateObjects(objects);
+	}
+	// Les modifications de la frame précédente sont invalidées en une fois.
+	m_deformation->Flush();
 
-	m_nodeTree->CalculateVisible(culledcam, objects);
+	UpdateLodDrivers(objects, culledcam);
+	{
+		KX_PROFILE_ZONE("Terrain Quadtree");
+		m_nodeTree->CalculateVisible(culledcam);
+	}
+
+	if (m_collisionTiles) {
+		m_collisionTiles->Update(objects);
+	}
+
+	UpdateMemoryBudget();
 
 	ScheduleEuthanasyChunks();
+	SchedulePendingChunks();
+}
+
+void KX_Terrain::UpdateLodDrivers(CListValue *objects, KX_Camera *culledcam)
+{
+	m_lodDrivers.Clear();
+
+	/* Les conditions ne dépendent pas des noeuds, on parcourt la liste des objets
+	 * une seule fois par frame plutôt qu'une fois par noeud.
+	 */
+	for (unsigned int i = 0; i < objects->GetCount(); ++i) {
+		KX_GameObject *object = (KX_GameObject *)objects->GetValue(i);
+
+		const bool iscamera = (object->GetGameObjectType() == SCA_IObject::OBJ_CAMERA);
+		const bool dynamic = object->GetVisible() &&
+							 object->GetPhysicsController() &&
+							 object->GetPhysicsController()->IsDynamic() &&
+							 !object->GetPhysicsController()->IsSuspended();
+
+		if (!dynamic) {
+			// Seules les cameras actives comptent parmi les objets non dynamiques.
+			if (!iscamera) {
+				continue;
+			}
+
+			KX_Camera *cam = (KX_Camera *)object;
+			if (cam != culledcam && !cam->GetViewport()) {
+				continue;
+			}
+		}
+		/* Avec les tuiles de collision les objets dynamiques n'ont pas besoin
+		 * de noeuds subdivisés, seules les cameras comptent.
+		 */
+		else if (!iscamera && m_useCollisionTiles) {
+			continue;
+		}
+
+		m_lodDrivers.AddDriver(object->NodeGetWorldPosition(), object->GetSGNode()->Radius(), iscamera, dynamic);
+	}
+
+	m_lodDrivers.BuildGrid();
 }
 
 void KX_Terrain::UpdateChunksMeshes()
 {
+	KX_PROFILE_ZONE("Terrain UpdateChunksMeshes");
+
+	// Les chunks dont le mesh doit être construit ou reconstruit cette frame.
+	std::vector<KX_Chunk *> buildChunkList;
+
 	for (KX_ChunkList::iterator it = m_chunkList.begin(); it != m_chunkList.end(); ++it) {
-		(*it)->UpdateMesh();
+		KX_Chunk *chunk = *it;
+		/* Le rafraichissement des vertices attend son tour avec les constructions
+		 * puis le nouveau mesh est construit dans le budget comme les autres.
+		 */
+		if (chunk->GetInvalidated() && chunk->GetVertexesReady()) {
+			chunk->QueueRefreshVertexes();
+			m_pendingChunkList.push_back(chunk);
+		}
+		chunk->UpdateMesh();
+		// Un mesh en attente n'est pas construit pendant le rafraichissement de ses vertices.
+		if (chunk->GetMeshOnConstruct() && chunk->GetVertexesReady()) {
+			chunk->ComputeBuildPriority(m_cameraPosition);
+			buildChunkList.push_back(chunk);
+		}
 	}
 
-	for (KX_ChunkList::iterator it = m_chunkList.begin(); it != m_chunkList.end(); ++it) {
+	std::sort(buildChunkList.begin(), buildChunkList.end(), chunk_build_priority_greater);
+
+	/* On construit les meshs par ordre de priorité jusqu'à épuisement du temps
+	 * alloué, les autres restent en construction pour les frames suivantes.
+	 * Au moins un mesh est construit par frame pour toujours avancer.
+	 */
+	const double budget = m_buildBudget / 1000.0;
+	const double starttime = GetTime();
+	unsigned int builtChunks = 0;
+	for (std::vector<KX_Chunk *>::iterator it = buildChunkList.begin(); it != buildChunkList.end(); ++it) {
+		if (budget > 0.0 && builtChunks > 0 && (GetTime() - starttime) > budget) {
+			break;
+		}
 		(*it)->EndUpdateMesh();
+		++builtChunks;
+	}
+
+	// Transition des vertices entre les niveaux selon la distance à la camera.
+	if (m_morphRange > 0.0f || m_morphTime > 0.0f) {
+		const double time = GetTime();
+		for (KX_ChunkList::iterator it = m_chunkList.begin(); it != m_chunkList.end(); ++it) {
+			(*it)->UpdateMorph(m_cameraPosition, time);
+		}
 	}
 
+	const unsigned int deferredChunks = buildChunkList.size() - builtChunks;
+	KX_Chunk::deferredMeshBuilds += deferredChunks;
+	KX_Chunk::meshQueueDepth = std::max(KX_Chunk::meshQueueDepth, deferredChunks);
+	KX_Chunk::vertexesQueueDepth = std::max(KX_Chunk::vertexesQueueDepth, (unsigned int)m_pendingChunkList.size());
+
 	if (m_debugMode & DEBUG_TIME) {
 		if (m_debugFrame > m_debugTimeFrame) {
 			KX_Chunk::PrintTime();
+			std::cout << "Pool Stats : " << std::endl;
+			m_vertexInfoPool->PrintStats("Vertex Infos");
+			m_vertexPool->PrintStats("Chunk Vertexes");
+			m_nodePool->PrintStats("Nodes");
+			PrintMemoryStats();
+			if (m_tileStore) {
+				KX_TerrainTileStore::PrintTime();
+				KX_TerrainTileStore::ResetTime();
+			}
+			if (m_collisionTiles) {
+				KX_TerrainCollisionTiles::PrintTime();
+				KX_TerrainCollisionTiles::ResetTime();
+			}
+			KX_TerrainDeformation::PrintTime();
+			KX_TerrainDeformation::ResetTime();
+			std::cout << std::endl;
 			KX_Chunk::ResetTime();
 			m_debugFrame = 0;
 		}
 		++m_debugFrame;
 	}
-
-	if (m_useCache) {
-		if (m_cacheFrame > m_cacheRefreshTime) {
-			m_chunkRootCache->Refresh();
-			m_cacheFrame = 0;
-		}
-		++m_cacheFrame;
-	}
 }
 
 void KX_Terrain::RenderChunksMeshes(KX_Camera *cam, RAS_IRasterizer* rasty)
@@ -165,10 +440,37 @@ void KX_Terrain::RenderChunksMeshes(KX_Camera *cam, RAS_IRasterizer* rasty)
 			if (chunk->GetNode()->IsCameraVisible(cam) != KX_Camera::OUTSIDE)
 				continue;
 		}
+		// Un chunk caché par le terrain ou les objets de la scène peut toujours projeter une ombre.
+		else if (chunk->GetOccluded()) {
+			continue;
+		}
 		chunk->RenderMesh(rasty, cam);
 	}
 }
 
+void KX_Terrain::AddOccluders(PHY_IOcclusionBuffer *buffer)
+{
+	for (KX_ChunkList::iterator it = m_chunkList.begin(); it != m_chunkList.end(); ++it) {
+		KX_Chunk *chunk = *it;
+		/* Seuls les chunks affichés à la frame précédente servent d'occluders, un chunk
+		 * caché ne cache rien de plus que ceux qui le cachent.
+		 */
+		if (!chunk->GetVisible() || !chunk->GetMeshReady() || chunk->GetOccluded() ||
+			chunk->GetNode()->GetCulledState() == KX_Camera::OUTSIDE)
+		{
+			continue;
+		}
+		chunk->AddOccluder(buffer);
+	}
+}
+
+void KX_Terrain::CalculateOccludedChunks(PHY_IOcclusionBuffer *buffer)
+{
+	for (KX_ChunkList::iterator it = m_chunkList.begin(); it != m_chunkList.end(); ++it) {
+		(*it)->UpdateOcclusion(buffer);
+	}
+}
+
 void KX_Terrain::DrawDebugNode()
 {
 	m_nodeTree->DrawDebugInfo(m_debugMode);
@@ -176,15 +478,14 @@ void KX_Terrain::DrawDebugNode()
 
 unsigned short KX_Terrain::GetSubdivision(float distance, bool iscamera) const
 {
-	// les objets non pas besoin d'une aussi grande subdivision que la camera
-	const float maxdistance = iscamera ? m_cameraMaxDistance : m_objectMaxDistance;
-	const float interval = maxdistance / m_maxChunkLevel;
-	for (unsigned short i = 0; i <= m_maxChunkLevel; ++i) {
-		if (distance < (interval * (i + 1))) {
-			return m_maxChunkLevel - i;
-		}
-	}
-	return 0;
+	return m_lodDrivers.GetSubdivision(distance, iscamera);
+}
+
+float KX_Terrain::GetLevelMaxDistance(unsigned short level) const
+{
+	// Un noeud du niveau précédent n'est plus subdivisé à partir de cette distance, voir GetSubdivision.
+	const float interval = m_cameraMaxDistance / m_maxChunkLevel;
+	return interval * (m_maxChunkLevel - level + 1);
 }
 
 KX_ChunkNode *KX_Terrain::GetNodeRelativePosition(float x, float y)
@@ -197,14 +498,41 @@ KX_ChunkNode *KX_Terrain::GetNodeRelativePosition(float x, float y)
 
 VertexZoneInfo *KX_Terrain::GetVertexInfo(int x, int y) const
 {
-	VertexZoneInfo *vertexInfo;
+	if (!m_useCache) {
+		return NewVertexInfo(x, y);
+	}
 
-	if (m_useCache) {
-		vertexInfo = m_chunkRootCache->GetVertexZoneInfo(x, y);
+	BLI_spin_lock(&m_cacheLock);
+	VertexZoneInfo *vertexInfo = m_chunkCache->GetVertexZoneInfo(x, y);
+	if (vertexInfo) {
 		vertexInfo->AddRef();
+		BLI_spin_unlock(&m_cacheLock);
+		return vertexInfo;
+	}
+	const unsigned int invalidationCount = m_invalidationCount;
+	BLI_spin_unlock(&m_cacheLock);
+
+	/* Le calcul du vertice est fait en dehors du verrou pour que les
+	 * threads de construction des chunks ne s'attendent pas entre eux.
+	 */
+	VertexZoneInfo *newVertexInfo = NewVertexInfo(x, y);
+
+	BLI_spin_lock(&m_cacheLock);
+	// Une zone a changé pendant le calcul, le vertice peut être périmé et n'est pas gardé.
+	if (invalidationCount != m_invalidationCount) {
+		vertexInfo = newVertexInfo;
 	}
 	else {
-		vertexInfo = NewVertexInfo(x, y);
+		vertexInfo = m_chunkCache->AddVertexZoneInfo(x, y, newVertexInfo);
+		if (vertexInfo != newVertexInfo) {
+			vertexInfo->AddRef();
+		}
+	}
+	BLI_spin_unlock(&m_cacheLock);
+
+	// Un autre thread a créé le même vertice avant nous.
+	if (vertexInfo != newVertexInfo) {
+		newVertexInfo->Release();
 	}
 
 	return vertexInfo;
@@ -212,52 +540,731 @@ VertexZoneInfo *KX_Terrain::GetVertexInfo(int x, int y) const
 
 VertexZoneInfo *KX_Terrain::NewVertexInfo(int x, int y) const
 {
-	VertexZoneInfo *info = new VertexZoneInfo();
+	VertexZoneInfo *info;
+	NewVertexInfos(1, &x, &y, &info);
+	return info;
+}
+
+void KX_Terrain::GetVertexInfos(unsigned int count, const int *x, const int *y, VertexZoneInfo **r_infos) const
+{
+	if (!m_useCache) {
+		NewVertexInfos(count, x, y, r_infos);
+		return;
+	}
+
+	// Les indices et positions des vertices absents du cache.
+	std::vector<unsigned int> missIndices;
+	std::vector<int> missx;
+	std::vector<int> missy;
+
+	BLI_spin_lock(&m_cacheLock);
+	for (unsigned int i = 0; i < count; ++i) {
+		VertexZoneInfo *vertexInfo = m_chunkCache->GetVertexZoneInfo(x[i], y[i]);
+		if (vertexInfo) {
+			vertexInfo->AddRef();
+		}
+		else {
+			missIndices.push_back(i);
+			missx.push_back(x[i]);
+			missy.push_back(y[i]);
+		}
+		r_infos[i] = vertexInfo;
+	}
+	const unsigned int invalidationCount = m_invalidationCount;
+	BLI_spin_unlock(&m_cacheLock);
+
+	const unsigned int missCount = missIndices.size();
+	if (missCount == 0) {
+		return;
+	}
+
+	/* Le calcul des vertices est fait en dehors du verrou pour que les
+	 * threads de construction des chunks ne s'attendent pas entre eux.
+	 */
+	std::vector<VertexZoneInfo *> newVertexInfos(missCount);
+	NewVertexInfos(missCount, &missx[0], &missy[0], &newVertexInfos[0]);
+
+	BLI_spin_lock(&m_cacheLock);
+	// Une zone a changé pendant le calcul, les vertices peuvent être périmés et ne sont pas gardés.
+	const bool invalidated = (invalidationCount != m_invalidationCount);
+	for (unsigned int i = 0; i < missCount; ++i) {
+		VertexZoneInfo *newVertexInfo = newVertexInfos[i];
+		if (invalidated) {
+			r_infos[missIndices[i]] = newVertexInfo;
+			continue;
+		}
+		VertexZoneInfo *vertexInfo = m_chunkCache->AddVertexZoneInfo(missx[i], missy[i], newVertexInfo);
+		if (vertexInfo != newVertexInfo) {
+			vertexInfo->AddRef();
+		}
+		r_infos[missIndices[i]] = vertexInfo;
+	}
+	BLI_spin_unlock(&m_cacheLock);
+
+	// Un autre thread a créé les mêmes vertices avant nous.
+	for (unsigned int i = 0; i < missCount; ++i) {
+		if (r_infos[missIndices[i]] != newVertexInfos[i]) {
+			newVertexInfos[i]->Release();
+		}
+	}
+}
+
+void KX_Terrain::NewVertexInfos(unsigned int count, const int *x, const int *y, VertexZoneInfo **r_infos) const
+{
+	const float interval = m_chunkSize / m_polyCount * 2.0f;
+
+	for (unsigned int i = 0; i < count; ++i) {
+		VertexZoneInfo *info = new(m_vertexInfoPool->Alloc()) VertexZoneInfo(m_vertexInfoPool);
+
+		const float fx = x[i] * interval;
+		const float fy = y[i] * interval;
+
+		// set vertex 2d position
+		info->pos[0] = fx;
+		info->pos[1] = fy;
+
+		info->m_uvs[0].x() = fx;
+		info->m_uvs[0].y() = fy;
+
+		r_infos[i] = info;
+	}
+
+	// Les vertices à calculer avec les zones, tous si il n'y a pas de stockage sur disque.
+	std::vector<unsigned int> computeIndices;
+	if (m_tileStore) {
+		std::vector<unsigned char> found(count);
+		const unsigned int foundCount = m_tileStore->ReadVertexInfos(count, x, y, r_infos, &found[0]);
+
+		computeIndices.reserve(count - foundCount);
+		for (unsigned int i = 0; i < count; ++i) {
+			if (!found[i]) {
+				computeIndices.push_back(i);
+			}
+		}
+	}
+	else {
+		computeIndices.resize(count);
+		for (unsigned int i = 0; i < count; ++i) {
+			computeIndices[i] = i;
+		}
+	}
+
+	const unsigned int computeCount = computeIndices.size();
+	std::vector<int> cx(computeCount);
+	std::vector<int> cy(computeCount);
+	std::vector<float> fx(computeCount);
+	std::vector<float> fy(computeCount);
+	std::vector<VertexZoneInfo *> infos(computeCount);
+
+	for (unsigned int i = 0; i < computeCount; ++i) {
+		const unsigned int index = computeIndices[i];
+		cx[i] = x[index];
+		cy[i] = y[index];
+		fx[i] = r_infos[index]->pos[0];
+		fy[i] = r_infos[index]->pos[1];
+		infos[i] = r_infos[index];
+	}
+
+	if (computeCount > 0) {
+		// Chaque zone traite tous les vertices à la fois.
+		for (unsigned short i = 0; i < m_zoneMeshList.size(); ++i)
+			m_zoneMeshList[i]->GetVertexInfos(computeCount, &fx[0], &fy[0], &infos[0]);
+
+		if (m_tileStore) {
+			m_tileStore->WriteVertexInfos(computeCount, &cx[0], &cy[0], &infos[0]);
+		}
+	}
+
+	// Le stockage sur disque ne contient que les hauteurs des zones, les modifications sont ajoutées après.
+	m_deformation->ApplyDeltas(count, x, y, r_infos);
+}
+
+/* La grille des requêtes a la résolution des chunks du niveau maximal, chaque case
+ * est coupée en deux triangles comme dans le mesh des chunks : (0, 0), (1, 0), (1, 1)
+ * et (0, 0), (1, 1), (0, 1).
+ */
+
+/** La hauteur et la normale dans une case à partir des hauteurs de ses coins,
+ * fx et fy sont la position relative dans la case entre 0 et 1.
+ */
+static float query_cell_height(const float heights[4], float fx, float fy, float cellSize, MT_Vector3 *r_normal)
+{
+	float dx;
+	float dy;
+	if (fx >= fy) {
+		dx = heights[1] - heights[0];
+		dy = heights[2] - heights[1];
+	}
+	else {
+		dx = heights[2] - heights[3];
+		dy = heights[3] - heights[0];
+	}
+
+	if (r_normal) {
+		*r_normal = MT_Vector3(-dx / cellSize, -dy / cellSize, 1.0f).normalized();
+	}
+
+	return heights[0] + fx * dx + fy * dy;
+}
+
+float KX_Terrain::GetQueryCellSize() const
+{
+	// L'interval en vertices entre deux vertices des plus petits chunks.
+	const int step = std::max(m_width >> m_maxChunkLevel, 1);
+	return m_chunkSize / m_polyCount * 2.0f * step;
+}
+
+void KX_Terrain::GetQueryCellHeights(unsigned int count, const int *cellx, const int *celly, float *r_heights) const
+{
+	static const int offsets[4][2] = {{0, 0}, {1, 0}, {1, 1}, {0, 1}};
+
+	const int step = std::max(m_width >> m_maxChunkLevel, 1);
+	const int halfCellCount = m_width * m_polyCount / 4 / step;
+
+	std::vector<int> x(count * 4);
+	std::vector<int> y(count * 4);
+	std::vector<VertexZoneInfo *> infos(count * 4);
+
+	for (unsigned int i = 0; i < count; ++i) {
+		for (unsigned short j = 0; j < 4; ++j) {
+			x[i * 4 + j] = (cellx[i] + offsets[j][0] - halfCellCount) * step;
+			y[i * 4 + j] = (celly[i] + offsets[j][1] - halfCellCount) * step;
+		}
+	}
+
+	GetVertexInfos(count * 4, &x[0], &y[0], &infos[0]);
+
+	for (unsigned int i = 0; i < count * 4; ++i) {
+		r_heights[i] = infos[i]->height;
+		infos[i]->Release();
+	}
+}
+
+float KX_Terrain::GetHeight(float x, float y) const
+{
+	float height;
+	GetHeights(1, &x, &y, &height, NULL);
+	return height;
+}
+
+MT_Vector3 KX_Terrain::GetNormal(float x, float y) const
+{
+	float height;
+	MT_Vector3 normal;
+	GetHeights(1, &x, &y, &height, &normal);
+	return normal;
+}
+
+void KX_Terrain::GetHeights(unsigned int count, const float *x, const float *y, float *r_heights, MT_Vector3 *r_normals) const
+{
+	if (count == 0) {
+		return;
+	}
+
+	const float cellSize = GetQueryCellSize();
+	const int cellCount = m_width * m_polyCount / 2 / std::max(m_width >> m_maxChunkLevel, 1);
+	const float halfCellCount = cellCount / 2.0f;
+
+	std::vector<int> cellx(count);
+	std::vector<int> celly(count);
+	std::vector<float> fx(count);
+	std::vector<float> fy(count);
+
+	for (unsigned int i = 0; i < count; ++i) {
+		const float gx = std::min(std::max(x[i] / cellSize + halfCellCount, 0.0f), (float)cellCount);
+		const float gy = std::min(std::max(y[i] / cellSize + halfCellCount, 0.0f), (float)cellCount);
+		cellx[i] = std::min((int)gx, cellCount - 1);
+		celly[i] = std::min((int)gy, cellCount - 1);
+		fx[i] = gx - cellx[i];
+		fy[i] = gy - celly[i];
+	}
+
+	std::vector<float> heights(count * 4);
+	GetQueryCellHeights(count, &cellx[0], &celly[0], &heights[0]);
+
+	for (unsigned int i = 0; i < count; ++i) {
+		r_heights[i] = query_cell_height(&heights[i * 4], fx[i], fy[i], cellSize, r_normals ? &r_normals[i] : NULL);
+	}
+}
+
+bool KX_Terrain::RayCast(const MT_Point3& from, const MT_Point3& to, MT_Point3& r_point, MT_Vector3& r_normal) const
+{
+	const float cellSize = GetQueryCellSize();
+	const int cellCount = m_width * m_polyCount / 2 / std::max(m_width >> m_maxChunkLevel, 1);
+	const float halfCellCount = cellCount / 2.0f;
+
+	// Le rayon dans l'espace de la grille où une case fait une unité, paramétré de 0 à 1.
+	const float gfrom[2] = {(float)from.x() / cellSize + halfCellCount, (float)from.y() / cellSize + halfCellCount};
+	const float gdir[2] = {(float)(to.x() - from.x()) / cellSize, (float)(to.y() - from.y()) / cellSize};
+
+	// On ne garde que la partie du rayon au dessus du terrain.
+	float tmin = 0.0f;
+	float tmax = 1.0f;
+	for (unsigned short axis = 0; axis < 2; ++axis) {
+		if (fabsf(gdir[axis]) < FLT_EPSILON) {
+			if (gfrom[axis] < 0.0f || gfrom[axis] > cellCount) {
+				return false;
+			}
+		}
+		else {
+			float t0 = -gfrom[axis] / gdir[axis];
+			float t1 = (cellCount - gfrom[axis]) / gdir[axis];
+			if (t0 > t1) {
+				std::swap(t0, t1);
+			}
+			tmin = std::max(tmin, t0);
+			tmax = std::min(tmax, t1);
+		}
+	}
+
+	if (tmin > tmax) {
+		return false;
+	}
+
+	// Parcours des cases traversées par le rayon dans l'ordre (Amanatides et Woo).
+	int cx = std::min(std::max((int)floorf(gfrom[0] + gdir[0] * tmin), 0), cellCount - 1);
+	int cy = std::min(std::max((int)floorf(gfrom[1] + gdir[1] * tmin), 0), cellCount - 1);
+	const int stepx = (gdir[0] > 0.0f) ? 1 : -1;
+	const int stepy = (gdir[1] > 0.0f) ? 1 : -1;
+	const float deltax = (fabsf(gdir[0]) < FLT_EPSILON) ? FLT_MAX : 1.0f / fabsf(gdir[0]);
+	const float deltay = (fabsf(gdir[1]) < FLT_EPSILON) ? FLT_MAX : 1.0f / fabsf(gdir[1]);
+	float nextx = (fabsf(gdir[0]) < FLT_EPSILON) ? FLT_MAX : ((stepx > 0 ? cx + 1 : cx) - gfrom[0]) / gdir[0];
+	float nexty = (fabsf(gdir[1]) < FLT_EPSILON) ? FLT_MAX : ((stepy > 0 ? cy + 1 : cy) - gfrom[1]) / gdir[1];
+
+	const MT_Vector3 dir = to - from;
+	const float origin[3] = {(float)from.x(), (float)from.y(), (float)from.z()};
+	const float direction[3] = {(float)dir.x(), (float)dir.y(), (float)dir.z()};
+
+	// Les cases sont traitées par groupes pour calculer leurs vertices ensemble.
+	const unsigned int batchSize = 64;
+	std::vector<int> cellx;
+	std::vector<int> celly;
+	std::vector<float> enter;
+	std::vector<float> exit;
+	std::vector<float> heights(batchSize * 4);
+
+	float t = tmin;
+	bool end = false;
+	while (!end) {
+		cellx.clear();
+		celly.clear();
+		enter.clear();
+		exit.clear();
+
+		while (!end && cellx.size() < batchSize) {
+			const float tnext = std::min(std::min(nextx, nexty), tmax);
+			cellx.push_back(cx);
+			celly.push_back(cy);
+			enter.push_back(t);
+			exit.push_back(tnext);
+
+			if (tnext >= tmax) {
+				end = true;
+			}
+			else {
+				if (nextx < nexty) {
+					cx += stepx;
+					nextx += deltax;
+				}
+				else {
+					cy += stepy;
+					nexty += deltay;
+				}
+				t = tnext;
+				end = (cx < 0 || cy < 0 || cx >= cellCount || cy >= cellCount);
+			}
+		}
+
+		GetQueryCellHeights(cellx.size(), &cellx[0], &celly[0], &heights[0]);
+
+		for (unsigned int i = 0; i < cellx.size(); ++i) {
+			const float *cellHeights = &heights[i * 4];
+
+			// Le rayon passe au dessus du plus haut coin de la case.
+			const float maxHeight = max_ffff(cellHeights[0], cellHeights[1], cellHeights[2], cellHeights[3]);
+			if (from.z() + dir.z() * std::min(enter[i], exit[i]) > maxHeight &&
+				from.z() + dir.z() * std::max(enter[i], exit[i]) > maxHeight)
+			{
+				continue;
+			}
+
+			const float x0 = (cellx[i] - halfCellCount) * cellSize;
+			const float y0 = (celly[i] - halfCellCount) * cellSize;
+			const float corners[4][3] = {
+				{x0, y0, cellHeights[0]},
+				{x0 + cellSize, y0, cellHeights[1]},
+				{x0 + cellSize, y0 + cellSize, cellHeights[2]},
+				{x0, y0 + cellSize, cellHeights[3]}
+			};
+
+			float lambda = FLT_MAX;
+			float triLambda;
+			float uv[2];
+			if (isect_ray_tri_v3(origin, direction, corners[0], corners[1], corners[2], &triLambda, uv) && triLambda <= 1.0f) {
+				lambda = triLambda;
+			}
+			if (isect_ray_tri_v3(origin, direction, corners[0], corners[2], corners[3], &triLambda, uv) && triLambda <= 1.0f) {
+				lambda = std::min(lambda, triLambda);
+			}
+
+			if (lambda != FLT_MAX) {
+				r_point = from + dir * lambda;
+				const float fx = std::min(std::max((float)r_point.x() / cellSize + halfCellCount - cellx[i], 0.0f), 1.0f);
+				const float fy = std::min(std::max((float)r_point.y() / cellSize + halfCellCount - celly[i], 0.0f), 1.0f);
+				query_cell_height(cellHeights, fx, fy, cellSize, &r_normal);
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+/// Les noms des parties du terrain comptées dans le budget mémoire.
+static const char *memory_type_names[KX_Terrain::MEMORY_MAX] = {
+	"vertexInfos",
+	"chunkVertexes",
+	"meshes",
+	"physics",
+	"cache",
+	"deformation",
+	"tileStore"
+};
+
+/// Un chunk pouvant être supprimé pour respecter le budget mémoire.
+struct EvictionCandidate
+{
+	KX_Chunk *chunk;
+	unsigned int lastUsedFrame;
+	float distance;
+
+	/// Les chunks les moins récemment vus puis les plus éloignés en premier.
+	bool operator<(const EvictionCandidate& other) const
+	{
+		if (lastUsedFrame != other.lastUsedFrame) {
+			return lastUsedFrame < other.lastUsedFrame;
+		}
+		return distance > other.distance;
+	}
+};
+
+void KX_Terrain::ComputeMemoryUsage()
+{
+	for (unsigned short i = 0; i < MEMORY_MAX; ++i) {
+		m_memoryUsage[i] = 0;
+	}
+
+	/* Seuls les éléments utilisés sont comptés : la place libre des blocs de
+	 * l'allocateur n'est rendue que lorsqu'il est vide, supprimer des éléments
+	 * ne la réduirait pas. Elle est affichée par KX_TerrainPool::PrintStats.
+	 */
+	m_memoryUsage[MEMORY_VERTEX_INFOS] = (size_t)m_vertexInfoPool->GetUsedCount() * sizeof(VertexZoneInfo);
+
+	for (KX_ChunkList::iterator it = m_chunkList.begin(); it != m_chunkList.end(); ++it) {
+		KX_Chunk *chunk = *it;
+		m_memoryUsage[MEMORY_CHUNK_VERTEXES] += chunk->GetVertexesMemory();
+		m_memoryUsage[MEMORY_MESHES] += chunk->GetMeshMemory();
+		m_memoryUsage[MEMORY_PHYSICS] += chunk->GetPhysicsMemory();
+	}
+
+	if (m_collisionTiles) {
+		m_memoryUsage[MEMORY_PHYSICS] += m_collisionTiles->GetMemoryUsage();
+	}
+
+	// Les vertices du cache sont déjà comptés dans les informations de vertices.
+	if (m_chunkCache) {
+		BLI_spin_lock(&m_cacheLock);
+		m_memoryUsage[MEMORY_CACHE] = m_chunkCache->GetTableMemoryUsage();
+		BLI_spin_unlock(&m_cacheLock);
+	}
 
-	const float interval = m_chunkSize / POLY_COUNT * 2.0f;
-	const float fx = x * interval;
-	const float fy = y * interval;
+	m_memoryUsage[MEMORY_DEFORMATION] = m_deformation->GetMemoryUsage();
 
-	// set vertex 2d position
-	info->pos[0] = fx;
-	info->pos[1] = fy;
+	if (m_tileStore) {
+		m_memoryUsage[MEMORY_TILE_STORE] = m_tileStore->GetMemoryUsage();
+	}
+}
+
+size_t KX_Terrain::GetTotalMemoryUsage() const
+{
+	size_t usage = 0;
+	for (unsigned short i = 0; i < MEMORY_MAX; ++i) {
+		usage += m_memoryUsage[i];
+	}
+	return usage;
+}
+
+void KX_Terrain::UpdateMemoryBudget()
+{
+	++m_frame;
+
+	// Les chunks dans le champ de la camera sont utilisés à cette frame.
+	for (KX_ChunkList::iterator it = m_chunkList.begin(); it != m_chunkList.end(); ++it) {
+		KX_Chunk *chunk = *it;
+		if (chunk->GetNode()->GetCulledState() != KX_Camera::OUTSIDE) {
+			chunk->SetLastUsedFrame(m_frame);
+		}
+	}
+
+	ComputeMemoryUsage();
+
+	if (m_memoryBudget == 0) {
+		return;
+	}
+
+	const size_t budget = GetMemoryBudget();
+	size_t usage = GetTotalMemoryUsage();
+
+	/* Les tuiles du stockage sur disque sont libérées en premier, les tuiles modifiées
+	 * sont écrites avant, elles seront relues.
+	 */
+	if (usage > budget && m_tileStore) {
+		const size_t tileUsage = m_memoryUsage[MEMORY_TILE_STORE];
+		const size_t excess = std::min(usage - budget, tileUsage);
+		// Des tuiles ont pu être chargées par les threads de travail depuis ComputeMemoryUsage.
+		const size_t freed = std::min(m_tileStore->ReleaseTiles(tileUsage - excess), tileUsage);
+		m_memoryUsage[MEMORY_TILE_STORE] -= freed;
+		usage -= freed;
+	}
+
+	// Puis les vertices gardés seulement par le cache.
+	if (usage > budget && m_chunkCache) {
+		const unsigned int count = (usage - budget) / sizeof(VertexZoneInfo) + 1;
+
+		BLI_spin_lock(&m_cacheLock);
+		const unsigned int evicted = m_chunkCache->Trim(count);
+		BLI_spin_unlock(&m_cacheLock);
+
+		const size_t freed = std::min((size_t)evicted * sizeof(VertexZoneInfo), m_memoryUsage[MEMORY_VERTEX_INFOS]);
+		m_memoryUsage[MEMORY_VERTEX_INFOS] -= freed;
+		usage -= freed;
+	}
+
+	/* Puis les meshs et vertices des chunks en dehors du champ de la camera, gardés
+	 * pour la physique des objets. Leurs informations de vertices retournent au cache
+	 * et seront supprimées aux prochaines frames.
+	 */
+	if (usage > budget) {
+		std::vector<EvictionCandidate> candidates;
+		for (KX_ChunkList::iterator it = m_chunkList.begin(); it != m_chunkList.end(); ++it) {
+			KX_Chunk *chunk = *it;
+			KX_ChunkNode *node = chunk->GetNode();
+			if (!chunk->GetVertexesReady() || chunk->GetMeshOnConstruct() || chunk->GetRefreshQueued() ||
+				node->GetCulledState() != KX_Camera::OUTSIDE)
+			{
+				continue;
+			}
+
+			EvictionCandidate candidate;
+			candidate.chunk = chunk;
+			candidate.lastUsedFrame = chunk->GetLastUsedFrame();
+			candidate.distance = node->GetCenter().distance(m_cameraPosition);
+			candidates.push_back(candidate);
+		}
 
-	info->m_uvs[0].x() = fx;
-	info->m_uvs[0].y() = fy;
+		std::sort(candidates.begin(), candidates.end());
+
+		for (std::vector<EvictionCandidate>::iterator it = candidates.begin(); it != candidates.end() && usage > budget; ++it) {
+			KX_Chunk *chunk = it->chunk;
+			const size_t vertexesMemory = chunk->GetVertexesMemory();
+			const size_t meshMemory = chunk->GetMeshMemory();
+			const size_t physicsMemory = chunk->GetPhysicsMemory();
+
+			chunk->Evict();
+
+			// Les hauteurs lues par un champ de hauteur restent avec la forme physique.
+			const size_t keptMemory = chunk->GetPhysicsMemory() - physicsMemory;
+
+			m_memoryUsage[MEMORY_CHUNK_VERTEXES] -= vertexesMemory;
+			m_memoryUsage[MEMORY_MESHES] -= meshMemory;
+			m_memoryUsage[MEMORY_PHYSICS] += keptMemory;
+			usage -= vertexesMemory + meshMemory - keptMemory;
+		}
+	}
+
+	/* Au delà du budget on arrête de subdiviser les noeuds, on reprend sous 90% du
+	 * budget pour ne pas créer et supprimer les mêmes noeuds à chaque frame.
+	 */
+	if (usage > budget) {
+		m_memoryExceeded = true;
+	}
+	else if (usage < budget / 10 * 9) {
+		m_memoryExceeded = false;
+	}
+}
+
+void KX_Terrain::PrintMemoryStats() const
+{
+	std::cout << "Terrain Memory Stats : " << std::endl;
+	for (unsigned short i = 0; i < MEMORY_MAX; ++i) {
+		std::cout << "\t " << memory_type_names[i] << " : \t\t" << m_memoryUsage[i] / 1024 << " KB" << std::endl;
+	}
+	std::cout << "\t total : \t\t" << GetTotalMemoryUsage() / 1024 << " KB" << std::endl;
+	if (m_memoryBudget > 0) {
+		std::cout << "\t budget : \t\t" << GetMemoryBudget() / 1024 << " KB" << (m_memoryExceeded ? " (exceeded)" : "") << std::endl;
+	}
+}
+
+unsigned int KX_Terrain::GetTileStoreKey() const
+{
+	BLI_HashMurmur2A mm2;
+	BLI_hash_mm2a_init(&mm2, 0);
+
+	// Tous les paramètres changeant la position des vertices.
+	BLI_hash_mm2a_add_int(&mm2, m_width);
+	BLI_hash_mm2a_add_int(&mm2, m_polyCount);
+	BLI_hash_mm2a_add(&mm2, (const unsigned char *)&m_chunkSize, sizeof(float));
 
 	for (unsigned short i = 0; i < m_zoneMeshList.size(); ++i)
-		m_zoneMeshList[i]->GetVertexInfo(fx, fy, info);
+		m_zoneMeshList[i]->AddHashKey(&mm2);
 
-	return info;
+	return BLI_hash_mm2a_end(&mm2);
+}
+
+bool KX_Terrain::BakeTileStore()
+{
+	if (!m_construct) {
+		Construct();
+	}
+
+	if (!m_tileStore) {
+		return false;
+	}
+
+	const double starttime = GetTime();
+
+	/* La moitié de la largeur du terrain en vertices et l'interval entre deux
+	 * vertices des plus petits chunks.
+	 */
+	const int halfwidth = m_width * m_polyCount / 4;
+	const int step = std::max(m_width >> m_maxChunkLevel, 1);
+	const unsigned int rowCount = halfwidth * 2 / step + 1;
+
+	std::vector<int> x(rowCount);
+	std::vector<int> y(rowCount);
+	std::vector<VertexZoneInfo *> infos(rowCount);
+
+	for (unsigned int i = 0; i < rowCount; ++i) {
+		x[i] = -halfwidth + i * step;
+	}
+
+	// On construit le terrain ligne par ligne.
+	for (int row = -halfwidth; row <= halfwidth; row += step) {
+		std::fill(y.begin(), y.end(), row);
+		NewVertexInfos(rowCount, &x[0], &y[0], &infos[0]);
+		for (unsigned int i = 0; i < rowCount; ++i) {
+			infos[i]->Release();
+		}
+	}
+
+	m_tileStore->Flush();
+
+	std::cout << "Terrain baked " << rowCount * rowCount << " vertexes in " << m_tileStore->GetDirectory()
+		<< " in " << (GetTime() - starttime) << " s" << std::endl;
+
+	return true;
+}
+
+RAS_IndexArray *KX_Terrain::GetPolygonTemplate(const unsigned short intervals[4])
+{
+	uint64_t key = 0;
+	for (unsigned short i = 0; i < 4; ++i) {
+		key = (key << 16) | intervals[i];
+	}
+
+	std::map<uint64_t, RAS_IndexArray *>::iterator it = m_polygonTemplates.find(key);
+	if (it != m_polygonTemplates.end()) {
+		return it->second;
+	}
+
+	RAS_IndexArray *indexarray = new RAS_IndexArray();
+	KX_Chunk::ConstructPolygonTemplate(m_polyCount, intervals, indexarray->m_index);
+	m_polygonTemplates[key] = indexarray;
+	return indexarray;
+}
+
+#ifdef WITH_BULLET
+btCollisionShape *KX_Terrain::NewHeightfieldShape(const float *heights, float interval, float minHeight, float maxHeight) const
+{
+	// Les faces sont coupées de (x, y) à (x + 1, y + 1) comme dans le mesh des chunks.
+	btHeightfieldTerrainShape *shape = new btHeightfieldTerrainShape(m_vertexCount, m_vertexCount, heights, 1.0f,
+																	 minHeight, maxHeight, 2, PHY_FLOAT, true);
+	shape->setLocalScaling(btVector3(interval, interval, 1.0f));
+
+	return shape;
+}
+
+PHY_IPhysicsController *KX_Terrain::NewPhysicsController(btCollisionShape *shape, CcdShapeConstructionInfo *shapeInfo,
+														 const MT_Point3& position)
+{
+	Material *material = m_material;
+	CcdPhysicsEnvironment *phyEnv = (CcdPhysicsEnvironment *)GetScene()->GetPhysicsEnvironment();
+
+	CcdConstructionInfo ci;
+
+	ci.m_collisionShape = shape;
+	ci.m_shapeInfo = shapeInfo;
+	ci.m_MotionState = new KX_ChunkMotionState(position);
+	ci.m_physicsEnv = phyEnv;
+	ci.m_fh_damping = material->xyfrict;
+	ci.m_fh_distance = material->fhdist;
+	ci.m_fh_spring = material->fh;
+	ci.m_friction = material->friction;
+	ci.m_restitution = material->reflect;
+	ci.m_collisionFilterMask = CcdConstructionInfo::AllFilter ^ CcdConstructionInfo::StaticFilter;
+	ci.m_collisionFilterGroup = CcdConstructionInfo::StaticFilter;
+
+	CcdPhysicsController *phyCtrl = new CcdPhysicsController(ci);
+	phyCtrl->SetNewClientInfo(getClientInfo());
+
+	// Puis on l'ajoute dans l'environnement physique.
+	phyEnv->AddCcdPhysicsController(phyCtrl);
+
+	return phyCtrl;
 }
+#endif
 
-KX_ChunkNode **KX_Terrain::NewNodeList(KX_ChunkNode *parentNode, int x, int y, unsigned short level)
+KX_ChunkNode *KX_Terrain::NewNodeList(KX_ChunkNode *parentNode, int x, int y, unsigned short level)
 {
-	KX_ChunkNode **nodeList = (KX_ChunkNode **)malloc(4 * sizeof(KX_ChunkNode *));
+	/* Les 4 sous noeuds sont construits dans un seul élément de l'allocateur,
+	 * ils sont ainsi contigus en mémoire pour les parcours de l'arbre.
+	 */
+	KX_ChunkNode *nodeList = (KX_ChunkNode *)m_nodePool->Alloc();
 
 	// la taille relative d'un chunk, = 2 si le noeud et final
-	const unsigned short relativesize = m_width / pow(2, level);
+	const unsigned short relativesize = m_width >> level;
 	// la largeur du chunk 
 	const unsigned short width = relativesize / 2;
 
-	nodeList[0] = new KX_ChunkNode(parentNode, x - width, y - width, relativesize, level + 1, this);
-	nodeList[1] = new KX_ChunkNode(parentNode, x + width, y - width, relativesize, level + 1, this);
-	nodeList[2] = new KX_ChunkNode(parentNode, x - width, y + width, relativesize, level + 1, this);
-	nodeList[3] = new KX_ChunkNode(parentNode, x + width, y + width, relativesize, level + 1, this);
+	new(&nodeList[0]) KX_ChunkNode(parentNode, x - width, y - width, relativesize, level + 1, this);
+	new(&nodeList[1]) KX_ChunkNode(parentNode, x + width, y - width, relativesize, level + 1, this);
+	new(&nodeList[2]) KX_ChunkNode(parentNode, x - width, y + width, relativesize, level + 1, this);
+	new(&nodeList[3]) KX_ChunkNode(parentNode, x + width, y + width, relativesize, level + 1, this);
 
 	return nodeList;
 }
 
+void KX_Terrain::FreeNodeList(KX_ChunkNode *nodeList)
+{
+	m_nodePool->Free(nodeList);
+}
+
 KX_Chunk* KX_Terrain::AddChunk(KX_ChunkNode* node)
 {
-	double starttime = KX_GetActiveEngine()->GetRealTime();
+	double starttime = GetTime();
 
 	KX_Chunk *chunk = new KX_Chunk(node, m_bucket);
 
 	////////////////////////// AJOUT DANS LA LISTE ///////////////////////////
 	m_chunkList.push_back(chunk);
 
-	double endtime = KX_GetActiveEngine()->GetRealTime();
+	/* Les vertices sont construits dans un thread de travail, le mesh et la
+	 * physique seront créés dans UpdateChunksMeshes une fois ceux-ci prêts.
+	 * Le chunk attend son tour dans SchedulePendingChunks.
+	 */
+	m_pendingChunkList.push_back(chunk);
+
+	double endtime = GetTime();
 
 	KX_Chunk::chunkCreationTime += endtime - starttime;
 
@@ -269,21 +1276,327 @@ KX_Chunk* KX_Terrain::AddChunk(KX_ChunkNode* node)
  */
 void KX_Terrain::RemoveChunk(KX_Chunk *chunk)
 {
+	// Si la construction des vertices n'a pas commencée elle est annulée.
+	chunk->CancelVertexes();
 	m_chunkList.remove(chunk);
+
+	std::vector<KX_Chunk *>::iterator it = std::find(m_pendingChunkList.begin(), m_pendingChunkList.end(), chunk);
+	if (it != m_pendingChunkList.end()) {
+		m_pendingChunkList.erase(it);
+	}
+
 	m_euthanasyChunkList.push_back(chunk);
 }
 
+void KX_Terrain::RestoreChunk(KX_Chunk *chunk)
+{
+	chunk->Restore();
+	m_pendingChunkList.push_back(chunk);
+}
+
 void KX_Terrain::ScheduleEuthanasyChunks()
 {
-	for (KX_ChunkList::iterator it = m_euthanasyChunkList.begin(); it != m_euthanasyChunkList.end(); ++it) {
+	for (KX_ChunkList::iterator it = m_euthanasyChunkList.begin(); it != m_euthanasyChunkList.end();) {
 		KX_Chunk *chunk = *it;
 
+		/* Le chunk est encore utilisé par un thread de travail, on
+		 * le supprimera à la prochaine frame.
+		 */
+		if (chunk->GetVertexesState() == KX_Chunk::VERTEXES_SCHEDULED) {
+			++it;
+			continue;
+		}
+
 		delete chunk;
+		it = m_euthanasyChunkList.erase(it);
 	}
-	m_euthanasyChunkList.clear();
+}
+
+void KX_Terrain::SchedulePendingChunks()
+{
+	KX_PROFILE_ZONE("Terrain SchedulePendingChunks");
+
+	/* On garde au plus deux chunks par thread en construction, ainsi les
+	 * chunks les plus prioritaires de la prochaine frame ne sont pas
+	 * bloqués derrière des chunks devenus inutiles.
+	 */
+	const unsigned int maxScheduledChunks = BLI_task_scheduler_num_threads(m_taskScheduler) * 2;
+	const unsigned int scheduledChunks = atomic_add_uint32(&m_scheduledChunkCount, 0);
+
+	if (m_pendingChunkList.empty() || scheduledChunks >= maxScheduledChunks) {
+		return;
+	}
+
+	for (std::vector<KX_Chunk *>::iterator it = m_pendingChunkList.begin(); it != m_pendingChunkList.end(); ++it) {
+		(*it)->ComputeBuildPriority(m_cameraPosition);
+	}
+
+	const unsigned int count = std::min((unsigned int)m_pendingChunkList.size(), maxScheduledChunks - scheduledChunks);
+	std::vector<KX_Chunk *>::iterator end = m_pendingChunkList.begin() + count;
+	std::partial_sort(m_pendingChunkList.begin(), end, m_pendingChunkList.end(), chunk_build_priority_greater);
+
+	for (std::vector<KX_Chunk *>::iterator it = m_pendingChunkList.begin(); it != end; ++it) {
+		KX_Chunk *chunk = *it;
+		chunk->SetVertexesScheduled();
+		atomic_add_uint32(&m_scheduledChunkCount, 1);
+		BLI_task_pool_push(m_taskPool, construct_chunk_vertexes_task, chunk, false, TASK_PRIORITY_LOW);
+	}
+
+	m_pendingChunkList.erase(m_pendingChunkList.begin(), end);
+}
+
+unsigned int KX_Terrain::GetBuildingChunkCount() const
+{
+	return m_pendingChunkList.size() + atomic_add_uint32((unsigned int *)&m_scheduledChunkCount, 0);
+}
+
+void KX_Terrain::ConstructChunkVertexes(KX_Chunk *chunk)
+{
+	// Les chunks invalidés par une zone ont déjà leurs vertices.
+	if (chunk->GetHasVertexes()) {
+		KX_PROFILE_ZONE("Chunk RefreshVertexes");
+		chunk->RefreshVertexes();
+	}
+	else {
+		KX_PROFILE_ZONE("Chunk ConstructVertexes");
+		chunk->ConstructVertexes();
+	}
+	// Le chunk peut être supprimé par le thread principal à partir d'ici.
+	atomic_sub_uint32(&m_scheduledChunkCount, 1);
+}
+
+void KX_Terrain::InvalidateArea(float minx, float miny, float maxx, float maxy)
+{
+	// Les positions relatives des vertices touchés, arrondies vers l'extérieur.
+	const float interval = m_chunkSize / m_polyCount * 2.0f;
+	const int step = std::max(m_width >> m_maxChunkLevel, 1);
+
+	BLI_spin_lock(&m_cacheLock);
+	++m_invalidationCount;
+	if (m_chunkCache) {
+		m_chunkCache->RemoveArea((int)floorf(minx / interval), (int)floorf(miny / interval),
+								 (int)ceilf(maxx / interval), (int)ceilf(maxy / interval), step);
+	}
+	BLI_spin_unlock(&m_cacheLock);
+
+	for (KX_ChunkList::iterator it = m_chunkList.begin(); it != m_chunkList.end(); ++it) {
+		(*it)->InvalidateArea(minx, miny, maxx, maxy);
+	}
+
+	if (m_collisionTiles) {
+		m_collisionTiles->InvalidateArea(minx, miny, maxx, maxy);
+	}
+}
+
+void KX_Terrain::Deform(int mode, float x, float y, float radius, float strength, float height)
+{
+	m_deformation->Brush((KX_TerrainDeformation::BRUSH_MODE)mode, x, y, radius, strength, height);
 }
 
 void KX_Terrain::AddTerrainZoneMesh(KX_TerrainZoneMesh *zoneMesh)
 {
 	m_zoneMeshList.push_back(zoneMesh);
 }
+
+#ifdef WITH_PYTHON
+
+PyMethodDef KX_Terrain::Methods[] = {
+	KX_PYMETHODTABLE(KX_Terrain, getHeight),
+	KX_PYMETHODTABLE(KX_Terrain, getNormal),
+	KX_PYMETHODTABLE_O(KX_Terrain, getHeights),
+	KX_PYMETHODTABLE(KX_Terrain, rayCast),
+	KX_PYMETHODTABLE(KX_Terrain, deform),
+	{NULL, NULL} //Sentinel
+};
+
+PyAttributeDef KX_Terrain::Attributes[] = {
+	KX_PYATTRIBUTE_RO_FUNCTION("memoryBudget", KX_Terrain, pyattr_get_memory_budget),
+	KX_PYATTRIBUTE_RO_FUNCTION("memoryUsage", KX_Terrain, pyattr_get_memory_usage),
+	{ NULL }	//Sentinel
+};
+
+PyTypeObject KX_Terrain::Type = {
+	PyVarObject_HEAD_INIT(NULL, 0)
+	"KX_Terrain",
+	sizeof(PyObjectPlus_Proxy),
+	0,
+	py_base_dealloc,
+	0,
+	0,
+	0,
+	0,
+	py_base_repr,
+	0,
+	&KX_GameObject::Sequence,
+	&KX_GameObject::Mapping,
+	0,0,0,
+	NULL,
+	NULL,
+	0,
+	Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE,
+	0,0,0,0,0,0,0,
+	Methods,
+	0,
+	0,
+	&KX_GameObject::Type,
+	0,0,0,0,0,0,
+	py_base_new
+};
+
+PyObject *KX_Terrain::pyattr_get_memory_budget(void *self_v, const KX_PYATTRIBUTE_DEF *attrdef)
+{
+	KX_Terrain *self = static_cast<KX_Terrain *>(self_v);
+	return PyLong_FromSize_t(self->GetMemoryBudget());
+}
+
+PyObject *KX_Terrain::pyattr_get_memory_usage(void *self_v, const KX_PYATTRIBUTE_DEF *attrdef)
+{
+	KX_Terrain *self = static_cast<KX_Terrain *>(self_v);
+	PyObject *dict = PyDict_New();
+
+	for (unsigned short i = 0; i < MEMORY_MAX; ++i) {
+		PyObject *item = PyLong_FromSize_t(self->GetMemoryUsage((MEMORY_TYPE)i));
+		PyDict_SetItemString(dict, memory_type_names[i], item);
+		Py_DECREF(item);
+	}
+
+	PyObject *total = PyLong_FromSize_t(self->GetTotalMemoryUsage());
+	PyDict_SetItemString(dict, "total", total);
+	Py_DECREF(total);
+
+	return dict;
+}
+
+KX_PYMETHODDEF_DOC_VARARGS(KX_Terrain, getHeight,
+"getHeight(x, y) -> float\n"
+"\treturns the height of the terrain surface at the given world position.\n"
+)
+{
+	float x, y;
+	if (!PyArg_ParseTuple(args, "ff:getHeight", &x, &y)) {
+		return NULL;
+	}
+
+	return PyFloat_FromDouble(GetHeight(x, y));
+}
+
+KX_PYMETHODDEF_DOC_VARARGS(KX_Terrain, getNormal,
+"getNormal(x, y) -> Vector\n"
+"\treturns the normal of the terrain surface at the given world position.\n"
+)
+{
+	float x, y;
+	if (!PyArg_ParseTuple(args, "ff:getNormal", &x, &y)) {
+		return NULL;
+	}
+
+	return PyObjectFrom(GetNormal(x, y));
+}
+
+KX_PYMETHODDEF_DOC_O(KX_Terrain, getHeights,
+"getHeights(points) -> list\n"
+"\treturns the heights of the terrain surface at a list of world positions,\n"
+"\tonly the x and y coordinates of the points are used.\n"
+)
+{
+	PyObject *seq = PySequence_Fast(value, "terrain.getHeights(points): KX_Terrain, expected a sequence of points");
+	if (!seq) {
+		return NULL;
+	}
+
+	const unsigned int count = PySequence_Fast_GET_SIZE(seq);
+	std::vector<float> x(count);
+	std::vector<float> y(count);
+
+	for (unsigned int i = 0; i < count; ++i) {
+		PyObject *point = PySequence_Fast(PySequence_Fast_GET_ITEM(seq, i), "");
+		if (!point || PySequence_Fast_GET_SIZE(point) < 2) {
+			Py_XDECREF(point);
+			Py_DECREF(seq);
+			PyErr_SetString(PyExc_TypeError, "terrain.getHeights(points): KX_Terrain, expected points of at least 2 floats");
+			return NULL;
+		}
+
+		x[i] = PyFloat_AsDouble(PySequence_Fast_GET_ITEM(point, 0));
+		y[i] = PyFloat_AsDouble(PySequence_Fast_GET_ITEM(point, 1));
+		Py_DECREF(point);
+
+		if (PyErr_Occurred()) {
+			Py_DECREF(seq);
+			return NULL;
+		}
+	}
+	Py_DECREF(seq);
+
+	std::vector<float> heights(count);
+	if (count > 0) {
+		GetHeights(count, &x[0], &y[0], &heights[0], NULL);
+	}
+
+	PyObject *list = PyList_New(count);
+	for (unsigned int i = 0; i < count; ++i) {
+		PyList_SET_ITEM(list, i, PyFloat_FromDouble(heights[i]));
+	}
+
+	return list;
+}
+
+KX_PYMETHODDEF_DOC_VARARGS(KX_Terrain, rayCast,
+"rayCast(from, to) -> (hitPosition, hitNormal)\n"
+"\tcasts a ray against the terrain surface without using the physics,\n"
+"\treturns (None, None) if the surface is not hit between from and to.\n"
+)
+{
+	PyObject *pyfrom;
+	PyObject *pyto;
+	if (!PyArg_ParseTuple(args, "OO:rayCast", &pyfrom, &pyto)) {
+		return NULL;
+	}
+
+	MT_Point3 from;
+	MT_Point3 to;
+	if (!PyVecTo(pyfrom, from) || !PyVecTo(pyto, to)) {
+		return NULL;
+	}
+
+	MT_Point3 point;
+	MT_Vector3 normal;
+	PyObject *result = PyTuple_New(2);
+	if (RayCast(from, to, point, normal)) {
+		PyTuple_SET_ITEM(result, 0, PyObjectFrom(point));
+		PyTuple_SET_ITEM(result, 1, PyObjectFrom(normal));
+	}
+	else {
+		PyTuple_SET_ITEM(result, 0, Py_None);
+		Py_INCREF(Py_None);
+		PyTuple_SET_ITEM(result, 1, Py_None);
+		Py_INCREF(Py_None);
+	}
+
+	return result;
+}
+
+KX_PYMETHODDEF_DOC_VARARGS(KX_Terrain, deform,
+"deform(mode, x, y, radius, strength, height=0.0)\n"
+"\tmodifies the terrain heights in a circle around the given world position,\n"
+"\tthe terrain is updated at the next frame.\n"
+)
+{
+	int mode;
+	float x, y, radius, strength;
+	float height = 0.0f;
+	if (!PyArg_ParseTuple(args, "iffff|f:deform", &mode, &x, &y, &radius, &strength, &height)) {
+		return NULL;
+	}
+
+	if (mode < KX_TerrainDeformation::BRUSH_RAISE || mode > KX_TerrainDeformation::BRUSH_SMOOTH) {
+		PyErr_SetString(PyExc_ValueError, "terrain.deform(mode, x, y, radius, strength, height): KX_Terrain, invalid mode");
+		return NULL;
+	}
+
+	Deform(mode, x, y, radius, strength, height);
+
+	Py_RETURN_NONE;
+}
+
+#endif  // WITH_PYTHON
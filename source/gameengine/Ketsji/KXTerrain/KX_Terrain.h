@@ -26,22 +26,53 @@
 
 #include <map>
 #include <list>
+#include <string>
 #include <vector>
 
 #include "MT_Transform.h"
 
+#include "BLI_threads.h"
+
 #include "KX_ChunkNode.h" // for Point2D
+#include "KX_ChunkNodeMap.h"
 #include "KX_TerrainZone.h"
 #include "KX_GameObject.h"
+#include "KX_IDeformableTerrain.h"
+#include "KX_TerrainLodDrivers.h"
 
 class RAS_IRasterizer;
 class RAS_MaterialBucket;
+class RAS_IndexArray;
 class CListValue;
 struct Material;
-class KX_ChunkRootCache;
-
-class KX_Terrain : public KX_GameObject
+class KX_ChunkCache;
+class KX_TerrainPool;
+class KX_TerrainCollisionTiles;
+class PHY_IPhysicsController;
+class CcdShapeConstructionInfo;
+class btCollisionShape;
+class PHY_IOcclusionBuffer;
+class KX_TerrainTileStore;
+class KX_TerrainDeformation;
+struct TaskPool;
+struct TaskScheduler;
+
+class KX_Terrain : public KX_GameObject, public KX_IDeformableTerrain
 {
+	Py_Header
+public:
+	/// Les parties du terrain dont la mémoire est comptée dans le budget.
+	enum MEMORY_TYPE {
+		MEMORY_VERTEX_INFOS = 0,
+		MEMORY_CHUNK_VERTEXES,
+		MEMORY_MESHES,
+		MEMORY_PHYSICS,
+		MEMORY_CACHE,
+		MEMORY_DEFORMATION,
+		MEMORY_TILE_STORE,
+		MEMORY_MAX
+	};
+
 private:
 	/// Le materiaux utilisé pour tous les meshs de chunks.
 	RAS_MaterialBucket *m_bucket;
@@ -58,12 +89,26 @@ private:
 
 	/// Le niveu de subdivision minimum pour un chunk physique.
 	unsigned short m_minPhysicsLevel;
-
-	/** En theorie le nombre de vertices en largeur dans un chunk.
-	 * Non implementé.
+	/// Utilisation de formes physiques en champ de hauteur au lieu de maillages de triangles.
+	bool m_useHeightfieldPhysics;
+	/** Utilisation de tuiles de collision autour des objets dynamiques au lieu
+	 * des chunks de rendu, les tuiles sont du niveau m_minPhysicsLevel.
 	 */
+	bool m_useCollisionTiles;
+	/// Les tuiles de collision, créées à la construction du terrain.
+	KX_TerrainCollisionTiles *m_collisionTiles;
+
+	/// Le nombre de faces en largeur dans un chunk demandé par l'utilisateur.
 	unsigned short m_vertexSubdivision;
 
+	/** Le nombre de faces en largeur dans un chunk, m_vertexSubdivision arrondi
+	 * à une puissance de deux d'au moins 4 pour que les jointures tombent
+	 * toujours sur un vertice.
+	 */
+	unsigned short m_polyCount;
+	/// Le nombre de vertices en largeur dans un chunk : m_polyCount + 1.
+	unsigned short m_vertexCount;
+
 	/// Le nombre de chunks en largeur dans le terrain.
 	unsigned short m_width;
 
@@ -81,6 +126,19 @@ private:
 	/// Le facteur de la marge du rayon d'un noeud.
 	float m_marginFactor;
 
+	/// Le temps maximum en millisecondes de construction des meshs par frame, 0 pour aucune limite.
+	float m_buildBudget;
+
+	/** La fraction de la distance d'un niveau pendant laquelle les vertices
+	 * se transforment vers les vertices du niveau parent, 0 pour aucune transition.
+	 */
+	float m_morphRange;
+	/// Le temps en secondes de transition d'un chunk nouvellement subdivisé.
+	float m_morphTime;
+
+	/// Les chunks sont utilisés comme occluders pour l'occlusion culling de la scène.
+	bool m_occluder;
+
 	/// Le mode de déboguage des noeuds.
 	short m_debugMode;
 	/// Le nombre de frames entre chaque affichages de temps.
@@ -96,6 +154,8 @@ private:
 
 	/// Le noeud principal du terrain.
 	KX_ChunkNode *m_nodeTree;
+	/// L'index de tous les noeuds par niveau et position, pour trouver les noeuds adjacents.
+	KX_ChunkNodeMap m_nodeMap;
 
 	typedef std::list<KX_Chunk *> KX_ChunkList;
 
@@ -105,18 +165,91 @@ private:
 	/// La liste de tous les chunks à supprimer à la fin de la frame.
 	KX_ChunkList m_euthanasyChunkList;
 
+	/** Les chunks dont la construction ou le rafraichissement des vertices n'est
+	 * pas encore envoyé aux threads de travail, triés par priorité à chaque frame.
+	 */
+	std::vector<KX_Chunk *> m_pendingChunkList;
+
+	/// Le nombre de chunks en cours de construction dans les threads de travail.
+	unsigned int m_scheduledChunkCount;
+
+	/// La position de la camera utilisée pour calculer la priorité des chunks.
+	MT_Point3 m_cameraPosition;
+
+	/// Les objets demandant une subdivision à cette frame.
+	KX_TerrainLodDrivers m_lodDrivers;
+
+	/// Remplit m_lodDrivers avec les objets de la scène.
+	void UpdateLodDrivers(CListValue *objects, KX_Camera *culledcam);
+
 	std::vector<KX_TerrainZoneMesh *> m_zoneMeshList;
 
 	/// Utilisation d'un cache pour la création des vertices.
 	bool m_useCache;
 
-	/// Tant maximum de vie pour un noeud de cache sans activité, en frame.
-	unsigned short m_cacheRefreshTime;
-
-	unsigned short m_cacheFrame;
+	/// La mémoire maximale utilisée par le cache, en mégaoctets.
+	unsigned int m_cacheMemory;
 
 	// Le cache des vertices.
-	KX_ChunkRootCache *m_chunkRootCache;
+	KX_ChunkCache *m_chunkCache;
+
+	/// La mémoire maximale utilisée par le terrain, en mégaoctets, 0 pour aucune limite.
+	unsigned int m_memoryBudget;
+	/// La mémoire utilisée par chaque partie du terrain en octets, mise à jour à chaque frame.
+	size_t m_memoryUsage[MEMORY_MAX];
+	/** Vrai si la mémoire dépasse le budget malgré les suppressions, aucun
+	 * nouveau noeud n'est alors créé.
+	 */
+	bool m_memoryExceeded;
+	/// Le numéro de la frame courante, pour trouver les chunks les moins récemment utilisés.
+	unsigned int m_frame;
+
+	/// Utilisation du stockage sur disque des vertices calculés par les zones.
+	bool m_useTileStore;
+	/// Le dossier absolu du stockage sur disque.
+	std::string m_tileStorePath;
+	/// Le stockage sur disque, créé à la construction du terrain.
+	KX_TerrainTileStore *m_tileStore;
+
+	/// Les modifications des hauteurs faites pendant le jeu.
+	KX_TerrainDeformation *m_deformation;
+
+	/// L'allocateur des informations de vertices.
+	KX_TerrainPool *m_vertexInfoPool;
+	/// L'allocateur des vertices des chunks, un élément contient tous les vertices d'un chunk.
+	KX_TerrainPool *m_vertexPool;
+	/// L'allocateur des sous noeuds, un élément contient les 4 sous noeuds d'un noeud.
+	KX_TerrainPool *m_nodePool;
+
+	/** Le verrou du cache, les vertices sont demandés à la fois par le
+	 * thread principal et par les threads de construction des chunks.
+	 */
+	mutable SpinLock m_cacheLock;
+	/** Incrémenté sous le verrou du cache à chaque modification des zones, un vertice
+	 * calculé pendant une modification n'est pas ajouté au cache.
+	 */
+	unsigned int m_invalidationCount;
+
+	/** Les indices des triangles des chunks pour chaque configuration de jointures,
+	 * indexés par les intervalles de vertices des quatres bords.
+	 */
+	std::map<uint64_t, RAS_IndexArray *> m_polygonTemplates;
+
+	/** Le groupe de taches utilisé pour construire les vertices des chunks
+	 * dans les threads de travail du moteur.
+	 */
+	TaskPool *m_taskPool;
+	/// Le planificateur des threads de travail, fourni par le moteur ou par l'appelant.
+	TaskScheduler *m_taskScheduler;
+
+	/** Les hauteurs des coins (0, 0), (1, 0), (1, 1) et (0, 1) de plusieurs cases
+	 * de la grille des requêtes, count * 4 hauteurs.
+	 */
+	void GetQueryCellHeights(unsigned int count, const int *cellx, const int *celly, float *r_heights) const;
+
+	/// Calcule la mémoire utilisée par chaque partie du terrain.
+	void ComputeMemoryUsage();
+	void PrintMemoryStats() const;
 
 public:
 	KX_Terrain(void *sgReplicationInfo,
@@ -125,26 +258,58 @@ public:
 			   Material *material,
 			   unsigned short maxLevel,
 			   unsigned short minPhysicsLevel,
+			   bool useHeightfieldPhysics,
+			   bool useCollisionTiles,
 			   unsigned short vertexSubdivision,
 			   unsigned short width,
 			   float cameraMaxDistance,
 			   float objectMaxDistance,
 			   float chunkSize,
 			   float marginFactor,
+			   float buildBudget,
+			   float morphRange,
+			   float morphTime,
+			   bool occluder,
 			   short debugMode,
 			   unsigned short debugTimeFrame,
 			   bool useCache,
-			   unsigned short cacheRefreshTime);
+			   unsigned int cacheMemory,
+			   unsigned int memoryBudget,
+			   bool useTileStore,
+			   const std::string& tileStorePath);
 	~KX_Terrain();
 
 	void Construct();
 	void Destruct();
 
-	void CalculateVisibleChunks(KX_Camera *culledcam);
+	/** Calcule les chunks visibles depuis la camera, les objets servent aux zones
+	 * et aux pilotes de niveau de détail. Aucune scène active n'est nécessaire.
+	 */
+	void CalculateVisibleChunks(KX_Camera *culledcam, CListValue *objects);
 	void UpdateChunksMeshes();
 	void RenderChunksMeshes(KX_Camera *cam, RAS_IRasterizer *rasty);
+
+	/** Dessine les chunks affichés dans le tampon d'occlusion, appelée par le test
+	 * de culling de la scène avant de tester les objets.
+	 */
+	void AddOccluders(PHY_IOcclusionBuffer *buffer);
+	/// Teste l'occlusion de chaque chunk visible dans le tampon rempli par le test de culling.
+	void CalculateOccludedChunks(PHY_IOcclusionBuffer *buffer);
 	void DrawDebugNode();
 
+	/// Le temps en secondes utilisé pour les mesures et les transitions, sûr entre les threads.
+	static double GetTime();
+
+	/// Doit être appelée avant la construction du terrain.
+	inline void SetTaskScheduler(TaskScheduler *scheduler)
+	{
+		m_taskScheduler = scheduler;
+	}
+	inline TaskScheduler *GetTaskScheduler() const
+	{
+		return m_taskScheduler;
+	}
+
 	/// Le niveau de subdivision maximal
 	inline unsigned short GetMaxLevel() const
 	{
@@ -155,11 +320,33 @@ public:
 	{
 		return m_minPhysicsLevel;
 	}
+	inline bool GetUseHeightfieldPhysics() const
+	{
+		return m_useHeightfieldPhysics;
+	}
+	inline bool GetUseCollisionTiles() const
+	{
+		return m_useCollisionTiles;
+	}
+	inline const KX_TerrainLodDrivers& GetLodDrivers() const
+	{
+		return m_lodDrivers;
+	}
 	/// le nombre maximun de face en largeur dans un chunk
 	inline unsigned short GetVertexSubdivision() const
 	{
 		return m_vertexSubdivision;
 	}
+	/// Le nombre de faces en largeur dans un chunk.
+	inline unsigned short GetPolyCount() const
+	{
+		return m_polyCount;
+	}
+	/// Le nombre de vertices en largeur dans un chunk.
+	inline unsigned short GetVertexCount() const
+	{
+		return m_vertexCount;
+	}
 	/// La largeur du terrain en echelle relative.
 	inline unsigned short GetWidth() const
 	{
@@ -184,6 +371,22 @@ public:
 	{
 		return m_marginFactor;
 	}
+	inline float GetMorphRange() const
+	{
+		return m_morphRange;
+	}
+	inline float GetMorphTime() const
+	{
+		return m_morphTime;
+	}
+	inline bool GetOccluder() const
+	{
+		return m_occluder;
+	}
+	/** La distance à la camera à partir de laquelle les chunks d'un niveau
+	 * sont remplacés par leur parent, sans la marge des noeuds.
+	 */
+	float GetLevelMaxDistance(unsigned short level) const;
 	/// Le materiaux blender.
 	inline Material *GetBlenderMaterial() const
 	{
@@ -208,12 +411,150 @@ public:
 	VertexZoneInfo *GetVertexInfo(int x, int y) const;
 	VertexZoneInfo *NewVertexInfo(int x, int y) const;
 
-	KX_ChunkNode **NewNodeList(KX_ChunkNode *parentNode, int x, int y, unsigned short level);
+	/** Les informations de plusieurs vertices à la fois, les vertices absents
+	 * du cache sont calculés ensemble zone par zone.
+	 * \param count Le nombre de vertices.
+	 * \param x Les positions en x relatives au terrain.
+	 * \param y Les positions en y relatives au terrain.
+	 * \param r_infos Les informations de chaque vertice, à libérer avec Release.
+	 */
+	virtual void GetVertexInfos(unsigned int count, const int *x, const int *y, VertexZoneInfo **r_infos) const;
+	void NewVertexInfos(unsigned int count, const int *x, const int *y, VertexZoneInfo **r_infos) const;
+
+	/// \section Requêtes sur la surface du terrain.
+
+	/** La surface des requêtes est celle des chunks du niveau maximal, lue dans le cache ou
+	 * calculée par les zones, elle ne dépend donc pas des chunks construits ni de la physique.
+	 * Les positions en dehors du terrain sont ramenées sur son bord.
+	 */
+
+	/// La largeur réelle d'une case de la grille des requêtes.
+	float GetQueryCellSize() const;
+	/// La hauteur du terrain à une position réelle.
+	float GetHeight(float x, float y) const;
+	/// La normale du terrain à une position réelle.
+	MT_Vector3 GetNormal(float x, float y) const;
+	/** Les hauteurs et normales de plusieurs positions à la fois, les vertices
+	 * manquants sont calculés ensemble par les zones.
+	 * \param r_normals Les normales, peut être NULL.
+	 */
+	void GetHeights(unsigned int count, const float *x, const float *y, float *r_heights, MT_Vector3 *r_normals) const;
+	/** Lance un rayon de from vers to sur la surface en parcourant les cases de la grille
+	 * traversées par le rayon. Renvoie vrai si la surface est touchée entre from et to.
+	 */
+	bool RayCast(const MT_Point3& from, const MT_Point3& to, MT_Point3& r_point, MT_Vector3& r_normal) const;
+
+	/// \section Modification des zones.
+
+	/** Supprime du cache les vertices d'un rectangle en coordonnées réelles et marque
+	 * les chunks le touchant pour qu'ils recalculent leurs vertices, appelée par les
+	 * zones quand leur influence change. Appelée uniquement depuis le thread principal.
+	 */
+	virtual void InvalidateArea(float minx, float miny, float maxx, float maxy);
+
+	/** Modifie les hauteurs du terrain dans un cercle en coordonnées réelles, voir
+	 * KX_TerrainDeformation::Brush. Le terrain est mis à jour à la frame suivante.
+	 * \param mode Une valeur de KX_TerrainDeformation::BRUSH_MODE.
+	 */
+	void Deform(int mode, float x, float y, float radius, float strength, float height);
+
+	/// \section Budget mémoire.
+
+	/** Met à jour la mémoire utilisée puis, au delà du budget, supprime les vertices
+	 * utilisés seulement par le cache et les meshs et vertices des chunks en dehors
+	 * du champ de la camera, les moins récemment vus et les plus éloignés en premier.
+	 */
+	void UpdateMemoryBudget();
+	/// La mémoire utilisée par une partie du terrain en octets.
+	inline size_t GetMemoryUsage(MEMORY_TYPE type) const
+	{
+		return m_memoryUsage[type];
+	}
+	size_t GetTotalMemoryUsage() const;
+	/// Le budget mémoire en octets, 0 pour aucune limite.
+	inline size_t GetMemoryBudget() const
+	{
+		return (size_t)m_memoryBudget * 1024 * 1024;
+	}
+	inline bool GetMemoryExceeded() const
+	{
+		return m_memoryExceeded;
+	}
+
+	/// Le hachage des paramètres du terrain et des zones utilisé pour nommer le stockage sur disque.
+	unsigned int GetTileStoreKey() const;
+	/** Calcule tous les vertices du terrain jusqu'au niveau maximal et les
+	 * écrit dans le stockage sur disque. Bloque jusqu'à la fin du calcul, c'est
+	 * pourquoi elle n'est appelée que par le mode de pré-calcul de blenderplayer
+	 * et jamais au lancement du jeu.
+	 * \return Faux si le terrain n'utilise pas de stockage sur disque.
+	 */
+	bool BakeTileStore();
+
+	/** Les indices des triangles d'un chunk partagés par tous les chunks ayant les
+	 * mêmes intervalles de vertices sur leurs bords, construits à la première demande.
+	 * Appelée uniquement depuis le thread principal.
+	 * Les meshs des chunks dessinent leurs vertices avec ces indices sans les copier,
+	 * RAS_StorageVBO n'utilise alors qu'un tampon d'indices par modèle.
+	 */
+	RAS_IndexArray *GetPolygonTemplate(const unsigned short intervals[4]);
+
+#ifdef WITH_BULLET
+	/** Créer une forme physique en champ de hauteur de GetVertexCount() vertices de coté,
+	 * les hauteurs sont rangées ligne par ligne et doivent exister jusqu'à la
+	 * suppression de la forme. La forme est centrée en x, y et sur sa hauteur moyenne.
+	 */
+	btCollisionShape *NewHeightfieldShape(const float *heights, float interval, float minHeight, float maxHeight) const;
+	/// Créer un controlleur physique statique du terrain et l'ajoute à l'environnement physique.
+	PHY_IPhysicsController *NewPhysicsController(btCollisionShape *shape, CcdShapeConstructionInfo *shapeInfo,
+												 const MT_Point3& position);
+#endif
+
+	inline KX_TerrainPool *GetVertexPool() const
+	{
+		return m_vertexPool;
+	}
+
+	inline KX_ChunkNodeMap& GetNodeMap()
+	{
+		return m_nodeMap;
+	}
+	inline const KX_ChunkNodeMap& GetNodeMap() const
+	{
+		return m_nodeMap;
+	}
+
+	/// Créer les 4 sous noeuds contigus d'un noeud.
+	KX_ChunkNode *NewNodeList(KX_ChunkNode *parentNode, int x, int y, unsigned short level);
+	/// Libère les sous noeuds d'un noeud, ceux-ci doivent être déjà détruits.
+	void FreeNodeList(KX_ChunkNode *nodeList);
 	KX_Chunk *AddChunk(KX_ChunkNode *node);
 	void RemoveChunk(KX_Chunk *chunk);
+	/// Reconstruit les vertices et le mesh d'un chunk supprimé par le budget mémoire.
+	void RestoreChunk(KX_Chunk *chunk);
 	void ScheduleEuthanasyChunks();
 
+	/** Envoie les chunks en attente les plus prioritaires aux threads de
+	 * travail sans dépasser un nombre maximal de chunks en construction.
+	 */
+	void SchedulePendingChunks();
+	/// Le nombre de chunks dont les vertices attendent ou sont en construction dans les threads de travail.
+	unsigned int GetBuildingChunkCount() const;
+	/// Construit ou rafraichit les vertices d'un chunk, appelée depuis un thread de travail.
+	void ConstructChunkVertexes(KX_Chunk *chunk);
+
 	void AddTerrainZoneMesh(KX_TerrainZoneMesh *zoneMesh);
+
+#ifdef WITH_PYTHON
+	KX_PYMETHOD_DOC_VARARGS(KX_Terrain, getHeight);
+	KX_PYMETHOD_DOC_VARARGS(KX_Terrain, getNormal);
+	KX_PYMETHOD_DOC_O(KX_Terrain, getHeights);
+	KX_PYMETHOD_DOC_VARARGS(KX_Terrain, rayCast);
+	KX_PYMETHOD_DOC_VARARGS(KX_Terrain, deform);
+
+	static PyObject *pyattr_get_memory_budget(void *self_v, const KX_PYATTRIBUTE_DEF *attrdef);
+	static PyObject *pyattr_get_memory_usage(void *self_v, const KX_PYATTRIBUTE_DEF *attrdef);
+#endif
 };
 
 #endif //__KX_TERRAIN_H__
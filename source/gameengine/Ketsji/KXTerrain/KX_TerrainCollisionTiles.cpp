@@ -0,0 +1,259 @@
+ /*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Contributor(s): none yet.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file gameengine/Ketsji/KXTerrain/KX_TerrainCollisionTiles.cpp
+ *  \ingroup ketsji
+ */
+#include "KX_TerrainCollisionTiles.h"
+#include "KX_Terrain.h"
+
+#include "KX_GameObject.h"
+#include "KX_Profiler.h"
+
+#include "SG_Node.h"
+
+#include "PHY_IPhysicsController.h"
+
+#include <algorithm>
+#include <iostream>
+#include <math.h>
+
+unsigned int KX_TerrainCollisionTiles::tileCreations = 0;
+unsigned int KX_TerrainCollisionTiles::tileRemovals = 0;
+double KX_TerrainCollisionTiles::tileCreatingTime = 0.0;
+unsigned int KX_TerrainCollisionTiles::tileActive = 0;
+
+void KX_TerrainCollisionTiles::ResetTime()
+{
+	tileCreations = 0;
+	tileRemovals = 0;
+	tileCreatingTime = 0.0;
+}
+
+void KX_TerrainCollisionTiles::PrintTime()
+{
+	std::cout << "Collision Tiles Stats : " << std::endl
+		<< "\t active tiles : \t" << tileActive << std::endl
+		<< "\t tile creations : \t" << tileCreations << std::endl
+		<< "\t tile removals : \t" << tileRemovals << std::endl
+		<< "\t tile creating time : \t" << tileCreatingTime << std::endl;
+}
+
+KX_TerrainCollisionTiles::KX_TerrainCollisionTiles(KX_Terrain *terrain, unsigned short level)
+	:m_terrain(terrain),
+	m_relativeSize(terrain->GetWidth() >> (level - 1)),
+	m_tileCount(1 << (level - 1)),
+	m_frame(0)
+{
+}
+
+KX_TerrainCollisionTiles::~KX_TerrainCollisionTiles()
+{
+	for (TileMap::iterator it = m_tiles.begin(); it != m_tiles.end(); ++it) {
+		DeleteTile(it->second);
+	}
+}
+
+KX_TerrainCollisionTiles::Tile *KX_TerrainCollisionTiles::NewTile(const TileKey& key)
+{
+	Tile *tile = new Tile();
+	tile->controller = NULL;
+	tile->lastUsedFrame = m_frame;
+
+	const unsigned short polyCount = m_terrain->GetPolyCount();
+	const unsigned short vertexCount = m_terrain->GetVertexCount();
+	const unsigned int count = vertexCount * vertexCount;
+
+	/* La position relative au terrain du premier vertice de la tuile,
+	 * un noeud de taille relative s fait s * polyCount / 2 vertices de large.
+	 */
+	const int halfTerrainWidth = m_terrain->GetWidth() * polyCount / 4;
+	const int tileWidth = m_relativeSize * polyCount / 2;
+	const int startx = key.first * tileWidth - halfTerrainWidth;
+	const int starty = key.second * tileWidth - halfTerrainWidth;
+	const unsigned short interval = std::max(m_relativeSize / 2, 1);
+
+	int *x = new int[count];
+	int *y = new int[count];
+	VertexZoneInfo **infos = new VertexZoneInfo *[count];
+
+	// Les vertices sont rangés ligne par ligne comme le demande Bullet.
+	for (unsigned short j = 0; j < vertexCount; ++j) {
+		for (unsigned short i = 0; i < vertexCount; ++i) {
+			x[j * vertexCount + i] = startx + i * interval;
+			y[j * vertexCount + i] = starty + j * interval;
+		}
+	}
+
+	m_terrain->GetVertexInfos(count, x, y, infos);
+
+	tile->heights = new float[count];
+	float minHeight = infos[0]->height;
+	float maxHeight = infos[0]->height;
+	for (unsigned int i = 0; i < count; ++i) {
+		const float height = infos[i]->height;
+		tile->heights[i] = height;
+		minHeight = std::min(minHeight, height);
+		maxHeight = std::max(maxHeight, height);
+		infos[i]->Release();
+	}
+
+	delete[] x;
+	delete[] y;
+	delete[] infos;
+
+#ifdef WITH_BULLET
+	const float chunkSize = m_terrain->GetChunkSize();
+	const float halfTerrainSize = m_terrain->GetWidth() * chunkSize / 2.0f;
+	const float tileSize = m_relativeSize * chunkSize;
+
+	// Le champ de hauteur est centré en x, y et sur sa hauteur moyenne.
+	const MT_Point3 position((key.first + 0.5f) * tileSize - halfTerrainSize,
+							 (key.second + 0.5f) * tileSize - halfTerrainSize,
+							 (minHeight + maxHeight) / 2.0f);
+
+	btCollisionShape *shape = m_terrain->NewHeightfieldShape(tile->heights, tileSize / polyCount, minHeight, maxHeight);
+	tile->controller = m_terrain->NewPhysicsController(shape, NULL, position);
+#endif
+
+	++tileCreations;
+	++tileActive;
+
+	return tile;
+}
+
+void KX_TerrainCollisionTiles::DeleteTile(Tile *tile)
+{
+	// La forme physique lit les hauteurs jusqu'à sa suppression.
+	if (tile->controller) {
+		delete tile->controller;
+	}
+	delete[] tile->heights;
+	delete tile;
+
+	--tileActive;
+}
+
+void KX_TerrainCollisionTiles::UseTiles(const MT_Point3& position, float radius, bool create)
+{
+	const float tileSize = m_relativeSize * m_terrain->GetChunkSize();
+	const float halfTerrainSize = m_tileCount * tileSize / 2.0f;
+
+	const int minx = std::max((int)floorf((position.x() - radius + halfTerrainSize) / tileSize), 0);
+	const int miny = std::max((int)floorf((position.y() - radius + halfTerrainSize) / tileSize), 0);
+	const int maxx = std::min((int)floorf((position.x() + radius + halfTerrainSize) / tileSize), m_tileCount - 1);
+	const int maxy = std::min((int)floorf((position.y() + radius + halfTerrainSize) / tileSize), m_tileCount - 1);
+
+	for (int x = minx; x <= maxx; ++x) {
+		for (int y = miny; y <= maxy; ++y) {
+			const TileKey key(x, y);
+			TileMap::iterator it = m_tiles.find(key);
+			if (it != m_tiles.end()) {
+				it->second->lastUsedFrame = m_frame;
+			}
+			else if (create) {
+				m_tiles[key] = NewTile(key);
+			}
+		}
+	}
+}
+
+void KX_TerrainCollisionTiles::Update(CListValue *objects)
+{
+	KX_PROFILE_ZONE("Terrain CollisionTiles");
+
+	const double starttime = KX_Terrain::GetTime();
+	const unsigned int creations = tileCreations;
+
+	++m_frame;
+
+	const float distance = m_terrain->GetObjectMaxDistance();
+	/* Les tuiles sont créées à distance de l'objet et gardées jusqu'à une distance plus grande
+	 * pour ne pas les recréer quand un objet oscille autour d'une limite.
+	 */
+	const float margin = m_terrain->GetMarginFactor();
+
+	for (unsigned int i = 0; i < objects->GetCount(); ++i) {
+		KX_GameObject *object = (KX_GameObject *)objects->GetValue(i);
+
+		// Seuls les objets dynamiques actifs ont besoin de collisions avec le terrain.
+		if (!object->GetPhysicsController() ||
+			!object->GetPhysicsController()->IsDynamic() ||
+			object->GetPhysicsController()->IsSuspended())
+		{
+			continue;
+		}
+
+		const MT_Point3 position = object->NodeGetWorldPosition();
+		const float radius = object->GetSGNode()->Radius() + distance;
+
+		UseTiles(position, radius, true);
+		UseTiles(position, radius * margin, false);
+	}
+
+	// Suppression des tuiles dont aucun objet n'est proche.
+	for (TileMap::iterator it = m_tiles.begin(); it != m_tiles.end();) {
+		Tile *tile = it->second;
+		if (tile->lastUsedFrame != m_frame) {
+			DeleteTile(tile);
+			m_tiles.erase(it++);
+			++tileRemovals;
+		}
+		else {
+			++it;
+		}
+	}
+
+	if (tileCreations != creations) {
+		tileCreatingTime += KX_Terrain::GetTime() - starttime;
+	}
+}
+
+void KX_TerrainCollisionTiles::InvalidateArea(float minx, float miny, float maxx, float maxy)
+{
+	const float tileSize = m_relativeSize * m_terrain->GetChunkSize();
+	const float halfTerrainSize = m_tileCount * tileSize / 2.0f;
+
+	// Une tuile contient aussi les vertices de son bord commun avec la tuile suivante.
+	const int mintilex = (int)ceilf((minx + halfTerrainSize) / tileSize) - 1;
+	const int mintiley = (int)ceilf((miny + halfTerrainSize) / tileSize) - 1;
+	const int maxtilex = (int)floorf((maxx + halfTerrainSize) / tileSize);
+	const int maxtiley = (int)floorf((maxy + halfTerrainSize) / tileSize);
+
+	for (TileMap::iterator it = m_tiles.begin(); it != m_tiles.end();) {
+		const TileKey& key = it->first;
+		if (mintilex <= key.first && key.first <= maxtilex && mintiley <= key.second && key.second <= maxtiley) {
+			DeleteTile(it->second);
+			m_tiles.erase(it++);
+			++tileRemovals;
+		}
+		else {
+			++it;
+		}
+	}
+}
+
+size_t KX_TerrainCollisionTiles::GetMemoryUsage() const
+{
+	const unsigned short vertexCount = m_terrain->GetVertexCount();
+	return m_tiles.size() * (vertexCount * vertexCount * sizeof(float) + sizeof(Tile));
+}
@@ -0,0 +1,113 @@
+ /*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Contributor(s): none yet.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+#ifndef __KX_TERRAIN_COLLISION_TILES_H__
+#define __KX_TERRAIN_COLLISION_TILES_H__
+
+#include "MT_Point3.h"
+
+#include <map>
+#include <utility>
+
+class KX_Terrain;
+class CListValue;
+class PHY_IPhysicsController;
+
+/** Gestion des formes physiques du terrain indépendamment des chunks de rendu.
+ * Le terrain est découpé en tuiles de la taille d'un noeud d'un niveau fixe,
+ * chaque tuile est un champ de hauteur créé quand un objet dynamique s'en
+ * approche et supprimé quand plus aucun objet n'est proche. Les subdivisions
+ * des noeuds de rendu ne reconstruisent donc jamais de formes physiques et
+ * le coût de la physique dépend du nombre d'objets et non de la vue.
+ */
+class KX_TerrainCollisionTiles
+{
+public:
+	/// Variables utilisées pour faire des statistiques.
+
+	/// Le nombre de tuiles créées.
+	static unsigned int tileCreations;
+	/// Le nombre de tuiles supprimées.
+	static unsigned int tileRemovals;
+	/// Le temps dépensé pour créer les tuiles, calcul des vertices compris.
+	static double tileCreatingTime;
+	/// Le nombre de tuiles actives.
+	static unsigned int tileActive;
+
+	static void ResetTime();
+	static void PrintTime();
+
+private:
+	struct Tile
+	{
+		PHY_IPhysicsController *controller;
+		/// Les hauteurs des vertices ligne par ligne lues par la forme physique.
+		float *heights;
+		/// La dernière frame où un objet était proche de la tuile.
+		unsigned int lastUsedFrame;
+	};
+
+	typedef std::pair<int, int> TileKey;
+	typedef std::map<TileKey, Tile *> TileMap;
+
+	KX_Terrain *m_terrain;
+	/// La taille relative d'une tuile, celle d'un noeud du niveau des tuiles.
+	const unsigned short m_relativeSize;
+	/// Le nombre de tuiles en largeur du terrain.
+	const int m_tileCount;
+
+	TileMap m_tiles;
+	/// Le numéro de la frame courante, pour trouver les tuiles inutilisées.
+	unsigned int m_frame;
+
+	Tile *NewTile(const TileKey& key);
+	void DeleteTile(Tile *tile);
+	/** Marque comme utilisées les tuiles touchant un carré centré sur une position,
+	 * si create est vrai les tuiles manquantes sont créées.
+	 */
+	void UseTiles(const MT_Point3& position, float radius, bool create);
+
+public:
+	/// Créer la gestion de tuiles pour des tuiles de la taille d'un noeud de niveau level.
+	KX_TerrainCollisionTiles(KX_Terrain *terrain, unsigned short level);
+	~KX_TerrainCollisionTiles();
+
+	/** Créer les tuiles autour des objets dynamiques et supprime celles qui
+	 * en sont trop éloignées, appelée une fois par frame.
+	 */
+	void Update(CListValue *objects);
+
+	/** Supprime les tuiles touchant un rectangle en coordonnées réelles dont les
+	 * hauteurs ont changées, elles sont recréées au prochain appel de Update.
+	 */
+	void InvalidateArea(float minx, float miny, float maxx, float maxy);
+
+	inline unsigned int GetTileCount() const
+	{
+		return m_tiles.size();
+	}
+
+	/// La mémoire utilisée par les hauteurs des tuiles en octets.
+	size_t GetMemoryUsage() const;
+};
+
+#endif  // __KX_TERRAIN_COLLISION_TILES_H__
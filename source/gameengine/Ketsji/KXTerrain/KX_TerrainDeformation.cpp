@@ -0,0 +1,281 @@
+ /*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Contributor(s): none yet.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file gameengine/Ketsji/KXTerrain/KX_TerrainDeformation.cpp
+ *  \ingroup ketsji
+ */
+#include "KX_TerrainDeformation.h"
+#include "KX_IDeformableTerrain.h"
+#include "KX_TerrainZone.h"
+
+#include <algorithm>
+#include <iostream>
+#include <string.h>
+#include <math.h>
+
+/// Le nombre de vertices de coté d'une tuile, une puissance de deux.
+#define TILE_SHIFT 5
+#define TILE_SIZE (1 << TILE_SHIFT)
+
+struct KX_TerrainDeformation::Tile
+{
+	float deltas[TILE_SIZE * TILE_SIZE];
+};
+
+unsigned int KX_TerrainDeformation::brushEdits = 0;
+unsigned int KX_TerrainDeformation::flushedAreas = 0;
+
+void KX_TerrainDeformation::ResetTime()
+{
+	brushEdits = 0;
+	flushedAreas = 0;
+}
+
+void KX_TerrainDeformation::PrintTime()
+{
+	std::cout << "Deformation Stats : " << std::endl
+		<< "\t brush edits : \t\t" << brushEdits << std::endl
+		<< "\t flushed areas : \t" << flushedAreas << std::endl;
+}
+
+KX_TerrainDeformation::KX_TerrainDeformation(KX_IDeformableTerrain *terrain, int step, float cellSize)
+	:m_terrain(terrain),
+	m_step(step),
+	m_cellSize(cellSize)
+{
+	BLI_rw_mutex_init(&m_tilesLock);
+}
+
+KX_TerrainDeformation::~KX_TerrainDeformation()
+{
+	for (TileMap::iterator it = m_tiles.begin(); it != m_tiles.end(); ++it) {
+		delete it->second;
+	}
+
+	BLI_rw_mutex_end(&m_tilesLock);
+}
+
+float *KX_TerrainDeformation::GetDelta(int gx, int gy, bool create)
+{
+	// Le décalage arithmétique arrondit aussi les positions négatives vers le bas.
+	const TileKey key(gx >> TILE_SHIFT, gy >> TILE_SHIFT);
+	TileMap::iterator it = m_tiles.find(key);
+
+	Tile *tile;
+	if (it != m_tiles.end()) {
+		tile = it->second;
+	}
+	else if (create) {
+		tile = new Tile();
+		memset(tile->deltas, 0, sizeof(tile->deltas));
+		m_tiles[key] = tile;
+	}
+	else {
+		return NULL;
+	}
+
+	return &tile->deltas[(gx & (TILE_SIZE - 1)) * TILE_SIZE + (gy & (TILE_SIZE - 1))];
+}
+
+void KX_TerrainDeformation::AddDirtyArea(const Area& area)
+{
+	Area merged = area;
+
+	// Les zones recouvertes sont fusionnées, on recommence car la zone fusionnée grandit.
+	bool overlap = true;
+	while (overlap) {
+		overlap = false;
+		for (std::vector<Area>::iterator it = m_dirtyAreas.begin(); it != m_dirtyAreas.end(); ++it) {
+			const float *bounds = it->bounds;
+			if (bounds[0] <= merged.bounds[2] && merged.bounds[0] <= bounds[2] &&
+				bounds[1] <= merged.bounds[3] && merged.bounds[1] <= bounds[3])
+			{
+				merged.bounds[0] = std::min(merged.bounds[0], bounds[0]);
+				merged.bounds[1] = std::min(merged.bounds[1], bounds[1]);
+				merged.bounds[2] = std::max(merged.bounds[2], bounds[2]);
+				merged.bounds[3] = std::max(merged.bounds[3], bounds[3]);
+				m_dirtyAreas.erase(it);
+				overlap = true;
+				break;
+			}
+		}
+	}
+
+	m_dirtyAreas.push_back(merged);
+}
+
+void KX_TerrainDeformation::Brush(BRUSH_MODE mode, float x, float y, float radius, float strength, float height)
+{
+	if (radius <= 0.0f) {
+		return;
+	}
+
+	// Les vertices de la grille compris dans le carré du pinceau.
+	const int mingx = (int)ceilf((x - radius) / m_cellSize);
+	const int mingy = (int)ceilf((y - radius) / m_cellSize);
+	const int maxgx = (int)floorf((x + radius) / m_cellSize);
+	const int maxgy = (int)floorf((y + radius) / m_cellSize);
+	if (mingx > maxgx || mingy > maxgy) {
+		return;
+	}
+
+	const int sizex = maxgx - mingx + 1;
+	const int sizey = maxgy - mingy + 1;
+
+	/* Les hauteurs actuelles sont lues pour aplanir et lisser avec une bordure d'un
+	 * vertice pour la moyenne des voisins.
+	 */
+	std::vector<float> heights;
+	if (mode == BRUSH_FLATTEN || mode == BRUSH_SMOOTH) {
+		const unsigned int count = (sizex + 2) * (sizey + 2);
+		std::vector<int> vx(count);
+		std::vector<int> vy(count);
+		std::vector<VertexZoneInfo *> infos(count);
+		for (int i = 0; i < sizex + 2; ++i) {
+			for (int j = 0; j < sizey + 2; ++j) {
+				vx[i * (sizey + 2) + j] = (mingx + i - 1) * m_step;
+				vy[i * (sizey + 2) + j] = (mingy + j - 1) * m_step;
+			}
+		}
+
+		m_terrain->GetVertexInfos(count, &vx[0], &vy[0], &infos[0]);
+
+		heights.resize(count);
+		for (unsigned int i = 0; i < count; ++i) {
+			heights[i] = infos[i]->height;
+			infos[i]->Release();
+		}
+	}
+
+	const float factor = std::min(strength, 1.0f);
+
+	BLI_rw_mutex_lock(&m_tilesLock, THREAD_LOCK_WRITE);
+	for (int i = 0; i < sizex; ++i) {
+		for (int j = 0; j < sizey; ++j) {
+			const float dx = (mingx + i) * m_cellSize - x;
+			const float dy = (mingy + j) * m_cellSize - y;
+			const float distance = sqrtf(dx * dx + dy * dy) / radius;
+			if (distance >= 1.0f) {
+				continue;
+			}
+
+			// Une décroissance douce et nulle au bord du pinceau.
+			const float falloff = (1.0f - distance * distance) * (1.0f - distance * distance);
+			float offset = 0.0f;
+
+			switch (mode) {
+				case BRUSH_RAISE:
+				{
+					offset = strength * falloff;
+					break;
+				}
+				case BRUSH_LOWER:
+				{
+					offset = -strength * falloff;
+					break;
+				}
+				case BRUSH_FLATTEN:
+				{
+					const float current = heights[(i + 1) * (sizey + 2) + j + 1];
+					offset = (height - current) * factor * falloff;
+					break;
+				}
+				case BRUSH_SMOOTH:
+				{
+					float sum = 0.0f;
+					for (int k = 0; k < 3; ++k) {
+						for (int l = 0; l < 3; ++l) {
+							sum += heights[(i + k) * (sizey + 2) + j + l];
+						}
+					}
+					const float current = heights[(i + 1) * (sizey + 2) + j + 1];
+					offset = (sum / 9.0f - current) * factor * falloff;
+					break;
+				}
+			}
+
+			if (offset != 0.0f) {
+				*GetDelta(mingx + i, mingy + j, true) += offset;
+			}
+		}
+	}
+	BLI_rw_mutex_unlock(&m_tilesLock);
+
+	const Area area = {{x - radius, y - radius, x + radius, y + radius}};
+	AddDirtyArea(area);
+
+	++brushEdits;
+}
+
+void KX_TerrainDeformation::ApplyDeltas(unsigned int count, const int *x, const int *y, VertexZoneInfo **infos) const
+{
+	BLI_rw_mutex_lock(&m_tilesLock, THREAD_LOCK_READ);
+
+	if (!m_tiles.empty()) {
+		/* Les vertices d'un chunk sont proches, on garde la dernière tuile
+		 * trouvée pour éviter une recherche par vertice.
+		 */
+		TileKey lastKey(0, 0);
+		const Tile *lastTile = NULL;
+		bool hasLastTile = false;
+
+		for (unsigned int i = 0; i < count; ++i) {
+			// Seuls les vertices de la grille la plus fine ont une différence de hauteur.
+			if (x[i] % m_step != 0 || y[i] % m_step != 0) {
+				continue;
+			}
+
+			const int gx = x[i] / m_step;
+			const int gy = y[i] / m_step;
+			const TileKey key(gx >> TILE_SHIFT, gy >> TILE_SHIFT);
+
+			if (!hasLastTile || key != lastKey) {
+				TileMap::const_iterator it = m_tiles.find(key);
+				lastTile = (it != m_tiles.end()) ? it->second : NULL;
+				lastKey = key;
+				hasLastTile = true;
+			}
+
+			if (lastTile) {
+				infos[i]->height += lastTile->deltas[(gx & (TILE_SIZE - 1)) * TILE_SIZE + (gy & (TILE_SIZE - 1))];
+			}
+		}
+	}
+
+	BLI_rw_mutex_unlock(&m_tilesLock);
+}
+
+void KX_TerrainDeformation::Flush()
+{
+	for (std::vector<Area>::const_iterator it = m_dirtyAreas.begin(); it != m_dirtyAreas.end(); ++it) {
+		const float *bounds = it->bounds;
+		m_terrain->InvalidateArea(bounds[0], bounds[1], bounds[2], bounds[3]);
+	}
+
+	flushedAreas += m_dirtyAreas.size();
+	m_dirtyAreas.clear();
+}
+
+size_t KX_TerrainDeformation::GetMemoryUsage() const
+{
+	return m_tiles.size() * (sizeof(Tile) + sizeof(TileMap::value_type));
+}
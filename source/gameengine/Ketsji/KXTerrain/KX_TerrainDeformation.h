@@ -0,0 +1,129 @@
+ /*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Contributor(s): none yet.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+#ifndef __KX_TERRAIN_DEFORMATION_H__
+#define __KX_TERRAIN_DEFORMATION_H__
+
+#include "BLI_threads.h"
+
+#include <map>
+#include <utility>
+#include <vector>
+
+class KX_IDeformableTerrain;
+class VertexZoneInfo;
+
+/** Modifications des hauteurs du terrain pendant le jeu par des coups de pinceau.
+ * Les modifications sont des différences de hauteur ajoutées aux hauteurs des zones,
+ * stockées sur la grille des vertices des plus petits chunks dans des tuiles créées
+ * seulement là où le terrain est modifié.
+ * Les zones modifiées sont accumulées et invalidées une seule fois par frame dans
+ * Flush, plusieurs coups de pinceau sur un même chunk ne le reconstruisent qu'une fois.
+ */
+class KX_TerrainDeformation
+{
+public:
+	enum BRUSH_MODE {
+		/// Monte le terrain de strength au centre du pinceau.
+		BRUSH_RAISE = 0,
+		/// Descend le terrain de strength au centre du pinceau.
+		BRUSH_LOWER,
+		/// Rapproche le terrain d'une hauteur, strength entre 0 et 1.
+		BRUSH_FLATTEN,
+		/// Rapproche le terrain de la moyenne de ses voisins, strength entre 0 et 1.
+		BRUSH_SMOOTH
+	};
+
+	/// Variables utilisées pour faire des statistiques.
+
+	/// Le nombre de coups de pinceau.
+	static unsigned int brushEdits;
+	/// Le nombre de zones invalidées par Flush.
+	static unsigned int flushedAreas;
+
+	static void ResetTime();
+	static void PrintTime();
+
+private:
+	struct Tile;
+
+	typedef std::pair<int, int> TileKey;
+	typedef std::map<TileKey, Tile *> TileMap;
+
+	/// Un rectangle en coordonnées réelles : minx, miny, maxx, maxy.
+	struct Area
+	{
+		float bounds[4];
+	};
+
+	KX_IDeformableTerrain *m_terrain;
+	/// L'intervalle en vertices entre deux vertices des plus petits chunks.
+	const int m_step;
+	/// La distance réelle entre deux vertices des plus petits chunks.
+	const float m_cellSize;
+
+	TileMap m_tiles;
+	/// Le verrou des tuiles, lues par les threads de construction des chunks.
+	mutable ThreadRWMutex m_tilesLock;
+
+	/// Les zones modifiées depuis le dernier appel de Flush, sans recouvrement.
+	std::vector<Area> m_dirtyAreas;
+
+	/// La différence de hauteur d'un vertice de la grille, NULL si sa tuile n'existe pas et create est faux.
+	float *GetDelta(int gx, int gy, bool create);
+	/// Ajoute une zone modifiée en la fusionnant avec les zones qu'elle recouvre.
+	void AddDirtyArea(const Area& area);
+
+public:
+	/** \param step L'intervalle en positions relatives entre deux vertices des plus petits chunks.
+	 * \param cellSize La distance réelle entre deux vertices des plus petits chunks.
+	 */
+	KX_TerrainDeformation(KX_IDeformableTerrain *terrain, int step, float cellSize);
+	~KX_TerrainDeformation();
+
+	/** Modifie les hauteurs dans un cercle, la modification décroit du centre au bord.
+	 * Les hauteurs modifiées sont utilisées par les chunks et les requêtes à partir
+	 * du prochain appel de Flush. Appelée uniquement depuis le thread principal.
+	 * \param mode Le type de modification.
+	 * \param x La position réelle du centre en x.
+	 * \param y La position réelle du centre en y.
+	 * \param radius Le rayon réel du pinceau.
+	 * \param strength La force du pinceau.
+	 * \param height La hauteur visée par BRUSH_FLATTEN.
+	 */
+	void Brush(BRUSH_MODE mode, float x, float y, float radius, float strength, float height);
+
+	/** Ajoute les différences de hauteur à des vertices calculés par les zones,
+	 * appelée depuis les threads de construction des chunks.
+	 * \param x Les positions en x relatives au terrain.
+	 * \param y Les positions en y relatives au terrain.
+	 */
+	void ApplyDeltas(unsigned int count, const int *x, const int *y, VertexZoneInfo **infos) const;
+
+	/// Invalide les vertices, chunks et formes physiques des zones modifiées, appelée une fois par frame.
+	void Flush();
+
+	/// La mémoire utilisée par les tuiles en octets.
+	size_t GetMemoryUsage() const;
+};
+
+#endif  // __KX_TERRAIN_DEFORMATION_H__
@@ -0,0 +1,253 @@
+ /*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Contributor(s): none yet.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file gameengine/Ketsji/KXTerrain/KX_TerrainLodDrivers.cpp
+ *  \ingroup ketsji
+ */
+
+#include "KX_TerrainLodDrivers.h"
+
+#include <algorithm>
+#include <float.h>
+
+/// Le nombre maximal de cellules sur chaque axe de la grille.
+#define GRID_MAX_SIZE 64
+
+KX_TerrainLodDrivers::KX_TerrainLodDrivers(unsigned short maxLevel, float cameraMaxDistance, float objectMaxDistance, float marginFactor)
+	:m_cellSize(objectMaxDistance),
+	m_maxLevel(maxLevel),
+	m_cameraMaxDistance(cameraMaxDistance),
+	m_objectMaxDistance(objectMaxDistance),
+	m_marginFactor(marginFactor)
+{
+	m_gridOrigin[0] = m_gridOrigin[1] = 0.0f;
+	m_gridSize[0] = m_gridSize[1] = 0;
+}
+
+void KX_TerrainLodDrivers::Clear()
+{
+	m_drivers.clear();
+	m_cellStarts.clear();
+	m_cellDrivers.clear();
+	m_gridSize[0] = m_gridSize[1] = 0;
+}
+
+void KX_TerrainLodDrivers::AddDriver(const MT_Point3& position, float radius, bool iscamera, bool dynamic)
+{
+	LodDriver driver;
+	driver.position = position;
+	driver.radius = radius;
+	driver.iscamera = iscamera;
+	driver.dynamic = dynamic;
+
+	if (iscamera) {
+		m_drivers.insert(m_drivers.begin(), driver);
+	}
+	else {
+		m_drivers.push_back(driver);
+	}
+}
+
+float KX_TerrainLodDrivers::GetReach(const LodDriver& driver) const
+{
+	/* GetSubdivision ne renvoie un niveau supérieur à 0 qu'en dessous de la distance
+	 * maximale, au delà l'objet ne subdivise aucun noeud.
+	 */
+	return (driver.iscamera ? m_cameraMaxDistance : m_objectMaxDistance) + driver.radius;
+}
+
+bool KX_TerrainLodDrivers::GetCellRange(const MT_Point3& center, float halfSize, int r_min[2], int r_max[2]) const
+{
+	for (unsigned short i = 0; i < 2; ++i) {
+		const float min = (center[i] - halfSize - m_gridOrigin[i]) / m_cellSize;
+		const float max = (center[i] + halfSize - m_gridOrigin[i]) / m_cellSize;
+		if (max < 0.0f || min >= m_gridSize[i]) {
+			return false;
+		}
+		r_min[i] = (min < 0.0f) ? 0 : (int)min;
+		r_max[i] = (max >= m_gridSize[i]) ? m_gridSize[i] - 1 : (int)max;
+	}
+	return true;
+}
+
+void KX_TerrainLodDrivers::BuildGrid()
+{
+	m_cellStarts.clear();
+	m_cellDrivers.clear();
+	m_gridSize[0] = m_gridSize[1] = 0;
+
+	if (m_drivers.empty()) {
+		return;
+	}
+
+	// La boite englobant la portée de tous les objets.
+	float min[2] = {FLT_MAX, FLT_MAX};
+	float max[2] = {-FLT_MAX, -FLT_MAX};
+	for (std::vector<LodDriver>::const_iterator it = m_drivers.begin(), end = m_drivers.end(); it != end; ++it) {
+		const float reach = GetReach(*it);
+		for (unsigned short i = 0; i < 2; ++i) {
+			min[i] = std::min(min[i], (float)it->position[i] - reach);
+			max[i] = std::max(max[i], (float)it->position[i] + reach);
+		}
+	}
+
+	/* Les cellules ont la taille de la portée des objets pour qu'un objet ne soit
+	 * rangé que dans quelques cellules, mais des objets très éloignés les uns des
+	 * autres agrandissent les cellules plutôt que le nombre de cellules.
+	 */
+	m_cellSize = std::max(std::max(m_objectMaxDistance, 1.0f), std::max(max[0] - min[0], max[1] - min[1]) / GRID_MAX_SIZE);
+	for (unsigned short i = 0; i < 2; ++i) {
+		m_gridOrigin[i] = min[i];
+		m_gridSize[i] = std::min((int)((max[i] - min[i]) / m_cellSize) + 1, GRID_MAX_SIZE);
+	}
+
+	/* Les objets sont rangés par cellule en deux passes : le comptage des objets
+	 * de chaque cellule puis le remplissage, dans l'ordre de m_drivers pour garder
+	 * les cameras en premier.
+	 */
+	m_cellStarts.resize(m_gridSize[0] * m_gridSize[1] + 1, 0);
+	for (unsigned short pass = 0; pass < 2; ++pass) {
+		for (unsigned int i = 0, size = m_drivers.size(); i < size; ++i) {
+			const LodDriver& driver = m_drivers[i];
+			int cellMin[2];
+			int cellMax[2];
+			GetCellRange(driver.position, GetReach(driver), cellMin, cellMax);
+			for (int y = cellMin[1]; y <= cellMax[1]; ++y) {
+				for (int x = cellMin[0]; x <= cellMax[0]; ++x) {
+					const unsigned int cell = y * m_gridSize[0] + x;
+					if (pass == 0) {
+						++m_cellStarts[cell + 1];
+					}
+					else {
+						m_cellDrivers[m_cellStarts[cell]++] = i;
+					}
+				}
+			}
+		}
+
+		if (pass == 0) {
+			for (unsigned int i = 1, size = m_cellStarts.size(); i < size; ++i) {
+				m_cellStarts[i] += m_cellStarts[i - 1];
+			}
+			m_cellDrivers.resize(m_cellStarts.back());
+		}
+		else {
+			// Le remplissage a avancé chaque début jusqu'au début de la cellule suivante.
+			for (unsigned int i = m_cellStarts.size() - 1; i > 0; --i) {
+				m_cellStarts[i] = m_cellStarts[i - 1];
+			}
+			m_cellStarts[0] = 0;
+		}
+	}
+}
+
+template <class Func>
+bool KX_TerrainLodDrivers::FindDriver(const MT_Point3& center, float radius, Func func) const
+{
+	int cellMin[2];
+	int cellMax[2];
+	if (!GetCellRange(center, radius, cellMin, cellMax)) {
+		return false;
+	}
+
+	for (int y = cellMin[1]; y <= cellMax[1]; ++y) {
+		for (int x = cellMin[0]; x <= cellMax[0]; ++x) {
+			const unsigned int cell = y * m_gridSize[0] + x;
+			for (unsigned int i = m_cellStarts[cell], end = m_cellStarts[cell + 1]; i < end; ++i) {
+				if (func(m_drivers[m_cellDrivers[i]])) {
+					return true;
+				}
+			}
+		}
+	}
+
+	return false;
+}
+
+unsigned short KX_TerrainLodDrivers::GetSubdivision(float distance, bool iscamera) const
+{
+	// les objets non pas besoin d'une aussi grande subdivision que la camera
+	const float maxdistance = iscamera ? m_cameraMaxDistance : m_objectMaxDistance;
+	const float interval = maxdistance / m_maxLevel;
+	for (unsigned short i = 0; i <= m_maxLevel; ++i) {
+		if (distance < (interval * (i + 1))) {
+			return m_maxLevel - i;
+		}
+	}
+	return 0;
+}
+
+struct NeedSubdivisionFunc
+{
+	const KX_TerrainLodDrivers& drivers;
+	const MT_Point3& center;
+	const float radius;
+	const float cameraRadius;
+	const unsigned short level;
+
+	NeedSubdivisionFunc(const KX_TerrainLodDrivers& drivers, const MT_Point3& center, float radius,
+						float cameraRadius, unsigned short level)
+		:drivers(drivers),
+		center(center),
+		radius(radius),
+		cameraRadius(cameraRadius),
+		level(level)
+	{
+	}
+
+	bool operator()(const KX_TerrainLodDrivers::LodDriver& driver) const
+	{
+		float distance = center.distance(driver.position) - driver.radius;
+		distance -= radius + (driver.iscamera ? cameraRadius : radius);
+
+		return (drivers.GetSubdivision(distance, driver.iscamera) > level);
+	}
+};
+
+bool KX_TerrainLodDrivers::NeedSubdivision(const MT_Point3& center, float radius, float radiusMargin, unsigned short level) const
+{
+	const float cameraRadius = radiusMargin * m_marginFactor;
+	return FindDriver(center, radius + std::max(radius, cameraRadius),
+					  NeedSubdivisionFunc(*this, center, radius, cameraRadius, level));
+}
+
+struct TouchDynamicFunc
+{
+	const MT_Point3& center;
+	const float radius;
+
+	TouchDynamicFunc(const MT_Point3& center, float radius)
+		:center(center),
+		radius(radius)
+	{
+	}
+
+	bool operator()(const KX_TerrainLodDrivers::LodDriver& driver) const
+	{
+		return (driver.dynamic && (center.distance(driver.position) - radius - driver.radius) < 0.0f);
+	}
+};
+
+bool KX_TerrainLodDrivers::TouchDynamic(const MT_Point3& center, float radius) const
+{
+	return FindDriver(center, radius, TouchDynamicFunc(center, radius));
+}
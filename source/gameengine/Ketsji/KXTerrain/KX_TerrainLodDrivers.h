@@ -0,0 +1,115 @@
+ /*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Contributor(s): none yet.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+#ifndef __KX_TERRAIN_LOD_DRIVERS_H__
+#define __KX_TERRAIN_LOD_DRIVERS_H__
+
+#include "MT_Point3.h"
+
+#include <vector>
+
+/** Les objets autour desquels les noeuds du terrain se subdivisent : les cameras
+ * actives et les objets dynamiques visibles. La liste est remplie une fois par frame
+ * depuis la liste des objets de la scène puis rangée dans une grille sur les axes X et Y
+ * par BuildGrid. Chaque noeud ne teste que les objets des cellules qu'il recouvre.
+ */
+class KX_TerrainLodDrivers
+{
+public:
+	struct LodDriver
+	{
+		MT_Point3 position;
+		/// Le rayon de l'objet.
+		float radius;
+		bool iscamera;
+		/// Vrai si l'objet utilise un controlleur physique dynamique actif.
+		bool dynamic;
+	};
+
+private:
+	/// Les objets de cette frame.
+	std::vector<LodDriver> m_drivers;
+
+	/// La taille d'une cellule de la grille.
+	float m_cellSize;
+	/// La position de la première cellule en x et y.
+	float m_gridOrigin[2];
+	/// Le nombre de cellules en x et y.
+	int m_gridSize[2];
+	/** L'indice dans m_cellDrivers du premier objet de chaque cellule, la dernière
+	 * valeur est la taille de m_cellDrivers.
+	 */
+	std::vector<unsigned int> m_cellStarts;
+	/** Les indices dans m_drivers des objets de chaque cellule, les cameras en premier
+	 * car elles subdivisent le plus loin. Un objet est rangé dans toutes les cellules
+	 * à portée de sa distance maximale de subdivision.
+	 */
+	std::vector<unsigned int> m_cellDrivers;
+
+	/// Le niveau maximal des noeuds.
+	const unsigned short m_maxLevel;
+	/// La distance à partir de laquelle une camera ne subdivise plus.
+	const float m_cameraMaxDistance;
+	/// La même chose que m_cameraMaxDistance mais pour les objets physique.
+	const float m_objectMaxDistance;
+	/// Le facteur de la marge ajoutée au rayon des noeuds pour les cameras.
+	const float m_marginFactor;
+
+	/// La distance maximale à laquelle un objet peut subdiviser ou toucher un noeud.
+	float GetReach(const LodDriver& driver) const;
+	/** Calcule les cellules recouvertes par un carré.
+	 * \return Faux si le carré est en dehors de la grille.
+	 */
+	bool GetCellRange(const MT_Point3& center, float halfSize, int r_min[2], int r_max[2]) const;
+
+	/** Appelle func pour chaque objet pouvant être à moins de radius d'un point
+	 * jusqu'à ce qu'elle renvoie vrai. Un objet peut être testé plusieurs fois.
+	 */
+	template <class Func>
+	bool FindDriver(const MT_Point3& center, float radius, Func func) const;
+
+public:
+	KX_TerrainLodDrivers(unsigned short maxLevel, float cameraMaxDistance, float objectMaxDistance, float marginFactor);
+
+	void Clear();
+	void AddDriver(const MT_Point3& position, float radius, bool iscamera, bool dynamic);
+	/// Range les objets ajoutés dans la grille, à appeler avant de tester les noeuds.
+	void BuildGrid();
+
+	/// Le niveau de subdivision demandé par un objet à une distance.
+	unsigned short GetSubdivision(float distance, bool iscamera) const;
+	/** Vrai si un des objets demande un niveau supérieur à level pour un noeud.
+	 * \param center Le centre du noeud.
+	 * \param radius Le rayon du noeud.
+	 * \param radiusMargin La marge du rayon du noeud pour les cameras.
+	 */
+	bool NeedSubdivision(const MT_Point3& center, float radius, float radiusMargin, unsigned short level) const;
+	/// Vrai si un objet dynamique touche la sphère d'un noeud.
+	bool TouchDynamic(const MT_Point3& center, float radius) const;
+
+	inline unsigned int GetCount() const
+	{
+		return m_drivers.size();
+	}
+};
+
+#endif  // __KX_TERRAIN_LOD_DRIVERS_H__
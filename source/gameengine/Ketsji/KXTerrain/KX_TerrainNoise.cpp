@@ -0,0 +1,243 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Contributor(s): none yet.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file gameengine/Ketsji/KXTerrain/KX_TerrainNoise.cpp
+ *  \ingroup ketsji
+ */
+#include "KX_TerrainNoise.h"
+
+#include "DNA_texture_types.h"
+
+#include "BLI_noise.h"
+
+#include <math.h>
+
+#ifdef __SSE2__
+#  include <emmintrin.h>
+
+/// Le type de bruit "Improved Perlin" dans TerrainZone::noisebasis.
+#define NOISE_BASIS_NEW_PERLIN 2
+
+// La table de permutation de noise.c.
+extern "C" {
+	extern const unsigned char hash[];
+}
+
+/** Equivalent de floor pour quatre flottants, les valeurs entières
+ * (y compris -0.0) sont renvoyées telles quelles comme le fait floor.
+ */
+static inline __m128 floor_ps(__m128 x)
+{
+	const __m128 trunc = _mm_cvtepi32_ps(_mm_cvttps_epi32(x));
+	const __m128 floor = _mm_sub_ps(trunc, _mm_and_ps(_mm_cmpgt_ps(trunc, x), _mm_set1_ps(1.0f)));
+	const __m128 integer = _mm_cmpeq_ps(trunc, x);
+	return _mm_or_ps(_mm_and_ps(integer, x), _mm_andnot_ps(integer, floor));
+}
+
+static inline __m128 select_ps(__m128 mask, __m128 a, __m128 b)
+{
+	return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+static inline __m128 lerp_ps(__m128 t, __m128 a, __m128 b)
+{
+	return _mm_add_ps(a, _mm_mul_ps(t, _mm_sub_ps(b, a)));
+}
+
+// Même ordre d'opérations que npfade de noise.c.
+static inline __m128 npfade_ps(__m128 t)
+{
+	const __m128 t3 = _mm_mul_ps(_mm_mul_ps(t, t), t);
+	const __m128 inner = _mm_add_ps(_mm_mul_ps(t, _mm_sub_ps(_mm_mul_ps(t, _mm_set1_ps(6.0f)), _mm_set1_ps(15.0f))),
+									_mm_set1_ps(10.0f));
+	return _mm_mul_ps(t3, inner);
+}
+
+// Même choix de gradient que grad de noise.c.
+static inline __m128 grad_ps(__m128i hash_val, __m128 x, __m128 y, __m128 z)
+{
+	const __m128i h = _mm_and_si128(hash_val, _mm_set1_epi32(15));
+	const __m128 hlt8 = _mm_castsi128_ps(_mm_cmplt_epi32(h, _mm_set1_epi32(8)));
+	const __m128 hlt4 = _mm_castsi128_ps(_mm_cmplt_epi32(h, _mm_set1_epi32(4)));
+	const __m128 h12or14 = _mm_castsi128_ps(_mm_or_si128(_mm_cmpeq_epi32(h, _mm_set1_epi32(12)),
+														 _mm_cmpeq_epi32(h, _mm_set1_epi32(14))));
+	const __m128 u = select_ps(hlt8, x, y);
+	const __m128 v = select_ps(hlt4, y, select_ps(h12or14, x, z));
+
+	const __m128 signmask = _mm_set1_ps(-0.0f);
+	const __m128 negu = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(h, _mm_set1_epi32(1)), _mm_set1_epi32(1)));
+	const __m128 negv = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(h, _mm_set1_epi32(2)), _mm_set1_epi32(2)));
+
+	return _mm_add_ps(_mm_xor_ps(u, _mm_and_ps(negu, signmask)), _mm_xor_ps(v, _mm_and_ps(negv, signmask)));
+}
+
+// newPerlin de noise.c pour quatre points.
+static __m128 new_perlin_ps(__m128 x, __m128 y, __m128 z)
+{
+	const __m128 fu = floor_ps(x);
+	const __m128 fv = floor_ps(y);
+	const __m128 fw = floor_ps(z);
+
+	int X[4], Y[4], Z[4];
+	_mm_storeu_si128((__m128i *)X, _mm_and_si128(_mm_cvttps_epi32(fu), _mm_set1_epi32(255)));
+	_mm_storeu_si128((__m128i *)Y, _mm_and_si128(_mm_cvttps_epi32(fv), _mm_set1_epi32(255)));
+	_mm_storeu_si128((__m128i *)Z, _mm_and_si128(_mm_cvttps_epi32(fw), _mm_set1_epi32(255)));
+
+	x = _mm_sub_ps(x, fu);
+	y = _mm_sub_ps(y, fv);
+	z = _mm_sub_ps(z, fw);
+
+	const __m128 u = npfade_ps(x);
+	const __m128 v = npfade_ps(y);
+	const __m128 w = npfade_ps(z);
+
+	// Les tables ne peuvent pas être lues en SSE2, on calcule les hachages par point.
+	int hAA[4], hBA[4], hAB[4], hBB[4], hAA1[4], hBA1[4], hAB1[4], hBB1[4];
+	for (unsigned short i = 0; i < 4; ++i) {
+		const int A = hash[X[i]] + Y[i];
+		const int AA = hash[A] + Z[i];
+		const int AB = hash[A + 1] + Z[i];
+		const int B = hash[X[i] + 1] + Y[i];
+		const int BA = hash[B] + Z[i];
+		const int BB = hash[B + 1] + Z[i];
+		hAA[i] = hash[AA];
+		hBA[i] = hash[BA];
+		hAB[i] = hash[AB];
+		hBB[i] = hash[BB];
+		hAA1[i] = hash[AA + 1];
+		hBA1[i] = hash[BA + 1];
+		hAB1[i] = hash[AB + 1];
+		hBB1[i] = hash[BB + 1];
+	}
+
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 x1 = _mm_sub_ps(x, one);
+	const __m128 y1 = _mm_sub_ps(y, one);
+	const __m128 z1 = _mm_sub_ps(z, one);
+
+	return lerp_ps(w, lerp_ps(v, lerp_ps(u, grad_ps(_mm_loadu_si128((__m128i *)hAA), x, y, z),
+											 grad_ps(_mm_loadu_si128((__m128i *)hBA), x1, y, z)),
+								 lerp_ps(u, grad_ps(_mm_loadu_si128((__m128i *)hAB), x, y1, z),
+											 grad_ps(_mm_loadu_si128((__m128i *)hBB), x1, y1, z))),
+					  lerp_ps(v, lerp_ps(u, grad_ps(_mm_loadu_si128((__m128i *)hAA1), x, y, z1),
+											 grad_ps(_mm_loadu_si128((__m128i *)hBA1), x1, y, z1)),
+								 lerp_ps(u, grad_ps(_mm_loadu_si128((__m128i *)hAB1), x, y1, z1),
+											 grad_ps(_mm_loadu_si128((__m128i *)hBB1), x1, y1, z1))));
+}
+
+// mg_fBm de noise.c pour quatre points.
+static __m128 fbm_ps(__m128 x, __m128 y, float H, float lacunarity, float octaves)
+{
+	const float pwHL = powf(lacunarity, -H);
+	const __m128 lac = _mm_set1_ps(lacunarity);
+	__m128 z = _mm_setzero_ps();
+	__m128 value = _mm_setzero_ps();
+	float pwr = 1.0f;
+
+	for (int i = 0; i < (int)octaves; i++) {
+		value = _mm_add_ps(value, _mm_mul_ps(new_perlin_ps(x, y, z), _mm_set1_ps(pwr)));
+		pwr *= pwHL;
+		x = _mm_mul_ps(x, lac);
+		y = _mm_mul_ps(y, lac);
+		z = _mm_mul_ps(z, lac);
+	}
+
+	const float rmd = octaves - floorf(octaves);
+	if (rmd != 0.0f) {
+		value = _mm_add_ps(value, _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(rmd), new_perlin_ps(x, y, z)), _mm_set1_ps(pwr)));
+	}
+
+	return value;
+}
+
+// mg_MultiFractal de noise.c pour quatre points.
+static __m128 multi_fractal_ps(__m128 x, __m128 y, float H, float lacunarity, float octaves)
+{
+	const float pwHL = powf(lacunarity, -H);
+	const __m128 lac = _mm_set1_ps(lacunarity);
+	const __m128 one = _mm_set1_ps(1.0f);
+	__m128 z = _mm_setzero_ps();
+	__m128 value = one;
+	float pwr = 1.0f;
+
+	for (int i = 0; i < (int)octaves; i++) {
+		value = _mm_mul_ps(value, _mm_add_ps(_mm_mul_ps(_mm_set1_ps(pwr), new_perlin_ps(x, y, z)), one));
+		pwr *= pwHL;
+		x = _mm_mul_ps(x, lac);
+		y = _mm_mul_ps(y, lac);
+		z = _mm_mul_ps(z, lac);
+	}
+
+	const float rmd = octaves - floorf(octaves);
+	if (rmd != 0.0f) {
+		value = _mm_mul_ps(value, _mm_add_ps(_mm_mul_ps(_mm_mul_ps(_mm_set1_ps(rmd), new_perlin_ps(x, y, z)),
+														_mm_set1_ps(pwr)), one));
+	}
+
+	return value;
+}
+#endif  // __SSE2__
+
+static float noise_scalar(int musgravetype, int noisebasis, float H, float lacunarity, float octaves,
+						  float offset, float gain, float x, float y)
+{
+	switch (musgravetype) {
+		case TEX_MFRACTAL:
+			return mg_MultiFractal(x, y, 0.0f, H, lacunarity, octaves, noisebasis);
+		case TEX_RIDGEDMF:
+			return mg_RidgedMultiFractal(x, y, 0.0f, H, lacunarity, octaves, offset, gain, noisebasis);
+		case TEX_HYBRIDMF:
+			return mg_HybridMultiFractal(x, y, 0.0f, H, lacunarity, octaves, offset, gain, noisebasis);
+		case TEX_FBM:
+			return mg_fBm(x, y, 0.0f, H, lacunarity, octaves, noisebasis);
+		case TEX_HTERRAIN:
+			return mg_HeteroTerrain(x, y, 0.0f, H, lacunarity, octaves, offset, noisebasis);
+	}
+	return 0.0f;
+}
+
+void KX_TerrainNoiseBatch(int musgravetype, int noisebasis, float H, float lacunarity, float octaves,
+						  float offset, float gain, unsigned int count, const float *x, const float *y,
+						  float *r_values)
+{
+	unsigned int i = 0;
+
+#ifdef __SSE2__
+	if (noisebasis == NOISE_BASIS_NEW_PERLIN) {
+		if (musgravetype == TEX_FBM) {
+			for (; i + 4 <= count; i += 4) {
+				_mm_storeu_ps(r_values + i, fbm_ps(_mm_loadu_ps(x + i), _mm_loadu_ps(y + i), H, lacunarity, octaves));
+			}
+		}
+		else if (musgravetype == TEX_MFRACTAL) {
+			for (; i + 4 <= count; i += 4) {
+				_mm_storeu_ps(r_values + i, multi_fractal_ps(_mm_loadu_ps(x + i), _mm_loadu_ps(y + i), H, lacunarity, octaves));
+			}
+		}
+	}
+#endif
+
+	// Les points restants et les bruits non vectorisés.
+	for (; i < count; ++i) {
+		r_values[i] = noise_scalar(musgravetype, noisebasis, H, lacunarity, octaves, offset, gain, x[i], y[i]);
+	}
+}
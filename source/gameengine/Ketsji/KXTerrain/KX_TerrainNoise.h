@@ -0,0 +1,40 @@
+ /*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Contributor(s): none yet.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+#ifndef __KX_TERRAIN_NOISE_H__
+#define __KX_TERRAIN_NOISE_H__
+
+/** Calcule un bruit fractal de Musgrave pour un lot de points à la hauteur z = 0.
+ * Les paramètres sont les mêmes que ceux des fonctions mg_* de BLI_noise.
+ * Le fBm et le multifractal sur la base "Improved Perlin" sont calculés par
+ * quatre points avec SSE2, le résultat est identique au bit près aux fonctions
+ * scalaires utilisées pour tous les autres cas et les points restants.
+ * \param count Le nombre de points.
+ * \param x Les positions en x déjà mises à l'échelle de la résolution.
+ * \param y Les positions en y déjà mises à l'échelle de la résolution.
+ * \param r_values Les valeurs du bruit pour chaque point.
+ */
+void KX_TerrainNoiseBatch(int musgravetype, int noisebasis, float H, float lacunarity, float octaves,
+						  float offset, float gain, unsigned int count, const float *x, const float *y,
+						  float *r_values);
+
+#endif  // __KX_TERRAIN_NOISE_H__
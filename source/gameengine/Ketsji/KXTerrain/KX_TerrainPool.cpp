@@ -0,0 +1,94 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Contributor(s): none yet.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file gameengine/Ketsji/KXTerrain/KX_TerrainPool.cpp
+ *  \ingroup ketsji
+ */
+#include "KX_TerrainPool.h"
+
+#include "BLI_mempool.h"
+
+#include <iostream>
+
+KX_TerrainPool::KX_TerrainPool(unsigned int elementSize, unsigned int chunkSize)
+	:m_elementSize(elementSize),
+	m_chunkSize(chunkSize)
+{
+	m_pool = BLI_mempool_create(m_elementSize, 0, m_chunkSize, BLI_MEMPOOL_NOP);
+	BLI_spin_init(&m_lock);
+}
+
+KX_TerrainPool::~KX_TerrainPool()
+{
+	BLI_mempool_destroy(m_pool);
+	BLI_spin_end(&m_lock);
+}
+
+void *KX_TerrainPool::Alloc()
+{
+	BLI_spin_lock(&m_lock);
+	void *element = BLI_mempool_alloc(m_pool);
+	BLI_spin_unlock(&m_lock);
+
+	return element;
+}
+
+void KX_TerrainPool::Free(void *element)
+{
+	BLI_spin_lock(&m_lock);
+	BLI_mempool_free(m_pool, element);
+	BLI_spin_unlock(&m_lock);
+}
+
+unsigned int KX_TerrainPool::GetUsedCount()
+{
+	BLI_spin_lock(&m_lock);
+	const unsigned int usedCount = BLI_mempool_count(m_pool);
+	BLI_spin_unlock(&m_lock);
+
+	return usedCount;
+}
+
+unsigned int KX_TerrainPool::GetReservedCount()
+{
+	BLI_spin_lock(&m_lock);
+	const unsigned int reservedCount = BLI_mempool_count_reserved(m_pool);
+	BLI_spin_unlock(&m_lock);
+
+	return reservedCount;
+}
+
+size_t KX_TerrainPool::GetReservedMemory()
+{
+	return (size_t)GetReservedCount() * m_elementSize;
+}
+
+void KX_TerrainPool::PrintStats(const char *name)
+{
+	const unsigned int usedCount = GetUsedCount();
+	const unsigned int reservedCount = GetReservedCount();
+	const size_t reservedMemory = GetReservedMemory();
+
+	std::cout << "\t " << name << " : \t" << usedCount << " / " << reservedCount
+		<< " (" << (reservedCount ? (float)usedCount / reservedCount * 100.0f : 0.0f) << "%, "
+		<< reservedMemory / 1024 << " KB)" << std::endl;
+}
@@ -0,0 +1,71 @@
+ /*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Contributor(s): none yet.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+#ifndef __KX_TERRAIN_POOL_H__
+#define __KX_TERRAIN_POOL_H__
+
+#include "BLI_threads.h"
+
+#include <stddef.h>
+
+struct BLI_mempool;
+
+/** Allocateur par blocs d'éléments de taille fixe utilisé par le terrain
+ * pour les VertexZoneInfo et les vertices des chunks. Les éléments libérés
+ * sont réutilisés sans repasser par le tas, ainsi la création et la
+ * suppression des chunks ne fragmente pas la mémoire.
+ * L'allocation et la libération sont protégées par un verrou car elles
+ * sont faites à la fois par le thread principal et les threads de travail.
+ */
+class KX_TerrainPool
+{
+private:
+	BLI_mempool *m_pool;
+	SpinLock m_lock;
+
+	/// La taille d'un élément en octets.
+	const unsigned int m_elementSize;
+	/// Le nombre d'éléments alloués par bloc.
+	const unsigned int m_chunkSize;
+
+public:
+	KX_TerrainPool(unsigned int elementSize, unsigned int chunkSize);
+	~KX_TerrainPool();
+
+	void *Alloc();
+	void Free(void *element);
+
+	/// Le nombre d'éléments utilisés.
+	unsigned int GetUsedCount();
+	/** Le nombre d'éléments que peuvent contenir les blocs réellement alloués,
+	 * utilisés ou non. BLI_mempool ne rend ses blocs que lorsque plus aucun
+	 * élément n'est utilisé.
+	 */
+	unsigned int GetReservedCount();
+	/// La mémoire réservée par les blocs en octets.
+	size_t GetReservedMemory();
+
+	/// Affiche l'occupation de l'allocateur.
+	void PrintStats(const char *name);
+};
+
+#endif  // __KX_TERRAIN_POOL_H__
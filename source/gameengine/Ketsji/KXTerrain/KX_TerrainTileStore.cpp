@@ -0,0 +1,389 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Contributor(s): none yet.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file gameengine/Ketsji/KXTerrain/KX_TerrainTileStore.cpp
+ *  \ingroup ketsji
+ */
+#include "KX_TerrainTileStore.h"
+#include "KX_TerrainZone.h"
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_fileops.h"
+#include "BLI_path_util.h"
+#include "BLI_string.h"
+
+#include "atomic_ops.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+/// Le nombre de vertices sur le coté d'une tuile.
+#define TILE_SIZE 64
+#define TILE_VERTEX_COUNT (TILE_SIZE * TILE_SIZE)
+/// La hauteur et les cannaux d'UVs 1 à 7, le premier cannal est la position du vertice.
+#define TILE_VALUE_COUNT 15
+/// Le niveau d'échantillonnage maximal, celui des vertices en (0, 0).
+#define TILE_MAX_LEVEL 16
+/// A incrémenter à chaque modification du format des tuiles.
+#define TILE_VERSION 2
+/// La mémoire d'une tuile chargée : les valeurs et les indicateurs de validité.
+#define TILE_MEMORY (TILE_VERTEX_COUNT * (TILE_VALUE_COUNT * sizeof(float) + 1))
+
+struct TileHeader
+{
+	char magic[4];
+	unsigned int version;
+	unsigned int key;
+	unsigned int size;
+};
+
+unsigned int KX_TerrainTileStore::tileHits = 0;
+unsigned int KX_TerrainTileStore::tileMisses = 0;
+unsigned int KX_TerrainTileStore::tileLoads = 0;
+
+void KX_TerrainTileStore::ResetTime()
+{
+	tileHits = 0;
+	tileMisses = 0;
+	tileLoads = 0;
+}
+
+void KX_TerrainTileStore::PrintTime()
+{
+	std::cout << "Tile Store Stats : " << std::endl
+		<< "\t tile hits : \t" << tileHits << std::endl
+		<< "\t tile misses : \t" << tileMisses << std::endl
+		<< "\t tile loads : \t" << tileLoads << std::endl;
+}
+
+/// La position d'une tuile, arrondie vers le bas pour les positions négatives.
+static int tile_coord(int pos)
+{
+	return (pos >= 0) ? (pos / TILE_SIZE) : ((pos + 1) / TILE_SIZE - 1);
+}
+
+/** Le niveau d'échantillonnage d'un vertice : le nombre de bits de poids faible nuls
+ * à la fois en x et en y. Les chunks grossiers n'échantillonnent que des vertices de
+ * niveaux élevés, ranger chaque niveau dans ses propres tuiles garde ces tuiles denses.
+ */
+static int tile_level(int x, int y)
+{
+	const int bits = x | y;
+	int level = 0;
+	while (level < TILE_MAX_LEVEL && ((bits >> level) & 1) == 0) {
+		++level;
+	}
+	return level;
+}
+
+bool KX_TerrainTileStore::TileKey::operator<(const TileKey& other) const
+{
+	if (level != other.level) {
+		return level < other.level;
+	}
+	if (x != other.x) {
+		return x < other.x;
+	}
+	return y < other.y;
+}
+
+KX_TerrainTileStore::KX_TerrainTileStore(const std::string& directory, unsigned int key)
+	:m_key(key),
+	m_useCount(0)
+{
+	char keyname[16];
+	BLI_snprintf(keyname, sizeof(keyname), "%08x", key);
+
+	char path[FILE_MAX];
+	BLI_join_dirfile(path, sizeof(path), directory.c_str(), keyname);
+	BLI_add_slash(path);
+	m_directory = path;
+
+	BLI_mutex_init(&m_lock);
+}
+
+KX_TerrainTileStore::~KX_TerrainTileStore()
+{
+	Flush();
+
+	for (TileMap::iterator it = m_tiles.begin(); it != m_tiles.end(); ++it) {
+		FreeTile(it->second);
+	}
+
+	BLI_mutex_end(&m_lock);
+}
+
+void KX_TerrainTileStore::FreeTile(Tile *tile)
+{
+	MEM_freeN(tile->values);
+	MEM_freeN(tile->valid);
+	delete tile;
+}
+
+std::string KX_TerrainTileStore::GetTilePath(const TileKey& key) const
+{
+	char filename[64];
+	BLI_snprintf(filename, sizeof(filename), "tile_%d_%d_%d.bin", key.level, key.x, key.y);
+	return m_directory + filename;
+}
+
+KX_TerrainTileStore::Tile *KX_TerrainTileStore::LoadTile(const TileKey& key)
+{
+	Tile *tile = new Tile();
+	tile->values = (float *)MEM_mallocN(sizeof(float) * TILE_VERTEX_COUNT * TILE_VALUE_COUNT, "KX_TerrainTileStore values");
+	tile->valid = (unsigned char *)MEM_callocN(TILE_VERTEX_COUNT, "KX_TerrainTileStore valid");
+	tile->modified = false;
+	tile->lastUsed = 0;
+
+	const std::string path = GetTilePath(key);
+	FILE *file = BLI_fopen(path.c_str(), "rb");
+	if (!file) {
+		return tile;
+	}
+
+	TileHeader header;
+	bool success = (fread(&header, sizeof(TileHeader), 1, file) == 1 &&
+					memcmp(header.magic, "BGTT", 4) == 0 &&
+					header.version == TILE_VERSION &&
+					header.key == m_key &&
+					header.size == TILE_SIZE &&
+					fread(tile->valid, 1, TILE_VERTEX_COUNT, file) == TILE_VERTEX_COUNT &&
+					fread(tile->values, sizeof(float), TILE_VERTEX_COUNT * TILE_VALUE_COUNT, file) ==
+					TILE_VERTEX_COUNT * TILE_VALUE_COUNT);
+	fclose(file);
+
+	if (success) {
+		atomic_add_uint32(&tileLoads, 1);
+	}
+	else {
+		// Une tuile invalide est ignorée, elle sera recalculée puis réécrite.
+		std::cout << "Warning: invalid terrain tile " << path << std::endl;
+		memset(tile->valid, 0, TILE_VERTEX_COUNT);
+		tile->modified = true;
+	}
+
+	return tile;
+}
+
+bool KX_TerrainTileStore::SaveTile(const TileKey& key, Tile *tile)
+{
+	const std::string path = GetTilePath(key);
+	// Ecrit dans un fichier temporaire pour ne jamais laisser une tuile à moitié écrite.
+	const std::string temppath = path + "@";
+
+	FILE *file = BLI_fopen(temppath.c_str(), "wb");
+	if (!file) {
+		return false;
+	}
+
+	TileHeader header;
+	memcpy(header.magic, "BGTT", 4);
+	header.version = TILE_VERSION;
+	header.key = m_key;
+	header.size = TILE_SIZE;
+
+	bool success = (fwrite(&header, sizeof(TileHeader), 1, file) == 1 &&
+					fwrite(tile->valid, 1, TILE_VERTEX_COUNT, file) == TILE_VERTEX_COUNT &&
+					fwrite(tile->values, sizeof(float), TILE_VERTEX_COUNT * TILE_VALUE_COUNT, file) ==
+					TILE_VERTEX_COUNT * TILE_VALUE_COUNT);
+	success = (fclose(file) == 0) && success;
+
+	if (success) {
+		// BLI_rename remplace l'ancienne tuile.
+		success = (BLI_rename(temppath.c_str(), path.c_str()) == 0);
+	}
+	else {
+		BLI_delete(temppath.c_str(), false, false);
+	}
+
+	return success;
+}
+
+KX_TerrainTileStore::Tile *KX_TerrainTileStore::GetTile(int x, int y, unsigned int *r_index)
+{
+	// Les positions dans la grille du niveau du vertice, les bits retirés sont nuls.
+	TileKey key;
+	key.level = tile_level(x, y);
+	x >>= key.level;
+	y >>= key.level;
+	key.x = tile_coord(x);
+	key.y = tile_coord(y);
+	*r_index = (x - key.x * TILE_SIZE) * TILE_SIZE + (y - key.y * TILE_SIZE);
+
+	TileMap::iterator it = m_tiles.find(key);
+	if (it != m_tiles.end()) {
+		it->second->lastUsed = ++m_useCount;
+		return it->second;
+	}
+
+	// Les autres threads peuvent utiliser les tuiles chargées pendant la lecture du fichier.
+	BLI_mutex_unlock(&m_lock);
+	Tile *tile = LoadTile(key);
+	BLI_mutex_lock(&m_lock);
+
+	// Un autre thread a pu charger ou créer la même tuile entre temps, on garde la sienne.
+	std::pair<TileMap::iterator, bool> result = m_tiles.insert(TileMap::value_type(key, tile));
+	if (!result.second) {
+		FreeTile(tile);
+		tile = result.first->second;
+	}
+
+	tile->lastUsed = ++m_useCount;
+	return tile;
+}
+
+unsigned int KX_TerrainTileStore::ReadVertexInfos(unsigned int count, const int *x, const int *y,
+												  VertexZoneInfo **r_infos, unsigned char *r_found)
+{
+	unsigned int foundCount = 0;
+
+	BLI_mutex_lock(&m_lock);
+	for (unsigned int i = 0; i < count; ++i) {
+		unsigned int index;
+		Tile *tile = GetTile(x[i], y[i], &index);
+
+		r_found[i] = tile->valid[index];
+		if (!r_found[i]) {
+			continue;
+		}
+
+		VertexZoneInfo *info = r_infos[i];
+		const float *values = &tile->values[index * TILE_VALUE_COUNT];
+		info->height = values[0];
+		for (unsigned short j = 1; j < 8; ++j) {
+			info->m_uvs[j].x() = values[j * 2 - 1];
+			info->m_uvs[j].y() = values[j * 2];
+		}
+		++foundCount;
+	}
+
+	tileHits += foundCount;
+	tileMisses += count - foundCount;
+	BLI_mutex_unlock(&m_lock);
+
+	return foundCount;
+}
+
+void KX_TerrainTileStore::WriteVertexInfos(unsigned int count, const int *x, const int *y, VertexZoneInfo **infos)
+{
+	BLI_mutex_lock(&m_lock);
+	for (unsigned int i = 0; i < count; ++i) {
+		unsigned int index;
+		Tile *tile = GetTile(x[i], y[i], &index);
+
+		const VertexZoneInfo *info = infos[i];
+		float *values = &tile->values[index * TILE_VALUE_COUNT];
+		values[0] = info->height;
+		for (unsigned short j = 1; j < 8; ++j) {
+			values[j * 2 - 1] = info->m_uvs[j].x();
+			values[j * 2] = info->m_uvs[j].y();
+		}
+
+		tile->valid[index] = 1;
+		tile->modified = true;
+	}
+	BLI_mutex_unlock(&m_lock);
+}
+
+bool KX_TerrainTileStore::FlushTile(const TileKey& key, Tile *tile)
+{
+	if (!BLI_is_dir(m_directory.c_str()) && !BLI_dir_create_recursive(m_directory.c_str())) {
+		std::cout << "Error: can't create terrain tile directory " << m_directory << std::endl;
+		return false;
+	}
+
+	if (!SaveTile(key, tile)) {
+		std::cout << "Error: can't write terrain tile " << GetTilePath(key) << std::endl;
+		return false;
+	}
+
+	tile->modified = false;
+	return true;
+}
+
+void KX_TerrainTileStore::Flush()
+{
+	BLI_mutex_lock(&m_lock);
+
+	for (TileMap::iterator it = m_tiles.begin(); it != m_tiles.end(); ++it) {
+		Tile *tile = it->second;
+		if (tile->modified && !FlushTile(it->first, tile)) {
+			break;
+		}
+	}
+
+	BLI_mutex_unlock(&m_lock);
+}
+
+/// Trie les tuiles de la moins récemment utilisée à la plus récente.
+static bool tile_used_less(const std::pair<unsigned int, KX_TerrainTileStore::TileKey>& tile1,
+						   const std::pair<unsigned int, KX_TerrainTileStore::TileKey>& tile2)
+{
+	return tile1.first < tile2.first;
+}
+
+size_t KX_TerrainTileStore::ReleaseTiles(size_t maxMemory)
+{
+	BLI_mutex_lock(&m_lock);
+
+	size_t usage = m_tiles.size() * TILE_MEMORY;
+	size_t freed = 0;
+	if (usage > maxMemory) {
+		std::vector<std::pair<unsigned int, TileKey> > candidates;
+		for (TileMap::iterator it = m_tiles.begin(); it != m_tiles.end(); ++it) {
+			candidates.push_back(std::make_pair(it->second->lastUsed, it->first));
+		}
+
+		std::sort(candidates.begin(), candidates.end(), tile_used_less);
+
+		for (unsigned int i = 0; i < candidates.size() && usage > maxMemory; ++i) {
+			TileMap::iterator it = m_tiles.find(candidates[i].second);
+			/* Les tuiles modifiées sont écrites avant d'être libérées. Si l'écriture
+			 * échoue la tuile est libérée quand même, ses vertices seront recalculés.
+			 */
+			if (it->second->modified) {
+				FlushTile(it->first, it->second);
+			}
+			FreeTile(it->second);
+			m_tiles.erase(it);
+			usage -= TILE_MEMORY;
+			freed += TILE_MEMORY;
+		}
+	}
+
+	BLI_mutex_unlock(&m_lock);
+
+	return freed;
+}
+
+size_t KX_TerrainTileStore::GetMemoryUsage()
+{
+	BLI_mutex_lock(&m_lock);
+	const size_t usage = m_tiles.size() * TILE_MEMORY;
+	BLI_mutex_unlock(&m_lock);
+
+	return usage;
+}
@@ -0,0 +1,147 @@
+ /*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Contributor(s): none yet.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+#ifndef __KX_TERRAIN_TILE_STORE_H__
+#define __KX_TERRAIN_TILE_STORE_H__
+
+#include "BLI_threads.h"
+
+#include <map>
+#include <string>
+
+class VertexZoneInfo;
+
+/** Stockage sur disque des informations des vertices calculées par les zones,
+ * pour ne pas les recalculer à chaque lancement du jeu.
+ * Les vertices sont groupés en tuiles carrées de TILE_SIZE vertices de coté,
+ * chaque tuile est un fichier dans un dossier nommé par la clé du terrain.
+ * Chaque vertice appartient à un niveau d'échantillonnage, le nombre de bits
+ * nuls de ses positions, et les tuiles d'un niveau ne contiennent qu'un vertice
+ * sur 2^niveau sur chaque axe.
+ * La clé est un hachage de tous les paramètres du terrain et des zones, une
+ * modification de ces paramètres utilise donc un nouveau dossier.
+ * Les tuiles sont chargées entièrement en mémoire à leur première utilisation
+ * et écrites dans Flush si elles contiennent de nouveaux vertices. Les tuiles
+ * les moins récemment utilisées sont écrites si besoin puis libérées par ReleaseTiles.
+ */
+class KX_TerrainTileStore
+{
+public:
+	/// Variables utilisées pour faire des statistiques.
+
+	/// Le nombre de vertices lus depuis les tuiles.
+	static unsigned int tileHits;
+	/// Le nombre de vertices absents des tuiles.
+	static unsigned int tileMisses;
+	/// Le nombre de tuiles lues depuis le disque.
+	static unsigned int tileLoads;
+
+	static void ResetTime();
+	static void PrintTime();
+
+	struct TileKey
+	{
+		/// Le niveau d'échantillonnage des vertices de la tuile.
+		int level;
+		/// La position de la tuile dans la grille de son niveau.
+		int x;
+		int y;
+
+		bool operator<(const TileKey& other) const;
+	};
+
+private:
+	struct Tile
+	{
+		/// La hauteur puis les cannaux d'UVs 1 à 7 de chaque vertice.
+		float *values;
+		/// Vrai pour chaque vertice déjà calculé.
+		unsigned char *valid;
+		/// Vrai si la tuile contient des vertices non écrits sur le disque.
+		bool modified;
+		/// La valeur de m_useCount à la dernière utilisation de la tuile.
+		unsigned int lastUsed;
+	};
+
+	typedef std::map<TileKey, Tile *> TileMap;
+
+	/// Le dossier contenant les tuiles du terrain.
+	std::string m_directory;
+	/// Le hachage des paramètres du terrain.
+	const unsigned int m_key;
+
+	TileMap m_tiles;
+	/// Incrémenté à chaque utilisation d'une tuile, pour libérer les moins récentes.
+	unsigned int m_useCount;
+	/** Protège m_tiles et le contenu des tuiles, un mutex car les tuiles sont
+	 * écrites sur le disque sous ce verrou dans Flush et ReleaseTiles.
+	 */
+	ThreadMutex m_lock;
+
+	/** La tuile contenant un vertice, chargée ou créée si besoin. Appelée sous le
+	 * verrou, qui est relaché pendant la lecture d'une tuile depuis le disque.
+	 */
+	Tile *GetTile(int x, int y, unsigned int *r_index);
+	/// Lit une tuile depuis le disque, sans le verrou.
+	Tile *LoadTile(const TileKey& key);
+	static void FreeTile(Tile *tile);
+	bool SaveTile(const TileKey& key, Tile *tile);
+	/// Ecrit une tuile modifiée en créant le dossier si besoin, sous le verrou.
+	bool FlushTile(const TileKey& key, Tile *tile);
+	std::string GetTilePath(const TileKey& key) const;
+
+public:
+	KX_TerrainTileStore(const std::string& directory, unsigned int key);
+	~KX_TerrainTileStore();
+
+	/** Lit les informations de plusieurs vertices.
+	 * \param count Le nombre de vertices.
+	 * \param x Les positions en x relatives au terrain.
+	 * \param y Les positions en y relatives au terrain.
+	 * \param r_infos Les informations des vertices, remplies seulement pour les vertices trouvés.
+	 * \param r_found 1 pour chaque vertice trouvé, 0 sinon.
+	 * \return Le nombre de vertices trouvés.
+	 */
+	unsigned int ReadVertexInfos(unsigned int count, const int *x, const int *y,
+								 VertexZoneInfo **r_infos, unsigned char *r_found);
+	/// Ajoute les informations de vertices calculées par les zones.
+	void WriteVertexInfos(unsigned int count, const int *x, const int *y, VertexZoneInfo **infos);
+
+	/// Ecrit toutes les tuiles modifiées sur le disque.
+	void Flush();
+
+	/** Libère les tuiles les moins récemment utilisées jusqu'à ce que les tuiles
+	 * chargées n'utilisent pas plus de maxMemory octets. Les tuiles modifiées
+	 * sont écrites sur le disque avant d'être libérées.
+	 * \return La mémoire libérée en octets.
+	 */
+	size_t ReleaseTiles(size_t maxMemory);
+	/// La mémoire utilisée par les tuiles chargées en octets.
+	size_t GetMemoryUsage();
+
+	inline const std::string& GetDirectory() const
+	{
+		return m_directory;
+	}
+};
+
+#endif  // __KX_TERRAIN_TILE_STORE_H__
@@ -23,6 +23,11 @@
 
 #include "KX_TerrainZone.h"
 #include "KX_Terrain.h"
+#include "KX_TerrainPool.h"
+#include "KX_TerrainNoise.h"
+#include "KX_GameObject.h"
+
+#include "EXP_ListValue.h"
 
 #include "DNA_mesh_types.h"
 #include "DNA_terrain_types.h"
@@ -39,18 +44,217 @@
 extern "C" {
 	#include "IMB_imbuf.h"
 	#include "BLI_math.h"
+	#include "BLI_hash_mm2a.h"
 }
 
+#include "atomic_ops.h"
+
+#include <algorithm>
+#include <iterator>
 #include <iostream>
+#include <vector>
+
+/// La résolution maximale de la grille des faces sur chaque axe.
+#define GRID_MAX_RESOLUTION 256
+
+void VertexZoneInfo::AddRef()
+{
+	atomic_add_uint32(&refcount, 1);
+}
+
+void VertexZoneInfo::Release()
+{
+	if (atomic_sub_uint32(&refcount, 1) == 0) {
+		KX_TerrainPool *pool = m_pool;
+		this->~VertexZoneInfo();
+		pool->Free(this);
+	}
+}
+
+bool KX_TerrainObjectIndex::Footprint::operator<(const Footprint& other) const
+{
+	for (unsigned short i = 0; i < 3; ++i) {
+		if (pos[i] != other.pos[i]) {
+			return pos[i] < other.pos[i];
+		}
+	}
+	for (unsigned short i = 0; i < 2; ++i) {
+		if (radius[i] != other.radius[i]) {
+			return radius[i] < other.radius[i];
+		}
+	}
+	return false;
+}
+
+bool KX_TerrainObjectIndex::Footprint::operator==(const Footprint& other) const
+{
+	return (pos[0] == other.pos[0] && pos[1] == other.pos[1] && pos[2] == other.pos[2] &&
+			radius[0] == other.radius[0] && radius[1] == other.radius[1]);
+}
+
+/** L'influence d'un objet sur un point entre 0 et 1, maximale au centre de l'objet et
+ * nulle au bord de l'ellipse de son empreinte.
+ */
+static float footprint_influence(const KX_TerrainObjectIndex::Footprint& footprint, const float x, const float y)
+{
+	const float point[2] = {(float)fabs(x - footprint.pos[0]), (float)fabs(y - footprint.pos[1])};
+	const float *radius = footprint.radius;
+
+	if (point[0] >= radius[0] || point[1] >= radius[1]) {
+		return 0.0f;
+	}
+
+	const float pointlength = len_v2(point);
+	static const float xaxis[2] = {1.0f, 0.0f};
+	const float unscaledpoint[2] = {point[0] / radius[0], point[1] / radius[1]};
+	const float angle = angle_v2v2(xaxis, unscaledpoint);
+	const float max[2] = {cosf(angle) * radius[0], sinf(angle) * radius[1]};
+	const float maxlength = len_v2(max);
+
+	float influence = (maxlength - pointlength) / maxlength;
+	CLAMP(influence, 0.0f, 1.0f);
+
+	return influence;
+}
+
+KX_TerrainObjectIndex::KX_TerrainObjectIndex(const std::vector<Footprint>& footprints)
+	:m_footprints(footprints),
+	m_refCount(1)
+{
+	const unsigned int count = m_footprints.size();
+
+	m_box[0] = m_box[1] = m_box[2] = m_box[3] = 0.0f;
+	for (unsigned int i = 0; i < count; ++i) {
+		const Footprint& footprint = m_footprints[i];
+		const float box[4] = {footprint.pos[0] - footprint.radius[0], footprint.pos[0] + footprint.radius[0],
+							  footprint.pos[1] - footprint.radius[1], footprint.pos[1] + footprint.radius[1]};
+		if (i == 0) {
+			copy_v4_v4(m_box, box);
+			continue;
+		}
+
+		m_box[0] = min_ff(m_box[0], box[0]);
+		m_box[1] = max_ff(m_box[1], box[1]);
+		m_box[2] = min_ff(m_box[2], box[2]);
+		m_box[3] = max_ff(m_box[3], box[3]);
+	}
+
+	// Environ une empreinte par cellule, comme la grille des faces du mesh.
+	const unsigned short resolution = max_ii(1, min_ii((int)sqrtf((float)count), GRID_MAX_RESOLUTION));
+	const float size[2] = {m_box[1] - m_box[0], m_box[3] - m_box[2]};
+
+	for (unsigned short axis = 0; axis < 2; ++axis) {
+		m_gridResolution[axis] = resolution;
+		m_gridInvCellSize[axis] = (size[axis] > 0.0f) ? (resolution / size[axis]) : 0.0f;
+	}
+
+	const unsigned int cellcount = m_gridResolution[0] * m_gridResolution[1];
+	// Les cellules couvertes par chaque empreinte : xmin, xmax, ymin, ymax.
+	std::vector<unsigned short> footprintCells(count * 4);
+	std::vector<unsigned int> cellCounts(cellcount, 0);
+
+	for (unsigned int i = 0; i < count; ++i) {
+		const Footprint& footprint = m_footprints[i];
+		unsigned short *cells = &footprintCells[i * 4];
+
+		for (unsigned short axis = 0; axis < 2; ++axis) {
+			cells[axis * 2] = GetGridCell(footprint.pos[axis] - footprint.radius[axis], axis);
+			cells[axis * 2 + 1] = GetGridCell(footprint.pos[axis] + footprint.radius[axis], axis);
+		}
+
+		for (unsigned short x = cells[0]; x <= cells[1]; ++x) {
+			for (unsigned short y = cells[2]; y <= cells[3]; ++y) {
+				++cellCounts[x * m_gridResolution[1] + y];
+			}
+		}
+	}
+
+	m_gridCellStart.resize(cellcount + 1);
+	m_gridCellStart[0] = 0;
+	for (unsigned int i = 0; i < cellcount; ++i) {
+		m_gridCellStart[i + 1] = m_gridCellStart[i] + cellCounts[i];
+		cellCounts[i] = m_gridCellStart[i];
+	}
+
+	m_gridFootprints.resize(m_gridCellStart[cellcount]);
+	for (unsigned int i = 0; i < count; ++i) {
+		const unsigned short *cells = &footprintCells[i * 4];
+		for (unsigned short x = cells[0]; x <= cells[1]; ++x) {
+			for (unsigned short y = cells[2]; y <= cells[3]; ++y) {
+				m_gridFootprints[cellCounts[x * m_gridResolution[1] + y]++] = i;
+			}
+		}
+	}
+}
+
+void KX_TerrainObjectIndex::AddRef()
+{
+	atomic_add_uint32(&m_refCount, 1);
+}
+
+void KX_TerrainObjectIndex::Release()
+{
+	if (atomic_sub_uint32(&m_refCount, 1) == 0) {
+		delete this;
+	}
+}
+
+unsigned short KX_TerrainObjectIndex::GetGridCell(const float pos, const unsigned short axis) const
+{
+	const int cell = (int)((pos - m_box[axis * 2]) * m_gridInvCellSize[axis]);
+	return min_ii(max_ii(cell, 0), m_gridResolution[axis] - 1);
+}
+
+float KX_TerrainObjectIndex::GetInfluence(const float x, const float y, float *r_height) const
+{
+	if (m_footprints.empty() || x < m_box[0] || x > m_box[1] || y < m_box[2] || y > m_box[3]) {
+		return 0.0f;
+	}
+
+	float influence = 0.0f;
+
+	// Seules les empreintes de la cellule du point peuvent le toucher.
+	const unsigned int cell = GetGridCell(x, 0) * m_gridResolution[1] + GetGridCell(y, 1);
+	for (unsigned int j = m_gridCellStart[cell], end = m_gridCellStart[cell + 1]; j < end; ++j) {
+		const Footprint& footprint = m_footprints[m_gridFootprints[j]];
+		const float objinfluence = footprint_influence(footprint, x, y);
+		if (objinfluence > influence) {
+			influence = objinfluence;
+			*r_height = footprint.pos[2];
+		}
+	}
+
+	return influence;
+}
 
 KX_TerrainZoneMesh::KX_TerrainZoneMesh(KX_Terrain *terrain, TerrainZone *zoneInfo, Mesh *mesh)
 	:m_terrain(terrain),
-	m_zoneInfo(zoneInfo)
+	m_zoneInfo(zoneInfo),
+	m_objectIndex(NULL)
 {
+	DerivedMesh *dm = NULL;
 	if (mesh) {
-		m_derivedMesh = CDDM_from_mesh(mesh);
-		DM_ensure_tessface(m_derivedMesh);
+		dm = CDDM_from_mesh(mesh);
+		DM_ensure_tessface(dm);
+	}
+
+	Construct(dm);
+}
+
+KX_TerrainZoneMesh::KX_TerrainZoneMesh(KX_Terrain *terrain, TerrainZone *zoneInfo, DerivedMesh *dm)
+	:m_terrain(terrain),
+	m_zoneInfo(zoneInfo),
+	m_objectIndex(NULL)
+{
+	Construct(dm);
+}
 
+void KX_TerrainZoneMesh::Construct(DerivedMesh *dm)
+{
+	BLI_spin_init(&m_objectIndexLock);
+
+	m_derivedMesh = dm;
+	if (m_derivedMesh) {
 		const unsigned int totvert = m_derivedMesh->getNumVerts(m_derivedMesh);
 		MVert *mvert = m_derivedMesh->getVertArray(m_derivedMesh);
 		for (unsigned int i = 0; i < totvert; ++i) {
@@ -69,9 +273,9 @@ KX_TerrainZoneMesh::KX_TerrainZoneMesh(KX_Terrain *terrain, TerrainZone *zoneInf
 			m_box[2] = min_ff(m_box[2], vert.co[1]);
 			m_box[3] = max_ff(m_box[3], vert.co[1]);
 		}
+
+		ConstructFaceGrid();
 	}
-	else
-		m_derivedMesh = NULL;
 
 	m_buf = m_zoneInfo->image ? BKE_image_acquire_ibuf(m_zoneInfo->image, NULL, NULL) : NULL;
 	if (m_buf) {
@@ -93,14 +297,123 @@ KX_TerrainZoneMesh::~KX_TerrainZoneMesh()
 		m_derivedMesh->release(m_derivedMesh);
 	if (m_buf)
 		BKE_image_release_ibuf(m_zoneInfo->image, m_buf, NULL);
+	if (m_objectIndex)
+		m_objectIndex->Release();
+
+	BLI_spin_end(&m_objectIndexLock);
+}
+
+KX_TerrainObjectIndex *KX_TerrainZoneMesh::AcquireObjectIndex() const
+{
+	BLI_spin_lock(&m_objectIndexLock);
+	KX_TerrainObjectIndex *index = m_objectIndex;
+	if (index) {
+		index->AddRef();
+	}
+	BLI_spin_unlock(&m_objectIndexLock);
+
+	return index;
+}
+
+bool KX_TerrainZoneMesh::GetUseObjects() const
+{
+	return (m_zoneInfo->flag & TERRAIN_ZONE_ACTIVE && m_zoneInfo->flag & TERRAIN_ZONE_USE_OBJECT && m_zoneInfo->groupobject);
+}
+
+void KX_TerrainZoneMesh::UpdateObjects(CListValue *objects)
+{
+	if (!GetUseObjects()) {
+		return;
+	}
+
+	/* Les objets blender du groupe sont cherchés une seule fois, les objets
+	 * ajoutés pendant le jeu utilisent le même objet blender que leur original.
+	 */
+	if (m_groupObjects.empty()) {
+		for (GroupObject *groupobj = (GroupObject *)m_zoneInfo->groupobject->gobject.first; groupobj; groupobj = groupobj->next) {
+			m_groupObjects.push_back(groupobj->ob);
+		}
+		std::sort(m_groupObjects.begin(), m_groupObjects.end());
+	}
+
+	const float influence = m_zoneInfo->objectinfluence;
+	/* Les positions et tailles sont arrondies à un quart de l'intervalle des plus petits
+	 * chunks, un objet qui tremble n'invalide pas le terrain à chaque frame.
+	 */
+	const float step = m_terrain->GetQueryCellSize() / 4.0f;
+
+	std::vector<KX_TerrainObjectIndex::Footprint> footprints;
+	for (unsigned int i = 0, size = objects->GetCount(); i < size; ++i) {
+		KX_GameObject *gameobj = (KX_GameObject *)objects->GetValue(i);
+		Object *blendobj = gameobj->GetBlenderObject();
+		if (!blendobj || !std::binary_search(m_groupObjects.begin(), m_groupObjects.end(), blendobj)) {
+			continue;
+		}
+
+		const MT_Point3& position = gameobj->NodeGetWorldPosition();
+		const MT_Vector3& scale = gameobj->NodeGetWorldScaling();
+
+		KX_TerrainObjectIndex::Footprint footprint;
+		for (unsigned short axis = 0; axis < 3; ++axis) {
+			footprint.pos[axis] = roundf(position[axis] / step) * step;
+		}
+		for (unsigned short axis = 0; axis < 2; ++axis) {
+			footprint.radius[axis] = roundf(fabs(scale[axis]) * influence / step) * step;
+		}
+
+		if (footprint.radius[0] > 0.0f && footprint.radius[1] > 0.0f) {
+			footprints.push_back(footprint);
+		}
+	}
+
+	std::sort(footprints.begin(), footprints.end());
+
+	// Seul le thread principal remplace l'index, on peut le lire sans verrou.
+	KX_TerrainObjectIndex *oldIndex = m_objectIndex;
+	if (oldIndex && oldIndex->GetFootprints() == footprints) {
+		return;
+	}
+
+	// Les empreintes qui ont disparues et celles qui sont apparues.
+	std::vector<KX_TerrainObjectIndex::Footprint> changed;
+	if (oldIndex) {
+		const std::vector<KX_TerrainObjectIndex::Footprint>& oldFootprints = oldIndex->GetFootprints();
+		std::set_symmetric_difference(oldFootprints.begin(), oldFootprints.end(), footprints.begin(), footprints.end(),
+									  std::back_inserter(changed));
+	}
+	else {
+		changed = footprints;
+	}
+
+	KX_TerrainObjectIndex *newIndex = new KX_TerrainObjectIndex(footprints);
+	BLI_spin_lock(&m_objectIndexLock);
+	m_objectIndex = newIndex;
+	BLI_spin_unlock(&m_objectIndexLock);
+
+	// Les threads de travail utilisant l'ancien index le libéreront.
+	if (oldIndex) {
+		oldIndex->Release();
+	}
+
+	// Le terrain est invalidé après le remplacement pour ne recalculer qu'avec le nouvel index.
+	for (std::vector<KX_TerrainObjectIndex::Footprint>::const_iterator it = changed.begin(); it != changed.end(); ++it) {
+		const KX_TerrainObjectIndex::Footprint& footprint = *it;
+		m_terrain->InvalidateArea(footprint.pos[0] - footprint.radius[0], footprint.pos[1] - footprint.radius[1],
+								  footprint.pos[0] + footprint.radius[0], footprint.pos[1] + footprint.radius[1]);
+	}
 }
 
-float KX_TerrainZoneMesh::GetClampedHeight(const float orgheight, const float x, const float y, const float *v1, const float *v2, const float *v3) const
+float KX_TerrainZoneMesh::GetClampedHeight(const float orgheight, const float x, const float y,
+										   const float *v1, const float *v2, const float *v3, const float *objectheight) const
 {
 	float height = 0.0f;
 
 	if (m_zoneInfo->flag & TERRAIN_ZONE_CLAMP) {
-		if (m_zoneInfo->flag & TERRAIN_ZONE_CLAMP_MESH) {
+		// On aplanit le terrain à la hauteur de l'objet le plus influent.
+		if (m_zoneInfo->flag & TERRAIN_ZONE_CLAMP_OBJECT && objectheight) {
+			height = *objectheight - orgheight;
+		}
+		else if (m_zoneInfo->flag & TERRAIN_ZONE_CLAMP_MESH) {
 			if (v1 && v2 && v3) {
 				const float rayheight = 5000.0f; // TODO exposer à l'utilisateur
 				float start[3] = {x, y, rayheight};
@@ -156,36 +469,6 @@ float KX_TerrainZoneMesh::GetMeshColorInterp(const float x, const float y, const
 		interp_v3_v3v3v3(color, c1, c2, c3, weight);
 		interp = color[0];
 	}
-	else if (m_zoneInfo->flag & TERRAIN_ZONE_USE_OBJECT && m_zoneInfo->groupobject) {
-		Group *group = m_zoneInfo->groupobject;
-		interp = 0.0f;
-		unsigned short objindex = 1;
-		for (GroupObject *groupobj = (GroupObject *)group->gobject.first;
-			 groupobj; groupobj = groupobj->next, ++objindex)
-		{
-			Object *blendobj = groupobj->ob;
-			const float *position = blendobj->loc;
-			const float *scale = blendobj->size;
-			const float influence = m_zoneInfo->objectinfluence;
-
-			const float point[2] = {(float)fabs(x - position[0]), (float)fabs(y - position[1])};
-			const float radius[2] = {scale[0] * influence, scale[1] * influence};
-
-			if (point[0] < radius[0] && point[1] < radius[1]) {
-				const float pointlength = len_v2(point);
-				static const float xaxis[2] = {1.0f, 0.0f};
-				const float unscaledpoint[2] = {point[0] / radius[0], point[1] / radius[1]};
-				const float angle = angle_v2v2(xaxis, unscaledpoint);
-				const float max[2] = {cosf(angle) * radius[0], sinf(angle) * radius[1]};
-				const float maxlength = len_v2(max);
-
-				float objinterp = (maxlength - pointlength) / maxlength;
-				CLAMP(objinterp, 0.0f, 1.0f);
-
-				interp = max_ff(interp, objinterp);
-			}
-		}
-	}
 
 	return interp;
 }
@@ -247,83 +530,300 @@ float KX_TerrainZoneMesh::GetImageHeight(const float x, const float y) const
 	return height;
 }
 
+void KX_TerrainZoneMesh::ConstructFaceGrid()
+{
+	const unsigned int totface = m_derivedMesh->getNumTessFaces(m_derivedMesh);
+	MVert *mvert = m_derivedMesh->getVertArray(m_derivedMesh);
+	MFace *mface = m_derivedMesh->getTessFaceArray(m_derivedMesh);
+
+	// Environ une face par cellule, pour un mesh aussi large que long.
+	const unsigned short resolution = max_ii(1, min_ii((int)sqrtf((float)totface), GRID_MAX_RESOLUTION));
+	const float size[2] = {m_box[1] - m_box[0], m_box[3] - m_box[2]};
+
+	for (unsigned short axis = 0; axis < 2; ++axis) {
+		m_gridResolution[axis] = resolution;
+		m_gridInvCellSize[axis] = (size[axis] > 0.0f) ? (resolution / size[axis]) : 0.0f;
+	}
+
+	const unsigned int cellcount = m_gridResolution[0] * m_gridResolution[1];
+	// Les cellules couvertes par la boite de chaque face : xmin, xmax, ymin, ymax.
+	std::vector<unsigned short> faceCells(totface * 4);
+	std::vector<unsigned int> cellCounts(cellcount, 0);
+
+	for (unsigned int i = 0; i < totface; ++i) {
+		const float *v1 = mvert[mface[i].v1].co;
+		const float *v2 = mvert[mface[i].v2].co;
+		const float *v3 = mvert[mface[i].v3].co;
+		unsigned short *cells = &faceCells[i * 4];
+
+		for (unsigned short axis = 0; axis < 2; ++axis) {
+			cells[axis * 2] = GetGridCell(min_fff(v1[axis], v2[axis], v3[axis]), axis);
+			cells[axis * 2 + 1] = GetGridCell(max_fff(v1[axis], v2[axis], v3[axis]), axis);
+		}
+
+		for (unsigned short x = cells[0]; x <= cells[1]; ++x) {
+			for (unsigned short y = cells[2]; y <= cells[3]; ++y) {
+				++cellCounts[x * m_gridResolution[1] + y];
+			}
+		}
+	}
+
+	m_gridCellStart.resize(cellcount + 1);
+	m_gridCellStart[0] = 0;
+	for (unsigned int i = 0; i < cellcount; ++i) {
+		m_gridCellStart[i + 1] = m_gridCellStart[i] + cellCounts[i];
+		cellCounts[i] = m_gridCellStart[i];
+	}
+
+	// Les faces sont ajoutées dans l'ordre de leurs indices.
+	m_gridFaces.resize(m_gridCellStart[cellcount]);
+	for (unsigned int i = 0; i < totface; ++i) {
+		const unsigned short *cells = &faceCells[i * 4];
+		for (unsigned short x = cells[0]; x <= cells[1]; ++x) {
+			for (unsigned short y = cells[2]; y <= cells[3]; ++y) {
+				m_gridFaces[cellCounts[x * m_gridResolution[1] + y]++] = i;
+			}
+		}
+	}
+}
+
+unsigned short KX_TerrainZoneMesh::GetGridCell(const float pos, const unsigned short axis) const
+{
+	const int cell = (int)((pos - m_box[axis * 2]) * m_gridInvCellSize[axis]);
+	return min_ii(max_ii(cell, 0), m_gridResolution[axis] - 1);
+}
+
+int KX_TerrainZoneMesh::GetHitFace(const float x, const float y) const
+{
+	// en premier on verifie que le point est bien compris dans les maximum et minimun du mesh
+	if (!((m_box[0] < x && x < m_box[1]) && (m_box[2] < y && y < m_box[3]))) {
+		return -1;
+	}
+
+	MVert *mvert = m_derivedMesh->getVertArray(m_derivedMesh);
+	MFace *mface = m_derivedMesh->getTessFaceArray(m_derivedMesh);
+	const float point[2] = {x, y};
+
+	/* On parcoure seulement les triangles de la cellule du point, comme ils sont
+	 * triés on touche le même triangle qu'en parcourant tout le mesh.
+	 */
+	const unsigned int cell = GetGridCell(x, 0) * m_gridResolution[1] + GetGridCell(y, 1);
+	for (unsigned int j = m_gridCellStart[cell], end = m_gridCellStart[cell + 1]; j < end; ++j) {
+		const unsigned int i = m_gridFaces[j];
+		const MVert &v1 = mvert[mface[i].v1];
+		const MVert &v2 = mvert[mface[i].v2];
+		const MVert &v3 = mvert[mface[i].v3];
+
+		// Si le point est bien dans un des triangles
+		if (isect_point_tri_v2(point, v1.co, v2.co, v3.co) == 1) {
+			return i;
+		}
+	}
+
+	return -1;
+}
+
 // Si ledit point est en contact, on renvoie la modif asociée à sa hauteur
 void KX_TerrainZoneMesh::GetVertexInfo(const float x, const float y, VertexZoneInfo *r_info) const
+{
+	GetVertexInfos(1, &x, &y, &r_info);
+}
+
+void KX_TerrainZoneMesh::GetVertexInfos(const unsigned int count, const float *x, const float *y, VertexZoneInfo **r_infos) const
 {
 	if (!(m_zoneInfo->flag & TERRAIN_ZONE_ACTIVE)) {
 		return;
 	}
 
-	float deltaheight = 0.0f;
-	float interp = 1.0f;
-	bool hit = false;
-
-	// on utilise un mesh comme zone
-	if (m_zoneInfo->flag & TERRAIN_ZONE_MESH && m_zoneInfo->mesh) {
-		// en premier on verifie que le point est bien compris dans les maximum et minimun du mesh
-		if ((m_box[0] < x && x < m_box[1]) && (m_box[2] < y && y < m_box[3])) {
-			const unsigned int totface = m_derivedMesh->getNumTessFaces(m_derivedMesh);
-			MVert *mvert = m_derivedMesh->getVertArray(m_derivedMesh);
-			MFace *mface = m_derivedMesh->getTessFaceArray(m_derivedMesh);
-			const float point[2] = {x, y};
-
-			// On parcoure toutes les triangles
-			for (unsigned int i = 0; i < totface; ++i) {
-				const MVert &v1 = mvert[mface[i].v1];
-				const MVert &v2 = mvert[mface[i].v2];
-				const MVert &v3 = mvert[mface[i].v3];
-
-				const int result = isect_point_tri_v2(point, v1.co, v2.co, v3.co);
-				// Si le point est bien dans un des triangles
-				if (result == 1) {
-					interp = GetMeshColorInterp(x, y, i, v1.co, v2.co, v3.co);
-					hit = true;
-					// La difference entre la hauteur precedente et une hauteur clampée.
-					deltaheight += GetClampedHeight(r_info->height, x, y, v1.co, v2.co, v3.co);
-					// La hauteur par default.
-					deltaheight += m_zoneInfo->offset;
-					// La hauteur calculé avec un bruit de perlin.
-					deltaheight += GetNoiseHeight(x, y);
-					// La hauteur dedui par une image.
-					deltaheight += GetImageHeight(x, y);
-					// On fais l'interpolation de cette difference de hauteur.
-					deltaheight *= interp;
-
-					break;
+	const bool usemesh = (m_zoneInfo->flag & TERRAIN_ZONE_MESH && m_derivedMesh);
+	const bool usemeshinterp = (m_zoneInfo->flag & TERRAIN_ZONE_MESH_VERTEX_COLOR_INTERP && m_derivedMesh);
+	const bool useobjects = GetUseObjects();
+	// L'index est gardé pendant tout le calcul même si le thread principal le remplace.
+	KX_TerrainObjectIndex *objectIndex = useobjects ? AcquireObjectIndex() : NULL;
+
+	// La face touchée par chaque point, -1 si le point est en dehors du mesh.
+	std::vector<int> faces(count, -1);
+	// Les indices des points modifiés par la zone.
+	std::vector<unsigned int> hits;
+	hits.reserve(count);
+	/* L'influence des objets et la hauteur de l'objet le plus influent pour chaque
+	 * point touché, utilisées seulement en dehors du mesh.
+	 */
+	std::vector<float> objectinterps;
+	std::vector<float> objectheights;
+	if (useobjects) {
+		objectinterps.reserve(count);
+		objectheights.reserve(count);
+	}
+
+	for (unsigned int i = 0; i < count; ++i) {
+		if (usemesh) {
+			faces[i] = GetHitFace(x[i], y[i]);
+			if (faces[i] == -1) {
+				continue;
+			}
+		}
+
+		/* Les points en dehors des empreintes des objets ne sont pas modifiés, on ne
+		 * calcule donc le bruit que sous les objets.
+		 */
+		if (useobjects) {
+			float objectinterp = 1.0f;
+			float objectheight = 0.0f;
+			if (!usemeshinterp && faces[i] == -1) {
+				objectinterp = objectIndex ? objectIndex->GetInfluence(x[i], y[i], &objectheight) : 0.0f;
+				if (objectinterp == 0.0f) {
+					continue;
 				}
 			}
+			objectinterps.push_back(objectinterp);
+			objectheights.push_back(objectheight);
+		}
+
+		hits.push_back(i);
+	}
+
+	if (objectIndex) {
+		objectIndex->Release();
+	}
+
+	const unsigned int hitcount = hits.size();
+	if (hitcount == 0) {
+		return;
+	}
+
+	/* La hauteur calculé avec un bruit de perlin, on calcule le bruit de tous les
+	 * points touchés en une fois pour utiliser les fonctions vectorisées.
+	 */
+	std::vector<float> noiseheights(hitcount, 0.0f);
+	if (m_zoneInfo->flag & TERRAIN_ZONE_PERLIN_NOISE) {
+		std::vector<float> scaledx(hitcount);
+		std::vector<float> scaledy(hitcount);
+		for (unsigned int i = 0; i < hitcount; ++i) {
+			scaledx[i] = x[hits[i]] / m_zoneInfo->resolution;
+			scaledy[i] = y[hits[i]] / m_zoneInfo->resolution;
 		}
-		if (!hit) {
-			return;
+
+		KX_TerrainNoiseBatch(m_zoneInfo->musgravetype, m_zoneInfo->noisebasis, m_zoneInfo->H, m_zoneInfo->lacunarity,
+							 m_zoneInfo->octaves, m_zoneInfo->musgraveoffset, m_zoneInfo->gain, hitcount,
+							 &scaledx[0], &scaledy[0], &noiseheights[0]);
+
+		const float factor = m_zoneInfo->noiseheight / m_fractalMaxHeight;
+		for (unsigned int i = 0; i < hitcount; ++i) {
+			noiseheights[i] *= factor;
 		}
 	}
-	else {
-		interp = GetMeshColorInterp(x, y, -1, NULL, NULL, NULL);
-		deltaheight += GetClampedHeight(r_info->height, x, y, NULL, NULL, NULL);
+
+	MVert *mvert = usemesh ? m_derivedMesh->getVertArray(m_derivedMesh) : NULL;
+	MFace *mface = usemesh ? m_derivedMesh->getTessFaceArray(m_derivedMesh) : NULL;
+
+	for (unsigned int i = 0; i < hitcount; ++i) {
+		const unsigned int index = hits[i];
+		const float px = x[index];
+		const float py = y[index];
+		const int faceindex = faces[index];
+		VertexZoneInfo *info = r_infos[index];
+
+		const float *v1 = NULL;
+		const float *v2 = NULL;
+		const float *v3 = NULL;
+		if (faceindex != -1) {
+			v1 = mvert[mface[faceindex].v1].co;
+			v2 = mvert[mface[faceindex].v2].co;
+			v3 = mvert[mface[faceindex].v3].co;
+		}
+
+		// Un point sous un objet est interpolé par l'influence de l'objet.
+		const bool objectinterp = (useobjects && !usemeshinterp && faceindex == -1);
+		const float interp = objectinterp ? objectinterps[i] : GetMeshColorInterp(px, py, faceindex, v1, v2, v3);
+		float deltaheight = 0.0f;
+		// La difference entre la hauteur precedente et une hauteur clampée.
+		deltaheight += GetClampedHeight(info->height, px, py, v1, v2, v3, objectinterp ? &objectheights[i] : NULL);
+		// La hauteur par default.
 		deltaheight += m_zoneInfo->offset;
-		deltaheight += GetNoiseHeight(x, y);
-		deltaheight += GetImageHeight(x, y);
+		deltaheight += noiseheights[i];
+		// La hauteur dedui par une image.
+		deltaheight += GetImageHeight(px, py);
+		// On fais l'interpolation de cette difference de hauteur.
 		deltaheight *= interp;
-	}
 
-	r_info->height += deltaheight;
-
-	if (m_zoneInfo->flag & TERRAIN_ZONE_USE_UV_TEXTURE_COLOR) {
-		if (deltaheight != 0.0f) {
-			const unsigned short channel = m_zoneInfo->uvchannel / 2;
-			const unsigned short axis = m_zoneInfo->uvchannel % 2;
-			float value;
-			if (m_zoneInfo->flag & TERRAIN_ZONE_USE_HEIGHT_COLOR) {
-				value = fabs(deltaheight);
-				if (m_zoneInfo->flag & TERRAIN_ZONE_DIVIDE_COLOR) {
-					value /= m_zoneInfo->colordividor;
+		info->height += deltaheight;
+
+		if (m_zoneInfo->flag & TERRAIN_ZONE_USE_UV_TEXTURE_COLOR) {
+			if (deltaheight != 0.0f) {
+				const unsigned short channel = m_zoneInfo->uvchannel / 2;
+				const unsigned short axis = m_zoneInfo->uvchannel % 2;
+				float value;
+				if (m_zoneInfo->flag & TERRAIN_ZONE_USE_HEIGHT_COLOR) {
+					value = fabs(deltaheight);
+					if (m_zoneInfo->flag & TERRAIN_ZONE_DIVIDE_COLOR) {
+						value /= m_zoneInfo->colordividor;
+					}
+					value *= m_zoneInfo->color;
 				}
-				value *= m_zoneInfo->color;
-			}
-			else {
-				value = m_zoneInfo->color;
+				else {
+					value = m_zoneInfo->color;
+				}
+				info->m_uvs[channel][axis] = value * interp;
 			}
-			r_info->m_uvs[channel][axis] = value * interp;
+		}
+	}
+}
+
+void KX_TerrainZoneMesh::AddHashKey(BLI_HashMurmur2A *mm2) const
+{
+	const TerrainZone *zone = m_zoneInfo;
+
+	BLI_hash_mm2a_add_int(mm2, zone->flag);
+	if (!(zone->flag & TERRAIN_ZONE_ACTIVE)) {
+		return;
+	}
+
+	BLI_hash_mm2a_add_int(mm2, zone->noisebasis);
+	BLI_hash_mm2a_add_int(mm2, zone->musgravetype);
+	BLI_hash_mm2a_add_int(mm2, zone->octaves);
+	BLI_hash_mm2a_add_int(mm2, zone->uvchannel);
+
+	const float values[] = {zone->offset, zone->noiseheight, zone->resolution, zone->lacunarity, zone->gain,
+		zone->musgraveoffset, zone->H, zone->clampstart, zone->clampend, zone->imageheight, zone->objectinfluence,
+		zone->color, zone->colordividor};
+	BLI_hash_mm2a_add(mm2, (const unsigned char *)values, sizeof(values));
+
+	// Les faces et couleurs du mesh utilisé comme zone.
+	if (m_derivedMesh) {
+		const unsigned int totvert = m_derivedMesh->getNumVerts(m_derivedMesh);
+		const unsigned int totface = m_derivedMesh->getNumTessFaces(m_derivedMesh);
+		MVert *mvert = m_derivedMesh->getVertArray(m_derivedMesh);
+		MFace *mface = m_derivedMesh->getTessFaceArray(m_derivedMesh);
+		MCol *mcol = (MCol *)m_derivedMesh->getTessFaceDataArray(m_derivedMesh, CD_MCOL);
+
+		for (unsigned int i = 0; i < totvert; ++i) {
+			BLI_hash_mm2a_add(mm2, (const unsigned char *)mvert[i].co, sizeof(mvert[i].co));
+		}
+		for (unsigned int i = 0; i < totface; ++i) {
+			BLI_hash_mm2a_add_int(mm2, mface[i].v1);
+			BLI_hash_mm2a_add_int(mm2, mface[i].v2);
+			BLI_hash_mm2a_add_int(mm2, mface[i].v3);
+			// Zéro pour un triangle.
+			BLI_hash_mm2a_add_int(mm2, mface[i].v4);
+		}
+		if (mcol) {
+			BLI_hash_mm2a_add(mm2, (const unsigned char *)mcol, sizeof(MCol) * 4 * totface);
+		}
+	}
+
+	// Les pixels de l'image de hauteur.
+	if (m_buf && m_buf->rect_float) {
+		BLI_hash_mm2a_add_int(mm2, m_buf->x);
+		BLI_hash_mm2a_add_int(mm2, m_buf->y);
+		BLI_hash_mm2a_add(mm2, (const unsigned char *)m_buf->rect_float, sizeof(float) * 4 * m_buf->x * m_buf->y);
+	}
+
+	// La position et la taille des objets d'influence.
+	if (zone->groupobject) {
+		for (GroupObject *groupobj = (GroupObject *)zone->groupobject->gobject.first; groupobj; groupobj = groupobj->next) {
+			BLI_hash_mm2a_add(mm2, (const unsigned char *)groupobj->ob->loc, sizeof(groupobj->ob->loc));
+			BLI_hash_mm2a_add(mm2, (const unsigned char *)groupobj->ob->size, sizeof(groupobj->ob->size));
 		}
 	}
 }
@@ -27,6 +27,10 @@
 #include "MT_Point2.h"
 #include "MT_Point3.h"
 
+#include <vector>
+
+#include "BLI_threads.h"
+
 extern "C" {
 #include "BKE_DerivedMesh.h"
 #include "BKE_cdderivedmesh.h"
@@ -36,7 +40,11 @@ class Mesh;
 class DerivedMesh;
 class TerrainZone;
 class KX_Terrain;
+class KX_TerrainPool;
+class CListValue;
+struct Object;
 struct ImBuf;
+struct BLI_HashMurmur2A;
 
 class VertexZoneInfo
 {
@@ -45,17 +53,22 @@ public:
 	float height;
 	/// Vertex 2d coord
 	float pos[2];
-	/// count of chunk vertexes which use it.
-	unsigned char refcount;
+	/** count of chunk vertexes which use it, modified by the worker threads
+	 * building the chunks so only use AddRef and Release.
+	 */
+	unsigned int refcount;
 	/** Tous les cannaux d'UVs.
 	 * Le premier cannal et utilisé pour l'UV du vertice
 	 * et les autres pour la couleur des textures.
 	 */
 	MT_Point2 m_uvs[8];
+	/// L'allocateur du terrain qui a créé ce vertice, utilisé pour sa libération.
+	KX_TerrainPool *m_pool;
 
-	VertexZoneInfo()
+	VertexZoneInfo(KX_TerrainPool *pool)
 		:height(0.0f),
-		refcount(1)
+		refcount(1),
+		m_pool(pool)
 	{
 		for (unsigned short i = 0; i < 8; ++i) {
 			m_uvs[i].x() = 0.0f;
@@ -67,15 +80,64 @@ public:
 	{
 	}
 
-	void AddRef()
+	void AddRef();
+	void Release();
+};
+
+/** The footprints of the objects of a group influencing a zone, stored in an
+ * uniform 2d grid like the zone mesh faces. An index is never modified once
+ * built, it is shared with the worker threads and replaced when objects move.
+ */
+class KX_TerrainObjectIndex
+{
+public:
+	struct Footprint
 	{
-		++refcount;
-	}
-	void Release()
+		/// The object world position.
+		float pos[3];
+		/// The half size of the footprint on x and y.
+		float radius[2];
+
+		bool operator<(const Footprint& other) const;
+		bool operator==(const Footprint& other) const;
+	};
+
+private:
+	/// All the footprints, sorted.
+	std::vector<Footprint> m_footprints;
+	/// The box of all the footprints.
+	float m_box[4];
+	unsigned short m_gridResolution[2];
+	/// The inverse of the cell size on x and y.
+	float m_gridInvCellSize[2];
+	/// The first footprint of each cell in m_gridFootprints, the last item is the total.
+	std::vector<unsigned int> m_gridCellStart;
+	/// The footprints of all cells one after another.
+	std::vector<unsigned int> m_gridFootprints;
+	/// Count of users of the index, modified by the worker threads so only use AddRef and Release.
+	unsigned int m_refCount;
+
+	/// The cell index on one axis of a position, clamped to the grid.
+	unsigned short GetGridCell(const float pos, const unsigned short axis) const;
+
+public:
+	/// \param footprints The sorted footprints.
+	KX_TerrainObjectIndex(const std::vector<Footprint>& footprints);
+
+	void AddRef();
+	void Release();
+
+	/** Compute the influence of the objects on a position.
+	 * \param x The position on x.
+	 * \param y The position on y.
+	 * \param r_height The height of the object with the greatest influence.
+	 * \return The greatest influence of the objects between 0 and 1.
+	 */
+	float GetInfluence(const float x, const float y, float *r_height) const;
+
+	inline const std::vector<Footprint>& GetFootprints() const
 	{
-		--refcount;
-		if (refcount == 0)
-			delete this;
+		return m_footprints;
 	}
 };
 
@@ -88,6 +150,17 @@ private:
 	TerrainZone *m_zoneInfo;
 	/// The box used to optimize.
 	float m_box[4];
+
+	/** Uniform 2d grid on the zone mesh faces, each cell lists the faces
+	 * whose box overlaps it, sorted by index.
+	 */
+	unsigned short m_gridResolution[2];
+	/// The inverse of the cell size on x and y.
+	float m_gridInvCellSize[2];
+	/// The first face of each cell in m_gridFaces, the last item is the total.
+	std::vector<unsigned int> m_gridCellStart;
+	/// The faces of all cells one after another.
+	std::vector<unsigned int> m_gridFaces;
 	/// La hauteur maximale de la fractale.
 	float m_fractalMaxHeight;
 	/// The mesh.
@@ -95,10 +168,33 @@ private:
 	/// L'image utilisé pour les hauteur (optionelle)
 	ImBuf *m_buf;
 
+	/// The blender objects of the influence group, sorted by address.
+	std::vector<Object *> m_groupObjects;
+	/// The footprints of the influence objects, NULL before the first update.
+	KX_TerrainObjectIndex *m_objectIndex;
+	/// Protect the replacement of m_objectIndex from the worker threads.
+	mutable SpinLock m_objectIndexLock;
+
+	/// Return the current object index with a new reference, or NULL.
+	KX_TerrainObjectIndex *AcquireObjectIndex() const;
+
+	/// Compute the box, the face grid and the fractal range, shared by the constructors.
+	void Construct(DerivedMesh *dm);
+	/// Build the grid of faces used by GetHitFace.
+	void ConstructFaceGrid();
+	/// The cell index on one axis of a position, clamped to the grid.
+	unsigned short GetGridCell(const float pos, const unsigned short axis) const;
+
 public:
 	KX_TerrainZoneMesh(KX_Terrain *terrain,
 					   TerrainZone *zoneInfo,
 					   Mesh *mesh);
+	/** Use an existing derived mesh with its tessellated faces, the zone mesh
+	 * takes ownership of it.
+	 */
+	KX_TerrainZoneMesh(KX_Terrain *terrain,
+					   TerrainZone *zoneInfo,
+					   DerivedMesh *dm);
 	~KX_TerrainZoneMesh();
 
 	/** Compute an height clamped.
@@ -109,10 +205,11 @@ public:
 	 * \param v1 The first vertex of the triangle hited.
 	 * \param v2 The second vertex of the triangle hited.
 	 * \param v3 The firth vertex of the triangle hited.
+	 * \param objectheight The height of the influence object on this point or NULL.
 	 * \return The height clamped
 	 */
 	float GetClampedHeight(const float orgheight, const float x, const float y,
-						   const float *v1, const float *v2, const float *v3) const;
+						   const float *v1, const float *v2, const float *v3, const float *objectheight) const;
 
 	/** Compute the interpolation on a position.
 	 * \param point The 2d point.
@@ -123,6 +220,10 @@ public:
 	 * \return The interpolation on this position.
 	 */
 	float GetMeshColorInterp(const float x, const float y, const int faceindex, const float *v1, const float *v2, const float *v3) const;
+	/** Find the face of the zone mesh under a position.
+	 * \return The index of the face or -1 if the point is out of the mesh.
+	 */
+	int GetHitFace(const float x, const float y) const;
 	float GetNoiseHeight(const float x, const float y) const;
 	float GetImageHeight(const float x, const float y) const;
 
@@ -133,6 +234,29 @@ public:
 	 */
 	void GetVertexInfo(const float x, const float y, VertexZoneInfo *r_info) const;
 
+	/** Compute all vertex infos for a set of points, the noise is computed
+	 * for all the points at once with KX_TerrainNoiseBatch.
+	 * \param count The number of points.
+	 * \param x The positions on x.
+	 * \param y The positions on y.
+	 * \param r_infos All vertex infos, one per point.
+	 */
+	void GetVertexInfos(const unsigned int count, const float *x, const float *y, VertexZoneInfo **r_infos) const;
+
+	/** Add all the zone parameters changing the vertex infos to a hash.
+	 * \param mm2 The hash used for the terrain tile store key.
+	 */
+	void AddHashKey(BLI_HashMurmur2A *mm2) const;
+
+	/// Return true if the zone height depends on objects of a group.
+	bool GetUseObjects() const;
+
+	/** Update the footprints of the influence objects and invalidate the terrain
+	 * around the objects which moved, called once per frame by the main thread.
+	 * \param objects The scene objects.
+	 */
+	void UpdateObjects(CListValue *objects);
+
 	inline TerrainZone *GetTerrainZoneInfo() const {
 		return m_zoneInfo;
 	}
@@ -77,6 +77,13 @@ public:
 		m_ipotime = time;
 		m_modified = true;
 	}
+	virtual bool IsModified() const {
+		return m_modified;
+	}
+	// Only the data of the controlled camera is written.
+	virtual bool IsThreadSafe() const {
+		return true;
+	}
 	void	SetModifyLens(bool modify) {
 		m_modify_lens = modify;
 	}
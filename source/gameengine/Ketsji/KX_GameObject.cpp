@@ -481,6 +481,25 @@ void KX_GameObject::UpdateActionManager(float curtime)
 	GetActionManager()->Update(curtime);
 }
 
+void KX_GameObject::UpdateActionIPOs()
+{
+	GetActionManager()->UpdateIPOs();
+}
+
+bool KX_GameObject::EvaluateActionIPOs()
+{
+	// Controllers writing other objects or the physics shapes are left to UpdateActionIPOs.
+	if (GetSGNode()->HasUnsafeControllers(false))
+		return false;
+
+	return GetActionManager()->EvaluateIPOs();
+}
+
+void KX_GameObject::EndActionIPOs()
+{
+	GetActionManager()->EndIPOs();
+}
+
 float KX_GameObject::GetActionFrame(short layer)
 {
 	return GetActionManager()->GetActionFrame(layer);
@@ -944,8 +963,8 @@ void KX_GameObject::InitIPO(bool ipo_as_force,
 void KX_GameObject::UpdateIPO(float curframetime,
 							  bool recurse) 
 {
-	/* This function shouldn't call BL_Action::Update, not even indirectly, 
-	 * as it will cause deadlock due to the lock in BL_Action::Update. */
+	/* This function isn't thread safe, it writes the transforms of the children
+	 * and the physics. Actions call it from BL_Action::UpdateIPOs on the main thread. */
 
 	// just the 'normal' update procedure.
 	GetSGNode()->SetSimulatedTime(curframetime,recurse);
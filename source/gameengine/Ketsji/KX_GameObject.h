@@ -327,6 +327,24 @@ public:
 	 */
 	void UpdateActionManager(float curtime);
 
+	/**
+	 * Apply the IPO frames evaluated by UpdateActionManager, not thread safe
+	 */
+	void UpdateActionIPOs();
+
+	/**
+	 * Apply the IPO frames evaluated by UpdateActionManager to the local transform
+	 * of this object only, the world transform must be updated after. Objects of
+	 * different hierarchies can be evaluated in parallel.
+	 * \return False if nothing was done and UpdateActionIPOs must be used.
+	 */
+	bool EvaluateActionIPOs();
+
+	/**
+	 * End the IPO frames applied by EvaluateActionIPOs
+	 */
+	void EndActionIPOs();
+
 	/*********************************
 	 * End Animation API
 	 *********************************/
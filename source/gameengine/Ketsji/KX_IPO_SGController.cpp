@@ -122,6 +122,26 @@ KX_IpoSGController::SetGameObject(
 
 
 
+bool KX_IpoSGController::IsThreadSafe() const
+{
+	// Forces go through the physics environment.
+	if (m_ipo_as_force)
+		return false;
+
+	// The scaling is applied to the physics shape, which can be shared between objects.
+	if (m_game_object && m_game_object->GetPhysicsController() &&
+	    (m_ipo_channels_active[OB_SIZE_X] || m_ipo_channels_active[OB_SIZE_Y] || m_ipo_channels_active[OB_SIZE_Z] ||
+	     m_ipo_channels_active[OB_DSIZE_X] || m_ipo_channels_active[OB_DSIZE_Y] || m_ipo_channels_active[OB_DSIZE_Z]))
+	{
+		return false;
+	}
+
+	/* Positions and orientations only write the node and the physics body of the object,
+	 * the broadphase and the culling tree are updated on the main thread by
+	 * KX_GameObject::UpdateTransform. */
+	return true;
+}
+
 bool KX_IpoSGController::Update(double currentTime)
 {
 	if (m_modified)
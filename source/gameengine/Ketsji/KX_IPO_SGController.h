@@ -119,6 +119,11 @@ public:
 		m_ipotime = time;
 		m_modified = true;
 	}
+	virtual bool	IsModified() const
+	{
+		return m_modified;
+	}
+	virtual bool	IsThreadSafe() const;
 
 
 #ifdef WITH_CXX_GUARDEDALLOC
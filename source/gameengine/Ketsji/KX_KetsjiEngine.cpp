@@ -55,6 +55,7 @@
 #include "MT_Vector3.h"
 #include "MT_Transform.h"
 #include "SCA_IInputDevice.h"
+#include "SCA_PythonController.h"
 #include "KX_Camera.h"
 #include "KX_Dome.h"
 #include "KX_Light.h"
@@ -68,6 +69,7 @@
 #include "KX_WorldInfo.h"
 #include "KX_ISceneConverter.h"
 #include "KX_TimeCategoryLogger.h"
+#include "KX_Profiler.h"
 
 #include "RAS_FramingManager.h"
 #include "DNA_world_types.h"
@@ -75,8 +77,6 @@
 
 #include "KX_NavMeshObject.h"
 
-#include "BL_Action.h" // For managing action lock.
-
 #define DEFAULT_LOGIC_TIC_RATE 60.0
 //#define DEFAULT_PHYSICS_TIC_RATE 60.0
 
@@ -150,6 +150,8 @@ KX_KetsjiEngine::KX_KetsjiEngine(KX_ISystem* system)
 	m_stereo(false),
 	m_curreye(0),
 
+	m_headless(false),
+
 	m_logger(NULL),
 	
 	// Set up timing info display variables
@@ -178,13 +180,20 @@ KX_KetsjiEngine::KX_KetsjiEngine(KX_ISystem* system)
 	for (int i = tc_first; i < tc_numCategories; i++)
 		m_logger->AddCategory((KX_TimeCategory)i);
 
+	// The logic doesn't depend on the engine, its scripts are profiled through these hooks.
+	SCA_ProfileCallbacks profileCallbacks = {
+		KX_Profiler::IsEnabled,
+		KX_Profiler::InternName,
+		KX_Profiler::BeginZone,
+		KX_Profiler::EndZone
+	};
+	SCA_PythonController::SetProfileCallbacks(profileCallbacks);
+
 #ifdef WITH_PYTHON
 	m_pyprofiledict = PyDict_New();
 #endif
 
 	m_taskscheduler = BLI_task_scheduler_create(TASK_SCHEDULER_AUTO_THREADS);
-
-	BL_Action::InitLock();
 }
 
 
@@ -205,7 +214,8 @@ KX_KetsjiEngine::~KX_KetsjiEngine()
 	if (m_taskscheduler)
 		BLI_task_scheduler_free(m_taskscheduler);
 
-	BL_Action::EndLock();
+	// No worker thread is left to record zones.
+	KX_Profiler::Clear();
 }
 
 
@@ -489,6 +499,9 @@ void KX_KetsjiEngine::ClearFrame()
 
 bool KX_KetsjiEngine::BeginFrame()
 {
+	// close the profiler frame, one frame per render
+	KX_Profiler::NextFrame(m_kxsystem->GetTimeInSeconds());
+
 	// set the area used for rendering (stereo can assign only a subset)
 	m_rasterizer->SetRenderArea();
 
@@ -507,6 +520,8 @@ bool KX_KetsjiEngine::BeginFrame()
 
 void KX_KetsjiEngine::EndFrame()
 {
+	KX_PROFILE_ZONE("EndFrame");
+
 	m_rasterizer->MotionBlur();
 
 	// Show profiling info
@@ -553,6 +568,8 @@ void KX_KetsjiEngine::EndFrame()
 
 bool KX_KetsjiEngine::NextFrame()
 {
+	KX_PROFILE_ZONE("NextFrame");
+
 	double timestep = 1.0/m_ticrate;
 	double framestep = timestep;
 	//	static hidden::Clock sClock;
@@ -609,7 +626,7 @@ bool KX_KetsjiEngine::NextFrame()
 
 	while (frames)
 	{
-	
+		KX_PROFILE_ZONE("LogicFrame");
 
 		m_frameTime += framestep;
 		
@@ -641,7 +658,10 @@ bool KX_KetsjiEngine::NextFrame()
 				
 				m_logger->StartLog(tc_network, m_kxsystem->GetTimeInSeconds(), true);
 				SG_SetActiveStage(SG_STAGE_NETWORK);
-				scene->GetNetworkScene()->proceed(m_frameTime);
+				{
+					KX_PROFILE_ZONE("Network");
+					scene->GetNetworkScene()->proceed(m_frameTime);
+				}
 	
 				//m_logger->StartLog(tc_scenegraph, m_kxsystem->GetTimeInSeconds(), true);
 				//SG_SetActiveStage(SG_STAGE_NETWORK_UPDATE);
@@ -666,30 +686,45 @@ bool KX_KetsjiEngine::NextFrame()
 				// Process sensors, and controllers
 				m_logger->StartLog(tc_logic, m_kxsystem->GetTimeInSeconds(), true);
 				SG_SetActiveStage(SG_STAGE_CONTROLLER);
-				scene->LogicBeginFrame(m_frameTime);
+				{
+					KX_PROFILE_ZONE("Sensors and Controllers");
+					scene->LogicBeginFrame(m_frameTime);
+				}
 	
 				// Scenegraph needs to be updated again, because Logic Controllers 
 				// can affect the local matrices.
 				m_logger->StartLog(tc_scenegraph, m_kxsystem->GetTimeInSeconds(), true);
 				SG_SetActiveStage(SG_STAGE_CONTROLLER_UPDATE);
-				scene->UpdateParents(m_frameTime);
+				{
+					KX_PROFILE_ZONE("UpdateParents");
+					scene->UpdateParents(m_frameTime);
+				}
 	
 				// Process actuators
 	
 				// Do some cleanup work for this logic frame
 				m_logger->StartLog(tc_logic, m_kxsystem->GetTimeInSeconds(), true);
 				SG_SetActiveStage(SG_STAGE_ACTUATOR);
-				scene->LogicUpdateFrame(m_frameTime, true);
-				
-				scene->LogicEndFrame();
+				{
+					KX_PROFILE_ZONE("Actuators");
+					scene->LogicUpdateFrame(m_frameTime, true);
+
+					scene->LogicEndFrame();
+				}
 	
 				// Actuators can affect the scenegraph
 				m_logger->StartLog(tc_scenegraph, m_kxsystem->GetTimeInSeconds(), true);
 				SG_SetActiveStage(SG_STAGE_ACTUATOR_UPDATE);
-				scene->UpdateParents(m_frameTime);
+				{
+					KX_PROFILE_ZONE("UpdateParents");
+					scene->UpdateParents(m_frameTime);
+				}
 
 				// update levels of detail
-				scene->UpdateObjectLods();
+				{
+					KX_PROFILE_ZONE("UpdateObjectLods");
+					scene->UpdateObjectLods();
+				}
 
 				// update and create terrain chunk
 				scene->UpdateTerrainChunksMeshes();
@@ -704,7 +739,10 @@ bool KX_KetsjiEngine::NextFrame()
 
 				m_logger->StartLog(tc_scenegraph, m_kxsystem->GetTimeInSeconds(), true);
 				SG_SetActiveStage(SG_STAGE_PHYSICS2_UPDATE);
-				scene->UpdateParents(m_frameTime);
+				{
+					KX_PROFILE_ZONE("UpdateParents");
+					scene->UpdateParents(m_frameTime);
+				}
 			
 			
 				if (m_animation_record)
@@ -748,6 +786,8 @@ bool KX_KetsjiEngine::NextFrame()
 
 void KX_KetsjiEngine::Render()
 {
+	KX_PROFILE_ZONE("Render");
+
 	if (m_usedome) {
 		RenderDome();
 		return;
@@ -811,7 +851,8 @@ void KX_KetsjiEngine::Render()
 		//scene->UpdateMeshTransformations();
 
 		// shadow buffers
-		RenderShadowBuffers(scene);
+		if (!m_headless)
+			RenderShadowBuffers(scene);
 
 		// Avoid drawing the scene with the active camera twice when it's viewport is enabled
 		if (cam && !cam->GetViewport())
@@ -1049,6 +1090,8 @@ void KX_KetsjiEngine::UpdateAnimations(KX_Scene *scene)
 
 void KX_KetsjiEngine::RenderShadowBuffers(KX_Scene *scene)
 {
+	KX_PROFILE_ZONE("RenderShadowBuffers");
+
 	CListValue *lightlist = scene->GetLightList();
 	int i, drawmode;
 
@@ -1104,6 +1147,8 @@ void KX_KetsjiEngine::RenderShadowBuffers(KX_Scene *scene)
 // update graphics
 void KX_KetsjiEngine::RenderFrame(KX_Scene* scene, KX_Camera* cam)
 {
+	KX_PROFILE_ZONE("RenderFrame");
+
 	bool override_camera;
 	RAS_Rect viewport, area;
 	float nearfrust, farfrust, focallength;
@@ -1228,19 +1273,30 @@ void KX_KetsjiEngine::RenderFrame(KX_Scene* scene, KX_Camera* cam)
 	m_logger->StartLog(tc_scenegraph, m_kxsystem->GetTimeInSeconds(), true);
 	SG_SetActiveStage(SG_STAGE_CULLING);
 
-	scene->CalculateVisibleMeshes(m_rasterizer,cam);
+	{
+		KX_PROFILE_ZONE("Culling");
+		scene->CalculateVisibleMeshes(m_rasterizer,cam);
 
-	// calculate visible terrain chunk
-	scene->CalculateVisibleTerrainChunks();
+		// calculate visible terrain chunk
+		scene->CalculateVisibleTerrainChunks();
+	}
 	// update and create terrain chunk
 	scene->UpdateTerrainChunksMeshes();
 
 	m_logger->StartLog(tc_animations, m_kxsystem->GetTimeInSeconds(), true);
 	SG_SetActiveStage(SG_STAGE_ANIMATION_UPDATE);
-	UpdateAnimations(scene);
+	{
+		KX_PROFILE_ZONE("Animations");
+		UpdateAnimations(scene);
+	}
 
 	m_logger->StartLog(tc_rasterizer, m_kxsystem->GetTimeInSeconds(), true);
 	SG_SetActiveStage(SG_STAGE_RENDER);
+
+	// Without graphic context materials, fonts and debug drawings can't be used.
+	if (m_headless)
+		return;
+
 	// render debug info for terrain and update visible flags
 	scene->RenderTerrainChunksMeshes(cam, m_rasterizer);
 
@@ -1250,7 +1306,10 @@ void KX_KetsjiEngine::RenderFrame(KX_Scene* scene, KX_Camera* cam)
 	scene->RunDrawingCallbacks(scene->GetPreDrawCB());
 #endif
 
-	scene->RenderBuckets(camtrans, m_rasterizer);
+	{
+		KX_PROFILE_ZONE("RenderBuckets");
+		scene->RenderBuckets(camtrans, m_rasterizer);
+	}
 
 	//render all the font objects for this scene
 	scene->RenderFonts();
@@ -1266,6 +1325,10 @@ void KX_KetsjiEngine::RenderFrame(KX_Scene* scene, KX_Camera* cam)
  */
 void KX_KetsjiEngine::PostRenderScene(KX_Scene* scene)
 {
+	// 2D filters and draw callbacks need a graphic context.
+	if (m_headless)
+		return;
+
 	KX_SetActiveScene(scene);
 
 	// We need to first make sure our viewport is correct (enabling multiple viewports can mess this up)
@@ -1789,6 +1852,31 @@ bool KX_KetsjiEngine::GetUseFixedTime(void) const
 	return m_bFixedTime;
 }
 
+void KX_KetsjiEngine::SetHeadless(bool headless)
+{
+	m_headless = headless;
+}
+
+bool KX_KetsjiEngine::GetHeadless() const
+{
+	return m_headless;
+}
+
+double KX_KetsjiEngine::GetProfileTotalTime(int category)
+{
+	return m_logger->GetTotal((KX_TimeCategory)category);
+}
+
+const char *KX_KetsjiEngine::GetProfileLabel(int category)
+{
+	return m_profileLabels[category];
+}
+
+int KX_KetsjiEngine::GetProfileCategoryCount()
+{
+	return tc_numCategories;
+}
+
 double KX_KetsjiEngine::GetSuspendedDelta()
 {
 	return m_suspendeddelta;
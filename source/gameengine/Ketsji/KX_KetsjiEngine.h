@@ -144,6 +144,9 @@ private:
 	bool m_stereo;
 	int m_curreye;
 
+	/// Run without graphic context, only the stages not drawing anything are rendered.
+	bool m_headless;
+
 	/** Categories for profiling display. */
 	typedef enum {
 		tc_first = 0,
@@ -291,6 +294,22 @@ public:
 	 */ 
 	bool GetUseFixedTime(void) const;
 
+	/**
+	 * Sets headless rendering: Render() only computes culling, terrain and
+	 * animations and never draws, for use with a null rasterizer and canvas.
+	 */
+	void SetHeadless(bool headless);
+	bool GetHeadless() const;
+
+	/**
+	 * Returns the time in seconds spent in a profiling category since the
+	 * engine creation, unlike the averages shown by the profile display.
+	 */
+	double GetProfileTotalTime(int category);
+	/// Returns the label of a profiling category.
+	static const char *GetProfileLabel(int category);
+	static int GetProfileCategoryCount();
+
 	/**
 	 * Returns current render frame clock time
 	 */
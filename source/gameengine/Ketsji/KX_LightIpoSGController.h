@@ -74,6 +74,15 @@ public:
 		m_modified = true;
 	}
 
+	virtual bool IsModified() const {
+		return m_modified;
+	}
+
+	// Only the data of the controlled object is written.
+	virtual bool IsThreadSafe() const {
+		return true;
+	}
+
 	void	SetModifyEnergy(bool modify) {
 		m_modify_energy = modify;
 	}
@@ -44,6 +44,10 @@ public:
 		m_ipotime = time;
 		m_modified = true;
 	}
+
+	virtual bool IsModified() const {
+		return m_modified;
+	}
 	
 		void
 	SetOption(
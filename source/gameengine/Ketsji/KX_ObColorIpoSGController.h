@@ -59,6 +59,15 @@ public:
 		m_ipotime = time;
 		m_modified = true;
 	}
+
+	virtual bool IsModified() const {
+		return m_modified;
+	}
+
+	// Only the data of the controlled object is written.
+	virtual bool IsThreadSafe() const {
+		return true;
+	}
 	
 		void
 	SetOption(
@@ -0,0 +1,339 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Contributor(s): none yet.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file gameengine/Ketsji/KX_Profiler.cpp
+ *  \ingroup ketsji
+ */
+
+#include "KX_Profiler.h"
+
+#include <stdio.h>
+#include <set>
+#include <string>
+#include <vector>
+
+extern "C" {
+#  include "BLI_threads.h"
+#  include "PIL_time.h"
+}
+
+#ifdef _MSC_VER
+#  define KX_THREAD_LOCAL __declspec(thread)
+#else
+#  define KX_THREAD_LOCAL __thread
+#endif
+
+struct KX_ProfileEvent
+{
+	const char *name;
+	double start;
+	double end;
+	unsigned int thread;
+	unsigned int depth;
+};
+
+struct KX_ProfileOpenZone
+{
+	const char *name;
+	double start;
+};
+
+/** The zones recorded by one thread since the last frame. The thread keeps a
+ * pointer to its buffer, so the buffers are never freed, Clear only empties them.
+ */
+struct KX_ProfileThread
+{
+	unsigned int index;
+	bool main;
+	/// Protects the stack and the events, only contended by NextFrame and Clear.
+	SpinLock lock;
+	std::vector<KX_ProfileOpenZone> stack;
+	std::vector<KX_ProfileEvent> events;
+};
+
+struct KX_ProfileFrame
+{
+	double start;
+	double end;
+	std::vector<KX_ProfileEvent> events;
+};
+
+bool KX_Profiler::m_enabled = false;
+
+static SpinLock profileLock;
+static bool profileLockInitialized = false;
+static std::vector<KX_ProfileThread *> profileThreads;
+/// Never cleared, the interned names are cached by their users.
+static std::set<std::string> profileNames;
+
+static std::vector<KX_ProfileFrame> profileFrames(KX_Profiler::DEFAULT_FRAME_COUNT);
+static unsigned int profileFrameHead = 0;
+static unsigned int profileFrameCount = 0;
+static double profileFrameStart = -1.0;
+static double profileTimeBase = -1.0;
+
+static double profileHitchThreshold = 0.0;
+static std::string profileHitchPath;
+/// Frames to record before the next hitch dump.
+static unsigned int profileHitchCooldown = 0;
+
+static KX_THREAD_LOCAL KX_ProfileThread *localThread = NULL;
+
+static void profile_lock_init()
+{
+	/* The first zone is always opened by the main thread before any task is run. */
+	if (!profileLockInitialized) {
+		BLI_spin_init(&profileLock);
+		profileLockInitialized = true;
+	}
+}
+
+static KX_ProfileThread *profile_get_thread()
+{
+	if (localThread) {
+		return localThread;
+	}
+
+	KX_ProfileThread *thread = new KX_ProfileThread();
+	thread->main = BLI_thread_is_main();
+	BLI_spin_init(&thread->lock);
+
+	profile_lock_init();
+	BLI_spin_lock(&profileLock);
+	// Index 0 is used by the frame markers.
+	thread->index = profileThreads.size() + 1;
+	profileThreads.push_back(thread);
+	BLI_spin_unlock(&profileLock);
+
+	localThread = thread;
+	return thread;
+}
+
+void KX_Profiler::SetEnabled(bool enabled)
+{
+	profile_lock_init();
+	m_enabled = enabled;
+	profileFrameStart = -1.0;
+}
+
+void KX_Profiler::SetFrameCount(unsigned int count)
+{
+	if (count == 0) {
+		count = 1;
+	}
+	profileFrames.clear();
+	profileFrames.resize(count);
+	profileFrameHead = 0;
+	profileFrameCount = 0;
+	profileHitchCooldown = 0;
+}
+
+unsigned int KX_Profiler::GetFrameCount()
+{
+	return profileFrames.size();
+}
+
+void KX_Profiler::SetHitchThreshold(double threshold, const char *filepath)
+{
+	profileHitchThreshold = threshold;
+	profileHitchPath = (filepath && filepath[0]) ? filepath : "hitch_trace.json";
+}
+
+double KX_Profiler::GetHitchThreshold()
+{
+	return profileHitchThreshold;
+}
+
+void KX_Profiler::BeginZone(const char *name)
+{
+	KX_ProfileThread *thread = profile_get_thread();
+	KX_ProfileOpenZone zone = {name, PIL_check_seconds_timer()};
+	// Clear can empty the stack from the main thread.
+	BLI_spin_lock(&thread->lock);
+	thread->stack.push_back(zone);
+	BLI_spin_unlock(&thread->lock);
+}
+
+void KX_Profiler::EndZone()
+{
+	KX_ProfileThread *thread = profile_get_thread();
+	const double end = PIL_check_seconds_timer();
+
+	BLI_spin_lock(&thread->lock);
+	// The buffers were cleared while the zone was open.
+	if (!thread->stack.empty()) {
+		const KX_ProfileOpenZone &zone = thread->stack.back();
+		KX_ProfileEvent event = {zone.name, zone.start, end, thread->index, (unsigned int)thread->stack.size() - 1};
+		thread->stack.pop_back();
+		thread->events.push_back(event);
+	}
+	BLI_spin_unlock(&thread->lock);
+}
+
+const char *KX_Profiler::InternName(const char *name)
+{
+	profile_lock_init();
+	BLI_spin_lock(&profileLock);
+	const char *result = profileNames.insert(std::string(name)).first->c_str();
+	BLI_spin_unlock(&profileLock);
+	return result;
+}
+
+void KX_Profiler::NextFrame(double now)
+{
+	if (!m_enabled) {
+		return;
+	}
+
+	if (profileTimeBase < 0.0) {
+		profileTimeBase = now;
+	}
+	// First frame since the profiler is enabled, nothing to close.
+	if (profileFrameStart < 0.0) {
+		profileFrameStart = now;
+		return;
+	}
+
+	KX_ProfileFrame &frame = profileFrames[profileFrameHead];
+	frame.start = profileFrameStart;
+	frame.end = now;
+	frame.events.clear();
+
+	BLI_spin_lock(&profileLock);
+	for (std::vector<KX_ProfileThread *>::iterator it = profileThreads.begin(); it != profileThreads.end(); ++it) {
+		KX_ProfileThread *thread = *it;
+		BLI_spin_lock(&thread->lock);
+		frame.events.insert(frame.events.end(), thread->events.begin(), thread->events.end());
+		thread->events.clear();
+		BLI_spin_unlock(&thread->lock);
+	}
+	BLI_spin_unlock(&profileLock);
+
+	profileFrameHead = (profileFrameHead + 1) % profileFrames.size();
+	if (profileFrameCount < profileFrames.size()) {
+		++profileFrameCount;
+	}
+	profileFrameStart = now;
+
+	if (profileHitchCooldown > 0) {
+		--profileHitchCooldown;
+	}
+	else if (profileHitchThreshold > 0.0 && (frame.end - frame.start) > profileHitchThreshold) {
+		const double dumpStart = PIL_check_seconds_timer();
+		if (WriteChromeTrace(profileHitchPath.c_str())) {
+			printf("Profiler: frame took %.2f ms, trace written to %s\n",
+			       (frame.end - frame.start) * 1000.0, profileHitchPath.c_str());
+		}
+		/* The dump isn't charged to the next frame, and the next dump only
+		 * happens once all the frames written are replaced. */
+		profileFrameStart += PIL_check_seconds_timer() - dumpStart;
+		profileHitchCooldown = profileFrames.size();
+	}
+}
+
+static void profile_write_name(FILE *fp, const char *name)
+{
+	fputc('"', fp);
+	for (const char *c = name; *c; ++c) {
+		if (*c == '"' || *c == '\\') {
+			fputc('\\', fp);
+		}
+		if ((unsigned char)*c >= 0x20) {
+			fputc(*c, fp);
+		}
+	}
+	fputc('"', fp);
+}
+
+bool KX_Profiler::WriteChromeTrace(const char *filepath)
+{
+	FILE *fp = fopen(filepath, "w");
+	if (!fp) {
+		return false;
+	}
+
+	fprintf(fp, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+	fprintf(fp, "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, \"tid\": 0, \"args\": {\"name\": \"Frames\"}}");
+
+	profile_lock_init();
+	BLI_spin_lock(&profileLock);
+	for (std::vector<KX_ProfileThread *>::iterator it = profileThreads.begin(); it != profileThreads.end(); ++it) {
+		const KX_ProfileThread *thread = *it;
+		if (thread->main) {
+			fprintf(fp, ",\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, \"tid\": %u, \"args\": {\"name\": \"Main\"}}",
+			        thread->index);
+		}
+		else {
+			fprintf(fp, ",\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, \"tid\": %u, \"args\": {\"name\": \"Worker %u\"}}",
+			        thread->index, thread->index);
+		}
+	}
+	BLI_spin_unlock(&profileLock);
+
+	// Oldest frame first.
+	const unsigned int size = profileFrames.size();
+	const unsigned int first = (profileFrameHead + size - profileFrameCount) % size;
+	for (unsigned int i = 0; i < profileFrameCount; ++i) {
+		const KX_ProfileFrame &frame = profileFrames[(first + i) % size];
+
+		fprintf(fp, ",\n{\"name\": \"Frame\", \"ph\": \"X\", \"pid\": 0, \"tid\": 0, \"ts\": %.3f, \"dur\": %.3f}",
+		        (frame.start - profileTimeBase) * 1e6, (frame.end - frame.start) * 1e6);
+
+		for (std::vector<KX_ProfileEvent>::const_iterator it = frame.events.begin(); it != frame.events.end(); ++it) {
+			const KX_ProfileEvent &event = *it;
+			fprintf(fp, ",\n{\"name\": ");
+			profile_write_name(fp, event.name);
+			fprintf(fp, ", \"ph\": \"X\", \"pid\": 0, \"tid\": %u, \"ts\": %.3f, \"dur\": %.3f, \"args\": {\"depth\": %u}}",
+			        event.thread, (event.start - profileTimeBase) * 1e6, (event.end - event.start) * 1e6, event.depth);
+		}
+	}
+
+	fprintf(fp, "\n]}\n");
+	fclose(fp);
+
+	return true;
+}
+
+void KX_Profiler::Clear()
+{
+	profile_lock_init();
+	BLI_spin_lock(&profileLock);
+	for (std::vector<KX_ProfileThread *>::iterator it = profileThreads.begin(); it != profileThreads.end(); ++it) {
+		KX_ProfileThread *thread = *it;
+		/* The threads still running use their buffer right after, swapping releases
+		 * the memory of the threads which exited, only the buffer itself stays. */
+		BLI_spin_lock(&thread->lock);
+		std::vector<KX_ProfileOpenZone>().swap(thread->stack);
+		std::vector<KX_ProfileEvent>().swap(thread->events);
+		BLI_spin_unlock(&thread->lock);
+	}
+	BLI_spin_unlock(&profileLock);
+
+	for (std::vector<KX_ProfileFrame>::iterator it = profileFrames.begin(); it != profileFrames.end(); ++it) {
+		it->events.clear();
+	}
+	profileFrameHead = 0;
+	profileFrameCount = 0;
+	profileFrameStart = -1.0;
+	profileTimeBase = -1.0;
+	profileHitchCooldown = 0;
+}
@@ -0,0 +1,138 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Contributor(s): none yet.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file KX_Profiler.h
+ *  \ingroup ketsji
+ */
+
+#ifndef __KX_PROFILER_H__
+#define __KX_PROFILER_H__
+
+/**
+ * Hierarchical zone profiler.
+ *
+ * Zones are opened and closed on any thread, each thread records into its own
+ * buffer. At the end of every engine frame the closed zones of all threads are
+ * moved into a ring buffer holding the last frames, which can be written as
+ * Chrome trace-event JSON (chrome://tracing, Perfetto).
+ *
+ * When the profiler is disabled a zone costs a single test of a global flag.
+ */
+class KX_Profiler
+{
+public:
+	/// Number of frames kept by default.
+	enum {
+		DEFAULT_FRAME_COUNT = 120
+	};
+
+	static inline bool IsEnabled()
+	{
+		return m_enabled;
+	}
+
+	static void SetEnabled(bool enabled);
+
+	/**
+	 * Changes the number of frames kept in the ring buffer, the recorded
+	 * frames are discarded.
+	 */
+	static void SetFrameCount(unsigned int count);
+	static unsigned int GetFrameCount();
+
+	/**
+	 * Writes the ring buffer to a file as soon as a frame lasts more than
+	 * threshold seconds, then waits for the ring buffer to be refilled
+	 * before the next dump.
+	 * \param threshold		The frame duration in seconds, 0 disables the dump.
+	 * \param filepath		The trace file to write, NULL or empty for "hitch_trace.json".
+	 */
+	static void SetHitchThreshold(double threshold, const char *filepath);
+	static double GetHitchThreshold();
+
+	/**
+	 * Opens a zone on the calling thread, name must outlive the recorded
+	 * frames, see InternName for names not known at compile time.
+	 */
+	static void BeginZone(const char *name);
+	/// Closes the last zone opened on the calling thread.
+	static void EndZone();
+
+	/// Returns a copy of name which lives until the end of the program, callers can keep it.
+	static const char *InternName(const char *name);
+
+	/**
+	 * Closes the current frame, must be called by the main thread once
+	 * per engine frame.
+	 * \param now	The current time in seconds.
+	 */
+	static void NextFrame(double now);
+
+	/**
+	 * Writes the recorded frames as Chrome trace-event JSON.
+	 * \return false if the file can't be written.
+	 */
+	static bool WriteChromeTrace(const char *filepath);
+
+	/**
+	 * Discards all the recorded frames and empties the thread buffers, the zones
+	 * still open are dropped. The buffers stay allocated for their thread until
+	 * the program exits, as the interned names.
+	 */
+	static void Clear();
+
+private:
+	static bool m_enabled;
+};
+
+/**
+ * Opens a profiler zone for the lifetime of the object.
+ */
+class KX_ProfileZone
+{
+public:
+	KX_ProfileZone(const char *name)
+		:m_active(KX_Profiler::IsEnabled())
+	{
+		if (m_active) {
+			KX_Profiler::BeginZone(name);
+		}
+	}
+
+	~KX_ProfileZone()
+	{
+		if (m_active) {
+			KX_Profiler::EndZone();
+		}
+	}
+
+private:
+	bool m_active;
+};
+
+#define KX_PROFILE_CONCAT_IMPL(a, b) a##b
+#define KX_PROFILE_CONCAT(a, b) KX_PROFILE_CONCAT_IMPL(a, b)
+
+/// Profiles the rest of the enclosing scope as a zone named name.
+#define KX_PROFILE_ZONE(name) KX_ProfileZone KX_PROFILE_CONCAT(profile_zone_, __LINE__)(name)
+
+#endif  /* __KX_PROFILER_H__ */
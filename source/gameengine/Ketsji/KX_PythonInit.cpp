@@ -77,6 +77,7 @@ extern "C" {
 #include "KX_PyConstraintBinding.h"
 
 #include "KX_KetsjiEngine.h"
+#include "KX_Profiler.h"
 #include "KX_RadarSensor.h"
 #include "KX_RaySensor.h"
 #include "KX_ArmatureSensor.h"
@@ -117,6 +118,7 @@ extern "C" {
 
 #include "BL_Shader.h"
 #include "BL_Action.h"
+#include "KX_TerrainDeformation.h"
 
 #include "KX_PyMath.h"
 
@@ -401,6 +403,71 @@ static PyObject *gPyGetProfileInfo(PyObject *)
 	return gp_KetsjiEngine->GetPyProfileDict();
 }
 
+PyDoc_STRVAR(gPySetProfileZones_doc,
+"setProfileZones(enable, frames=120)\n"
+"Enables or disables the zone profiler, which records the last frames"
+);
+static PyObject *gPySetProfileZones(PyObject *, PyObject *args)
+{
+	int enable;
+	int frames = KX_Profiler::DEFAULT_FRAME_COUNT;
+
+	if (!PyArg_ParseTuple(args, "i|i:setProfileZones", &enable, &frames))
+		return NULL;
+
+	if (frames < 1) {
+		PyErr_SetString(PyExc_ValueError, "setProfileZones(enable, frames): frames must be greater than zero");
+		return NULL;
+	}
+
+	if ((unsigned int)frames != KX_Profiler::GetFrameCount())
+		KX_Profiler::SetFrameCount(frames);
+	KX_Profiler::SetEnabled(enable != 0);
+	Py_RETURN_NONE;
+}
+
+PyDoc_STRVAR(gPyDumpProfileTrace_doc,
+"dumpProfileTrace(filepath)\n"
+"Writes the frames recorded by the zone profiler as Chrome trace-event JSON"
+);
+static PyObject *gPyDumpProfileTrace(PyObject *, PyObject *args)
+{
+	char expanded[FILE_MAX];
+	char *filepath;
+
+	if (!PyArg_ParseTuple(args, "s:dumpProfileTrace", &filepath))
+		return NULL;
+
+	BLI_strncpy(expanded, filepath, FILE_MAX);
+	BLI_path_abs(expanded, gp_GamePythonPath);
+
+	if (!KX_Profiler::WriteChromeTrace(expanded)) {
+		PyErr_Format(PyExc_IOError, "dumpProfileTrace(filepath): could not write \"%s\"", expanded);
+		return NULL;
+	}
+	Py_RETURN_NONE;
+}
+
+PyDoc_STRVAR(gPySetProfileHitchThreshold_doc,
+"setProfileHitchThreshold(threshold, filepath=\"//hitch_trace.json\")\n"
+"Dumps the zone profiler frames when a frame lasts more than threshold milliseconds, 0 disables it"
+);
+static PyObject *gPySetProfileHitchThreshold(PyObject *, PyObject *args)
+{
+	char expanded[FILE_MAX];
+	float threshold;
+	const char *filepath = "//hitch_trace.json";
+
+	if (!PyArg_ParseTuple(args, "f|s:setProfileHitchThreshold", &threshold, &filepath))
+		return NULL;
+
+	BLI_strncpy(expanded, filepath, FILE_MAX);
+	BLI_path_abs(expanded, gp_GamePythonPath);
+
+	KX_Profiler::SetHitchThreshold((threshold > 0.0f) ? threshold / 1000.0 : 0.0, expanded);
+	Py_RETURN_NONE;
+}
+
 PyDoc_STRVAR(gPySendMessage_doc,
 "sendMessage(subject, [body, to, from])\n"
 "sends a message in same manner as a message actuator"
@@ -915,6 +982,9 @@ static struct PyMethodDef game_methods[] = {
 	{"PrintMemInfo", (PyCFunction)pyPrintStats, METH_NOARGS, (const char *)"Print engine statistics"},
 	{"NextFrame", (PyCFunction)gPyNextFrame, METH_NOARGS, (const char *)"Render next frame (if Python has control)"},
 	{"getProfileInfo", (PyCFunction)gPyGetProfileInfo, METH_NOARGS, gPyGetProfileInfo_doc},
+	{"setProfileZones", (PyCFunction)gPySetProfileZones, METH_VARARGS, gPySetProfileZones_doc},
+	{"dumpProfileTrace", (PyCFunction)gPyDumpProfileTrace, METH_VARARGS, gPyDumpProfileTrace_doc},
+	{"setProfileHitchThreshold", (PyCFunction)gPySetProfileHitchThreshold, METH_VARARGS, gPySetProfileHitchThreshold_doc},
 	/* library functions */
 	{"LibLoad", (PyCFunction)gLibLoad, METH_VARARGS|METH_KEYWORDS, (const char *)""},
 	{"LibNew", (PyCFunction)gLibNew, METH_VARARGS, (const char *)""},
@@ -1884,6 +1954,12 @@ PyMODINIT_FUNC initGameLogicPythonBinding()
 	KX_MACRO_addTypesToDict(d, KX_ACTION_BLEND_BLEND, BL_Action::ACT_BLEND_BLEND);
 	KX_MACRO_addTypesToDict(d, KX_ACTION_BLEND_ADD, BL_Action::ACT_BLEND_ADD);
 
+	/* KX_Terrain deformation brushes */
+	KX_MACRO_addTypesToDict(d, KX_TERRAIN_DEFORM_RAISE, KX_TerrainDeformation::BRUSH_RAISE);
+	KX_MACRO_addTypesToDict(d, KX_TERRAIN_DEFORM_LOWER, KX_TerrainDeformation::BRUSH_LOWER);
+	KX_MACRO_addTypesToDict(d, KX_TERRAIN_DEFORM_FLATTEN, KX_TerrainDeformation::BRUSH_FLATTEN);
+	KX_MACRO_addTypesToDict(d, KX_TERRAIN_DEFORM_SMOOTH, KX_TerrainDeformation::BRUSH_SMOOTH);
+
 	/* Mouse Actuator object axis*/
 	KX_MACRO_addTypesToDict(d, KX_ACT_MOUSE_OBJECT_AXIS_X, KX_MouseActuator::KX_ACT_MOUSE_OBJECT_AXIS_X);
 	KX_MACRO_addTypesToDict(d, KX_ACT_MOUSE_OBJECT_AXIS_Y, KX_MouseActuator::KX_ACT_MOUSE_OBJECT_AXIS_Y);
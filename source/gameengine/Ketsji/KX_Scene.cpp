@@ -87,6 +87,7 @@
 #include "PHY_IPhysicsEnvironment.h"
 #include "PHY_IGraphicController.h"
 #include "PHY_IPhysicsController.h"
+#include "PHY_IOcclusionBuffer.h"
 #include "KX_BlenderSceneConverter.h"
 #include "KX_MotionState.h"
 
@@ -107,6 +108,7 @@
 #include "KX_Terrain.h"
 
 #include <stdio.h>
+#include <stdint.h>
 
 #include "BLI_task.h"
 
@@ -127,20 +129,305 @@ static void *KX_SceneDestructionFunc(SG_IObject* node,void* gameobj,void* scene)
 	return NULL;
 };
 
+/**
+ * The scheduled nodes of one root hierarchy. A group is updated by a single
+ * task so parents are still updated before their children.
+ */
+struct KX_SceneGraphUpdateGroup
+{
+	/// Same use as KX_Scene::m_sghead, but private to the group.
+	SG_QList m_head;
+	/// Objects whose physics and culling transforms are synchronized after the update.
+	std::vector<KX_GameObject *> m_transformed;
+	/// Animated objects of the hierarchy in the animated list order, see UpdateAnimations.
+	std::vector<KX_GameObject *> m_animated;
+	/// Updated on the calling thread because a controller of the group is not thread safe.
+	bool m_serial;
+
+#ifdef WITH_CXX_GUARDEDALLOC
+	MEM_CXX_CLASS_ALLOC_FUNCS("GE:KX_SceneGraphUpdateGroup")
+#endif
+};
+
+#ifdef _MSC_VER
+#  define KX_THREAD_LOCAL __declspec(thread)
+#else
+#  define KX_THREAD_LOCAL __thread
+#endif
+
+/// The group updated by the current thread, NULL outside of a parallel scenegraph update.
+static KX_THREAD_LOCAL KX_SceneGraphUpdateGroup *sg_update_group = NULL;
+
+/** True while the animation threads evaluate the controllers of their object, the
+ * nodes are not scheduled as UpdateAnimations updates them right after.
+ */
+static KX_THREAD_LOCAL bool sg_schedule_disabled = false;
+
+/// Below this number of groups the scenegraph is updated on the calling thread.
+static const unsigned int sg_update_min_parallel_groups = 8;
+
 bool KX_Scene::KX_ScenegraphUpdateFunc(SG_IObject* node,void* gameobj,void* scene)
 {
-	return ((SG_Node*)node)->Schedule(((KX_Scene*)scene)->m_sghead);
+	if (sg_schedule_disabled) {
+		return false;
+	}
+
+	SG_QList& head = (sg_update_group) ? sg_update_group->m_head : ((KX_Scene*)scene)->m_sghead;
+	return ((SG_Node*)node)->Schedule(head);
 }
 
 bool KX_Scene::KX_ScenegraphRescheduleFunc(SG_IObject* node,void* gameobj,void* scene)
 {
-	return ((SG_Node*)node)->Reschedule(((KX_Scene*)scene)->m_sghead);
+	SG_QList& head = (sg_update_group) ? sg_update_group->m_head : ((KX_Scene*)scene)->m_sghead;
+	return ((SG_Node*)node)->Reschedule(head);
+}
+
+void KX_Scene::KX_ScenegraphTransformFunc(SG_IObject* node,void* gameobj,void* scene)
+{
+	// Physics and culling trees are not thread safe, defer to the end of the update.
+	if (sg_update_group) {
+		sg_update_group->m_transformed.push_back((KX_GameObject*)gameobj);
+	}
+	else {
+		((KX_GameObject*)gameobj)->UpdateTransform();
+	}
+}
+
+/** The groups by root node, an open addressing table owned by the scene so the updates
+ * don't allocate. Clear only changes the stamp of the used entries.
+ */
+struct KX_SceneGraphUpdateGroupTable
+{
+	struct Entry
+	{
+		const SG_Node *m_root;
+		KX_SceneGraphUpdateGroup *m_group;
+		/// The entry is used if its stamp is the one of the table.
+		unsigned int m_stamp;
+	};
+
+	std::vector<Entry> m_entries;
+	unsigned int m_count;
+	unsigned int m_stamp;
+
+	KX_SceneGraphUpdateGroupTable()
+		:m_entries(64),
+		m_count(0),
+		m_stamp(1)
+	{
+	}
+
+	void Clear()
+	{
+		m_count = 0;
+		if (++m_stamp == 0) {
+			// The stamp wrapped, the entries of the first stamps would be used again.
+			for (std::vector<Entry>::iterator it = m_entries.begin(); it != m_entries.end(); ++it) {
+				it->m_stamp = 0;
+			}
+			m_stamp = 1;
+		}
+	}
+
+	/// The entry of a root, added with a NULL group if it is not in the table.
+	Entry& Insert(const SG_Node *root)
+	{
+		// Keep the table half empty so the probes stay short.
+		if ((m_count + 1) * 2 > m_entries.size()) {
+			Grow();
+		}
+
+		Entry& entry = Probe(root);
+		if (entry.m_stamp != m_stamp) {
+			entry.m_root = root;
+			entry.m_group = NULL;
+			entry.m_stamp = m_stamp;
+			++m_count;
+		}
+		return entry;
+	}
+
+	/// The group of a root, NULL if the root is not in the table.
+	KX_SceneGraphUpdateGroup *Find(const SG_Node *root)
+	{
+		Entry& entry = Probe(root);
+		return (entry.m_stamp == m_stamp) ? entry.m_group : NULL;
+	}
+
+private:
+	/// The entry of a root or the unused entry where it is added.
+	Entry& Probe(const SG_Node *root)
+	{
+		const size_t mask = m_entries.size() - 1;
+		// The lowest bits are the same for every node because of the allocation alignment.
+		size_t index = (size_t)((((uintptr_t)root) >> 4) * 2654435761u) & mask;
+		while (m_entries[index].m_stamp == m_stamp && m_entries[index].m_root != root) {
+			index = (index + 1) & mask;
+		}
+		return m_entries[index];
+	}
+
+	void Grow()
+	{
+		std::vector<Entry> entries(m_entries.size() * 2);
+		m_entries.swap(entries);
+
+		const unsigned int stamp = m_stamp;
+		m_stamp = 1;
+		for (std::vector<Entry>::iterator it = entries.begin(); it != entries.end(); ++it) {
+			if (it->m_stamp == stamp) {
+				Entry& entry = Probe(it->m_root);
+				entry = *it;
+				entry.m_stamp = m_stamp;
+			}
+		}
+	}
+
+#ifdef WITH_CXX_GUARDEDALLOC
+	MEM_CXX_CLASS_ALLOC_FUNCS("GE:KX_SceneGraphUpdateGroupTable")
+#endif
+};
+
+/// The group of a root hierarchy, the groups are reused between updates.
+static KX_SceneGraphUpdateGroup *get_update_group(KX_SceneGraphUpdateGroupTable& table,
+                                                  std::vector<KX_SceneGraphUpdateGroup *>& groups,
+                                                  unsigned int& numgroups, const SG_Node *root)
+{
+	KX_SceneGraphUpdateGroupTable::Entry& entry = table.Insert(root);
+	if (!entry.m_group) {
+		if (numgroups == groups.size()) {
+			groups.push_back(new KX_SceneGraphUpdateGroup());
+		}
+		entry.m_group = groups[numgroups++];
+		entry.m_group->m_serial = false;
+		entry.m_group->m_animated.clear();
+	}
+	return entry.m_group;
+}
+
+/// True if a node or one of its children has a controller to update that is not thread safe.
+static bool sg_node_has_unsafe_controllers(SG_Node *node)
+{
+	if (node->HasUnsafeControllers(true)) {
+		return true;
+	}
+
+	NodeList& children = node->GetSGChildren();
+	for (NodeList::iterator it = children.begin(); it != children.end(); ++it) {
+		if (sg_node_has_unsafe_controllers(*it)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/// Updates the scheduled nodes of a group, for UpdateParents.
+static void update_group_nodes(KX_SceneGraphUpdateGroup *group, double curtime)
+{
+	SG_Node* node;
+	while ((node = SG_Node::GetNextScheduled(group->m_head)) != NULL)
+	{
+		node->UpdateWorldData(curtime);
+	}
+}
+
+/// Updates the animated objects of a group, for UpdateAnimations.
+static void update_group_animations(KX_SceneGraphUpdateGroup *group, double curtime)
+{
+	for (std::vector<KX_GameObject *>::iterator it = group->m_animated.begin(); it != group->m_animated.end(); ++it) {
+		KX_GameObject *gameobj = *it;
+		if (group->m_serial) {
+			// Applies again the IPO frames of the objects evaluated in parallel, in the list order.
+			gameobj->UpdateActionIPOs();
+		}
+		else {
+			gameobj->GetSGNode()->UpdateWorldData(curtime);
+			group->m_transformed.push_back(gameobj);
+			gameobj->EndActionIPOs();
+		}
+	}
+}
+
+typedef void (*KX_SceneGraphUpdateGroupFunc)(KX_SceneGraphUpdateGroup *group, double curtime);
+
+struct KX_SceneGraphUpdateTask
+{
+	KX_SceneGraphUpdateGroupFunc m_func;
+	double m_curtime;
+};
+
+static void update_group_thread_func(TaskPool *pool, void *taskdata, int UNUSED(threadid))
+{
+	KX_SceneGraphUpdateGroup *group = (KX_SceneGraphUpdateGroup *)taskdata;
+	const KX_SceneGraphUpdateTask *task = (KX_SceneGraphUpdateTask *)BLI_task_pool_userdata(pool);
+
+	sg_update_group = group;
+	task->m_func(group, task->m_curtime);
+	sg_update_group = NULL;
+}
+
+/** Runs func for each group, in parallel when there are enough groups. The groups
+ * that are not thread safe run on the calling thread once the others are done.
+ */
+static void run_update_groups(TaskScheduler *scheduler, const std::vector<KX_SceneGraphUpdateGroup *>& groups,
+                              unsigned int numgroups, double curtime, KX_SceneGraphUpdateGroupFunc func)
+{
+	KX_SceneGraphUpdateTask task;
+	task.m_func = func;
+	task.m_curtime = curtime;
+
+	const bool parallel = (numgroups >= sg_update_min_parallel_groups);
+	if (parallel) {
+		TaskPool *pool = BLI_task_pool_create(scheduler, &task);
+		for (unsigned int i = 0; i < numgroups; ++i) {
+			if (!groups[i]->m_serial) {
+				BLI_task_pool_push(pool, update_group_thread_func, groups[i], false, TASK_PRIORITY_LOW);
+			}
+		}
+		BLI_task_pool_work_and_wait(pool);
+		BLI_task_pool_free(pool);
+	}
+
+	for (unsigned int i = 0; i < numgroups; ++i) {
+		if (!parallel || groups[i]->m_serial) {
+			sg_update_group = groups[i];
+			func(groups[i], curtime);
+			sg_update_group = NULL;
+		}
+	}
+}
+
+/** Synchronizes the groups in their order so the result doesn't depend on the thread
+ * scheduling, and gives back their remaining scheduled nodes to the scene list.
+ */
+static void sync_update_groups(const std::vector<KX_SceneGraphUpdateGroup *>& groups, unsigned int numgroups,
+                               SG_QList& head)
+{
+	SG_Node* node;
+	for (unsigned int i = 0; i < numgroups; ++i) {
+		KX_SceneGraphUpdateGroup *group = groups[i];
+		for (std::vector<KX_GameObject *>::iterator it = group->m_transformed.begin();
+		     it != group->m_transformed.end(); ++it)
+		{
+			(*it)->UpdateTransform();
+		}
+		group->m_transformed.clear();
+
+		while ((node = SG_Node::GetNextScheduled(group->m_head)) != NULL)
+		{
+			node->Schedule(head);
+		}
+		while ((node = SG_Node::GetNextRescheduled(group->m_head)) != NULL)
+		{
+			node->Reschedule(head);
+		}
+	}
 }
 
 SG_Callbacks KX_Scene::m_callbacks = SG_Callbacks(
 	KX_SceneReplicationFunc,
 	KX_SceneDestructionFunc,
-	KX_GameObject::UpdateTransformFunc,
+	KX_Scene::KX_ScenegraphTransformFunc,
 	KX_Scene::KX_ScenegraphUpdateFunc,
 	KX_Scene::KX_ScenegraphRescheduleFunc);
 
@@ -168,6 +455,9 @@ KX_Scene::KX_Scene(class SCA_IInputDevice* keyboarddevice,
 	m_lodHysteresisValue(0),
 	m_terrain(NULL)
 {
+	m_sgUpdateGroupTable = new KX_SceneGraphUpdateGroupTable();
+	m_taskScheduler = NULL;
+
 	m_suspendedtime = 0.0;
 	m_suspendeddelta = 0.0;
 
@@ -292,6 +582,13 @@ KX_Scene::~KX_Scene()
 	if (m_animatedlist)
 		m_animatedlist->Release();
 
+	for (std::vector<KX_SceneGraphUpdateGroup *>::iterator it = m_sgUpdateGroups.begin();
+	     it != m_sgUpdateGroups.end(); ++it)
+	{
+		delete *it;
+	}
+	delete m_sgUpdateGroupTable;
+
 	if (m_logicmgr)
 		delete m_logicmgr;
 
@@ -1543,6 +1840,11 @@ void KX_Scene::PhysicsCullingCallback(KX_ClientObjectInfo *objectInfo, void* cul
 	gameobj->UpdateBuckets(false);
 }
 
+static void TerrainOccluderCallback(PHY_IOcclusionBuffer *buffer, void *userData)
+{
+	((KX_Terrain *)userData)->AddOccluders(buffer);
+}
+
 void KX_Scene::CalculateVisibleMeshes(RAS_IRasterizer* rasty,KX_Camera* cam, int layer)
 {
 	bool dbvt_culling = false;
@@ -1575,9 +1877,14 @@ void KX_Scene::CalculateVisibleMeshes(RAS_IRasterizer* rasty,KX_Camera* cam, int
 		double pmat[16] = {0};
 		cam->GetProjectionMatrix().getValue(pmat);
 
+		// the terrain chunks hide the objects behind them
+		const bool terrainOccluder = (m_terrain && m_terrain->GetOccluder());
+
 		dbvt_culling = m_physicsEnvironment->CullingTest(PhysicsCullingCallback,&info,planes,5,m_dbvt_occlusion_res,
 		                                                 KX_GetActiveEngine()->GetCanvas()->GetViewPort(),
-		                                                 mvmat, pmat);
+		                                                 mvmat, pmat,
+		                                                 (terrainOccluder) ? TerrainOccluderCallback : NULL,
+		                                                 m_terrain);
 	}
 	if (!dbvt_culling) {
 		// the physics engine couldn't help us, do it the hard way
@@ -1627,14 +1934,25 @@ void KX_Scene::AddAnimatedObject(CValue* gameobj)
 	m_animatedlist->Add(gameobj);
 }
 
+/// Per object state shared by the animation update phases.
+struct KX_AnimationTask
+{
+	KX_GameObject *m_gameobj;
+	/// True when the actions were evaluated and must be applied.
+	bool m_updated;
+	/// True when the IPO frames were applied to the local transform of the object.
+	bool m_evaluated;
+};
+
 static void update_anim_thread_func(TaskPool *pool, void *taskdata, int UNUSED(threadid))
 {
-	KX_GameObject *gameobj, *child, *parent;
+	KX_AnimationTask *task = (KX_AnimationTask*)taskdata;
+	KX_GameObject *gameobj, *child;
 	CListValue *children;
 	bool needs_update;
 	double curtime = *(double*)BLI_task_pool_userdata(pool);
 
-	gameobj = (KX_GameObject*)taskdata;
+	gameobj = task->m_gameobj;
 
 	// Non-armature updates are fast enough, so just update them
 	needs_update = gameobj->GetGameObjectType() != SCA_IObject::OBJ_ARMATURE;
@@ -1670,36 +1988,116 @@ static void update_anim_thread_func(TaskPool *pool, void *taskdata, int UNUSED(t
 		children->Release();
 	}
 
+	task->m_updated = needs_update;
+	task->m_evaluated = false;
+
 	if (needs_update) {
+		// Evaluates poses, shapes and IPO frames.
 		gameobj->UpdateActionManager(curtime);
-		children = gameobj->GetChildren();
-		parent = gameobj->GetParent();
 
-		// Only do deformers here if they are not parented to an armature, otherwise the armature will
-		// handle updating its children
-		if (gameobj->GetDeformer() && (!parent || (parent && parent->GetGameObjectType() != SCA_IObject::OBJ_ARMATURE)))
-			gameobj->GetDeformer()->Update();
+		// The IPO controllers of the object only write its local transform.
+		sg_schedule_disabled = true;
+		task->m_evaluated = gameobj->EvaluateActionIPOs();
+		sg_schedule_disabled = false;
+	}
+}
+
+static void update_deformers_thread_func(TaskPool *pool, void *taskdata, int UNUSED(threadid))
+{
+	KX_AnimationTask *task = (KX_AnimationTask*)taskdata;
+	KX_GameObject *gameobj, *child, *parent;
+	CListValue *children;
 
-		for (int j=0; j<children->GetCount(); ++j) {
-			child = (KX_GameObject*)children->GetValue(j);
+	if (!task->m_updated)
+		return;
 
-			if (child->GetDeformer()) {
-				child->GetDeformer()->Update();
-			}
-		}
+	gameobj = task->m_gameobj;
+	children = gameobj->GetChildren();
+	parent = gameobj->GetParent();
 
-		children->Release();
+	// Only do deformers here if they are not parented to an armature, otherwise the armature will
+	// handle updating its children
+	if (gameobj->GetDeformer() && (!parent || (parent && parent->GetGameObjectType() != SCA_IObject::OBJ_ARMATURE)))
+		gameobj->GetDeformer()->Update();
+
+	for (int j=0; j<children->GetCount(); ++j) {
+		child = (KX_GameObject*)children->GetValue(j);
+
+		if (child->GetDeformer()) {
+			child->GetDeformer()->Update();
+		}
 	}
+
+	children->Release();
 }
 
 void KX_Scene::UpdateAnimations(double curtime)
 {
-	TaskPool *pool = BLI_task_pool_create(KX_GetActiveEngine()->GetTaskScheduler(), &curtime);
+	const int count = m_animatedlist->GetCount();
+	if (count == 0)
+		return;
+
+	std::vector<KX_AnimationTask> tasks(count);
+	TaskScheduler *scheduler = m_taskScheduler;
 
-	for (int i=0; i<m_animatedlist->GetCount(); ++i) {
-		BLI_task_pool_push(pool, update_anim_thread_func, m_animatedlist->GetValue(i), false, TASK_PRIORITY_LOW);
+	/* Evaluate the actions of every object in parallel, and their IPO frames
+	 * into the local transform of the object when possible.
+	 */
+	TaskPool *pool = BLI_task_pool_create(scheduler, &curtime);
+	for (int i=0; i<count; ++i) {
+		tasks[i].m_gameobj = (KX_GameObject*)m_animatedlist->GetValue(i);
+		tasks[i].m_updated = false;
+		tasks[i].m_evaluated = false;
+		BLI_task_pool_push(pool, update_anim_thread_func, &tasks[i], false, TASK_PRIORITY_LOW);
 	}
+	BLI_task_pool_work_and_wait(pool);
+	BLI_task_pool_free(pool);
+
+	/* Update the world transforms per root hierarchy. A hierarchy with an object
+	 * whose IPO frames were not evaluated applies all of its IPO frames on the
+	 * calling thread in the list order, as they write the children or the physics.
+	 */
+	KX_SceneGraphUpdateGroupTable& table = *m_sgUpdateGroupTable;
+	table.Clear();
+	unsigned int numgroups = 0;
+	for (int i=0; i<count; ++i) {
+		if (!tasks[i].m_updated)
+			continue;
 
+		KX_GameObject *gameobj = tasks[i].m_gameobj;
+		KX_SceneGraphUpdateGroup *group = get_update_group(table, m_sgUpdateGroups, numgroups,
+		                                                   gameobj->GetSGNode()->GetRootSGParent());
+		group->m_animated.push_back(gameobj);
+		if (!group->m_serial && (!tasks[i].m_evaluated || sg_node_has_unsafe_controllers(gameobj->GetSGNode())))
+			group->m_serial = true;
+	}
+
+	if (numgroups > 0) {
+		/* The scheduled nodes of these hierarchies are moved to their group as the
+		 * world update removes them from their list.
+		 */
+		std::vector<SG_Node *> scheduled;
+		SG_DList::iterator<SG_Node> sgit(m_sghead);
+		for (sgit.begin(); !sgit.end(); ++sgit) {
+			if (table.Find((*sgit)->GetRootSGParent())) {
+				scheduled.push_back(*sgit);
+			}
+		}
+		for (std::vector<SG_Node *>::iterator it = scheduled.begin(); it != scheduled.end(); ++it) {
+			SG_Node *node = *it;
+			node->Delink();
+			table.Find(node->GetRootSGParent())->m_head.AddBack(node);
+		}
+
+		run_update_groups(scheduler, m_sgUpdateGroups, numgroups, curtime, update_group_animations);
+		sync_update_groups(m_sgUpdateGroups, numgroups, m_sghead);
+	}
+
+	// Deformers read the applied poses and transforms.
+	pool = BLI_task_pool_create(scheduler, &curtime);
+	for (int i=0; i<count; ++i) {
+		BLI_task_pool_push(pool, update_deformers_thread_func, &tasks[i], false, TASK_PRIORITY_LOW);
+	}
 	BLI_task_pool_work_and_wait(pool);
 	BLI_task_pool_free(pool);
 }
@@ -1742,9 +2140,39 @@ void KX_Scene::UpdateParents(double curtime)
 	// we use the SG dynamic list
 	SG_Node* node;
 
-	while ((node = SG_Node::GetNextScheduled(m_sghead)) != NULL)
-	{
-		node->UpdateWorldData(curtime);
+	/* Split the scheduled nodes by root hierarchy, keeping the order of the list
+	 * inside a group. Nodes of different hierarchies never read each other. The
+	 * roots are only counted until there are enough of them for a parallel update.
+	 */
+	KX_SceneGraphUpdateGroupTable& table = *m_sgUpdateGroupTable;
+	table.Clear();
+	SG_DList::iterator<SG_Node> sgit(m_sghead);
+	for (sgit.begin(); !sgit.end() && table.m_count < sg_update_min_parallel_groups; ++sgit) {
+		table.Insert((*sgit)->GetRootSGParent());
+	}
+
+	if (table.m_count >= sg_update_min_parallel_groups) {
+		table.Clear();
+		unsigned int numgroups = 0;
+
+		while ((node = SG_Node::GetNextScheduled(m_sghead)) != NULL)
+		{
+			KX_SceneGraphUpdateGroup *group = get_update_group(table, m_sgUpdateGroups, numgroups, node->GetRootSGParent());
+			group->m_head.AddBack(node);
+			// The update of a node runs the controllers of its children too.
+			if (!group->m_serial && sg_node_has_unsafe_controllers(node)) {
+				group->m_serial = true;
+			}
+		}
+
+		run_update_groups(m_taskScheduler, m_sgUpdateGroups, numgroups, curtime, update_group_nodes);
+		sync_update_groups(m_sgUpdateGroups, numgroups, m_sghead);
+	}
+	else {
+		while ((node = SG_Node::GetNextScheduled(m_sghead)) != NULL)
+		{
+			node->UpdateWorldData(curtime);
+		}
 	}
 
 	//for (int i=0; i<GetRootParentList()->GetCount(); i++)
@@ -1866,8 +2294,14 @@ KX_Terrain *KX_Scene::GetTerrain() const
 
 void KX_Scene::CalculateVisibleTerrainChunks()
 {
-	if (m_terrain)
-		m_terrain->CalculateVisibleChunks(m_active_camera);
+	if (m_terrain) {
+		m_terrain->CalculateVisibleChunks(m_active_camera, m_objectlist);
+
+		// the occlusion buffer is filled by the culling test of CalculateVisibleMeshes
+		PHY_IOcclusionBuffer *buffer = (m_dbvt_culling && m_dbvt_occlusion_res) ? m_physicsEnvironment->GetOcclusionBuffer() : NULL;
+		if (buffer && m_terrain->GetOccluder())
+			m_terrain->CalculateOccludedChunks(buffer);
+	}
 }
 
 void KX_Scene::UpdateTerrainChunksMeshes()
@@ -2447,6 +2881,16 @@ PyObject *KX_Scene::pyattr_get_active_camera(void *self_v, const KX_PYATTRIBUTE_
 }
 
 
+PyObject *KX_Scene::pyattr_get_terrain(void *self_v, const KX_PYATTRIBUTE_DEF *attrdef)
+{
+	KX_Scene* self = static_cast<KX_Scene*>(self_v);
+	KX_Terrain* terrain = self->GetTerrain();
+	if (terrain)
+		return terrain->GetProxy();
+	else
+		Py_RETURN_NONE;
+}
+
 int KX_Scene::pyattr_set_active_camera(void *self_v, const KX_PYATTRIBUTE_DEF *attrdef, PyObject *value)
 {
 	KX_Scene* self = static_cast<KX_Scene*>(self_v);
@@ -2567,6 +3011,7 @@ PyAttributeDef KX_Scene::Attributes[] = {
 	KX_PYATTRIBUTE_RO_FUNCTION("cameras",			KX_Scene, pyattr_get_cameras),
 	KX_PYATTRIBUTE_RO_FUNCTION("world",				KX_Scene, pyattr_get_world),
 	KX_PYATTRIBUTE_RW_FUNCTION("active_camera",		KX_Scene, pyattr_get_active_camera, pyattr_set_active_camera),
+	KX_PYATTRIBUTE_RO_FUNCTION("terrain",			KX_Scene, pyattr_get_terrain),
 	KX_PYATTRIBUTE_RW_FUNCTION("pre_draw",			KX_Scene, pyattr_get_drawing_callback_pre, pyattr_set_drawing_callback_pre),
 	KX_PYATTRIBUTE_RW_FUNCTION("post_draw",			KX_Scene, pyattr_get_drawing_callback_post, pyattr_set_drawing_callback_post),
 	KX_PYATTRIBUTE_RW_FUNCTION("pre_draw_setup",	KX_Scene, pyattr_get_drawing_setup_callback_pre, pyattr_set_drawing_setup_callback_pre),
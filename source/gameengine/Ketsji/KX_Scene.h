@@ -58,6 +58,7 @@
 struct SM_MaterialProps;
 struct SM_ShapeProps;
 struct Scene;
+struct TaskScheduler;
 
 class CTR_HashedPtr;
 class CListValue;
@@ -88,6 +89,8 @@ class KX_BlenderSceneConverter;
 struct KX_ClientObjectInfo;
 class KX_ObstacleSimulation;
 class KX_Terrain;
+struct KX_SceneGraphUpdateGroup;
+struct KX_SceneGraphUpdateGroupTable;
 
 #ifdef WITH_CXX_GUARDEDALLOC
 #include "MEM_guardedalloc.h"
@@ -138,6 +141,13 @@ protected:
 										// the Qlist is for objects that needs to be rescheduled
 										// for updates after udpate is over (slow parent, bone parent)
 
+	/// Scenegraph update groups, one per root hierarchy, reused between UpdateParents calls.
+	std::vector<KX_SceneGraphUpdateGroup *> m_sgUpdateGroups;
+	/// Finds the update group of a root node, reused between updates as the groups.
+	KX_SceneGraphUpdateGroupTable *m_sgUpdateGroupTable;
+	/// The scheduler of the engine used by the scenegraph and animation updates.
+	TaskScheduler *m_taskScheduler;
+
 
 	/**
 	 * The set of cameras for this scene
@@ -326,6 +336,12 @@ public:
 	 */
 	static bool KX_ScenegraphUpdateFunc(SG_IObject* node,void* gameobj,void* scene);
 	static bool KX_ScenegraphRescheduleFunc(SG_IObject* node,void* gameobj,void* scene);
+	static void KX_ScenegraphTransformFunc(SG_IObject* node,void* gameobj,void* scene);
+	/**
+	 * Update the world transforms of the scheduled nodes. Independent root
+	 * hierarchies are updated in parallel when there are enough of them, the
+	 * physics and culling transforms are then synchronized on the calling thread.
+	 */
 	void UpdateParents(double curtime);
 	void DupliGroupRecurse(CValue* gameobj, int level);
 	bool IsObjectInGroup(CValue* gameobj)
@@ -583,6 +599,10 @@ public:
 	
 	void SetSceneConverter(class KX_BlenderSceneConverter* sceneConverter);
 
+	/// Must be set before the first scenegraph or animation update.
+	void SetTaskScheduler(TaskScheduler *scheduler) { m_taskScheduler = scheduler; }
+	TaskScheduler *GetTaskScheduler() const { return m_taskScheduler; }
+
 	class PHY_IPhysicsEnvironment*		GetPhysicsEnvironment()
 	{
 		return m_physicsEnvironment;
@@ -639,6 +659,7 @@ public:
 	static PyObject*	pyattr_get_cameras(void* self_v, const KX_PYATTRIBUTE_DEF *attrdef);
 	static PyObject*	pyattr_get_world(void* self_v, const KX_PYATTRIBUTE_DEF *attrdef);
 	static PyObject*	pyattr_get_active_camera(void* self_v, const KX_PYATTRIBUTE_DEF *attrdef);
+	static PyObject*	pyattr_get_terrain(void* self_v, const KX_PYATTRIBUTE_DEF *attrdef);
 	static int			pyattr_set_active_camera(void *self_v, const KX_PYATTRIBUTE_DEF *attrdef, PyObject *value);
 	static PyObject*	pyattr_get_drawing_callback_pre(void *self_v, const KX_PYATTRIBUTE_DEF *attrdef);
 	static int			pyattr_set_drawing_callback_pre(void *selv_v, const KX_PYATTRIBUTE_DEF *attrdef, PyObject *value);
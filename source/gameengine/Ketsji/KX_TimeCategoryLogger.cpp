@@ -131,6 +131,26 @@ double KX_TimeCategoryLogger::GetAverage(void)
 }
 
 
+double KX_TimeCategoryLogger::GetTotal(TimeCategory tc)
+{
+	//assert(m_loggers[tc] != m_loggers.end());
+	return m_loggers[tc]->GetTotal();
+}
+
+
+double KX_TimeCategoryLogger::GetTotal(void)
+{
+	double time = 0.0;
+
+	KX_TimeLoggerMap::iterator it;
+	for (it = m_loggers.begin(); it != m_loggers.end(); it++) {
+		time += it->second->GetTotal();
+	}
+
+	return time;
+}
+
+
 void KX_TimeCategoryLogger::DisposeLoggers(void)
 {
 	KX_TimeLoggerMap::iterator it;
@@ -115,6 +115,16 @@ public:
 	 */
 	virtual double GetAverage(void);
 
+	/**
+	 * Returns the time logged in the given category since its creation.
+	 */
+	virtual double GetTotal(TimeCategory tc);
+
+	/**
+	 * Returns the time logged in all categories.
+	 */
+	virtual double GetTotal(void);
+
 protected:
 	/**  
 	 * Disposes loggers.
@@ -35,7 +35,8 @@
 KX_TimeLogger::KX_TimeLogger(unsigned int maxNumMeasurements) : 
 	m_maxNumMeasurements(maxNumMeasurements), 
 	m_logStart(0),
-	m_logging(false)
+	m_logging(false),
+	m_total(0.0)
 {
 }
 
@@ -74,6 +75,7 @@ void KX_TimeLogger::EndLog(double now)
 	if (m_logging) {
 		m_logging = false;
 		double time = now - m_logStart;
+		m_total += time;
 		if (m_measurements.size() > 0) {
 			m_measurements[0] += time;
 		}
@@ -115,3 +117,8 @@ double KX_TimeLogger::GetAverage(void) const
 	return avg;
 }
 
+double KX_TimeLogger::GetTotal(void) const
+{
+	return m_total;
+}
+
@@ -92,6 +92,11 @@ public:
 	 */
 	virtual double GetAverage(void) const;
 
+	/**
+	 * Returns the time logged since the creation of the logger.
+	 */
+	virtual double GetTotal(void) const;
+
 protected:
 	/** Storage for the measurements. */
 	std::deque<double> m_measurements;
@@ -104,6 +109,8 @@ protected:
 
 	/** State of logging. */
 	bool m_logging;
+	/** Time logged in all measurements, including the dropped ones. */
+	double m_total;
 
 
 #ifdef WITH_CXX_GUARDEDALLOC
@@ -78,6 +78,10 @@ public:
 		m_modified = true;
 	}
 
+	virtual bool IsModified() const {
+		return m_modified;
+	}
+
 	void	SetModifyMistStart(bool modify) {
 		m_modify_mist_start = modify;
 	}
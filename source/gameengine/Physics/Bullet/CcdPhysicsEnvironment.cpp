@@ -38,10 +38,12 @@ subject to the following restrictions:
 
 
 #include "PHY_IMotionState.h"
+#include "PHY_IOcclusionBuffer.h"
 #include "PHY_ICharacter.h"
 #include "PHY_Pro.h"
 #include "KX_GameObject.h"
 #include "KX_PythonInit.h" // for KX_RasterizerDrawDebugLine
+#include "KX_Profiler.h"
 #include "KX_BlenderSceneConverter.h"
 #include "RAS_MeshObject.h"
 #include "RAS_Polygon.h"
@@ -404,6 +406,8 @@ static void DrawAabb(btIDebugDraw* debugDrawer,const btVector3& from,const btVec
 CcdPhysicsEnvironment::CcdPhysicsEnvironment(bool useDbvtCulling,btDispatcher* dispatcher,btOverlappingPairCache* pairCache)
 :m_cullingCache(NULL),
 m_cullingTree(NULL),
+m_occlusionBuffer(NULL),
+m_occlusionCulling(false),
 m_numIterations(10),
 m_numTimeSubSteps(1),
 m_ccdMode(0),
@@ -717,6 +721,8 @@ void CcdPhysicsEnvironment::SimulationSubtickCallback(btScalar timeStep)
 
 bool	CcdPhysicsEnvironment::ProceedDeltaTime(double curTime,float timeStep,float interval)
 {
+	KX_PROFILE_ZONE("Physics ProceedDeltaTime");
+
 	std::set<CcdPhysicsController*>::iterator it;
 	int i;
 
@@ -730,7 +736,10 @@ bool	CcdPhysicsEnvironment::ProceedDeltaTime(double curTime,float timeStep,float
 	}
 
 	float subStep = timeStep / float(m_numTimeSubSteps);
-	i = m_dynamicsWorld->stepSimulation(interval,25,subStep);//perform always a full simulation step
+	{
+		KX_PROFILE_ZONE("Physics stepSimulation");
+		i = m_dynamicsWorld->stepSimulation(interval,25,subStep);//perform always a full simulation step
+	}
 //uncomment next line to see where Bullet spend its time (printf in console)
 //CProfileManager::dumpAll();
 
@@ -753,7 +762,10 @@ bool	CcdPhysicsEnvironment::ProceedDeltaTime(double curTime,float timeStep,float
 	}
 
 
-	CallbackTriggers();
+	{
+		KX_PROFILE_ZONE("Physics CallbackTriggers");
+		CallbackTriggers();
+	}
 
 	return true;
 }
@@ -1401,7 +1413,7 @@ PHY_IPhysicsController* CcdPhysicsEnvironment::RayTest(PHY_IRayCastFilterCallbac
 
 // Handles occlusion culling. 
 // The implementation is based on the CDTestFramework
-struct OcclusionBuffer
+struct OcclusionBuffer : public PHY_IOcclusionBuffer
 {
 	struct WriteOCL
 	{
@@ -1431,6 +1443,11 @@ struct OcclusionBuffer
 		m_buffer = NULL;
 		m_bufferSize = 0;
 	}
+	~OcclusionBuffer()
+	{
+		if (m_buffer)
+			free(m_buffer);
+	}
 	// multiplication of column major matrices: m=m1*m2
 	template<typename T1, typename T2>
 	void		CMmat4mul(btScalar* m, const T1* m1, const T2* m2)
@@ -1505,7 +1522,7 @@ struct OcclusionBuffer
 		m_initialized = true;
 		m_occlusion = false;
 	}
-	void		SetModelMatrix(double *fl)
+	virtual void	SetModelMatrix(double *fl)
 	{
 		CMmat4mul(m_mtc,m_wtc,fl);
 		if (!m_initialized)
@@ -1822,6 +1839,15 @@ struct OcclusionBuffer
 		transformM(d,p[3]);
 		clipDraw<4,WriteOCL>(p,face,btScalar(0.f));
 	}
+	// PHY_IOcclusionBuffer interface, used by occluders that are not in the culling tree
+	virtual void	AppendOccluder(const float *v1, const float *v2, const float *v3)
+	{
+		appendOccluderM(v1, v2, v3, 0.0f);
+	}
+	virtual bool	QueryBox(const MT_Vector3& center, const MT_Vector3& extents)
+	{
+		return queryOccluderW(btVector3(center.x(), center.y(), center.z()), btVector3(extents.x(), extents.y(), extents.z()));
+	}
 	// query occluder for a box (c=center, e=extend) in world coordinate
 	inline bool	queryOccluderW(	const btVector3& c,
 								const btVector3& e)
@@ -1936,9 +1962,10 @@ struct	DbvtCullingCallback : btDbvt::ICollide
 	}
 };
 
-static OcclusionBuffer gOcb;
-bool CcdPhysicsEnvironment::CullingTest(PHY_CullingCallback callback, void* userData, MT_Vector4 *planes, int nplanes, int occlusionRes, const int *viewport, double modelview[16], double projection[16])
+bool CcdPhysicsEnvironment::CullingTest(PHY_CullingCallback callback, void* userData, MT_Vector4 *planes, int nplanes, int occlusionRes, const int *viewport, double modelview[16], double projection[16],
+                                        PHY_OccluderCallback occluderCallback, void *occluderUserData)
 {
+	m_occlusionCulling = false;
 	if (!m_cullingTree)
 		return false;
 	DbvtCullingCallback dispatcher(callback, userData);
@@ -1954,8 +1981,16 @@ bool CcdPhysicsEnvironment::CullingTest(PHY_CullingCallback callback, void* user
 	// if occlusionRes != 0 => occlusion culling
 	if (occlusionRes)
 	{
-		gOcb.setup(occlusionRes, viewport, modelview, projection);
-		dispatcher.m_ocb = &gOcb;
+		// each environment (i.e each scene) owns its buffer, so that the buffer read
+		// back through GetOcclusionBuffer() is the one filled for this scene
+		if (!m_occlusionBuffer)
+			m_occlusionBuffer = new OcclusionBuffer();
+		m_occlusionBuffer->setup(occlusionRes, viewport, modelview, projection);
+		dispatcher.m_ocb = m_occlusionBuffer;
+		m_occlusionCulling = true;
+		// extra occluders go first so that they can hide the objects of the culling tree
+		if (occluderCallback)
+			(*occluderCallback)(m_occlusionBuffer, occluderUserData);
 		// occlusion culling, the direction of the view is taken from the first plan which MUST be the near plane
 		btDbvt::collideOCL(m_cullingTree->m_sets[1].m_root,planes_n,planes_o,planes_n[0],nplanes,dispatcher);
 		btDbvt::collideOCL(m_cullingTree->m_sets[0].m_root,planes_n,planes_o,planes_n[0],nplanes,dispatcher);
@@ -1967,6 +2002,11 @@ bool CcdPhysicsEnvironment::CullingTest(PHY_CullingCallback callback, void* user
 	return true;
 }
 
+PHY_IOcclusionBuffer *CcdPhysicsEnvironment::GetOcclusionBuffer()
+{
+	return (m_occlusionCulling) ? m_occlusionBuffer : NULL;
+}
+
 int	CcdPhysicsEnvironment::GetNumContactPoints()
 {
 	return 0;
@@ -2024,6 +2064,9 @@ CcdPhysicsEnvironment::~CcdPhysicsEnvironment()
 	//delete m_dispatcher;
 	delete m_dynamicsWorld;
 	
+	if (m_occlusionBuffer)
+		delete m_occlusionBuffer;
+
 
 	if (NULL != m_ownPairCache)
 		delete m_ownPairCache;
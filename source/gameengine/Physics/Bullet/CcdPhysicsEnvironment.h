@@ -78,6 +78,8 @@ protected:
 	// for culling only
 	btOverlappingPairCache*				m_cullingCache;
 	struct btDbvtBroadphase*			m_cullingTree;	// broadphase for culling
+	struct OcclusionBuffer*				m_occlusionBuffer;	// software occlusion buffer of this environment, created on first use
+	bool								m_occlusionCulling;	// last culling test used the occlusion buffer
 
 	//solver iterations
 	int	m_numIterations;
@@ -211,7 +213,9 @@ protected:
 		btTypedConstraint*	GetConstraintById(int constraintId);
 
 		virtual PHY_IPhysicsController* RayTest(PHY_IRayCastFilterCallback &filterCallback, float fromX,float fromY,float fromZ, float toX,float toY,float toZ);
-		virtual bool CullingTest(PHY_CullingCallback callback, void* userData, MT_Vector4* planes, int nplanes, int occlusionRes, const int *viewport, double modelview[16], double projection[16]);
+		virtual bool CullingTest(PHY_CullingCallback callback, void* userData, MT_Vector4* planes, int nplanes, int occlusionRes, const int *viewport, double modelview[16], double projection[16],
+		                         PHY_OccluderCallback occluderCallback, void *occluderUserData);
+		virtual PHY_IOcclusionBuffer *GetOcclusionBuffer();
 
 
 		//Methods for gamelogic collision/physics callbacks
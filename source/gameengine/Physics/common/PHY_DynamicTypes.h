@@ -23,6 +23,7 @@ subject to the following restrictions:
 #include "MT_Vector3.h"
 
 struct KX_ClientObjectInfo;
+class PHY_IOcclusionBuffer;
 
 enum
 {
@@ -48,6 +49,7 @@ typedef bool (*PHY_ResponseCallback)(void *client_data,
                                      void *client_object2,
                                      const PHY_CollData *coll_data);
 typedef void (*PHY_CullingCallback)(KX_ClientObjectInfo* info, void* param);
+typedef void (*PHY_OccluderCallback)(PHY_IOcclusionBuffer* buffer, void* param);
 
 
 /// PHY_PhysicsType enumerates all possible Physics Entities.
@@ -0,0 +1,54 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Contributor(s): none yet.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file PHY_IOcclusionBuffer.h
+ *  \ingroup phys
+ */
+
+#ifndef __PHY_IOCCLUSIONBUFFER_H__
+#define __PHY_IOCCLUSIONBUFFER_H__
+
+#include "MT_Vector3.h"
+
+/**
+ * PHY_IOcclusionBuffer is the software depth buffer used by the occlusion culling.
+ * It lets geometry that is not part of the culling tree (like terrain chunks)
+ * be rasterized as occluder and boxes be tested against the buffer.
+ */
+class PHY_IOcclusionBuffer
+{
+	public:
+		virtual ~PHY_IOcclusionBuffer() {}
+
+		/// Set the model to world matrix (column major) used by the next occluders.
+		virtual void SetModelMatrix(double *fl) = 0;
+		/// Rasterize a double sided triangle in model coordinates.
+		virtual void AppendOccluder(const float *v1, const float *v2, const float *v3) = 0;
+		/// Return false if the box (in world coordinates) is completely hidden by the occluders.
+		virtual bool QueryBox(const MT_Vector3& center, const MT_Vector3& extents) = 0;
+
+#ifdef WITH_CXX_GUARDEDALLOC
+	MEM_CXX_CLASS_ALLOC_FUNCS("GE:PHY_IOcclusionBuffer")
+#endif
+};
+
+#endif  /* __PHY_IOCCLUSIONBUFFER_H__ */
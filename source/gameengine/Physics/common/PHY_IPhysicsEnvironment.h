@@ -183,7 +183,11 @@ class PHY_IPhysicsEnvironment
 		//culling based on physical broad phase
 		// the plane number must be set as follow: near, far, left, right, top, botton
 		// the near plane must be the first one and must always be present, it is used to get the direction of the view
-		virtual bool CullingTest(PHY_CullingCallback callback, void *userData, MT_Vector4* planeNormals, int planeNumber, int occlusionRes, const int *viewport, double modelview[16], double projection[16]) = 0;
+		// with occlusion culling, occluderCallback (if not NULL) is called before the culling tree to add extra occluders
+		virtual bool CullingTest(PHY_CullingCallback callback, void *userData, MT_Vector4* planeNormals, int planeNumber, int occlusionRes, const int *viewport, double modelview[16], double projection[16],
+		                         PHY_OccluderCallback occluderCallback, void *occluderUserData) = 0;
+		// the occlusion buffer of the last culling test, NULL if it didn't use occlusion culling
+		virtual PHY_IOcclusionBuffer *GetOcclusionBuffer() { return NULL; }
 
 		//Methods for gamelogic collision/physics callbacks
 		//todo:
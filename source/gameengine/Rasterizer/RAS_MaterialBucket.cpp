@@ -46,6 +46,65 @@
 #include "RAS_MeshObject.h"
 #include "RAS_Deformer.h"	// __NLA
 
+#include "MT_assert.h"
+
+/* index array */
+
+RAS_IndexArray::RAS_IndexArray()
+	:m_users(1),
+	m_storageSlot(NULL)
+{
+}
+
+RAS_IndexArray::~RAS_IndexArray()
+{
+	if (m_storageSlot) {
+		m_storageSlot->Release();
+	}
+}
+
+void RAS_IndexArray::AddRef()
+{
+	++m_users;
+}
+
+void RAS_IndexArray::Release()
+{
+	if (--m_users == 0) {
+		delete this;
+	}
+}
+
+/* display array */
+
+RAS_DisplayArray::RAS_DisplayArray()
+	:m_offset(0),
+	m_type(TRIANGLE),
+	m_users(0),
+	m_sharedIndex(NULL)
+{
+}
+
+RAS_DisplayArray::RAS_DisplayArray(const RAS_DisplayArray& array)
+	:m_offset(array.m_offset),
+	m_vertex(array.m_vertex),
+	m_index(array.m_index),
+	m_type(array.m_type),
+	m_users(array.m_users),
+	m_sharedIndex(array.m_sharedIndex)
+{
+	if (m_sharedIndex) {
+		m_sharedIndex->AddRef();
+	}
+}
+
+RAS_DisplayArray::~RAS_DisplayArray()
+{
+	if (m_sharedIndex) {
+		m_sharedIndex->Release();
+	}
+}
+
 /* mesh slot */
 
 RAS_MeshSlot::RAS_MeshSlot() : SG_QList()
@@ -148,7 +207,7 @@ void RAS_MeshSlot::begin(RAS_MeshSlot::iterator& it)
 
 	it.array = m_displayArrays.empty() ? NULL : m_displayArrays[m_startarray];
 
-	if (it.array == NULL || it.array->m_index.size() == 0 || it.array->m_vertex.size() == 0) {
+	if (it.array == NULL || it.array->GetIndex().size() == 0 || it.array->m_vertex.size() == 0) {
 		it.array = NULL;
 		it.vertex = NULL;
 		it.index = NULL;
@@ -160,10 +219,10 @@ void RAS_MeshSlot::begin(RAS_MeshSlot::iterator& it)
 		startvertex = m_startvertex;
 		endvertex = (m_startarray == m_endarray)? m_endvertex: it.array->m_vertex.size();
 		startindex = m_startindex;
-		endindex = (m_startarray == m_endarray)? m_endindex: it.array->m_index.size();
+		endindex = (m_startarray == m_endarray)? m_endindex: it.array->GetIndex().size();
 
 		it.vertex = &it.array->m_vertex[0];
-		it.index = &it.array->m_index[startindex];
+		it.index = &it.array->GetIndex()[startindex];
 		it.startvertex = startvertex;
 		it.endvertex = endvertex;
 		it.totindex = endindex-startindex;
@@ -189,12 +248,12 @@ void RAS_MeshSlot::next(RAS_MeshSlot::iterator& it)
 		it.array = m_displayArrays[it.arraynum];
 
 		startindex = 0;
-		endindex = (it.arraynum == (size_t)m_endarray)? m_endindex: it.array->m_index.size();
+		endindex = (it.arraynum == (size_t)m_endarray)? m_endindex: it.array->GetIndex().size();
 		startvertex = 0;
 		endvertex = (it.arraynum == (size_t)m_endarray)? m_endvertex: it.array->m_vertex.size();
 
 		it.vertex = &it.array->m_vertex[0];
-		it.index = &it.array->m_index[startindex];
+		it.index = &it.array->GetIndex()[startindex];
 		it.startvertex = startvertex;
 		it.endvertex = endvertex;
 		it.totindex = endindex-startindex;
@@ -219,7 +278,8 @@ void RAS_MeshSlot::SetDisplayArray(int numverts)
 	for (it=m_displayArrays.begin(); it!=m_displayArrays.end(); it++) {
 		darray = *it;
 
-		if (darray->m_type == numverts) {
+		/* arrays drawn with shared indices can't get new polygons */
+		if (darray->m_type == numverts && !darray->m_sharedIndex) {
 			if (darray->m_index.size()+numverts >= RAS_DisplayArray::BUCKET_MAX_INDEX)
 				darray = NULL;
 			else if (darray->m_vertex.size()+numverts >= RAS_DisplayArray::BUCKET_MAX_VERTEX)
@@ -287,6 +347,22 @@ void RAS_MeshSlot::AddPolygonVertex(int offset)
 		m_endindex++;
 }
 
+void RAS_MeshSlot::SetSharedIndexArray(RAS_IndexArray *indexarray)
+{
+	RAS_DisplayArray *darray;
+
+	/* the vertices of the current array are the ones indexed by the
+	 * shared array, it must not have its own polygons */
+	darray = m_currentArray;
+	MT_assert(darray->m_index.empty() && !darray->m_sharedIndex);
+
+	indexarray->AddRef();
+	darray->m_sharedIndex = indexarray;
+
+	if (darray == m_displayArrays[m_endarray])
+		m_endindex = indexarray->m_index.size();
+}
+
 void RAS_MeshSlot::UpdateDisplayArraysOffset()
 {
 	unsigned int offset = 0;
@@ -415,7 +491,7 @@ bool RAS_MeshSlot::Join(RAS_MeshSlot *target, MT_Scalar distance)
 		target->m_displayArrays.push_back(*it);
 		target->m_endarray++;
 		target->m_endvertex = target->m_displayArrays.back()->m_vertex.size();
-		target->m_endindex = target->m_displayArrays.back()->m_index.size();
+		target->m_endindex = target->m_displayArrays.back()->GetIndex().size();
 	}
 
 	if (m_DisplayList) {
@@ -472,7 +548,7 @@ bool RAS_MeshSlot::Split(bool force)
 
 		if (target->m_displayArrays.empty() == false) {
 			target->m_endvertex = target->m_displayArrays.back()->m_vertex.size();
-			target->m_endindex = target->m_displayArrays.back()->m_index.size();
+			target->m_endindex = target->m_displayArrays.back()->GetIndex().size();
 		}
 		else {
 			target->m_endvertex = 0;
@@ -75,6 +75,32 @@ public:
 	virtual void SetModified(bool mod)=0;
 };
 
+/* Indices shared by several display arrays with the same topology,
+ * the storage can then use a single index buffer for all of them. */
+
+class RAS_IndexArray
+{
+public:
+	vector<unsigned short> m_index;
+
+	/* Number of RAS_DisplayArray using this array, plus the owner */
+	int m_users;
+
+	/* Storage data of the indices (e.g the index buffer object),
+	 * released with the array */
+	KX_ListSlot *m_storageSlot;
+
+	RAS_IndexArray();
+	~RAS_IndexArray();
+
+	void AddRef();
+	void Release();
+
+#ifdef WITH_CXX_GUARDEDALLOC
+	MEM_CXX_CLASS_ALLOC_FUNCS("GE:RAS_IndexArray")
+#endif
+};
+
 /* An array with data used for OpenGL drawing */
 
 class RAS_DisplayArray
@@ -96,8 +122,21 @@ public:
 	/* Number of RAS_MeshSlot using this array */
 	int m_users;
 
+	/* Indices used instead of m_index when set */
+	RAS_IndexArray *m_sharedIndex;
+
 	enum { BUCKET_MAX_INDEX = 65535 };
 	enum { BUCKET_MAX_VERTEX = 65535 };
+
+	RAS_DisplayArray();
+	RAS_DisplayArray(const RAS_DisplayArray& array);
+	~RAS_DisplayArray();
+
+	/// The indices used to draw this array, shared or not
+	vector<unsigned short>& GetIndex()
+	{
+		return m_sharedIndex ? m_sharedIndex->m_index : m_index;
+	}
 };
 
 /* Entry of a RAS_MeshObject into RAS_MaterialBucket */
@@ -171,6 +210,7 @@ public:
 	void AddPolygon(int numverts);
 	int AddVertex(const RAS_TexVert& tv);
 	void AddPolygonVertex(int offset);
+	void SetSharedIndexArray(RAS_IndexArray *indexarray);
 
 	/// Update offset of each display array
 	void UpdateDisplayArraysOffset();
@@ -250,11 +250,9 @@ int RAS_MeshObject::GetMaterialId(RAS_IPolyMaterial *mat)
 	return -1;
 }
 
-RAS_Polygon* RAS_MeshObject::AddPolygon(RAS_MaterialBucket *bucket, int numverts)
+RAS_MeshMaterial *RAS_MeshObject::AddMeshMaterial(RAS_MaterialBucket *bucket, int numverts)
 {
 	RAS_MeshMaterial *mmat;
-	RAS_Polygon *poly;
-	RAS_MeshSlot *slot;
 
 	/* find a mesh material */
 	mmat = GetMeshMaterial(bucket->GetPolyMaterial());
@@ -269,6 +267,17 @@ RAS_Polygon* RAS_MeshObject::AddPolygon(RAS_MaterialBucket *bucket, int numverts
 		mmat = &m_materials.back();
 	}
 
+	return mmat;
+}
+
+RAS_Polygon* RAS_MeshObject::AddPolygon(RAS_MaterialBucket *bucket, int numverts)
+{
+	RAS_MeshMaterial *mmat;
+	RAS_Polygon *poly;
+	RAS_MeshSlot *slot;
+
+	mmat = AddMeshMaterial(bucket, numverts);
+
 	/* add it to the bucket, this also adds new display arrays */
 	slot = mmat->m_baseslot;
 	slot->AddPolygon(numverts);
@@ -403,6 +412,14 @@ void RAS_MeshObject::AddPolygonVertex(RAS_Polygon *poly, unsigned short polyvert
 	poly->SetVertexOffset(polyvertind, vertind);
 }
 
+void RAS_MeshObject::SetSharedIndexArray(RAS_MaterialBucket *bucket, RAS_IndexArray *indexarray)
+{
+	RAS_MeshMaterial *mmat = GetMeshMaterial(bucket->GetPolyMaterial());
+	RAS_MeshSlot *slot = mmat->m_baseslot;
+
+	slot->SetSharedIndexArray(indexarray);
+}
+
 int RAS_MeshObject::NumVertices(RAS_IPolyMaterial* mat)
 {
 	RAS_MeshMaterial *mmat;
@@ -573,6 +590,9 @@ void RAS_MeshObject::SortPolygons(RAS_MeshSlot& ms, const MT_Transform &transfor
 			continue;
 		if (it.array->m_type == RAS_DisplayArray::LINE)
 			continue;
+		// shared indices are drawn by other meshes too
+		if (it.array->m_sharedIndex)
+			continue;
 
 		// Extract camera Z plane...
 		const MT_Vector3 pnorm(transform.getBasis()[2]);
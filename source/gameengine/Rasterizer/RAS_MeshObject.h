@@ -137,6 +137,17 @@ public:
 	// Set the vertex index
 	void AddPolygonVertex(RAS_Polygon *poly, unsigned short polyvertind, unsigned int vertind);
 
+	/* A third way without any polygon, the vertexes are added via AddVertex after
+	 * AddMeshMaterial, then indexed by an array shared with other meshes via
+	 * SetSharedIndexArray. These meshes can't be used for triangle mesh physics.
+	 */
+
+	// Add the material bucket to the mesh if not already used.
+	RAS_MeshMaterial *AddMeshMaterial(RAS_MaterialBucket *bucket, int numverts);
+
+	// Draw the vertexes added with the shared indices.
+	void SetSharedIndexArray(RAS_MaterialBucket *bucket, RAS_IndexArray *indexarray);
+
 	void					SchedulePolygons(int drawingmode);
 
 	/* vertex and polygon acces */
@@ -0,0 +1,196 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Contributor(s): none yet.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file gameengine/Rasterizer/RAS_NullRasterizer.cpp
+ *  \ingroup bgerast
+ */
+
+#include "RAS_NullRasterizer.h"
+
+#include "MT_Transform.h"
+
+RAS_NullLight::RAS_NullLight()
+{
+	m_modified = true;
+	m_layer = 0;
+	m_scene = NULL;
+	m_light = NULL;
+	m_energy = 1.0f;
+	m_distance = 0.0f;
+	m_color[0] = m_color[1] = m_color[2] = 1.0f;
+	m_att1 = 0.0f;
+	m_att2 = 0.0f;
+	m_spotsize = 0.0f;
+	m_spotblend = 0.0f;
+	m_type = LIGHT_NORMAL;
+	m_nodiffuse = false;
+	m_nospecular = false;
+	m_glsl = false;
+}
+
+RAS_ILightObject *RAS_NullLight::Clone()
+{
+	return new RAS_NullLight(*this);
+}
+
+RAS_NullRasterizer::RAS_NullRasterizer(RAS_ICanvas *canvas)
+	:RAS_IRasterizer(canvas),
+	m_2DCanvas(canvas),
+	m_time(0.0),
+	m_drawingmode(KX_TEXTURED),
+	m_stereomode(RAS_STEREO_NOSTEREO),
+	m_curreye(RAS_STEREO_LEFTEYE),
+	m_eyeseparation(0.0f),
+	m_focallength(0.0f),
+	m_campos(0.0f, 0.0f, 0.0f),
+	m_camortho(false),
+	m_motionblurvalue(-1.0f),
+	m_motionblur(0),
+	m_anisotropic(0),
+	m_mipmap(RAS_MIPMAP_NONE),
+	m_usingoverrideshader(false)
+{
+	m_viewmatrix.setIdentity();
+	m_viewinvmatrix.setIdentity();
+}
+
+RAS_NullRasterizer::~RAS_NullRasterizer()
+{
+}
+
+bool RAS_NullRasterizer::BeginFrame(double time)
+{
+	m_time = time;
+	return true;
+}
+
+bool RAS_NullRasterizer::Stereo()
+{
+	return (m_stereomode > RAS_STEREO_NOSTEREO);
+}
+
+MT_Matrix4x4 RAS_NullRasterizer::GetFrustumMatrix(
+	float left,
+	float right,
+	float bottom,
+	float top,
+	float frustnear,
+	float frustfar,
+	float focallength,
+	bool
+) {
+	// correction for stereo, same as RAS_OpenGLRasterizer
+	if (Stereo()) {
+		if (m_focallength == 0.0f)
+			m_focallength = (focallength == 0.0f) ? m_eyeseparation * 30.0f : focallength;
+
+		const float offset = 0.5f * m_eyeseparation * frustnear / m_focallength;
+		if (m_curreye == RAS_STEREO_LEFTEYE) {
+			left += offset;
+			right += offset;
+		}
+		else {
+			left -= offset;
+			right -= offset;
+		}
+		if (m_stereomode == RAS_STEREO_3DTVTOPBOTTOM) {
+			top *= 2.0f;
+			bottom *= 2.0f;
+		}
+	}
+
+	// same matrix as glFrustum
+	const MT_Scalar w = right - left;
+	const MT_Scalar h = top - bottom;
+	const MT_Scalar d = frustfar - frustnear;
+
+	return MT_Matrix4x4(
+		2.0 * frustnear / w, 0.0, (right + left) / w, 0.0,
+		0.0, 2.0 * frustnear / h, (top + bottom) / h, 0.0,
+		0.0, 0.0, -(frustfar + frustnear) / d, -2.0 * frustfar * frustnear / d,
+		0.0, 0.0, -1.0, 0.0);
+}
+
+MT_Matrix4x4 RAS_NullRasterizer::GetOrthoMatrix(
+	float left,
+	float right,
+	float bottom,
+	float top,
+	float frustnear,
+	float frustfar
+) {
+	// same matrix as glOrtho
+	const MT_Scalar w = right - left;
+	const MT_Scalar h = top - bottom;
+	const MT_Scalar d = frustfar - frustnear;
+
+	return MT_Matrix4x4(
+		2.0 / w, 0.0, 0.0, -(right + left) / w,
+		0.0, 2.0 / h, 0.0, -(top + bottom) / h,
+		0.0, 0.0, -2.0 / d, -(frustfar + frustnear) / d,
+		0.0, 0.0, 0.0, 1.0);
+}
+
+void RAS_NullRasterizer::SetViewMatrix(const MT_Matrix4x4 &mat,
+                                       const MT_Matrix3x3 &camOrientMat3x3,
+                                       const MT_Point3 &pos,
+                                       bool perspective)
+{
+	m_viewmatrix = mat;
+
+	// correction for stereo, same as RAS_OpenGLRasterizer
+	if (Stereo() && perspective) {
+		const MT_Vector3 viewDir = camOrientMat3x3 * MT_Vector3(0.0, -1.0, 0.0);
+		const MT_Vector3 viewupVec = camOrientMat3x3 * MT_Vector3(0.0, 0.0, 1.0);
+		const MT_Vector3 eyeline = viewDir.cross(viewupVec);
+
+		MT_Transform transform;
+		transform.setIdentity();
+		if (m_curreye == RAS_STEREO_LEFTEYE)
+			transform.translate(-(eyeline * m_eyeseparation / 2.0));
+		else
+			transform.translate(eyeline * m_eyeseparation / 2.0);
+		m_viewmatrix *= transform;
+	}
+
+	m_viewinvmatrix = m_viewmatrix;
+	m_viewinvmatrix.invert();
+	m_campos = pos;
+}
+
+void RAS_NullRasterizer::SetProjectionMatrix(const MT_Matrix4x4 &mat)
+{
+	m_camortho = (mat[3][3] != 0.0);
+}
+
+void RAS_NullRasterizer::EnableMotionBlur(float motionblurvalue)
+{
+	if (m_motionblur == 0)
+		m_motionblur = 1;
+	m_motionblurvalue = motionblurvalue;
+}
+
+void RAS_NullRasterizer::DisableMotionBlur()
+{
+	m_motionblur = 0;
+	m_motionblurvalue = -1.0f;
+}
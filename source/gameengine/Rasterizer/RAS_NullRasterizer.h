@@ -0,0 +1,200 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Contributor(s): none yet.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file RAS_NullRasterizer.h
+ *  \ingroup bgerast
+ */
+
+#ifndef __RAS_NULLRASTERIZER_H__
+#define __RAS_NULLRASTERIZER_H__
+
+#include "RAS_IRasterizer.h"
+#include "RAS_ILightObject.h"
+
+#include "MT_Point3.h"
+
+/**
+ * Light object without any shadow buffer, used by RAS_NullRasterizer.
+ */
+class RAS_NullLight : public RAS_ILightObject
+{
+public:
+	RAS_NullLight();
+	virtual ~RAS_NullLight() {}
+
+	virtual RAS_ILightObject *Clone();
+	virtual bool HasShadowBuffer() { return false; }
+	virtual int GetShadowLayer() { return 0; }
+	virtual void BindShadowBuffer(RAS_ICanvas *canvas, KX_Camera *cam, MT_Transform& camtrans) {}
+	virtual void UnbindShadowBuffer() {}
+	virtual Image *GetTextureImage(short texslot) { return NULL; }
+	virtual void Update() {}
+};
+
+/**
+ * Rasterizer which never touches OpenGL. It keeps the state the engine
+ * queries back (matrices, stereo and drawing settings) and discards every
+ * drawing call, so that logic, physics, animations and culling can run
+ * without any GL context, e.g. for headless benchmarks.
+ */
+class RAS_NullRasterizer : public RAS_IRasterizer
+{
+	RAS_ICanvas *m_2DCanvas;
+	double m_time;
+	int m_drawingmode;
+	StereoMode m_stereomode;
+	StereoEye m_curreye;
+	float m_eyeseparation;
+	float m_focallength;
+	MT_Matrix4x4 m_viewmatrix;
+	MT_Matrix4x4 m_viewinvmatrix;
+	MT_Point3 m_campos;
+	bool m_camortho;
+	float m_motionblurvalue;
+	int m_motionblur;
+	short m_anisotropic;
+	MipmapOption m_mipmap;
+	bool m_usingoverrideshader;
+
+public:
+	RAS_NullRasterizer(RAS_ICanvas *canv);
+	virtual ~RAS_NullRasterizer();
+
+	virtual void SetDepthMask(DepthMask depthmask) {}
+	virtual bool SetMaterial(const RAS_IPolyMaterial &mat) { return true; }
+	virtual bool Init() { return true; }
+	virtual void Exit() {}
+	virtual bool BeginFrame(double time);
+	virtual void ClearColorBuffer() {}
+	virtual void ClearDepthBuffer() {}
+	virtual void ClearCachingInfo(void) {}
+	virtual void EndFrame() {}
+	virtual void SetRenderArea() {}
+
+	virtual void SetStereoMode(const StereoMode stereomode) { m_stereomode = stereomode; }
+	virtual bool Stereo();
+	virtual StereoMode GetStereoMode() { return m_stereomode; }
+	virtual bool InterlacedStereo() { return false; }
+	virtual void SetEye(const StereoEye eye) { m_curreye = eye; }
+	virtual StereoEye GetEye() { return m_curreye; }
+	virtual void SetEyeSeparation(const float eyeseparation) { m_eyeseparation = eyeseparation; }
+	virtual float GetEyeSeparation() { return m_eyeseparation; }
+	virtual void SetFocalLength(const float focallength) { m_focallength = focallength; }
+	virtual float GetFocalLength() { return m_focallength; }
+
+	virtual void SwapBuffers() {}
+
+	virtual void IndexPrimitives(class RAS_MeshSlot &ms) {}
+	virtual void IndexPrimitivesMulti(class RAS_MeshSlot &ms) {}
+	virtual void IndexPrimitives_3DText(class RAS_MeshSlot &ms, class RAS_IPolyMaterial *polymat) {}
+
+	virtual void SetProjectionMatrix(MT_CmMatrix4x4 &mat) { m_camortho = (mat(3, 3) != 0.0); }
+	virtual void SetProjectionMatrix(const MT_Matrix4x4 &mat);
+	virtual void SetViewMatrix(const MT_Matrix4x4 &mat, const MT_Matrix3x3 &ori,
+	                           const MT_Point3 &pos, bool perspective);
+	virtual const MT_Point3& GetCameraPosition() { return m_campos; }
+	virtual bool GetCameraOrtho() { return m_camortho; }
+
+	virtual void SetFog(short type, float start, float dist, float intensity, float color[3]) {}
+	virtual void DisplayFog() {}
+	virtual void EnableFog(bool enable) {}
+	virtual void SetBackColor(float color[3]) {}
+
+	virtual void SetDrawingMode(int drawingmode) { m_drawingmode = drawingmode; }
+	virtual int GetDrawingMode() { return m_drawingmode; }
+	virtual void SetCullFace(bool enable) {}
+	virtual void SetLines(bool enable) {}
+
+	virtual double GetTime() { return m_time; }
+
+	virtual MT_Matrix4x4 GetFrustumMatrix(
+	        float left, float right, float bottom, float top,
+	        float frustnear, float frustfar,
+	        float focallength = 0.0f, bool perspective = true);
+	virtual MT_Matrix4x4 GetOrthoMatrix(
+	        float left, float right, float bottom, float top,
+	        float frustnear, float frustfar);
+
+	virtual void SetSpecularity(float specX, float specY, float specZ, float specval) {}
+	virtual void SetShinyness(float shiny) {}
+	virtual void SetDiffuse(float difX, float difY, float difZ, float diffuse) {}
+	virtual void SetEmissive(float eX, float eY, float eZ, float e) {}
+	virtual void SetAmbientColor(float color[3]) {}
+	virtual void SetAmbient(float factor) {}
+	virtual void SetPolygonOffset(float mult, float add) {}
+
+	virtual void DrawDebugLine(SCA_IScene *scene, const MT_Vector3 &from, const MT_Vector3 &to, const MT_Vector3& color) {}
+	virtual void DrawDebugCircle(SCA_IScene *scene, const MT_Vector3 &center, const MT_Scalar radius,
+	                             const MT_Vector3 &color, const MT_Vector3 &normal, int nsector) {}
+	virtual void FlushDebugShapes(SCA_IScene *scene) {}
+
+	virtual void SetTexCoordNum(int num) {}
+	virtual void SetAttribNum(int num) {}
+	virtual void SetTexCoord(TexCoGen coords, int unit) {}
+	virtual void SetAttrib(TexCoGen coords, int unit, int layer = 0) {}
+
+	virtual const MT_Matrix4x4 &GetViewMatrix() const { return m_viewmatrix; }
+	virtual const MT_Matrix4x4 &GetViewInvMatrix() const { return m_viewinvmatrix; }
+
+	virtual void EnableMotionBlur(float motionblurvalue);
+	virtual void DisableMotionBlur();
+	virtual float GetMotionBlurValue() { return m_motionblurvalue; }
+	virtual int GetMotionBlurState() { return m_motionblur; }
+	virtual void SetMotionBlurState(int newstate) { m_motionblur = newstate; }
+
+	virtual void SetAlphaBlend(int alphablend) {}
+	virtual void SetFrontFace(bool ccw) {}
+
+	virtual void SetAnisotropicFiltering(short level) { m_anisotropic = level; }
+	virtual short GetAnisotropicFiltering() { return m_anisotropic; }
+	virtual void SetMipmapping(MipmapOption val) { m_mipmap = val; }
+	virtual MipmapOption GetMipmapping() { return m_mipmap; }
+	virtual void SetUsingOverrideShader(bool val) { m_usingoverrideshader = val; }
+	virtual bool GetUsingOverrideShader() { return m_usingoverrideshader; }
+
+	virtual void applyTransform(double *oglmatrix, int drawingmode) {}
+	virtual void RenderBox2D(int xco, int yco, int width, int height, float percentage) {}
+	virtual void RenderText3D(
+	        int fontid, const char *text, int size, int dpi,
+	        const float color[4], const double mat[16], float aspect) {}
+	virtual void RenderText2D(
+	        RAS_TEXT_RENDER_MODE mode, const char *text,
+	        int xco, int yco, int width, int height) {}
+
+	virtual void ProcessLighting(bool uselights, const MT_Transform &trans) {}
+	virtual void PushMatrix() {}
+	virtual void PopMatrix() {}
+
+	virtual RAS_ILightObject *CreateLight() { return new RAS_NullLight(); }
+	virtual void AddLight(RAS_ILightObject *lightobject) {}
+	virtual void RemoveLight(RAS_ILightObject *lightobject) {}
+
+	virtual void MotionBlur() {}
+	virtual void SetClientObject(void *obj) {}
+	virtual void SetAuxilaryClientInfo(void *inf) {}
+
+#ifdef WITH_CXX_GUARDEDALLOC
+	MEM_CXX_CLASS_ALLOC_FUNCS("GE:RAS_NullRasterizer")
+#endif
+};
+
+#endif  /* __RAS_NULLRASTERIZER_H__ */
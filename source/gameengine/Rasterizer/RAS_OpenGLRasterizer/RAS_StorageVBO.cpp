@@ -30,6 +30,19 @@
 
 #include "glew-mx.h"
 
+IBO::IBO(RAS_IndexArray *data)
+{
+	glGenBuffersARB(1, &this->ibo);
+	glBindBufferARB(GL_ELEMENT_ARRAY_BUFFER_ARB, this->ibo);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, data->m_index.size() * sizeof(GLushort),
+					&data->m_index[0], GL_STATIC_DRAW);
+}
+
+IBO::~IBO()
+{
+	glDeleteBuffersARB(1, &this->ibo);
+}
+
 VBO::VBO(RAS_DisplayArray *data, unsigned int indices)
 {
 	this->data = data;
@@ -45,8 +58,18 @@ VBO::VBO(RAS_DisplayArray *data, unsigned int indices)
 	else
 		this->mode = GL_LINE;
 
-	// Generate Buffers
-	glGenBuffersARB(1, &this->ibo);
+	// Generate Buffers, the index buffer is created once for all arrays using shared indices
+	if (data->m_sharedIndex) {
+		RAS_IndexArray *indexarray = data->m_sharedIndex;
+		if (!indexarray->m_storageSlot)
+			indexarray->m_storageSlot = new IBO(indexarray);
+		this->shared_ibo = (IBO *)indexarray->m_storageSlot->AddRef();
+		this->ibo = this->shared_ibo->ibo;
+	}
+	else {
+		this->shared_ibo = NULL;
+		glGenBuffersARB(1, &this->ibo);
+	}
 	glGenBuffersARB(1, &this->vbo_id);
 
 	// Fill the buffers with initial data
@@ -63,7 +86,10 @@ VBO::VBO(RAS_DisplayArray *data, unsigned int indices)
 
 VBO::~VBO()
 {
-	glDeleteBuffersARB(1, &this->ibo);
+	if (this->shared_ibo)
+		this->shared_ibo->Release();
+	else
+		glDeleteBuffersARB(1, &this->ibo);
 	glDeleteBuffersARB(1, &this->vbo_id);
 }
 
@@ -75,6 +101,10 @@ void VBO::UpdateData()
 
 void VBO::UpdateIndices()
 {
+	// Shared indices never change
+	if (this->shared_ibo)
+		return;
+
 	glBindBufferARB(GL_ELEMENT_ARRAY_BUFFER_ARB, this->ibo);
 	glBufferData(GL_ELEMENT_ARRAY_BUFFER, data->m_index.size() * sizeof(GLushort),
 					&data->m_index[0], GL_STATIC_DRAW);
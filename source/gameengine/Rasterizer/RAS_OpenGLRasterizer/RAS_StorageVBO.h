@@ -36,6 +36,19 @@
 
 #include "RAS_OpenGLRasterizer.h"
 
+/* Index buffer of a RAS_IndexArray, used by the VBO of all display arrays
+ * sharing these indices */
+class IBO : public KX_ListSlot
+{
+public:
+	IBO(RAS_IndexArray *data);
+	virtual ~IBO();
+
+	virtual void SetModified(bool mod) {}
+
+	GLuint			ibo;
+};
+
 class VBO
 {
 public:
@@ -53,6 +66,7 @@ private:
 	GLuint			indices;
 	GLenum			mode;
 	GLuint			ibo;
+	IBO*			shared_ibo;
 	GLuint			vbo_id;
 
 	void*			vertex_offset;
@@ -58,6 +58,28 @@ public:
 		double time
 	)=0;
 
+	/**
+	 * True if the controller has a new time to apply in the next Update.
+	 */
+	virtual
+		bool
+	IsModified(
+	) const {
+		return true;
+	}
+
+	/**
+	 * True if Update only writes the controlled node and the data owned by
+	 * its client object. The controllers of separate hierarchies can then
+	 * be updated in parallel.
+	 */
+	virtual
+		bool
+	IsThreadSafe(
+	) const {
+		return false;
+	}
+
 	virtual 
 		void 
 	SetObject (
@@ -96,6 +96,26 @@ void SG_IObject::SetControllerTime(double time)
 	}
 }
 
+void SG_IObject::UpdateControllers(double time)
+{
+	SGControllerList::iterator contit;
+	for (contit = m_SGcontrollers.begin();contit!=m_SGcontrollers.end();++contit)
+	{
+		(*contit)->Update(time);
+	}
+}
+
+bool SG_IObject::HasUnsafeControllers(bool modifiedOnly) const
+{
+	SGControllerList::const_iterator contit;
+	for (contit = m_SGcontrollers.begin();contit!=m_SGcontrollers.end();++contit)
+	{
+		if ((!modifiedOnly || (*contit)->IsModified()) && !(*contit)->IsThreadSafe())
+			return true;
+	}
+	return false;
+}
+
 /// Needed for replication
 
 
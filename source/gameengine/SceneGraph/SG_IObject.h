@@ -278,6 +278,18 @@ public:
 	 */
  
 	void SetControllerTime(double time);
+
+	/**
+	 * Update the controllers of this node only, the world data and the
+	 * children are left untouched.
+	 */
+	void UpdateControllers(double time);
+
+	/**
+	 * True if a controller of this node is not thread safe, see SG_Controller::IsThreadSafe.
+	 * \param modifiedOnly Only check the controllers with a new time to apply.
+	 */
+	bool HasUnsafeControllers(bool modifiedOnly) const;
 	
 	virtual 
 		void
@@ -0,0 +1,423 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#ifdef WITH_PYTHON
+#  include <Python.h>
+#endif
+
+#include "KX_ISystem.h"
+#include "KX_KetsjiEngine.h"
+#include "KX_Scene.h"
+#include "KX_GameObject.h"
+#include "KX_BlenderSceneConverter.h"
+#include "BL_ArmatureObject.h"
+#include "BL_Action.h"
+
+#include "SCA_LogicManager.h"
+
+#include "NG_LoopBackNetworkDeviceInterface.h"
+
+#include "SG_Node.h"
+
+#ifdef WITH_BULLET
+#  include "CcdPhysicsEnvironment.h"
+#  include "CcdPhysicsController.h"
+#  include "KX_MotionState.h"
+#  include "PHY_Pro.h"
+#endif
+
+#include <cstring>
+#include <vector>
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+#include "BLI_listbase.h"
+#include "BLI_string.h"
+#include "BLI_threads.h"
+#include "DNA_action_types.h"
+#include "DNA_anim_types.h"
+#include "DNA_armature_types.h"
+#include "DNA_curve_types.h"
+#include "DNA_object_types.h"
+#include "DNA_scene_types.h"
+#include "BKE_action.h"
+#include "BKE_armature.h"
+#include "BKE_fcurve.h"
+#include "BKE_global.h"
+#include "BKE_library.h"
+#include "BKE_main.h"
+#include "BKE_object.h"
+#include "PIL_time.h"
+#include "RNA_define.h"
+}
+
+/// Above the number of root hierarchies updated in parallel by KX_Scene::UpdateAnimations.
+#define HIERARCHIES 8
+#define THREADS 4
+#define FRAMES 6
+#define START_FRAME 1.0f
+#define END_FRAME 21.0f
+
+/* As GPG_System without any GHOST system. */
+class TestSystem : public KX_ISystem
+{
+public:
+	virtual double GetTimeInSeconds()
+	{
+		return PIL_check_seconds_timer();
+	}
+};
+
+/* The blender data and the engine needed to play actions, with several
+ * animation threads even on a single core. */
+class TestEngine
+{
+public:
+	TestSystem system;
+	KX_KetsjiEngine *engine;
+	KX_BlenderSceneConverter *converter;
+	bool initPython;
+
+	TestEngine()
+	{
+		BLI_threadapi_init();
+		BLI_system_num_threads_override_set(THREADS);
+#ifdef WITH_PYTHON
+		// The engine creates its profile dictionary.
+		initPython = !Py_IsInitialized();
+		if (initPython) {
+			Py_Initialize();
+		}
+#endif
+		// The actions are evaluated through RNA.
+		RNA_init();
+		G.main = BKE_main_new();
+
+		engine = new KX_KetsjiEngine(&system);
+		converter = new KX_BlenderSceneConverter(G.main, engine);
+	}
+
+	~TestEngine()
+	{
+		delete converter;
+		delete engine;
+
+		BKE_main_free(G.main);
+		G.main = NULL;
+		RNA_exit();
+#ifdef WITH_PYTHON
+		if (initPython) {
+			Py_Finalize();
+		}
+#endif
+		BLI_system_num_threads_override_set(0);
+		BLI_threadapi_exit();
+	}
+};
+
+/// A linear curve of an action from START_FRAME to END_FRAME.
+static void add_fcurve(bAction *action, const char *path, int index, float start, float end)
+{
+	FCurve *fcu = (FCurve *)MEM_callocN(sizeof(FCurve), "TestFCurve");
+	fcu->rna_path = BLI_strdup(path);
+	fcu->array_index = index;
+	fcu->flag = FCURVE_VISIBLE | FCURVE_SELECTED;
+	fcu->totvert = 2;
+	fcu->bezt = (BezTriple *)MEM_callocN(fcu->totvert * sizeof(BezTriple), "TestBezTriple");
+
+	const float frames[2] = {START_FRAME, END_FRAME};
+	const float values[2] = {start, end};
+	for (unsigned int i = 0; i < fcu->totvert; ++i) {
+		BezTriple *bezt = &fcu->bezt[i];
+		for (unsigned short j = 0; j < 3; ++j) {
+			bezt->vec[j][0] = frames[i];
+			bezt->vec[j][1] = values[i];
+		}
+		bezt->ipo = BEZT_IPO_LIN;
+		bezt->h1 = bezt->h2 = HD_AUTO;
+	}
+	calchandles_fcurve(fcu);
+
+	BLI_addtail(&action->curves, fcu);
+}
+
+/// The value of a curve added by add_fcurve at a frame.
+static float fcurve_value(float start, float end, float frame)
+{
+	return start + (end - start) * (frame - START_FRAME) / (END_FRAME - START_FRAME);
+}
+
+/* The actions played by the objects of both scenes. */
+class TestActions
+{
+public:
+	bAction *transform;
+	bAction *location;
+	bAction *pose;
+
+	TestActions()
+	{
+		transform = add_empty_action(G.main, "Transform");
+		for (int i = 0; i < 3; ++i) {
+			add_fcurve(transform, "location", i, 0.1f * i, 2.0f + i);
+			add_fcurve(transform, "rotation_euler", i, 0.0f, 0.5f * (i + 1));
+			add_fcurve(transform, "scale", i, 1.0f, 1.5f + 0.25f * i);
+		}
+
+		location = add_empty_action(G.main, "Location");
+		for (int i = 0; i < 3; ++i) {
+			add_fcurve(location, "location", i, 1.0f, -1.0f - i);
+		}
+
+		pose = add_empty_action(G.main, "Pose");
+		for (int i = 0; i < 3; ++i) {
+			add_fcurve(pose, "pose.bones[\"Bone\"].location", i, 0.0f, 1.0f + i);
+		}
+		add_fcurve(pose, "location", 2, 0.0f, 3.0f);
+	}
+};
+
+/* A scene set up as KX_BlenderSceneConverter::ConvertScene does, its objects
+ * are removed with the scene. */
+class TestScene
+{
+public:
+	NG_LoopBackNetworkDeviceInterface network;
+	Scene blenderScene;
+	KX_Scene *scene;
+	std::vector<KX_GameObject *> objects;
+	/// The objects in the order of the animated list of the scene.
+	std::vector<KX_GameObject *> animated;
+
+	TestScene(TestEngine& test, const TestActions& actions)
+	{
+		memset(&blenderScene, 0, sizeof(blenderScene));
+		scene = new KX_Scene(NULL, NULL, &network, "TestScene", &blenderScene, NULL);
+		scene->SetTaskScheduler(test.engine->GetTaskScheduler());
+		scene->SetSceneConverter(test.converter);
+#ifdef WITH_BULLET
+		scene->SetPhysicsEnvironment(CcdPhysicsEnvironment::Create(&blenderScene, false));
+#endif
+
+		SCA_LogicManager *logicmgr = scene->GetLogicManager();
+		logicmgr->RegisterActionName("Transform", actions.transform);
+		logicmgr->RegisterActionName("Location", actions.location);
+		logicmgr->RegisterActionName("Pose", actions.pose);
+	}
+
+	~TestScene()
+	{
+		// As KX_Scene::RemoveNodeDestructObject, the nodes outlive their object.
+		std::vector<SG_Node *> nodes;
+		for (std::vector<KX_GameObject *>::iterator it = objects.begin(); it != objects.end(); ++it) {
+			nodes.push_back((*it)->GetSGNode());
+			(*it)->Release();
+		}
+		// Releases the animated objects, and their physics before the physics environment.
+		delete scene;
+		for (std::vector<SG_Node *>::iterator it = nodes.begin(); it != nodes.end(); ++it) {
+			delete *it;
+		}
+	}
+
+	/// An empty with its blender object, as the converter creates it.
+	KX_GameObject *AddObject(KX_GameObject *parent, unsigned int index)
+	{
+		KX_GameObject *gameobj = new KX_GameObject(scene, KX_Scene::m_callbacks);
+		InitObject(gameobj, BKE_object_add_only_object(G.main, OB_EMPTY, "Empty"), parent, index);
+		return gameobj;
+	}
+
+	void InitObject(KX_GameObject *gameobj, Object *ob, KX_GameObject *parent, unsigned int index)
+	{
+		const float value = index * 0.37f;
+		const MT_Point3 position(value, 1.0f - value, 0.5f * value);
+		const MT_Vector3 rotation(0.3f * value, -0.2f * value, 0.1f + value);
+		const MT_Vector3 scale(1.0f + 0.01f * index, 1.0f, 1.1f);
+		position.getValue(ob->loc);
+		rotation.getValue(ob->rot);
+		scale.getValue(ob->size);
+
+		gameobj->SetBlenderObject(ob);
+		if (parent) {
+			parent->GetSGNode()->AddChild(gameobj->GetSGNode());
+		}
+		gameobj->NodeSetLocalPosition(position);
+		gameobj->NodeSetLocalOrientation(MT_Matrix3x3(rotation));
+		gameobj->NodeSetLocalScale(scale);
+		gameobj->NodeUpdateGS(0.0);
+		objects.push_back(gameobj);
+	}
+
+	void PlayAction(KX_GameObject *gameobj, const char *name, short ipoFlags)
+	{
+		EXPECT_TRUE(gameobj->PlayAction(name, START_FRAME, END_FRAME, 0, 0, 0.0f, BL_Action::ACT_MODE_PLAY, 0.0f, ipoFlags));
+		animated.push_back(gameobj);
+	}
+
+	/// An armature with a single bone and a child without mesh, so its pose is updated.
+	BL_ArmatureObject *AddArmature(unsigned int index)
+	{
+		bArmature *arm = BKE_armature_add(G.main, "Armature");
+		Bone *bone = (Bone *)MEM_callocN(sizeof(Bone), "TestBone");
+		BLI_strncpy(bone->name, "Bone", sizeof(bone->name));
+		bone->tail[1] = 1.0f;
+		BLI_addtail(&arm->bonebase, bone);
+
+		Object *ob = BKE_object_add_only_object(G.main, OB_ARMATURE, "Armature");
+		ob->data = arm;
+		BKE_pose_rebuild(ob, arm);
+
+		BL_ArmatureObject *armobj = new BL_ArmatureObject(scene, KX_Scene::m_callbacks, ob, &blenderScene, ARM_VDEF_BLENDER);
+		InitObject(armobj, ob, NULL, index);
+		AddObject(armobj, index + 1);
+		return armobj;
+	}
+
+#ifdef WITH_BULLET
+	/// A static sphere, its scale IPO is applied to its shape on the main thread.
+	KX_GameObject *AddPhysicsObject(unsigned int index)
+	{
+		KX_GameObject *gameobj = AddObject(NULL, index);
+		Object *ob = gameobj->GetBlenderObject();
+		ob->gameflag = OB_COLLISION | OB_BOUNDS;
+		ob->collision_boundtype = OB_BOUND_SPHERE;
+		ob->inertia = 1.0f;
+		ob->lay = 1;
+
+		PHY_ShapeProps shapeprops;
+		PHY_MaterialProps matprops;
+		memset(&shapeprops, 0, sizeof(shapeprops));
+		memset(&matprops, 0, sizeof(matprops));
+		CcdPhysicsEnvironment *env = (CcdPhysicsEnvironment *)scene->GetPhysicsEnvironment();
+		env->ConvertObject(gameobj, NULL, NULL, scene, &shapeprops, &matprops,
+		                   new KX_MotionState(gameobj->GetSGNode()), 1, false, false);
+		EXPECT_TRUE(gameobj->GetPhysicsController() != NULL);
+		return gameobj;
+	}
+#endif
+
+	/* Parented and unparented IPOs, IPOs applied to the children and to the physics,
+	 * and a pose, in more hierarchies than a parallel update needs. */
+	void AddAnimatedObjects()
+	{
+		unsigned int index = 0;
+		for (unsigned int i = 0; i < HIERARCHIES; ++i) {
+			KX_GameObject *root = AddObject(NULL, index++);
+			AddObject(root, index++);
+			PlayAction(root, "Transform", 0);
+		}
+
+		// An animated child of an animated parent, in the same group.
+		KX_GameObject *parent = AddObject(NULL, index++);
+		KX_GameObject *child = AddObject(parent, index++);
+		PlayAction(parent, "Transform", 0);
+		PlayAction(child, "Location", 0);
+
+		// The IPO is applied to the children too, on the main thread.
+		KX_GameObject *childIpo = AddObject(NULL, index++);
+		AddObject(childIpo, index++);
+		PlayAction(childIpo, "Transform", BL_Action::ACT_IPOFLAG_CHILD);
+
+#ifdef WITH_BULLET
+		KX_GameObject *physics = AddPhysicsObject(index++);
+		AddObject(physics, index++);
+		PlayAction(physics, "Transform", 0);
+#endif
+
+		BL_ArmatureObject *armature = AddArmature(index);
+		index += 2;
+		PlayAction(armature, "Pose", 0);
+	}
+};
+
+/// Evaluates and applies the actions of every object in the list order, then updates the scenegraph.
+static void update_serial(TestScene& test, double curtime)
+{
+	for (std::vector<KX_GameObject *>::iterator it = test.animated.begin(); it != test.animated.end(); ++it) {
+		(*it)->UpdateActionManager(curtime);
+		(*it)->UpdateActionIPOs();
+	}
+	test.scene->UpdateParents(curtime);
+}
+
+static void update_parallel(TestScene& test, double curtime)
+{
+	test.scene->UpdateAnimations(curtime);
+	test.scene->UpdateParents(curtime);
+}
+
+static bPoseChannel *get_bone(KX_GameObject *gameobj)
+{
+	return BKE_pose_channel_find_name(((BL_ArmatureObject *)gameobj)->GetArmatureObject()->pose, "Bone");
+}
+
+static void expect_same_transforms(const TestScene& expected, const TestScene& test)
+{
+	ASSERT_EQ(expected.objects.size(), test.objects.size());
+	for (unsigned int i = 0; i < test.objects.size(); ++i) {
+		KX_GameObject *expectedobj = expected.objects[i];
+		KX_GameObject *gameobj = test.objects[i];
+		// The same operations in the same order give the same values.
+		for (unsigned short j = 0; j < 3; ++j) {
+			EXPECT_EQ(expectedobj->NodeGetLocalPosition()[j], gameobj->NodeGetLocalPosition()[j]) << "object " << i;
+			EXPECT_EQ(expectedobj->NodeGetLocalScaling()[j], gameobj->NodeGetLocalScaling()[j]) << "object " << i;
+			EXPECT_EQ(expectedobj->NodeGetWorldPosition()[j], gameobj->NodeGetWorldPosition()[j]) << "object " << i;
+			EXPECT_EQ(expectedobj->NodeGetWorldScaling()[j], gameobj->NodeGetWorldScaling()[j]) << "object " << i;
+			for (unsigned short k = 0; k < 3; ++k) {
+				EXPECT_EQ(expectedobj->NodeGetWorldOrientation()[j][k], gameobj->NodeGetWorldOrientation()[j][k]) << "object " << i;
+			}
+		}
+
+		if (gameobj->GetGameObjectType() == SCA_IObject::OBJ_ARMATURE) {
+			bPoseChannel *expectedchan = get_bone(expectedobj);
+			bPoseChannel *chan = get_bone(gameobj);
+			for (unsigned short j = 0; j < 3; ++j) {
+				EXPECT_EQ(expectedchan->loc[j], chan->loc[j]) << "object " << i;
+			}
+		}
+
+#ifdef WITH_BULLET
+		if (gameobj->GetPhysicsController()) {
+			const btVector3& expectedscale = ((CcdPhysicsController *)expectedobj->GetPhysicsController())->GetCollisionShape()->getLocalScaling();
+			const btVector3& scale = ((CcdPhysicsController *)gameobj->GetPhysicsController())->GetCollisionShape()->getLocalScaling();
+			for (unsigned short j = 0; j < 3; ++j) {
+				EXPECT_EQ(expectedscale[j], scale[j]) << "object " << i;
+			}
+		}
+#endif
+	}
+}
+
+/* The actions evaluated in parallel and applied per hierarchy give the same
+ * poses and transforms as evaluating and applying them in the list order. */
+TEST(animation_update, ParallelEvaluation)
+{
+	TestEngine engine;
+	TestActions actions;
+
+	{
+		TestScene parallel(engine, actions);
+		TestScene serial(engine, actions);
+		parallel.AddAnimatedObjects();
+		serial.AddAnimatedObjects();
+		ASSERT_EQ(serial.animated.size(), parallel.animated.size());
+
+		// The first update starts the actions.
+		const double starttime = 1.0;
+		for (unsigned int frame = 0; frame < FRAMES; ++frame) {
+			const double curtime = starttime + frame / KX_KetsjiEngine::GetAnimFrameRate();
+			update_parallel(parallel, curtime);
+			update_serial(serial, curtime);
+			expect_same_transforms(serial, parallel);
+		}
+
+		// The actions were played up to the last frame.
+		const float lastframe = START_FRAME + (FRAMES - 1);
+		EXPECT_NEAR(fcurve_value(0.0f, 2.0f, lastframe), parallel.animated[0]->NodeGetLocalPosition()[0], 1e-4);
+		EXPECT_NEAR(fcurve_value(1.0f, 1.75f, lastframe), parallel.animated[0]->NodeGetLocalScaling()[1], 1e-4);
+		bPoseChannel *chan = get_bone(parallel.animated.back());
+		EXPECT_NEAR(fcurve_value(0.0f, 2.0f, lastframe), chan->loc[1], 1e-4);
+	}
+}
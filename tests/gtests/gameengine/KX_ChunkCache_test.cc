@@ -0,0 +1,254 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include <math.h>
+#include <new>
+#include <stdint.h>
+#include <vector>
+
+#include "KX_ChunkCache.h"
+#include "KX_TerrainPool.h"
+#include "KX_TerrainZone.h"
+
+/* Large enough that nothing is evicted. */
+#define CACHE_MEMORY (64 * 1024 * 1024)
+
+/* The vertexes of the finest level are two relative positions apart. */
+#define STEP 2
+
+/* A cache with its vertex pool, checking that every vertex is released. */
+struct TestCache
+{
+	KX_TerrainPool *pool;
+	KX_ChunkCache *cache;
+
+	/* Cached positions, in insertion order. */
+	std::vector<int> xs;
+	std::vector<int> ys;
+
+	TestCache()
+	{
+		pool = new KX_TerrainPool(sizeof(VertexZoneInfo), 512);
+		cache = new KX_ChunkCache(CACHE_MEMORY);
+	}
+
+	~TestCache()
+	{
+		delete cache;
+		EXPECT_EQ(0, pool->GetUsedCount());
+		delete pool;
+	}
+
+	void Add(int x, int y)
+	{
+		VertexZoneInfo *info = new (pool->Alloc()) VertexZoneInfo(pool);
+		info->pos[0] = x;
+		info->pos[1] = y;
+		EXPECT_EQ(info, cache->AddVertexZoneInfo(x, y, info));
+		// The cache keeps the only reference.
+		info->Release();
+		xs.push_back(x);
+		ys.push_back(y);
+	}
+
+	/* Fills the cache with all the vertexes of a square of half size extent
+	 * around the origin, added in a shuffled order to mix the probe chains. */
+	void Fill(int extent)
+	{
+		std::vector<int> positions;
+		for (int x = -extent; x <= extent; x += STEP) {
+			for (int y = -extent; y <= extent; y += STEP) {
+				positions.push_back(x);
+				positions.push_back(y);
+			}
+		}
+		const unsigned int count = positions.size() / 2;
+		for (unsigned int i = 0; i < count; ++i) {
+			const unsigned int j = (i * 7919u) % count;
+			std::swap(positions[i * 2], positions[j * 2]);
+			std::swap(positions[i * 2 + 1], positions[j * 2 + 1]);
+		}
+		for (unsigned int i = 0; i < count; ++i) {
+			Add(positions[i * 2], positions[i * 2 + 1]);
+		}
+	}
+
+	/* The vertex i is in the inclusive rectangle and on a position of the step. */
+	bool Inside(unsigned int i, int minx, int miny, int maxx, int maxy, int step) const
+	{
+		return (minx <= xs[i] && xs[i] <= maxx && miny <= ys[i] && ys[i] <= maxy &&
+		        (xs[i] % step) == 0 && (ys[i] % step) == 0);
+	}
+
+	/* Removes the area and checks that exactly the cached vertexes inside
+	 * the rectangle are removed and released. */
+	void ExpectRemoveArea(int minx, int miny, int maxx, int maxy, int step)
+	{
+		const unsigned int usedCount = pool->GetUsedCount();
+		const unsigned int invalidations = KX_ChunkCache::cacheInvalidations;
+
+		unsigned int inside = 0;
+		for (unsigned int i = 0; i < xs.size(); ++i) {
+			if (cache->GetVertexZoneInfo(xs[i], ys[i]) && Inside(i, minx, miny, maxx, maxy, step)) {
+				++inside;
+			}
+		}
+
+		const unsigned int count = cache->GetCount();
+		EXPECT_EQ(inside, cache->RemoveArea(minx, miny, maxx, maxy, step));
+		EXPECT_EQ(count - inside, cache->GetCount());
+		EXPECT_EQ(usedCount - inside, pool->GetUsedCount());
+		EXPECT_EQ(invalidations + inside, KX_ChunkCache::cacheInvalidations);
+
+		for (unsigned int i = 0; i < xs.size(); ++i) {
+			const bool removed = Inside(i, minx, miny, maxx, maxy, step);
+			VertexZoneInfo *info = cache->GetVertexZoneInfo(xs[i], ys[i]);
+			if (removed) {
+				EXPECT_EQ(NULL, info) << "(" << xs[i] << ", " << ys[i] << ")";
+			}
+			else if (info) {
+				EXPECT_EQ(xs[i], info->pos[0]);
+				EXPECT_EQ(ys[i], info->pos[1]);
+			}
+		}
+	}
+
+	/* The number of vertex positions RemoveArea visits for this rectangle. */
+	static uint64_t PositionCount(int minx, int miny, int maxx, int maxy, int step)
+	{
+		const int x0 = (int)ceilf((float)minx / step);
+		const int y0 = (int)ceilf((float)miny / step);
+		const int x1 = (int)floorf((float)maxx / step);
+		const int y1 = (int)floorf((float)maxy / step);
+		return (uint64_t)(x1 - x0 + 1) * (uint64_t)(y1 - y0 + 1);
+	}
+};
+
+/* A rectangle with less positions than table slots looks up each position. */
+TEST(chunk_cache, RemoveAreaPerPosition)
+{
+	TestCache test;
+	test.Fill(64);
+	const unsigned int capacity = test.cache->GetCapacity();
+
+	EXPECT_LT(TestCache::PositionCount(-10, -6, 14, 8, STEP), capacity);
+	test.ExpectRemoveArea(-10, -6, 14, 8, STEP);
+
+	// Bounds between two vertexes are rounded inwards.
+	EXPECT_LT(TestCache::PositionCount(-33, 17, -19, 31, STEP), capacity);
+	test.ExpectRemoveArea(-33, 17, -19, 31, STEP);
+
+	// A coarser step only visits its own positions.
+	EXPECT_LT(TestCache::PositionCount(20, -64, 64, -20, 4), capacity);
+	test.ExpectRemoveArea(20, -64, 64, -20, 4);
+
+	// Removing again finds nothing.
+	EXPECT_EQ(0, test.cache->RemoveArea(-10, -6, 14, 8, STEP));
+
+	// No position between the bounds.
+	EXPECT_EQ(0, test.cache->RemoveArea(1, 1, 3, 3, 4));
+	EXPECT_EQ(capacity, test.cache->GetCapacity());
+}
+
+/* A rectangle with at least as many positions as table slots scans the table. */
+TEST(chunk_cache, RemoveAreaFullScan)
+{
+	TestCache test;
+	test.Fill(64);
+	const unsigned int capacity = test.cache->GetCapacity();
+
+	EXPECT_GE(TestCache::PositionCount(-100000, -9, 100000, 9, STEP), capacity);
+	test.ExpectRemoveArea(-100000, -9, 100000, 9, STEP);
+
+	EXPECT_GE(TestCache::PositionCount(-47, -100000, -13, 100000, STEP), capacity);
+	test.ExpectRemoveArea(-47, -100000, -13, 100000, STEP);
+
+	// Everything left.
+	test.ExpectRemoveArea(-100000, -100000, 100000, 100000, STEP);
+	EXPECT_EQ(0, test.cache->GetCount());
+}
+
+/* 65536 positions on each axis, the count of positions does not fit in 32 bits
+ * and must not be mistaken for a small rectangle. */
+TEST(chunk_cache, RemoveAreaHuge)
+{
+	TestCache test;
+	test.Fill(64);
+
+	const int extent = 65536 * STEP / 2;
+	EXPECT_EQ(1ull << 32, TestCache::PositionCount(-extent, -extent, extent - STEP, extent - STEP, STEP));
+	test.ExpectRemoveArea(-extent, -extent, extent - STEP, extent - STEP, STEP);
+	EXPECT_EQ(0, test.cache->GetCount());
+}
+
+/* Both paths remove the same vertexes, the remaining vertexes are still found
+ * after the probe chains were shifted and new vertexes can be added. */
+TEST(chunk_cache, RemoveAreaPathsMatch)
+{
+	TestCache test;
+	test.Fill(64);
+	EXPECT_LT(TestCache::PositionCount(-30, -30, 30, 64, STEP), test.cache->GetCapacity());
+	test.ExpectRemoveArea(-30, -30, 30, 64, STEP);
+
+	TestCache other;
+	other.Fill(64);
+	// Same vertexes, but a rectangle larger than the table to use the full scan.
+	EXPECT_GE(TestCache::PositionCount(-30, -30, 30, 100000, STEP), other.cache->GetCapacity());
+	other.ExpectRemoveArea(-30, -30, 30, 100000, STEP);
+
+	EXPECT_EQ(test.cache->GetCount(), other.cache->GetCount());
+	for (unsigned int i = 0; i < test.xs.size(); ++i) {
+		EXPECT_EQ(test.cache->GetVertexZoneInfo(test.xs[i], test.ys[i]) == NULL,
+		          other.cache->GetVertexZoneInfo(test.xs[i], test.ys[i]) == NULL);
+	}
+
+	for (int x = -30; x <= 30; x += STEP) {
+		test.Add(x, 0);
+	}
+	for (int x = -30; x <= 30; x += STEP) {
+		EXPECT_TRUE(test.cache->GetVertexZoneInfo(x, 0) != NULL);
+	}
+}
+
+/* A zone footprint in real coordinates is converted to relative positions
+ * rounded outwards as KX_Terrain::InvalidateArea does: every vertex under the
+ * footprint is removed and no vertex farther than one interval is. */
+TEST(chunk_cache, RemoveFootprint)
+{
+	TestCache test;
+	test.Fill(64);
+
+	// Real distance between two relative positions for a 10 m chunk of 8 faces.
+	const float interval = 10.0f / 8 * 2.0f;
+	const float footprints[][4] = {
+		{-12.3f, 4.1f, 7.9f, 21.6f},
+		{30.0f, -80.0f, 31.0f, -79.5f},
+		{-200.0f, -3.0f, 200.0f, 3.0f}
+	};
+
+	for (unsigned short i = 0; i < ARRAY_SIZE(footprints); ++i) {
+		const float *footprint = footprints[i];
+		const int minx = (int)floorf(footprint[0] / interval);
+		const int miny = (int)floorf(footprint[1] / interval);
+		const int maxx = (int)ceilf(footprint[2] / interval);
+		const int maxy = (int)ceilf(footprint[3] / interval);
+		test.cache->RemoveArea(minx, miny, maxx, maxy, STEP);
+
+		for (unsigned int j = 0; j < test.xs.size(); ++j) {
+			const float x = test.xs[j] * interval;
+			const float y = test.ys[j] * interval;
+			const bool under = (footprint[0] <= x && x <= footprint[2] && footprint[1] <= y && y <= footprint[3]);
+			const bool far = (x < footprint[0] - interval || footprint[2] + interval < x ||
+			                  y < footprint[1] - interval || footprint[3] + interval < y);
+			VertexZoneInfo *info = test.cache->GetVertexZoneInfo(test.xs[j], test.ys[j]);
+			if (under) {
+				EXPECT_EQ(NULL, info);
+			}
+			else if (far && i == 0) {
+				// Only the first footprint is checked, the next ones remove more.
+				EXPECT_TRUE(info != NULL);
+			}
+		}
+	}
+}
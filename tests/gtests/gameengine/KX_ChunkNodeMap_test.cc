@@ -0,0 +1,298 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include <map>
+#include <vector>
+
+#include "KX_ChunkNode.h"
+#include "KX_ChunkNodeMap.h"
+
+/* The nodes are never read by the map, the tests store their own records. */
+struct TestNode
+{
+	unsigned short level;
+	int x;
+	int y;
+	bool removed;
+};
+
+static KX_ChunkNode *as_node(TestNode *node)
+{
+	return reinterpret_cast<KX_ChunkNode *>(node);
+}
+
+static TestNode *as_test_node(KX_ChunkNode *node)
+{
+	return reinterpret_cast<TestNode *>(node);
+}
+
+TEST(chunk_node_map, MortonKey)
+{
+	// x bits go to the even bits, y bits to the odd bits.
+	EXPECT_EQ(0x0ull, KX_ChunkNodeMap::GetKey(0, 0, 0));
+	EXPECT_EQ(0x1ull, KX_ChunkNodeMap::GetKey(0, 1, 0));
+	EXPECT_EQ(0x2ull, KX_ChunkNodeMap::GetKey(0, 0, 1));
+	EXPECT_EQ(0x1Bull, KX_ChunkNodeMap::GetKey(0, 5, 3));
+	EXPECT_EQ(0xFFFFFFFFull, KX_ChunkNodeMap::GetKey(0, 0xFFFF, 0xFFFF));
+	EXPECT_EQ(0x55555555ull, KX_ChunkNodeMap::GetKey(0, 0xFFFF, 0));
+	// The level is in the high 32 bits.
+	EXPECT_EQ((7ull << 32) | 0x1Bull, KX_ChunkNodeMap::GetKey(7, 5, 3));
+
+	/* The four children of a node have consecutive keys whose Morton code
+	 * shifted by two is the code of their parent. */
+	for (unsigned int x = 0; x < 64; ++x) {
+		for (unsigned int y = 0; y < 64; ++y) {
+			const uint64_t parent = KX_ChunkNodeMap::GetKey(3, x, y) & 0xFFFFFFFFull;
+			for (unsigned int i = 0; i < 4; ++i) {
+				const uint64_t child = KX_ChunkNodeMap::GetKey(4, x * 2 + (i & 1), y * 2 + (i >> 1));
+				EXPECT_EQ(4ull, child >> 32);
+				EXPECT_EQ((parent << 2) | i, child & 0xFFFFFFFFull);
+			}
+		}
+	}
+}
+
+/* Full levels, grown from the minimal table, then half of the nodes removed. */
+TEST(chunk_node_map, AddGetRemove)
+{
+	KX_ChunkNodeMap map;
+	std::vector<TestNode> nodes;
+	for (unsigned short level = 1; level <= 7; ++level) {
+		const int count = 1 << (level - 1);
+		for (int x = 0; x < count; ++x) {
+			for (int y = 0; y < count; ++y) {
+				const TestNode node = {level, x, y, false};
+				nodes.push_back(node);
+			}
+		}
+	}
+
+	const size_t memory = map.GetMemoryUsage();
+	for (unsigned int i = 0; i < nodes.size(); ++i) {
+		map.AddNode(as_node(&nodes[i]), nodes[i].level, nodes[i].x, nodes[i].y);
+	}
+	EXPECT_EQ(nodes.size(), map.GetCount());
+	EXPECT_GT(map.GetMemoryUsage(), memory);
+
+	for (unsigned int i = 0; i < nodes.size(); ++i) {
+		EXPECT_EQ(as_node(&nodes[i]), map.GetNode(nodes[i].level, nodes[i].x, nodes[i].y));
+	}
+	// Outside of the levels grids.
+	EXPECT_EQ(NULL, map.GetNode(1, 1, 0));
+	EXPECT_EQ(NULL, map.GetNode(3, 4, 0));
+	EXPECT_EQ(NULL, map.GetNode(8, 0, 0));
+
+	// Removing in a scattered order shifts the following entries of each probe chain.
+	unsigned int removed = 0;
+	for (unsigned int i = 0; i < nodes.size(); ++i) {
+		const unsigned int j = (i * 7919u) % nodes.size();
+		if (j % 2 == 0) {
+			map.RemoveNode(as_node(&nodes[j]), nodes[j].level, nodes[j].x, nodes[j].y);
+			nodes[j].removed = true;
+			++removed;
+		}
+	}
+	EXPECT_EQ(nodes.size() - removed, map.GetCount());
+
+	for (unsigned int i = 0; i < nodes.size(); ++i) {
+		KX_ChunkNode *node = map.GetNode(nodes[i].level, nodes[i].x, nodes[i].y);
+		EXPECT_EQ(nodes[i].removed ? NULL : as_node(&nodes[i]), node);
+	}
+
+	// Removing a node not in the map, or another node at the same key, does nothing.
+	TestNode other = {1, 0, 0, false};
+	map.RemoveNode(as_node(&nodes[0]), 1, 0, 0);
+	map.RemoveNode(as_node(&other), nodes[1].level, nodes[1].x, nodes[1].y);
+	EXPECT_EQ(nodes.size() - removed, map.GetCount());
+
+	for (unsigned int i = 0; i < nodes.size(); ++i) {
+		if (!nodes[i].removed) {
+			map.RemoveNode(as_node(&nodes[i]), nodes[i].level, nodes[i].x, nodes[i].y);
+		}
+	}
+	EXPECT_EQ(0, map.GetCount());
+}
+
+/* An unbalanced quadtree as built by KX_Terrain::NewNodeList. */
+class NodeTree
+{
+public:
+	/* Relative width of the terrain, the root is at level 1. */
+	static const int width = 128;
+	std::vector<TestNode *> nodes;
+	KX_ChunkNodeMap map;
+
+	~NodeTree()
+	{
+		for (unsigned int i = 0; i < nodes.size(); ++i) {
+			map.RemoveNode(as_node(nodes[i]), nodes[i]->level, nodes[i]->x, nodes[i]->y);
+			delete nodes[i];
+		}
+	}
+
+	/* Adds a node centered at a relative position, subdivided while split
+	 * returns true, and checks the grid position of its children. */
+	template <class Split>
+	void Build(int relx, int rely, unsigned short level, Split split)
+	{
+		const unsigned short relativesize = width >> (level - 1);
+		const KX_ChunkNode::Point2D gridPos = KX_ChunkNode::GetGridPos(KX_ChunkNode::Point2D(relx, rely), relativesize, width);
+		TestNode *node = new TestNode();
+		node->level = level;
+		node->x = gridPos.x;
+		node->y = gridPos.y;
+		node->removed = false;
+		nodes.push_back(node);
+		map.AddNode(as_node(node), level, node->x, node->y);
+
+		if (relativesize > 2 && split(level, gridPos.x, gridPos.y)) {
+			// Same order and positions as KX_Terrain::NewNodeList.
+			const int half = relativesize / 4;
+			const int offsets[4][2] = {{-half, -half}, {half, -half}, {-half, half}, {half, half}};
+			for (unsigned short i = 0; i < 4; ++i) {
+				const size_t first = nodes.size();
+				Build(relx + offsets[i][0], rely + offsets[i][1], level + 1, split);
+				const TestNode *child = nodes[first];
+				EXPECT_EQ(gridPos.x * 2 + (i & 1), child->x);
+				EXPECT_EQ(gridPos.y * 2 + (i >> 1), child->y);
+			}
+		}
+	}
+
+	/* The deepest node of the tree at most at this level which contains the
+	 * grid position, found by a linear search. */
+	TestNode *FindNodeOrParent(unsigned short level, int x, int y) const
+	{
+		const int count = 1 << (level - 1);
+		if (x < 0 || y < 0 || x >= count || y >= count) {
+			return NULL;
+		}
+		TestNode *best = NULL;
+		for (unsigned int i = 0; i < nodes.size(); ++i) {
+			TestNode *node = nodes[i];
+			const int shift = level - node->level;
+			if (shift >= 0 && (x >> shift) == node->x && (y >> shift) == node->y &&
+				(!best || node->level > best->level))
+			{
+				best = node;
+			}
+		}
+		return best;
+	}
+};
+
+/* Nodes near the corner (0, 0) of the grid are split down to level 6,
+ * the others stop at level 3. */
+static bool split_corner(unsigned short level, int x, int y)
+{
+	return (level < 3) || (level < 6 && (x << (6 - level)) < 8 && (y << (6 - level)) < 12);
+}
+
+TEST(chunk_node_map, GridPos)
+{
+	NodeTree tree;
+	tree.Build(0, 0, 1, split_corner);
+	EXPECT_EQ(tree.nodes.size(), tree.map.GetCount());
+
+	// The root covers the whole terrain.
+	EXPECT_EQ(0, tree.nodes[0]->x);
+	EXPECT_EQ(0, tree.nodes[0]->y);
+	// Its first child is the corner at the negative relative positions.
+	EXPECT_EQ(0, tree.nodes[1]->x);
+	EXPECT_EQ(0, tree.nodes[1]->y);
+}
+
+TEST(chunk_node_map, NodeOrParent)
+{
+	NodeTree tree;
+	tree.Build(0, 0, 1, split_corner);
+
+	// Every position of every level, as the adjacent node of its neighbours.
+	for (unsigned short level = 1; level <= 7; ++level) {
+		const int count = 1 << (level - 1);
+		for (int x = -1; x <= count; ++x) {
+			for (int y = -1; y <= count; ++y) {
+				KX_ChunkNode *node = tree.map.GetNodeOrParent(level, x, y);
+				EXPECT_EQ(tree.FindNodeOrParent(level, x, y), as_test_node(node))
+				    << "level " << level << " (" << x << ", " << y << ")";
+			}
+		}
+	}
+
+	// A neighbour on the same level when it exists.
+	TestNode *node = as_test_node(tree.map.GetNodeOrParent(6, 3, 4));
+	ASSERT_TRUE(node != NULL);
+	EXPECT_EQ(6, node->level);
+	// The larger leaf next to the subdivided corner.
+	node = as_test_node(tree.map.GetNodeOrParent(6, 8, 4));
+	ASSERT_TRUE(node != NULL);
+	EXPECT_EQ(3, node->level);
+	EXPECT_EQ(1, node->x);
+	EXPECT_EQ(0, node->y);
+	// Outside of the terrain.
+	EXPECT_EQ(NULL, tree.map.GetNodeOrParent(6, -1, 4));
+	EXPECT_EQ(NULL, tree.map.GetNodeOrParent(6, 3, 32));
+}
+
+/* Random adds and removes keep the table full near its maximum load, so the
+ * removals shift long probe chains, some of them wrapping around the end of
+ * the table. Every operation is checked against a std::map. */
+TEST(chunk_node_map, RemoveInterleaved)
+{
+	KX_ChunkNodeMap map;
+	std::map<uint64_t, TestNode *> reference;
+	std::vector<TestNode> nodes(4096);
+	unsigned int seed = 12345;
+
+	for (unsigned int step = 0; step < 20000; ++step) {
+		seed = seed * 1103515245u + 12345u;
+		TestNode *node = &nodes[(seed >> 8) % nodes.size()];
+
+		// The nodes get a position on the first use, at the levels 5 and 6.
+		if (node->level == 0) {
+			const unsigned int index = node - &nodes[0];
+			node->level = 5 + (index & 1);
+			node->x = (index >> 1) % 32;
+			node->y = (index >> 1) / 32;
+			node->removed = true;
+		}
+
+		const uint64_t key = KX_ChunkNodeMap::GetKey(node->level, node->x, node->y);
+		if (node->removed) {
+			// Below the growth threshold of the minimal table, half full.
+			if (reference.size() >= 120) {
+				continue;
+			}
+			map.AddNode(as_node(node), node->level, node->x, node->y);
+			reference[key] = node;
+			node->removed = false;
+		}
+		else {
+			map.RemoveNode(as_node(node), node->level, node->x, node->y);
+			reference.erase(key);
+			node->removed = true;
+		}
+
+		ASSERT_EQ(reference.size(), map.GetCount());
+		if (step % 64 == 0) {
+			for (unsigned int i = 0; i < nodes.size(); ++i) {
+				if (nodes[i].level == 0) {
+					continue;
+				}
+				EXPECT_EQ(nodes[i].removed ? NULL : as_node(&nodes[i]), map.GetNode(nodes[i].level, nodes[i].x, nodes[i].y));
+			}
+		}
+	}
+
+	// The table did not grow, the chains stayed in the minimal table.
+	KX_ChunkNodeMap empty;
+	EXPECT_EQ(empty.GetMemoryUsage(), map.GetMemoryUsage());
+
+	for (unsigned int i = 0; i < nodes.size(); ++i) {
+		if (nodes[i].level != 0 && !nodes[i].removed) {
+			map.RemoveNode(as_node(&nodes[i]), nodes[i].level, nodes[i].x, nodes[i].y);
+		}
+	}
+	EXPECT_EQ(0, map.GetCount());
+}
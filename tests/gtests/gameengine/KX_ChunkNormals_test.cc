@@ -0,0 +1,218 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include <math.h>
+#include <vector>
+
+#include "KX_Chunk.h"
+
+extern "C" {
+#include "BLI_utildefines.h"
+#include "BLI_math_geom.h"
+}
+
+#define CHUNK_SIZE 10.0f
+#define POLY_COUNT 8
+#define VERTEX_COUNT (POLY_COUNT + 1)
+
+/* Positions are given in units of the smallest vertex spacing of the tests,
+ * a chunk of relative size 1 has one unit between two vertices. Both sides of
+ * a seam then sample the heights at bit-identical positions. */
+#define UNIT (CHUNK_SIZE / POLY_COUNT)
+
+enum HeightField {
+	HEIGHT_FLAT,
+	HEIGHT_SLOPE,
+	HEIGHT_BUMPS
+};
+
+static float height_at(HeightField field, int ux, int uy)
+{
+	const float x = ux * UNIT;
+	const float y = uy * UNIT;
+	switch (field) {
+		case HEIGHT_FLAT:
+			return 5.0f;
+		case HEIGHT_SLOPE:
+			return 0.3f * x - 0.7f * y + 2.0f;
+		case HEIGHT_BUMPS:
+			return 0.3f * x - 0.7f * y + 2.0f * sinf(0.37f * x) * cosf(0.21f * y);
+	}
+	return 0.0f;
+}
+
+/* A chunk grid with its border, filled as KX_Chunk::ConstructVertexes does. */
+struct ChunkGrid {
+	/* Relative size, the vertex spacing in units. */
+	int size;
+	/* Position of the vertex (0, 0) in units. */
+	int originx;
+	int originy;
+	float factor;
+	float heights[VERTEX_COUNT * VERTEX_COUNT];
+	float borderHeights[VERTEX_COUNT * 4];
+
+	ChunkGrid(HeightField field, int size_, int originx_, int originy_)
+		:size(size_),
+		originx(originx_),
+		originy(originy_)
+	{
+		factor = KX_Chunk::GetNormalFactor(POLY_COUNT, CHUNK_SIZE, size);
+		for (int i = 0; i < VERTEX_COUNT; ++i) {
+			borderHeights[i] = Height(field, -1, i);
+			borderHeights[VERTEX_COUNT + i] = Height(field, VERTEX_COUNT, i);
+			borderHeights[VERTEX_COUNT * 2 + i] = Height(field, i, -1);
+			borderHeights[VERTEX_COUNT * 3 + i] = Height(field, i, VERTEX_COUNT);
+			for (int j = 0; j < VERTEX_COUNT; ++j) {
+				heights[j * VERTEX_COUNT + i] = Height(field, i, j);
+			}
+		}
+	}
+
+	float Height(HeightField field, int x, int y) const
+	{
+		return height_at(field, originx + x * size, originy + y * size);
+	}
+
+	void Normal(int x, int y, float r_normal[3]) const
+	{
+		KX_Chunk::ComputeGridNormal(heights, borderHeights, VERTEX_COUNT, x, y, factor, r_normal);
+	}
+
+	/* The normal of a vertex kept on a joint with a chunk ratio times less
+	 * subdivided, as KX_Chunk::ComputeJointVertexesNormal does. */
+	void JointNormal(HeightField field, int x, int y, int ratio, float r_normal[3]) const
+	{
+		KX_Chunk::ComputeCenteredNormal(Height(field, x - ratio, y), Height(field, x + ratio, y),
+		                                Height(field, x, y - ratio), Height(field, x, y + ratio),
+		                                factor / ratio, r_normal);
+	}
+};
+
+static void expect_normal_eq(const float a[3], const float b[3])
+{
+	EXPECT_EQ(a[0], b[0]);
+	EXPECT_EQ(a[1], b[1]);
+	EXPECT_EQ(a[2], b[2]);
+}
+
+static const HeightField fields[] = {HEIGHT_FLAT, HEIGHT_SLOPE, HEIGHT_BUMPS};
+
+TEST(chunk_normals, PaddedHeight)
+{
+	const ChunkGrid grid(HEIGHT_BUMPS, 2, -16, 48);
+	for (int x = -1; x <= VERTEX_COUNT; ++x) {
+		for (int y = -1; y <= VERTEX_COUNT; ++y) {
+			const bool borderx = (x == -1 || x == VERTEX_COUNT);
+			const bool bordery = (y == -1 || y == VERTEX_COUNT);
+			if (borderx && bordery) {
+				continue;
+			}
+			EXPECT_EQ(grid.Height(HEIGHT_BUMPS, x, y),
+			          KX_Chunk::GetPaddedHeight(grid.heights, grid.borderHeights, VERTEX_COUNT, x, y));
+		}
+	}
+}
+
+/* Two chunks of the same size share their border vertices and must compute
+ * the same normals for them. */
+TEST(chunk_normals, SameLevelSeam)
+{
+	for (unsigned short f = 0; f < ARRAY_SIZE(fields); ++f) {
+		const HeightField field = fields[f];
+		const int size = 2;
+		const int span = POLY_COUNT * size;
+		const ChunkGrid chunk(field, size, -span, 3 * span);
+		const ChunkGrid right(field, size, 0, 3 * span);
+		const ChunkGrid back(field, size, -span, 4 * span);
+
+		for (int i = 0; i < VERTEX_COUNT; ++i) {
+			float n1[3], n2[3];
+			chunk.Normal(POLY_COUNT, i, n1);
+			right.Normal(0, i, n2);
+			expect_normal_eq(n1, n2);
+
+			chunk.Normal(i, POLY_COUNT, n1);
+			back.Normal(i, 0, n2);
+			expect_normal_eq(n1, n2);
+		}
+	}
+}
+
+/* A chunk next to a chunk one or two levels less subdivided keeps one vertex
+ * on ratio on the joint, these vertices must get the normals of the larger chunk. */
+TEST(chunk_normals, JointSeam)
+{
+	for (unsigned short f = 0; f < ARRAY_SIZE(fields); ++f) {
+		const HeightField field = fields[f];
+		for (int ratio = 2; ratio <= 4; ratio *= 2) {
+			const int size = 2;
+			const int coarseSize = size * ratio;
+			const int coarseSpan = POLY_COUNT * coarseSize;
+			const ChunkGrid coarse(field, coarseSize, coarseSpan, -coarseSpan);
+			// Chunks on the left and on the back edge of the large chunk.
+			const ChunkGrid left(field, size, coarseSpan - POLY_COUNT * size, -coarseSpan);
+			const ChunkGrid back(field, size, coarseSpan, 0);
+
+			EXPECT_EQ(coarse.factor, left.factor / ratio);
+
+			for (int i = 0; i < VERTEX_COUNT; i += ratio) {
+				float n1[3], n2[3];
+				coarse.Normal(0, i / ratio, n1);
+				left.JointNormal(field, POLY_COUNT, i, ratio, n2);
+				expect_normal_eq(n1, n2);
+
+				coarse.Normal(i / ratio, POLY_COUNT, n1);
+				back.JointNormal(field, i, 0, ratio, n2);
+				expect_normal_eq(n1, n2);
+			}
+		}
+	}
+}
+
+/* The normals match the former per vertex quad normal computed with
+ * normal_quad_v3 on the four neighbour vertices. */
+TEST(chunk_normals, QuadNormal)
+{
+	for (unsigned short f = 0; f < ARRAY_SIZE(fields); ++f) {
+		const HeightField field = fields[f];
+		const ChunkGrid grid(field, 2, 64, -32);
+		const float spacing = grid.size * UNIT;
+
+		for (int x = 0; x < VERTEX_COUNT; ++x) {
+			for (int y = 0; y < VERTEX_COUNT; ++y) {
+				const float px = (grid.originx + x * grid.size) * UNIT;
+				const float py = (grid.originy + y * grid.size) * UNIT;
+				const float quad[4][3] = {
+					{px + spacing, py, grid.Height(field, x + 1, y)},
+					{px, py + spacing, grid.Height(field, x, y + 1)},
+					{px - spacing, py, grid.Height(field, x - 1, y)},
+					{px, py - spacing, grid.Height(field, x, y - 1)}
+				};
+				float expected[3];
+				normal_quad_v3(expected, quad[0], quad[1], quad[2], quad[3]);
+
+				float normal[3];
+				grid.Normal(x, y, normal);
+				EXPECT_V3_NEAR(normal, expected, 1e-5f);
+			}
+		}
+	}
+
+	// The flat and the sloped fields have one exact normal.
+	const ChunkGrid flat(HEIGHT_FLAT, 2, 0, 0);
+	const ChunkGrid slope(HEIGHT_SLOPE, 2, 0, 0);
+	float slopeNormal[3] = {-0.3f, 0.7f, 1.0f};
+	normalize_v3(slopeNormal);
+	const float up[3] = {0.0f, 0.0f, 1.0f};
+	for (int x = 0; x < VERTEX_COUNT; ++x) {
+		for (int y = 0; y < VERTEX_COUNT; ++y) {
+			float normal[3];
+			flat.Normal(x, y, normal);
+			expect_normal_eq(normal, up);
+			slope.Normal(x, y, normal);
+			EXPECT_V3_NEAR(normal, slopeNormal, 1e-5f);
+		}
+	}
+}
@@ -0,0 +1,235 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#ifdef WITH_PYTHON
+#  include <Python.h>
+#endif
+
+#include "GPC_NullCanvas.h"
+
+#include "RAS_NullRasterizer.h"
+#include "RAS_ILightObject.h"
+
+#include "KX_ISystem.h"
+#include "KX_KetsjiEngine.h"
+#include "KX_TimeCategoryLogger.h"
+
+#include <cstring>
+
+extern "C" {
+#include "BLI_threads.h"
+#include "PIL_time.h"
+}
+
+#define CANVAS_WIDTH 640
+#define CANVAS_HEIGHT 480
+
+/* As GPG_System without any GHOST system, the time comes from the system timer. */
+class TestSystem : public KX_ISystem
+{
+public:
+	virtual double GetTimeInSeconds()
+	{
+		return PIL_check_seconds_timer();
+	}
+};
+
+static void expect_matrix_near(const MT_Matrix4x4& expected, const MT_Matrix4x4& mat)
+{
+	for (unsigned short i = 0; i < 4; ++i) {
+		for (unsigned short j = 0; j < 4; ++j) {
+			EXPECT_NEAR(expected[i][j], mat[i][j], 1e-6) << "row " << i << ", column " << j;
+		}
+	}
+}
+
+/* The canvas keeps its size without any window, the viewport includes
+ * both pixels as GPC_Canvas. */
+TEST(headless, NullCanvas)
+{
+	GPC_NullCanvas canvas(CANVAS_WIDTH, CANVAS_HEIGHT);
+
+	EXPECT_EQ(CANVAS_WIDTH, canvas.GetWidth());
+	EXPECT_EQ(CANVAS_HEIGHT, canvas.GetHeight());
+	EXPECT_TRUE(canvas.BeginDraw());
+
+	int width, height;
+	canvas.GetDisplayDimensions(width, height);
+	EXPECT_EQ(CANVAS_WIDTH, width);
+	EXPECT_EQ(CANVAS_HEIGHT, height);
+
+	const RAS_Rect& area = canvas.GetDisplayArea();
+	EXPECT_EQ(0, area.GetLeft());
+	EXPECT_EQ(0, area.GetBottom());
+	EXPECT_EQ(CANVAS_WIDTH, area.GetRight());
+	EXPECT_EQ(CANVAS_HEIGHT, area.GetTop());
+
+	// As KX_KetsjiEngine::Render before the scenes are drawn.
+	canvas.SetViewPort(0, 0, canvas.GetWidth(), canvas.GetHeight());
+	const int *viewport = canvas.GetViewPort();
+	EXPECT_EQ(0, viewport[0]);
+	EXPECT_EQ(0, viewport[1]);
+	EXPECT_EQ(CANVAS_WIDTH + 1, viewport[2]);
+	EXPECT_EQ(CANVAS_HEIGHT + 1, viewport[3]);
+
+	EXPECT_FLOAT_EQ(0.5f, canvas.GetMouseNormalizedX(CANVAS_WIDTH / 2));
+	EXPECT_FLOAT_EQ(0.25f, canvas.GetMouseNormalizedY(CANVAS_HEIGHT / 4));
+}
+
+/* The rasterizer computes the glFrustum and glOrtho matrices and keeps the
+ * camera state used by the culling without any GL context. */
+TEST(headless, NullRasterizer)
+{
+	GPC_NullCanvas canvas(CANVAS_WIDTH, CANVAS_HEIGHT);
+	RAS_NullRasterizer rasterizer(&canvas);
+
+	EXPECT_FALSE(rasterizer.Stereo());
+	EXPECT_TRUE(rasterizer.BeginFrame(2.5));
+	EXPECT_EQ(2.5, rasterizer.GetTime());
+
+	const float left = -0.4f, right = 0.6f, bottom = -0.3f, top = 0.5f;
+	const float frustnear = 0.1f, frustfar = 100.0f;
+
+	const MT_Matrix4x4 frustum = rasterizer.GetFrustumMatrix(left, right, bottom, top, frustnear, frustfar, 0.0f, false);
+	expect_matrix_near(MT_Matrix4x4(
+		2.0 * frustnear / (right - left), 0.0, (right + left) / (right - left), 0.0,
+		0.0, 2.0 * frustnear / (top - bottom), (top + bottom) / (top - bottom), 0.0,
+		0.0, 0.0, -(frustfar + frustnear) / (frustfar - frustnear), -2.0 * frustfar * frustnear / (frustfar - frustnear),
+		0.0, 0.0, -1.0, 0.0), frustum);
+
+	const MT_Matrix4x4 ortho = rasterizer.GetOrthoMatrix(left, right, bottom, top, frustnear, frustfar);
+	expect_matrix_near(MT_Matrix4x4(
+		2.0 / (right - left), 0.0, 0.0, -(right + left) / (right - left),
+		0.0, 2.0 / (top - bottom), 0.0, -(top + bottom) / (top - bottom),
+		0.0, 0.0, -2.0 / (frustfar - frustnear), -(frustfar + frustnear) / (frustfar - frustnear),
+		0.0, 0.0, 0.0, 1.0), ortho);
+
+	rasterizer.SetProjectionMatrix(frustum);
+	EXPECT_FALSE(rasterizer.GetCameraOrtho());
+	rasterizer.SetProjectionMatrix(ortho);
+	EXPECT_TRUE(rasterizer.GetCameraOrtho());
+
+	// A camera at (1, 2, 3) without rotation.
+	const MT_Point3 campos(1.0, 2.0, 3.0);
+	MT_Matrix4x4 view;
+	view.setIdentity();
+	view[0][3] = -campos[0];
+	view[1][3] = -campos[1];
+	view[2][3] = -campos[2];
+	MT_Matrix3x3 orientation;
+	orientation.setIdentity();
+	rasterizer.SetViewMatrix(view, orientation, campos, true);
+
+	EXPECT_EQ(campos, rasterizer.GetCameraPosition());
+	expect_matrix_near(view, rasterizer.GetViewMatrix());
+	const MT_Matrix4x4& viewinv = rasterizer.GetViewInvMatrix();
+	EXPECT_NEAR(campos[0], viewinv[0][3], 1e-6);
+	EXPECT_NEAR(campos[1], viewinv[1][3], 1e-6);
+	EXPECT_NEAR(campos[2], viewinv[2][3], 1e-6);
+
+	// The lights never have any shadow buffer to render.
+	RAS_ILightObject *light = rasterizer.CreateLight();
+	ASSERT_TRUE(light != NULL);
+	EXPECT_FALSE(light->HasShadowBuffer());
+	delete light;
+}
+
+/* The stereo correction of the frustum is the same as RAS_OpenGLRasterizer. */
+TEST(headless, NullRasterizerStereo)
+{
+	GPC_NullCanvas canvas(CANVAS_WIDTH, CANVAS_HEIGHT);
+	RAS_NullRasterizer rasterizer(&canvas);
+
+	rasterizer.SetStereoMode(RAS_IRasterizer::RAS_STEREO_ANAGLYPH);
+	rasterizer.SetEyeSeparation(0.1f);
+	rasterizer.SetFocalLength(1.0f);
+	EXPECT_TRUE(rasterizer.Stereo());
+
+	rasterizer.SetEye(RAS_IRasterizer::RAS_STEREO_LEFTEYE);
+	const MT_Matrix4x4 leftEye = rasterizer.GetFrustumMatrix(-1.0f, 1.0f, -1.0f, 1.0f, 1.0f, 10.0f, 1.0f, false);
+	rasterizer.SetEye(RAS_IRasterizer::RAS_STEREO_RIGHTEYE);
+	const MT_Matrix4x4 rightEye = rasterizer.GetFrustumMatrix(-1.0f, 1.0f, -1.0f, 1.0f, 1.0f, 10.0f, 1.0f, false);
+
+	// The frustum is shifted by half the eye separation at the focal length.
+	EXPECT_NEAR(0.05, leftEye[0][2], 1e-6);
+	EXPECT_NEAR(-0.05, rightEye[0][2], 1e-6);
+	EXPECT_NEAR(leftEye[0][0], rightEye[0][0], 1e-6);
+}
+
+/* The profile totals of the benchmark report accumulate every logged time,
+ * unlike the averages which only keep the last measurements. */
+TEST(headless, ProfileTotal)
+{
+	KX_TimeCategoryLogger logger(2);
+	logger.AddCategory(0);
+	logger.AddCategory(1);
+
+	double now = 0.0;
+	for (unsigned short frame = 0; frame < 10; ++frame) {
+		logger.StartLog(0, now);
+		now += 1.0;
+		logger.StartLog(1, now);
+		now += 0.5;
+		logger.NextMeasurement(now);
+	}
+
+	EXPECT_NEAR(10.0, logger.GetTotal(0), 1e-9);
+	EXPECT_NEAR(5.0, logger.GetTotal(1), 1e-9);
+	EXPECT_NEAR(15.0, logger.GetTotal(), 1e-9);
+	// Only the last measurement is used by the average.
+	EXPECT_NEAR(1.0, logger.GetAverage(0), 1e-9);
+}
+
+/* The engine is set up as GPG_Application::initEngine does for the
+ * headless player. */
+TEST(headless, EngineSetup)
+{
+	BLI_threadapi_init();
+#ifdef WITH_PYTHON
+	// The engine creates its profile dictionary.
+	const bool initPython = !Py_IsInitialized();
+	if (initPython) {
+		Py_Initialize();
+	}
+#endif
+
+	{
+		TestSystem system;
+		GPC_NullCanvas canvas(CANVAS_WIDTH, CANVAS_HEIGHT);
+		RAS_NullRasterizer rasterizer(&canvas);
+
+		KX_KetsjiEngine *engine = new KX_KetsjiEngine(&system);
+		EXPECT_FALSE(engine->GetHeadless());
+		EXPECT_TRUE(engine->GetTaskScheduler() != NULL);
+
+		engine->SetCanvas(&canvas);
+		engine->SetRasterizer(&rasterizer);
+		engine->SetHeadless(true);
+		engine->SetUseFixedTime(true);
+
+		EXPECT_TRUE(engine->GetHeadless());
+		EXPECT_TRUE(engine->GetUseFixedTime());
+		EXPECT_EQ(&canvas, engine->GetCanvas());
+		EXPECT_EQ(&rasterizer, engine->GetRasterizer());
+
+		// Every category of the report has a label and starts without any time.
+		const int categories = KX_KetsjiEngine::GetProfileCategoryCount();
+		EXPECT_GT(categories, 0);
+		for (int i = 0; i < categories; ++i) {
+			const char *label = KX_KetsjiEngine::GetProfileLabel(i);
+			ASSERT_TRUE(label != NULL);
+			EXPECT_GT(strlen(label), 0);
+			EXPECT_EQ(0.0, engine->GetProfileTotalTime(i));
+		}
+
+		delete engine;
+	}
+
+#ifdef WITH_PYTHON
+	if (initPython) {
+		Py_Finalize();
+	}
+#endif
+	BLI_threadapi_exit();
+}
@@ -0,0 +1,167 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include <stdio.h>
+#include <string>
+
+#include "KX_Profiler.h"
+
+extern "C" {
+#include "BLI_compiler_attrs.h"
+#include "BLI_utildefines.h"
+#include "BLI_math.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
+#include "PIL_time.h"
+}
+
+#define TRACE_FILE "KX_Profiler_test_trace.json"
+#define WORKER_TASKS 8
+#define WORKER_ZONES 20000
+
+/* The profiler enabled with its own worker threads, disabled and cleared at the end. */
+class TestProfiler
+{
+public:
+	TaskScheduler *scheduler;
+	TaskPool *pool;
+
+	TestProfiler()
+	{
+		BLI_threadapi_init();
+		scheduler = BLI_task_scheduler_create(max_ii(BLI_system_thread_count(), 2));
+		pool = BLI_task_pool_create(scheduler, NULL);
+
+		KX_Profiler::Clear();
+		KX_Profiler::SetEnabled(true);
+		// Nothing to close for the first frame.
+		KX_Profiler::NextFrame(0.0);
+	}
+
+	~TestProfiler()
+	{
+		BLI_task_pool_free(pool);
+		BLI_task_scheduler_free(scheduler);
+		KX_Profiler::SetEnabled(false);
+		KX_Profiler::Clear();
+		BLI_threadapi_exit();
+		remove(TRACE_FILE);
+	}
+
+	/* Writes the recorded frames and returns the content of the trace. */
+	static std::string ReadTrace()
+	{
+		std::string trace;
+		EXPECT_TRUE(KX_Profiler::WriteChromeTrace(TRACE_FILE));
+		FILE *fp = fopen(TRACE_FILE, "r");
+		if (!fp) {
+			return trace;
+		}
+		char buffer[4096];
+		size_t size;
+		while ((size = fread(buffer, 1, sizeof(buffer), fp)) > 0) {
+			trace.append(buffer, size);
+		}
+		fclose(fp);
+		return trace;
+	}
+
+	static unsigned int CountOccurrences(const std::string& trace, const char *name)
+	{
+		unsigned int count = 0;
+		for (size_t pos = trace.find(name); pos != std::string::npos; pos = trace.find(name, pos + 1)) {
+			++count;
+		}
+		return count;
+	}
+};
+
+static void task_record_zones(TaskPool *__restrict UNUSED(pool), void *taskdata, int UNUSED(threadid))
+{
+	const unsigned int count = GET_UINT_FROM_POINTER(taskdata);
+	for (unsigned int i = 0; i < count; ++i) {
+		KX_PROFILE_ZONE("Worker outer");
+		KX_PROFILE_ZONE("Worker inner");
+	}
+}
+
+/* Zones of the main and worker threads end in the frame they are closed in. */
+TEST(profiler, RecordZones)
+{
+	TestProfiler test;
+
+	{
+		KX_PROFILE_ZONE("Main outer");
+		KX_PROFILE_ZONE("Main inner");
+	}
+	for (unsigned int i = 0; i < WORKER_TASKS; ++i) {
+		BLI_task_pool_push(test.pool, task_record_zones, SET_UINT_IN_POINTER(1), false, TASK_PRIORITY_HIGH);
+	}
+	BLI_task_pool_work_and_wait(test.pool);
+	KX_Profiler::NextFrame(1.0);
+
+	const std::string trace = TestProfiler::ReadTrace();
+	EXPECT_EQ(1, TestProfiler::CountOccurrences(trace, "\"Main outer\""));
+	EXPECT_EQ(1, TestProfiler::CountOccurrences(trace, "\"Main inner\""));
+	EXPECT_EQ(WORKER_TASKS, TestProfiler::CountOccurrences(trace, "\"Worker outer\""));
+	EXPECT_EQ(WORKER_TASKS, TestProfiler::CountOccurrences(trace, "\"Worker inner\""));
+	EXPECT_EQ(1, TestProfiler::CountOccurrences(trace, "\"Frame\""));
+	// The zone opened last is nested in the first one.
+	EXPECT_NE(std::string::npos, trace.find("\"depth\": 1"));
+}
+
+/* Clearing while the worker threads record zones keeps their buffers valid,
+ * the zones recorded afterwards are kept. */
+TEST(profiler, ClearWhileRecording)
+{
+	TestProfiler test;
+
+	for (unsigned int i = 0; i < WORKER_TASKS; ++i) {
+		BLI_task_pool_push(test.pool, task_record_zones, SET_UINT_IN_POINTER(WORKER_ZONES), false, TASK_PRIORITY_HIGH);
+	}
+
+	double now = 1.0;
+	while (BLI_task_pool_tasks_done(test.pool) < WORKER_TASKS) {
+		KX_Profiler::NextFrame(now);
+		KX_Profiler::Clear();
+		// Clear resets the frame start, the next call only opens a frame.
+		KX_Profiler::NextFrame(now);
+		now += 1.0;
+	}
+	BLI_task_pool_work_and_wait(test.pool);
+
+	// The buffers of the worker threads still record after all the clears.
+	KX_Profiler::Clear();
+	KX_Profiler::NextFrame(now);
+	BLI_task_pool_push(test.pool, task_record_zones, SET_UINT_IN_POINTER(1), false, TASK_PRIORITY_HIGH);
+	BLI_task_pool_work_and_wait(test.pool);
+	{
+		KX_PROFILE_ZONE("Main after clear");
+	}
+	KX_Profiler::NextFrame(now + 1.0);
+
+	const std::string trace = TestProfiler::ReadTrace();
+	EXPECT_EQ(1, TestProfiler::CountOccurrences(trace, "\"Main after clear\""));
+	EXPECT_EQ(1, TestProfiler::CountOccurrences(trace, "\"Worker outer\""));
+	EXPECT_EQ(1, TestProfiler::CountOccurrences(trace, "\"Frame\""));
+}
+
+/* A zone open during Clear is dropped, the next zones are recorded. */
+TEST(profiler, ClearOpenZone)
+{
+	TestProfiler test;
+
+	KX_Profiler::BeginZone("Dropped");
+	KX_Profiler::Clear();
+	KX_Profiler::NextFrame(1.0);
+	KX_Profiler::EndZone();
+	{
+		KX_PROFILE_ZONE("Kept");
+	}
+	KX_Profiler::NextFrame(2.0);
+
+	const std::string trace = TestProfiler::ReadTrace();
+	EXPECT_EQ(0, TestProfiler::CountOccurrences(trace, "\"Dropped\""));
+	EXPECT_EQ(1, TestProfiler::CountOccurrences(trace, "\"Kept\""));
+}
@@ -0,0 +1,330 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "KX_Scene.h"
+#include "KX_GameObject.h"
+
+#include "NG_LoopBackNetworkDeviceInterface.h"
+
+#include "SG_Controller.h"
+#include "SG_Node.h"
+
+#include <cstring>
+#include <vector>
+
+extern "C" {
+#include "BLI_task.h"
+#include "BLI_threads.h"
+#include "DNA_scene_types.h"
+}
+
+/// Above the number of root hierarchies updated in parallel by KX_Scene::UpdateParents.
+#define HIERARCHIES 12
+#define CHILDREN 3
+#define THREADS 4
+
+/// Records the thread of its updates, thread safe or not as a physics IPO.
+class TestController : public SG_Controller
+{
+public:
+	bool threadSafe;
+	unsigned int updates;
+	bool updatedInThread;
+
+	TestController(bool safe)
+		:threadSafe(safe),
+		updates(0),
+		updatedInThread(false)
+	{
+	}
+
+	virtual bool Update(double time)
+	{
+		++updates;
+		if (!BLI_thread_is_main()) {
+			updatedInThread = true;
+		}
+		// The parent relation computes the world transform.
+		return false;
+	}
+
+	virtual bool IsThreadSafe() const
+	{
+		return threadSafe;
+	}
+
+	virtual void SetSimulatedTime(double time)
+	{
+	}
+
+	virtual SG_Controller *GetReplica(SG_Node *destnode)
+	{
+		return NULL;
+	}
+
+	virtual void SetOption(int option, int value)
+	{
+	}
+};
+
+/// The threads of the engine, several workers even on a single core.
+class TestThreads
+{
+public:
+	TaskScheduler *scheduler;
+
+	TestThreads()
+	{
+		BLI_threadapi_init();
+		scheduler = BLI_task_scheduler_create(THREADS);
+	}
+
+	~TestThreads()
+	{
+		BLI_task_scheduler_free(scheduler);
+		BLI_threadapi_exit();
+	}
+};
+
+/* A scene without any blender data as KX_BlenderSceneConverter::ConvertScene
+ * sets it up, its objects are removed with the scene. */
+class TestScene
+{
+public:
+	NG_LoopBackNetworkDeviceInterface network;
+	Scene blenderScene;
+	KX_Scene *scene;
+	std::vector<KX_GameObject *> objects;
+
+	TestScene(const TestThreads& threads)
+	{
+		memset(&blenderScene, 0, sizeof(blenderScene));
+		scene = new KX_Scene(NULL, NULL, &network, "TestScene", &blenderScene, NULL);
+		scene->SetTaskScheduler(threads.scheduler);
+	}
+
+	~TestScene()
+	{
+		for (std::vector<KX_GameObject *>::iterator it = objects.begin(); it != objects.end(); ++it) {
+			// As KX_Scene::RemoveNodeDestructObject, the node outlives its object.
+			SG_Node *node = (*it)->GetSGNode();
+			(*it)->Release();
+			delete node;
+		}
+		delete scene;
+	}
+
+	KX_GameObject *AddObject(KX_GameObject *parent, unsigned int index)
+	{
+		KX_GameObject *gameobj = new KX_GameObject(scene, KX_Scene::m_callbacks);
+		if (parent) {
+			parent->GetSGNode()->AddChild(gameobj->GetSGNode());
+		}
+		SetTransform(gameobj, index, 0);
+		objects.push_back(gameobj);
+		return gameobj;
+	}
+
+	/// Builds the root hierarchies, each root with children and a grandchild per child.
+	void AddHierarchies(unsigned int count, std::vector<KX_GameObject *>& roots)
+	{
+		unsigned int index = 0;
+		for (unsigned int i = 0; i < count; ++i) {
+			KX_GameObject *root = AddObject(NULL, index++);
+			for (unsigned int j = 0; j < CHILDREN; ++j) {
+				KX_GameObject *child = AddObject(root, index++);
+				AddObject(child, index++);
+			}
+			roots.push_back(root);
+		}
+	}
+
+	/// A different transform per object and per frame, the parents rotate and scale their children.
+	static void SetTransform(KX_GameObject *gameobj, unsigned int index, unsigned int frame)
+	{
+		const double value = index * 0.37 + frame * 0.11;
+		gameobj->NodeSetLocalPosition(MT_Point3(value, 1.0 - value, 0.5 * value));
+		gameobj->NodeSetLocalOrientation(MT_Matrix3x3(MT_Vector3(0.3 * value, -0.2 * value, 0.1 + value)));
+		gameobj->NodeSetLocalScale(MT_Vector3(1.0 + 0.01 * index, 1.0, 1.0 + 0.02 * frame));
+	}
+};
+
+/// The world transform as UpdateWorldData computes it from the parent transforms.
+static void expect_world_transform(KX_GameObject *gameobj)
+{
+	SG_Node *node = gameobj->GetSGNode();
+	SG_Node *parent = node->GetSGParent();
+
+	MT_Point3 position = node->GetLocalPosition();
+	MT_Matrix3x3 orientation = node->GetLocalOrientation();
+	MT_Vector3 scale = node->GetLocalScale();
+	if (parent) {
+		const MT_Vector3& pscale = parent->GetWorldScaling();
+		const MT_Matrix3x3& porientation = parent->GetWorldOrientation();
+		position = parent->GetWorldPosition() + pscale * (porientation * position);
+		orientation = porientation * orientation;
+		scale = pscale * scale;
+	}
+
+	for (unsigned short i = 0; i < 3; ++i) {
+		EXPECT_NEAR(position[i], gameobj->NodeGetWorldPosition()[i], 1e-9);
+		EXPECT_NEAR(scale[i], gameobj->NodeGetWorldScaling()[i], 1e-9);
+		for (unsigned short j = 0; j < 3; ++j) {
+			EXPECT_NEAR(orientation[i][j], gameobj->NodeGetWorldOrientation()[i][j], 1e-9);
+		}
+	}
+}
+
+static void expect_same_world_transforms(const std::vector<KX_GameObject *>& expected, const std::vector<KX_GameObject *>& objects)
+{
+	ASSERT_EQ(expected.size(), objects.size());
+	for (unsigned int i = 0; i < objects.size(); ++i) {
+		// The same operations in the same order give the same values.
+		for (unsigned short j = 0; j < 3; ++j) {
+			EXPECT_EQ(expected[i]->NodeGetWorldPosition()[j], objects[i]->NodeGetWorldPosition()[j]) << "object " << i;
+			EXPECT_EQ(expected[i]->NodeGetWorldScaling()[j], objects[i]->NodeGetWorldScaling()[j]) << "object " << i;
+			for (unsigned short k = 0; k < 3; ++k) {
+				EXPECT_EQ(expected[i]->NodeGetWorldOrientation()[j][k], objects[i]->NodeGetWorldOrientation()[j][k]) << "object " << i;
+			}
+		}
+		expect_world_transform(objects[i]);
+	}
+}
+
+/// Updates the scheduled roots in their order, as the scenegraph update does on a single thread.
+static void update_serial(const std::vector<KX_GameObject *>& roots, double curtime)
+{
+	for (std::vector<KX_GameObject *>::const_iterator it = roots.begin(); it != roots.end(); ++it) {
+		(*it)->GetSGNode()->UpdateWorldData(curtime);
+	}
+}
+
+/* The hierarchies updated per group give the same world transforms as the
+ * serial update, when the roots and when only children are modified. */
+TEST(scenegraph_update, GroupedTransforms)
+{
+	TestThreads threads;
+	TestScene grouped(threads);
+	TestScene serial(threads);
+
+	std::vector<KX_GameObject *> groupedRoots;
+	std::vector<KX_GameObject *> serialRoots;
+	grouped.AddHierarchies(HIERARCHIES, groupedRoots);
+	serial.AddHierarchies(HIERARCHIES, serialRoots);
+
+	grouped.scene->UpdateParents(0.0);
+	update_serial(serialRoots, 0.0);
+	expect_same_world_transforms(serial.objects, grouped.objects);
+
+	// Only the children of the roots are modified, their subtrees read the previous root transforms.
+	for (unsigned int i = 0; i < grouped.objects.size(); ++i) {
+		if (grouped.objects[i]->GetSGNode()->GetSGParent() && !grouped.objects[i]->GetSGNode()->GetSGChildren().empty()) {
+			TestScene::SetTransform(grouped.objects[i], i, 1);
+			TestScene::SetTransform(serial.objects[i], i, 1);
+		}
+	}
+	grouped.scene->UpdateParents(1.0);
+	for (unsigned int i = 0; i < serial.objects.size(); ++i) {
+		SG_Node *node = serial.objects[i]->GetSGNode();
+		if (node->GetSGParent() && !node->GetSGChildren().empty()) {
+			node->UpdateWorldData(1.0);
+		}
+	}
+	expect_same_world_transforms(serial.objects, grouped.objects);
+
+	// The roots and the grandchildren, a grandchild is updated with its root in the same group.
+	for (unsigned int i = 0; i < grouped.objects.size(); ++i) {
+		if (grouped.objects[i]->GetSGNode()->GetSGChildren().empty() || !grouped.objects[i]->GetSGNode()->GetSGParent()) {
+			TestScene::SetTransform(grouped.objects[i], i, 2);
+			TestScene::SetTransform(serial.objects[i], i, 2);
+		}
+	}
+	grouped.scene->UpdateParents(2.0);
+	update_serial(serialRoots, 2.0);
+	expect_same_world_transforms(serial.objects, grouped.objects);
+}
+
+/* Below the number of groups of a parallel update, the hierarchies are updated
+ * on the calling thread. */
+TEST(scenegraph_update, FewHierarchies)
+{
+	TestThreads threads;
+	TestScene test(threads);
+
+	std::vector<KX_GameObject *> roots;
+	test.AddHierarchies(2, roots);
+
+	std::vector<TestController *> controllers;
+	for (std::vector<KX_GameObject *>::iterator it = test.objects.begin(); it != test.objects.end(); ++it) {
+		TestController *controller = new TestController(true);
+		(*it)->GetSGNode()->AddSGController(controller);
+		controller->SetObject((*it)->GetSGNode());
+		controllers.push_back(controller);
+	}
+
+	test.scene->UpdateParents(0.0);
+	for (unsigned int i = 0; i < controllers.size(); ++i) {
+		// A child is updated again with each of its scheduled parents.
+		EXPECT_GE(controllers[i]->updates, 1u);
+		EXPECT_FALSE(controllers[i]->updatedInThread);
+		expect_world_transform(test.objects[i]);
+	}
+}
+
+/* A hierarchy with a controller that isn't thread safe, even on a child of the
+ * updated node, is updated on the main thread. The other ones still get the
+ * same transforms. */
+TEST(scenegraph_update, UnsafeControllers)
+{
+	TestThreads threads;
+	TestScene test(threads);
+
+	std::vector<KX_GameObject *> roots;
+	test.AddHierarchies(HIERARCHIES, roots);
+
+	// The unsafe controllers are on a grandchild of the first hierarchy and on the root of the last one.
+	std::vector<TestController *> unsafeControllers;
+	std::vector<TestController *> safeControllers;
+	for (unsigned int i = 0; i < HIERARCHIES; ++i) {
+		SG_Node *root = roots[i]->GetSGNode();
+		SG_Node *node = (i == 0) ? root->GetSGChildren().front()->GetSGChildren().front() : root;
+		TestController *controller = new TestController(i != 0 && i != (HIERARCHIES - 1));
+		node->AddSGController(controller);
+		controller->SetObject(node);
+		if (controller->threadSafe) {
+			safeControllers.push_back(controller);
+		}
+		else {
+			unsafeControllers.push_back(controller);
+		}
+	}
+
+	// Twice, once with every node scheduled and once with the roots only.
+	for (unsigned int frame = 0; frame < 2; ++frame) {
+		for (std::vector<KX_GameObject *>::iterator it = roots.begin(); it != roots.end(); ++it) {
+			TestScene::SetTransform(*it, 0, frame);
+		}
+		std::vector<unsigned int> unsafeUpdates;
+		for (std::vector<TestController *>::iterator it = unsafeControllers.begin(); it != unsafeControllers.end(); ++it) {
+			unsafeUpdates.push_back((*it)->updates);
+		}
+		std::vector<unsigned int> safeUpdates;
+		for (std::vector<TestController *>::iterator it = safeControllers.begin(); it != safeControllers.end(); ++it) {
+			safeUpdates.push_back((*it)->updates);
+		}
+
+		test.scene->UpdateParents(frame);
+
+		for (unsigned int i = 0; i < unsafeControllers.size(); ++i) {
+			EXPECT_GT(unsafeControllers[i]->updates, unsafeUpdates[i]);
+			EXPECT_FALSE(unsafeControllers[i]->updatedInThread);
+		}
+		for (unsigned int i = 0; i < safeControllers.size(); ++i) {
+			EXPECT_GT(safeControllers[i]->updates, safeUpdates[i]);
+		}
+		for (std::vector<KX_GameObject *>::iterator it = test.objects.begin(); it != test.objects.end(); ++it) {
+			expect_world_transform(*it);
+		}
+	}
+}
@@ -0,0 +1,255 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include <math.h>
+#include <new>
+#include <vector>
+
+#include "KX_IDeformableTerrain.h"
+#include "KX_TerrainDeformation.h"
+#include "KX_TerrainPool.h"
+#include "KX_TerrainZone.h"
+
+/* Relative positions between two vertexes of the smallest chunks. */
+#define STEP 4
+/* Real distance between two vertexes of the smallest chunks. */
+#define CELL_SIZE 2.5f
+
+/* A terrain whose zones give a slope, the deformation deltas are applied
+ * on top as KX_Terrain::GetVertexInfos does. */
+class FakeTerrain : public KX_IDeformableTerrain
+{
+public:
+	mutable KX_TerrainPool pool;
+	KX_TerrainDeformation deformation;
+	std::vector<std::vector<float> > invalidatedAreas;
+
+	FakeTerrain()
+		:pool(sizeof(VertexZoneInfo), 512),
+		deformation(this, STEP, CELL_SIZE)
+	{
+	}
+
+	static float ZoneHeight(int x, int y)
+	{
+		return 0.25f * x - 0.125f * y + ((x / STEP + y / STEP) % 3 == 0 ? 1.0f : 0.0f);
+	}
+
+	virtual void GetVertexInfos(unsigned int count, const int *x, const int *y, VertexZoneInfo **r_infos) const
+	{
+		for (unsigned int i = 0; i < count; ++i) {
+			VertexZoneInfo *info = new (pool.Alloc()) VertexZoneInfo(&pool);
+			info->height = ZoneHeight(x[i], y[i]);
+			r_infos[i] = info;
+		}
+		deformation.ApplyDeltas(count, x, y, r_infos);
+	}
+
+	virtual void InvalidateArea(float minx, float miny, float maxx, float maxy)
+	{
+		std::vector<float> area(4);
+		area[0] = minx;
+		area[1] = miny;
+		area[2] = maxx;
+		area[3] = maxy;
+		invalidatedAreas.push_back(area);
+	}
+
+	/* The height of a vertex of the smallest chunks grid. */
+	float Height(int gx, int gy) const
+	{
+		return RelativeHeight(gx * STEP, gy * STEP);
+	}
+
+	float RelativeHeight(int x, int y) const
+	{
+		VertexZoneInfo *info;
+		GetVertexInfos(1, &x, &y, &info);
+		const float height = info->height;
+		info->Release();
+		return height;
+	}
+
+	/* The deformation of a vertex of the smallest chunks grid. */
+	float Delta(int gx, int gy) const
+	{
+		return Height(gx, gy) - ZoneHeight(gx * STEP, gy * STEP);
+	}
+};
+
+/* The brush falloff at a vertex as in KX_TerrainDeformation::Brush, 0 outside. */
+static float falloff(int gx, int gy, float x, float y, float radius)
+{
+	const float dx = gx * CELL_SIZE - x;
+	const float dy = gy * CELL_SIZE - y;
+	const float distance = sqrtf(dx * dx + dy * dy) / radius;
+	if (distance >= 1.0f) {
+		return 0.0f;
+	}
+	return (1.0f - distance * distance) * (1.0f - distance * distance);
+}
+
+/* Brushes centered across tile borders and on both signs of x and y. */
+static const float centers[][2] = {{0.0f, 0.0f}, {80.0f, -80.0f}, {-77.5f, 40.0f}, {-2.5f, -2.5f}};
+
+TEST(terrain_deformation, RaiseLower)
+{
+	FakeTerrain terrain;
+	const float radius = 12.0f;
+	const float strength = 3.0f;
+
+	for (unsigned short c = 0; c < ARRAY_SIZE(centers); ++c) {
+		const float x = centers[c][0];
+		const float y = centers[c][1];
+		const int cgx = (int)floorf(x / CELL_SIZE + 0.5f);
+		const int cgy = (int)floorf(y / CELL_SIZE + 0.5f);
+
+		terrain.deformation.Brush(KX_TerrainDeformation::BRUSH_RAISE, x, y, radius, strength, 0.0f);
+		// The center is on a vertex, it is raised by the full strength.
+		EXPECT_NEAR(strength, terrain.Delta(cgx, cgy), 1e-4f);
+
+		for (int gx = cgx - 8; gx <= cgx + 8; ++gx) {
+			for (int gy = cgy - 8; gy <= cgy + 8; ++gy) {
+				EXPECT_NEAR(strength * falloff(gx, gy, x, y, radius), terrain.Delta(gx, gy), 1e-4f);
+			}
+		}
+
+		// Lowering with the same brush cancels the modification.
+		terrain.deformation.Brush(KX_TerrainDeformation::BRUSH_LOWER, x, y, radius, strength, 0.0f);
+		for (int gx = cgx - 8; gx <= cgx + 8; ++gx) {
+			for (int gy = cgy - 8; gy <= cgy + 8; ++gy) {
+				EXPECT_EQ(0.0f, terrain.Delta(gx, gy));
+			}
+		}
+	}
+}
+
+/* Only the vertexes of the smallest chunks grid have a deformation, the other
+ * relative positions keep the zone heights. */
+TEST(terrain_deformation, GridOnly)
+{
+	FakeTerrain terrain;
+	terrain.deformation.Brush(KX_TerrainDeformation::BRUSH_RAISE, -5.0f, 5.0f, 20.0f, 1.0f, 0.0f);
+
+	for (int x = -40; x <= 40; ++x) {
+		for (int y = -40; y <= 40; ++y) {
+			if ((x % STEP) == 0 && (y % STEP) == 0) {
+				continue;
+			}
+			EXPECT_EQ(FakeTerrain::ZoneHeight(x, y), terrain.RelativeHeight(x, y));
+		}
+	}
+}
+
+TEST(terrain_deformation, Flatten)
+{
+	FakeTerrain terrain;
+	const float x = 10.0f;
+	const float y = -10.0f;
+	const float radius = 15.0f;
+	const float target = -4.0f;
+
+	std::vector<float> before;
+	for (int gx = -4; gx <= 12; ++gx) {
+		for (int gy = -12; gy <= 4; ++gy) {
+			before.push_back(terrain.Height(gx, gy));
+		}
+	}
+
+	terrain.deformation.Brush(KX_TerrainDeformation::BRUSH_FLATTEN, x, y, radius, 1.0f, target);
+
+	unsigned int i = 0;
+	for (int gx = -4; gx <= 12; ++gx) {
+		for (int gy = -12; gy <= 4; ++gy, ++i) {
+			const float f = falloff(gx, gy, x, y, radius);
+			EXPECT_NEAR(before[i] + (target - before[i]) * f, terrain.Height(gx, gy), 1e-5f);
+		}
+	}
+	// The center reaches the height.
+	EXPECT_NEAR(target, terrain.Height(4, -4), 1e-5f);
+
+	// A strength greater than 1 does not go past the height.
+	terrain.deformation.Brush(KX_TerrainDeformation::BRUSH_FLATTEN, x, y, radius, 10.0f, target);
+	EXPECT_NEAR(target, terrain.Height(4, -4), 1e-5f);
+}
+
+TEST(terrain_deformation, Smooth)
+{
+	FakeTerrain terrain;
+	const float x = -20.0f;
+	const float y = 30.0f;
+	const float radius = 10.0f;
+	const int cgx = -8;
+	const int cgy = 12;
+
+	float sum = 0.0f;
+	for (int k = -1; k <= 1; ++k) {
+		for (int l = -1; l <= 1; ++l) {
+			sum += terrain.Height(cgx + k, cgy + l);
+		}
+	}
+
+	terrain.deformation.Brush(KX_TerrainDeformation::BRUSH_SMOOTH, x, y, radius, 1.0f, 0.0f);
+	// The center takes the mean of its neighbours.
+	EXPECT_NEAR(sum / 9.0f, terrain.Height(cgx, cgy), 1e-5f);
+
+	// Vertexes outside the brush are not modified.
+	EXPECT_EQ(0.0f, terrain.Delta(cgx + 4, cgy));
+	EXPECT_EQ(0.0f, terrain.Delta(cgx, cgy - 4));
+}
+
+/* Brushes are invalidated only by Flush, overlapping brushes once as their union. */
+TEST(terrain_deformation, Flush)
+{
+	FakeTerrain terrain;
+	const unsigned int flushedAreas = KX_TerrainDeformation::flushedAreas;
+
+	terrain.deformation.Brush(KX_TerrainDeformation::BRUSH_RAISE, 0.0f, 0.0f, 5.0f, 1.0f, 0.0f);
+	terrain.deformation.Brush(KX_TerrainDeformation::BRUSH_RAISE, 6.0f, 2.0f, 5.0f, 1.0f, 0.0f);
+	terrain.deformation.Brush(KX_TerrainDeformation::BRUSH_LOWER, 100.0f, 100.0f, 2.0f, 1.0f, 0.0f);
+	// Joins the two first brushes.
+	terrain.deformation.Brush(KX_TerrainDeformation::BRUSH_RAISE, 3.0f, -6.0f, 2.0f, 1.0f, 0.0f);
+	EXPECT_EQ(0, terrain.invalidatedAreas.size());
+
+	terrain.deformation.Flush();
+	ASSERT_EQ(2, terrain.invalidatedAreas.size());
+	EXPECT_EQ(flushedAreas + 2, KX_TerrainDeformation::flushedAreas);
+
+	const float expected[2][4] = {{100.0f - 2.0f, 100.0f - 2.0f, 100.0f + 2.0f, 100.0f + 2.0f},
+	                              {-5.0f, -8.0f, 11.0f, 7.0f}};
+	for (unsigned short i = 0; i < 2; ++i) {
+		for (unsigned short j = 0; j < 4; ++j) {
+			EXPECT_EQ(expected[i][j], terrain.invalidatedAreas[i][j]);
+		}
+	}
+
+	// Nothing left to invalidate.
+	terrain.deformation.Flush();
+	EXPECT_EQ(2, terrain.invalidatedAreas.size());
+
+	// A brush between two vertexes modifies and invalidates nothing.
+	terrain.deformation.Brush(KX_TerrainDeformation::BRUSH_RAISE, 1.25f, 1.25f, 0.5f, 1.0f, 0.0f);
+	terrain.deformation.Flush();
+	EXPECT_EQ(2, terrain.invalidatedAreas.size());
+}
+
+/* Tiles are only created where the terrain is modified. */
+TEST(terrain_deformation, Memory)
+{
+	FakeTerrain terrain;
+	EXPECT_EQ(0, terrain.deformation.GetMemoryUsage());
+
+	terrain.deformation.Brush(KX_TerrainDeformation::BRUSH_RAISE, 200.0f, 200.0f, 5.0f, 1.0f, 0.0f);
+	const size_t tileMemory = terrain.deformation.GetMemoryUsage();
+	EXPECT_GT(tileMemory, 0);
+
+	// Across the corner of four tiles.
+	terrain.deformation.Brush(KX_TerrainDeformation::BRUSH_RAISE, 0.0f, 0.0f, 5.0f, 1.0f, 0.0f);
+	EXPECT_EQ(tileMemory * 5, terrain.deformation.GetMemoryUsage());
+
+	// Flattening a vertex already at the height creates nothing.
+	const float height = terrain.Height(-100, -100);
+	terrain.deformation.Brush(KX_TerrainDeformation::BRUSH_FLATTEN, -250.0f, -250.0f, 1.0f, 1.0f, height);
+	EXPECT_EQ(tileMemory * 5, terrain.deformation.GetMemoryUsage());
+}
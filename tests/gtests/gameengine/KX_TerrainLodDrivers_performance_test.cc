@@ -0,0 +1,202 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "KX_TerrainLodDrivers.h"
+
+extern "C" {
+#include "BLI_compiler_attrs.h"
+#include "BLI_utildefines.h"
+#include "BLI_rand.h"
+#include "PIL_time.h"
+}
+
+#include <stdio.h>
+#include <vector>
+
+/* Same settings as the default terrain of the tests scenes. */
+#define TERRAIN_SIZE 2048.0f
+#define MAX_LEVEL 8
+#define CAMERA_MAX_DISTANCE 1000.0f
+#define OBJECT_MAX_DISTANCE 200.0f
+#define MARGIN_FACTOR 1.0f
+
+#define FRAME_COUNT 50
+
+/* A scene object as seen by the former per node walk, every test goes through
+ * a virtual call as KX_GameObject::GetVisible and GetPhysicsController do. */
+class TestObject
+{
+public:
+	MT_Point3 position;
+	float radius;
+	bool dynamic;
+
+	virtual ~TestObject()
+	{
+	}
+
+	virtual bool GetVisible() const
+	{
+		return true;
+	}
+
+	virtual bool IsDynamic() const
+	{
+		return dynamic;
+	}
+};
+
+struct TestScene
+{
+	MT_Point3 camera;
+	std::vector<TestObject *> objects;
+
+	TestScene(RNG *rng, unsigned int count)
+	{
+		for (unsigned int i = 0; i < count; ++i) {
+			TestObject *object = new TestObject();
+			object->position = MT_Point3((BLI_rng_get_float(rng) - 0.5f) * TERRAIN_SIZE,
+			                             (BLI_rng_get_float(rng) - 0.5f) * TERRAIN_SIZE,
+			                             BLI_rng_get_float(rng) * 10.0f);
+			object->radius = 1.0f + BLI_rng_get_float(rng);
+			// One object out of ten has an active dynamic controller.
+			object->dynamic = (i % 10) == 0;
+			objects.push_back(object);
+		}
+	}
+
+	~TestScene()
+	{
+		for (unsigned int i = 0; i < objects.size(); ++i) {
+			delete objects[i];
+		}
+	}
+
+	/* The camera moves along a diagonal of the terrain. */
+	void MoveCamera(unsigned int frame)
+	{
+		const float t = (float)frame / FRAME_COUNT - 0.5f;
+		camera = MT_Point3(t * TERRAIN_SIZE * 0.8f, t * TERRAIN_SIZE * 0.6f, 20.0f);
+	}
+};
+
+/* Statistics of one traversal, both paths must give the same. */
+struct TreeStats
+{
+	unsigned int nodeCount;
+	unsigned int leafCount;
+	unsigned int touchedCount;
+};
+
+/* The former path: every node loops over all the scene objects. */
+static bool old_need_subdivision(const TestScene& scene, const KX_TerrainLodDrivers& drivers,
+                                 const MT_Point3& center, float radius, unsigned short level)
+{
+	float distance = center.distance(scene.camera) - (radius + radius * MARGIN_FACTOR);
+	if (drivers.GetSubdivision(distance, true) > level) {
+		return true;
+	}
+	for (unsigned int i = 0; i < scene.objects.size(); ++i) {
+		const TestObject *object = scene.objects[i];
+		if (!object->GetVisible()) {
+			continue;
+		}
+		distance = center.distance(object->position) - object->radius - radius * 2.0f;
+		if (drivers.GetSubdivision(distance, false) > level) {
+			return true;
+		}
+	}
+	return false;
+}
+
+static bool old_touch_dynamic(const TestScene& scene, const MT_Point3& center, float radius)
+{
+	for (unsigned int i = 0; i < scene.objects.size(); ++i) {
+		const TestObject *object = scene.objects[i];
+		if (!object->GetVisible() || !object->IsDynamic()) {
+			continue;
+		}
+		if ((center.distance(object->position) - radius - object->radius) < 0.0f) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/* Traverses the quadtree as KX_ChunkNode::CalculateVisible does, subdividing
+ * the nodes with NeedCreateNodes and testing the leafs with InNode. */
+static void traverse(const TestScene& scene, const KX_TerrainLodDrivers& drivers, bool oldpath,
+                     const MT_Point3& center, float size, unsigned short level, TreeStats& stats)
+{
+	++stats.nodeCount;
+	const float radius = size * 0.7071f;
+	const bool subdivide = (level < MAX_LEVEL) && (oldpath ?
+		old_need_subdivision(scene, drivers, center, radius, level) :
+		drivers.NeedSubdivision(center, radius, radius, level));
+
+	if (subdivide) {
+		const float quarter = size / 4.0f;
+		for (unsigned short i = 0; i < 4; ++i) {
+			const MT_Point3 childcenter(center.x() + ((i & 1) ? quarter : -quarter),
+			                            center.y() + ((i & 2) ? quarter : -quarter), 0.0f);
+			traverse(scene, drivers, oldpath, childcenter, size / 2.0f, level + 1, stats);
+		}
+	}
+	else {
+		++stats.leafCount;
+		if (oldpath ? old_touch_dynamic(scene, center, radius) : drivers.TouchDynamic(center, radius)) {
+			++stats.touchedCount;
+		}
+	}
+}
+
+/* Runs all the frames, the drivers are gathered and sorted in the grid once per
+ * frame for the new path. */
+static double run_frames(TestScene& scene, KX_TerrainLodDrivers& drivers, bool oldpath, TreeStats& stats)
+{
+	const double start = PIL_check_seconds_timer();
+	for (unsigned int frame = 0; frame < FRAME_COUNT; ++frame) {
+		scene.MoveCamera(frame);
+		if (!oldpath) {
+			drivers.Clear();
+			drivers.AddDriver(scene.camera, 0.0f, true, false);
+			for (unsigned int i = 0; i < scene.objects.size(); ++i) {
+				const TestObject *object = scene.objects[i];
+				if (object->GetVisible()) {
+					drivers.AddDriver(object->position, object->radius, false, object->IsDynamic());
+				}
+			}
+			drivers.BuildGrid();
+		}
+		traverse(scene, drivers, oldpath, MT_Point3(0.0f, 0.0f, 0.0f), TERRAIN_SIZE, 1, stats);
+	}
+	return (PIL_check_seconds_timer() - start) / FRAME_COUNT * 1000.0;
+}
+
+TEST(terrain_lod_drivers, FrameTime)
+{
+	const unsigned int counts[] = {1, 10, 100, 1000, 10000};
+	RNG *rng = BLI_rng_new(0);
+
+	printf("%8s %8s %8s %12s %12s\n", "objects", "nodes", "leafs", "old (ms)", "new (ms)");
+	for (unsigned short i = 0; i < ARRAY_SIZE(counts); ++i) {
+		TestScene scene(rng, counts[i]);
+		KX_TerrainLodDrivers drivers(MAX_LEVEL, CAMERA_MAX_DISTANCE, OBJECT_MAX_DISTANCE, MARGIN_FACTOR);
+
+		TreeStats oldstats = {0, 0, 0};
+		TreeStats newstats = {0, 0, 0};
+		const double oldtime = run_frames(scene, drivers, true, oldstats);
+		const double newtime = run_frames(scene, drivers, false, newstats);
+
+		printf("%8u %8u %8u %12.3f %12.3f\n", counts[i], newstats.nodeCount / FRAME_COUNT,
+		       newstats.leafCount / FRAME_COUNT, oldtime, newtime);
+
+		// The drivers list must subdivide exactly as the former walk.
+		EXPECT_EQ(oldstats.nodeCount, newstats.nodeCount);
+		EXPECT_EQ(oldstats.leafCount, newstats.leafCount);
+		EXPECT_EQ(oldstats.touchedCount, newstats.touchedCount);
+	}
+
+	BLI_rng_free(rng);
+}
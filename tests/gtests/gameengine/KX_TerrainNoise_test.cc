@@ -0,0 +1,98 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "KX_TerrainNoise.h"
+
+extern "C" {
+#include "BLI_utildefines.h"
+#include "BLI_noise.h"
+#include "DNA_texture_types.h"
+}
+
+/* Number of points per batch. Not a multiple of four so the scalar
+ * tail of the SSE2 path is exercised too. */
+#define POINT_COUNT 1031
+
+static const int noisebases[] = {
+	TEX_BLENDER, TEX_STDPERLIN, TEX_NEWPERLIN, TEX_VORONOI_F1, TEX_CELLNOISE
+};
+
+static const float octaves[] = {1.0f, 2.0f, 4.5f, 8.0f};
+
+/* Each seed moves the sampled area, covering both signs of x and y. */
+static const float seeds[][2] = {
+	{0.0f, 0.0f}, {-1234.5f, 987.25f}, {40960.0f, -3.75f}, {-0.375f, -70000.0f}
+};
+
+static float noise_scalar(int musgravetype, int noisebasis, float octave, float x, float y)
+{
+	switch (musgravetype) {
+		case TEX_FBM:
+			return mg_fBm(x, y, 0.0f, 0.9f, 2.1f, octave, noisebasis);
+		case TEX_MFRACTAL:
+			return mg_MultiFractal(x, y, 0.0f, 0.9f, 2.1f, octave, noisebasis);
+		case TEX_RIDGEDMF:
+			return mg_RidgedMultiFractal(x, y, 0.0f, 0.9f, 2.1f, octave, 1.0f, 2.0f, noisebasis);
+	}
+	return 0.0f;
+}
+
+/* Compare the bits, the original Perlin basis returns NaN for some
+ * positions and the batch must return the same NaN. */
+static unsigned int float_as_uint(float f)
+{
+	union { float f; unsigned int i; } u;
+	u.f = f;
+	return u.i;
+}
+
+/* The batch must give the exact same bits as the scalar functions, otherwise
+ * chunks sampled by the batch would not match terrain queries. */
+static void noise_batch_compare(int musgravetype)
+{
+	float x[POINT_COUNT];
+	float y[POINT_COUNT];
+	float values[POINT_COUNT];
+
+	for (unsigned int s = 0; s < ARRAY_SIZE(seeds); ++s) {
+		for (unsigned int i = 0; i < POINT_COUNT; ++i) {
+			// A grid crossing zero, with fractional steps so lattice cells are split.
+			x[i] = seeds[s][0] + ((int)(i % 37) - 18) * 0.71f;
+			y[i] = seeds[s][1] + ((int)(i / 37) - 14) * 1.37f;
+		}
+		// Points exactly on the lattice and on both zeros.
+		x[0] = 0.0f;
+		y[0] = -0.0f;
+		x[1] = -3.0f;
+		y[1] = -5.0f;
+
+		for (unsigned int b = 0; b < ARRAY_SIZE(noisebases); ++b) {
+			for (unsigned int o = 0; o < ARRAY_SIZE(octaves); ++o) {
+				KX_TerrainNoiseBatch(musgravetype, noisebases[b], 0.9f, 2.1f, octaves[o], 1.0f, 2.0f,
+									 POINT_COUNT, x, y, values);
+
+				for (unsigned int i = 0; i < POINT_COUNT; ++i) {
+					const float expected = noise_scalar(musgravetype, noisebases[b], octaves[o], x[i], y[i]);
+					EXPECT_EQ(float_as_uint(expected), float_as_uint(values[i])) << "basis " << noisebases[b] << ", octaves " << octaves[o]
+						<< ", seed " << s << ", position (" << x[i] << ", " << y[i] << ")";
+				}
+			}
+		}
+	}
+}
+
+TEST(terrain_noise, FBm)
+{
+	noise_batch_compare(TEX_FBM);
+}
+
+TEST(terrain_noise, MultiFractal)
+{
+	noise_batch_compare(TEX_MFRACTAL);
+}
+
+TEST(terrain_noise, RidgedMultiFractal)
+{
+	noise_batch_compare(TEX_RIDGEDMF);
+}
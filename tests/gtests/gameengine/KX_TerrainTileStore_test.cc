@@ -0,0 +1,145 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include <new>
+
+#include "KX_TerrainPool.h"
+#include "KX_TerrainTileStore.h"
+#include "KX_TerrainZone.h"
+
+extern "C" {
+#include "BLI_fileops.h"
+}
+
+#define STORE_DIRECTORY "kx_terrain_tile_store_test"
+#define STORE_KEY 0x1234
+
+/* The side of a tile in vertexes, as in KX_TerrainTileStore.cpp. */
+#define TILE_SIZE 64
+
+/* A store in a directory removed at the end of the test. */
+struct TestStore
+{
+	KX_TerrainPool *pool;
+	KX_TerrainTileStore *store;
+
+	TestStore()
+	{
+		pool = new KX_TerrainPool(sizeof(VertexZoneInfo), 512);
+		store = new KX_TerrainTileStore(STORE_DIRECTORY, STORE_KEY);
+	}
+
+	~TestStore()
+	{
+		delete store;
+		EXPECT_EQ(0, pool->GetUsedCount());
+		delete pool;
+		BLI_delete(STORE_DIRECTORY, true, true);
+	}
+
+	void Write(int x, int y, float height)
+	{
+		VertexZoneInfo *info = new (pool->Alloc()) VertexZoneInfo(pool);
+		info->height = height;
+		store->WriteVertexInfos(1, &x, &y, &info);
+		info->Release();
+	}
+
+	/* Returns false if the vertex isn't stored. */
+	bool Read(int x, int y, float *r_height)
+	{
+		VertexZoneInfo *info = new (pool->Alloc()) VertexZoneInfo(pool);
+		unsigned char found;
+		store->ReadVertexInfos(1, &x, &y, &info, &found);
+		*r_height = info->height;
+		info->Release();
+		return found;
+	}
+};
+
+/* Released tiles are the least recently used ones and are read again from the disk. */
+TEST(terrain_tile_store, ReleaseLeastRecentlyUsed)
+{
+	TestStore test;
+	for (int i = 0; i < 3; ++i) {
+		test.Write(i * TILE_SIZE, 0, i + 1.0f);
+	}
+	test.store->Flush();
+
+	const size_t tileMemory = test.store->GetMemoryUsage() / 3;
+	EXPECT_GT(tileMemory, 0);
+
+	float height;
+	EXPECT_TRUE(test.Read(0, 0, &height));
+
+	EXPECT_EQ(tileMemory * 2, test.store->ReleaseTiles(tileMemory));
+	EXPECT_EQ(tileMemory, test.store->GetMemoryUsage());
+
+	/* The first tile was kept, the others are loaded again. */
+	for (int i = 0; i < 3; ++i) {
+		EXPECT_TRUE(test.Read(i * TILE_SIZE, 0, &height));
+		EXPECT_EQ(i + 1.0f, height);
+	}
+	EXPECT_EQ(tileMemory * 3, test.store->GetMemoryUsage());
+}
+
+/* Tiles with vertexes not written to the disk are written before being released. */
+TEST(terrain_tile_store, WriteModifiedOnRelease)
+{
+	TestStore test;
+	test.Write(0, 0, 1.0f);
+	test.Write(-TILE_SIZE, -TILE_SIZE, 2.0f);
+
+	const size_t usage = test.store->GetMemoryUsage();
+	EXPECT_EQ(usage, test.store->ReleaseTiles(0));
+	EXPECT_EQ(0, test.store->GetMemoryUsage());
+
+	float height;
+	EXPECT_TRUE(test.Read(0, 0, &height));
+	EXPECT_EQ(1.0f, height);
+	EXPECT_TRUE(test.Read(-TILE_SIZE, -TILE_SIZE, &height));
+	EXPECT_EQ(2.0f, height);
+
+	/* A vertex modified after a flush is written again. */
+	test.store->Flush();
+	test.Write(0, 0, 3.0f);
+	test.store->ReleaseTiles(0);
+
+	EXPECT_TRUE(test.Read(0, 0, &height));
+	EXPECT_EQ(3.0f, height);
+}
+
+/* Vertexes sampled every few vertexes as by the coarse chunks fill only a few
+ * tiles instead of one tile per finest level tile. */
+TEST(terrain_tile_store, SparseSamples)
+{
+	TestStore test;
+	test.Write(1, 1, 1.0f);
+	const size_t tileMemory = test.store->GetMemoryUsage();
+
+	/* 64 x 64 samples every 8 vertexes over 8 x 8 finest level tiles. */
+	const int step = 8;
+	for (int x = 0; x < TILE_SIZE * step; x += step) {
+		for (int y = 0; y < TILE_SIZE * step; y += step) {
+			test.Write(x, y, x * 1000.0f + y);
+		}
+	}
+
+	/* One tile per sampling interval from 8 to 256 vertexes, one for the vertex
+	 * (0, 0) and the first tile. */
+	EXPECT_EQ(tileMemory * 8, test.store->GetMemoryUsage());
+
+	test.store->ReleaseTiles(0);
+
+	float height;
+	for (int x = 0; x < TILE_SIZE * step; x += step) {
+		for (int y = 0; y < TILE_SIZE * step; y += step) {
+			EXPECT_TRUE(test.Read(x, y, &height));
+			EXPECT_EQ(x * 1000.0f + y, height);
+		}
+	}
+	EXPECT_TRUE(test.Read(1, 1, &height));
+	EXPECT_EQ(1.0f, height);
+	EXPECT_FALSE(test.Read(step / 2, 0, &height));
+}
@@ -0,0 +1,145 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "KX_TerrainZone.h"
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+#include "BLI_utildefines.h"
+#include "BLI_math.h"
+#include "BLI_rand.h"
+#include "BKE_cdderivedmesh.h"
+#include "DNA_meshdata_types.h"
+#include "DNA_terrain_types.h"
+#include "PIL_time.h"
+}
+
+#include <string.h>
+#include <stdio.h>
+
+/* 159 * 159 quads split in two triangles, a bit more than 50k faces. */
+#define MESH_RESOLUTION 159
+#define MESH_SIZE 1000.0f
+
+#define GRID_QUERY_COUNT 1000000
+/* The linear scan is too slow to query as much points. */
+#define LINEAR_QUERY_COUNT 20000
+
+/* A flat grid with jittered inner vertices, so faces have different shapes
+ * and boxes, as in a sculpted zone mesh. */
+static DerivedMesh *zone_mesh_create(RNG *rng)
+{
+	const unsigned int vertcount = (MESH_RESOLUTION + 1) * (MESH_RESOLUTION + 1);
+	const unsigned int facecount = MESH_RESOLUTION * MESH_RESOLUTION * 2;
+	const float step = MESH_SIZE / MESH_RESOLUTION;
+
+	DerivedMesh *dm = CDDM_new(vertcount, 0, facecount, 0, 0);
+	MVert *mvert = dm->getVertArray(dm);
+	MFace *mface = dm->getTessFaceArray(dm);
+
+	for (unsigned int x = 0; x <= MESH_RESOLUTION; ++x) {
+		for (unsigned int y = 0; y <= MESH_RESOLUTION; ++y) {
+			MVert *vert = &mvert[x * (MESH_RESOLUTION + 1) + y];
+			vert->co[0] = x * step;
+			vert->co[1] = y * step;
+			vert->co[2] = 0.0f;
+			if (x != 0 && y != 0 && x != MESH_RESOLUTION && y != MESH_RESOLUTION) {
+				vert->co[0] += (BLI_rng_get_float(rng) - 0.5f) * step * 0.5f;
+				vert->co[1] += (BLI_rng_get_float(rng) - 0.5f) * step * 0.5f;
+			}
+		}
+	}
+
+	MFace *face = mface;
+	for (unsigned int x = 0; x < MESH_RESOLUTION; ++x) {
+		for (unsigned int y = 0; y < MESH_RESOLUTION; ++y) {
+			const unsigned int v = x * (MESH_RESOLUTION + 1) + y;
+			face->v1 = v;
+			face->v2 = v + MESH_RESOLUTION + 1;
+			face->v3 = v + MESH_RESOLUTION + 2;
+			face->v4 = 0;
+			++face;
+			face->v1 = v;
+			face->v2 = v + MESH_RESOLUTION + 2;
+			face->v3 = v + 1;
+			face->v4 = 0;
+			++face;
+		}
+	}
+
+	return dm;
+}
+
+/* The face lookup used before the grid: every face is tested. */
+static int zone_mesh_hit_face_linear(DerivedMesh *dm, const float x, const float y)
+{
+	MVert *mvert = dm->getVertArray(dm);
+	MFace *mface = dm->getTessFaceArray(dm);
+	const unsigned int totface = dm->getNumTessFaces(dm);
+	const float point[2] = {x, y};
+
+	for (unsigned int i = 0; i < totface; ++i) {
+		if (isect_point_tri_v2(point, mvert[mface[i].v1].co, mvert[mface[i].v2].co, mvert[mface[i].v3].co) == 1) {
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+TEST(terrain_zone_mesh, HitFace)
+{
+	RNG *rng = BLI_rng_new(0);
+
+	TerrainZone zoneInfo;
+	memset(&zoneInfo, 0, sizeof(zoneInfo));
+	zoneInfo.octaves = 1;
+	zoneInfo.lacunarity = 2.0f;
+
+	DerivedMesh *dm = zone_mesh_create(rng);
+	printf("Zone mesh with %d faces\n", dm->getNumTessFaces(dm));
+
+	const double buildstart = PIL_check_seconds_timer();
+	KX_TerrainZoneMesh *zoneMesh = new KX_TerrainZoneMesh(NULL, &zoneInfo, dm);
+	printf("Grid build: %.3f ms\n", (PIL_check_seconds_timer() - buildstart) * 1000.0);
+
+	float (*points)[2] = (float (*)[2])MEM_mallocN(sizeof(float[2]) * GRID_QUERY_COUNT, __func__);
+	for (unsigned int i = 0; i < GRID_QUERY_COUNT; ++i) {
+		points[i][0] = 0.01f + BLI_rng_get_float(rng) * (MESH_SIZE - 0.02f);
+		points[i][1] = 0.01f + BLI_rng_get_float(rng) * (MESH_SIZE - 0.02f);
+	}
+
+	// The linear scan, the results are kept to check the grid.
+	int *linearFaces = (int *)MEM_mallocN(sizeof(int) * LINEAR_QUERY_COUNT, __func__);
+	const double linearstart = PIL_check_seconds_timer();
+	for (unsigned int i = 0; i < LINEAR_QUERY_COUNT; ++i) {
+		linearFaces[i] = zone_mesh_hit_face_linear(dm, points[i][0], points[i][1]);
+	}
+	const double lineartime = PIL_check_seconds_timer() - linearstart;
+
+	unsigned int hitcount = 0;
+	const double gridstart = PIL_check_seconds_timer();
+	for (unsigned int i = 0; i < GRID_QUERY_COUNT; ++i) {
+		if (zoneMesh->GetHitFace(points[i][0], points[i][1]) != -1) {
+			++hitcount;
+		}
+	}
+	const double gridtime = PIL_check_seconds_timer() - gridstart;
+
+	const double linearquery = lineartime / LINEAR_QUERY_COUNT * 1.0e6;
+	const double gridquery = gridtime / GRID_QUERY_COUNT * 1.0e6;
+	printf("Linear scan: %u queries in %.3f s, %.3f us per query\n", LINEAR_QUERY_COUNT, lineartime, linearquery);
+	printf("Grid: %u queries in %.3f s, %.3f us per query, %u hits\n", GRID_QUERY_COUNT, gridtime, gridquery, hitcount);
+	printf("Speedup: %.1fx\n", linearquery / gridquery);
+
+	// The grid keeps the faces sorted, it must hit the same face as the linear scan.
+	for (unsigned int i = 0; i < LINEAR_QUERY_COUNT; ++i) {
+		EXPECT_EQ(linearFaces[i], zoneMesh->GetHitFace(points[i][0], points[i][1]));
+	}
+
+	MEM_freeN(linearFaces);
+	MEM_freeN(points);
+	delete zoneMesh;
+	BLI_rng_free(rng);
+}
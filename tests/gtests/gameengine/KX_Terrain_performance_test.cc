@@ -0,0 +1,339 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "KX_Terrain.h"
+#include "KX_TerrainZone.h"
+#include "KX_Chunk.h"
+#include "KX_ChunkNode.h"
+#include "KX_ChunkCache.h"
+#include "KX_Camera.h"
+
+#include "EXP_ListValue.h"
+
+#include "RAS_CameraData.h"
+#include "RAS_IPolygonMaterial.h"
+#include "RAS_MaterialBucket.h"
+
+#include "SG_Node.h"
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+#include "BLI_compiler_attrs.h"
+#include "BLI_utildefines.h"
+#include "BLI_math.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
+#include "BKE_cdderivedmesh.h"
+#include "BKE_DerivedMesh.h"
+#include "BKE_global.h"
+#include "BKE_image.h"
+#include "BKE_library.h"
+#include "IMB_imbuf.h"
+#include "IMB_imbuf_types.h"
+#include "DNA_meshdata_types.h"
+#include "DNA_terrain_types.h"
+#include "DNA_texture_types.h"
+#include "PIL_time.h"
+}
+
+#include <algorithm>
+#include <string.h>
+#include <stdio.h>
+
+/* 128 chunks of 16 m, 2048 m in width. */
+#define TERRAIN_WIDTH 128
+#define TERRAIN_MAX_LEVEL 7
+#define TERRAIN_CHUNK_SIZE 16.0f
+#define TERRAIN_SUBDIVISION 16
+#define TERRAIN_CACHE_MEMORY 64
+
+/* The camera flies over the terrain during PATH_FRAMES frames, then stays
+ * in place until all the chunks are built. */
+#define PATH_FRAMES 600
+/* The frames last at least as long as at 60 frames per second, the worker
+ * threads build the vertexes while the main thread would render. */
+#define FRAME_TIME (1.0 / 60.0)
+#define PATH_HEIGHT 30.0f
+#define MAX_DRAIN_FRAMES 10000
+
+#define IMAGE_SIZE 512
+/* 71 * 71 quads split in two triangles, a bit more than 10k faces. */
+#define MESH_RESOLUTION 71
+#define MESH_SIZE 1200.0f
+
+enum ZoneSetup {
+	ZONE_NOISE,
+	ZONE_IMAGE,
+	ZONE_MESH
+};
+
+static void zone_init_noise(TerrainZone *zone)
+{
+	memset(zone, 0, sizeof(TerrainZone));
+	zone->flag = TERRAIN_ZONE_ACTIVE | TERRAIN_ZONE_PERLIN_NOISE;
+	zone->noisebasis = TEX_STDPERLIN;
+	zone->musgravetype = TEX_FBM;
+	zone->noiseheight = 80.0f;
+	zone->resolution = 300.0f;
+	zone->octaves = 6;
+	zone->lacunarity = 2.0f;
+	zone->gain = 1.0f;
+	zone->musgraveoffset = 1.0f;
+	zone->H = 1.0f;
+}
+
+/* A float image of rounded hills, the pixels are read by bicubic interpolation. */
+static Image *zone_image_create()
+{
+	ImBuf *ibuf = IMB_allocImBuf(IMAGE_SIZE, IMAGE_SIZE, 32, IB_rectfloat);
+	for (unsigned int x = 0; x < IMAGE_SIZE; ++x) {
+		for (unsigned int y = 0; y < IMAGE_SIZE; ++y) {
+			const float u = (float)x / IMAGE_SIZE * (float)M_PI * 8.0f;
+			const float v = (float)y / IMAGE_SIZE * (float)M_PI * 6.0f;
+			const float value = 0.5f + 0.25f * sinf(u) * cosf(v) + 0.25f * sinf(u * 0.3f + v * 0.7f);
+			float *pixel = &ibuf->rect_float[(y * IMAGE_SIZE + x) * 4];
+			pixel[0] = pixel[1] = pixel[2] = value;
+			pixel[3] = 1.0f;
+		}
+	}
+
+	Image *image = BKE_image_add_from_imbuf(ibuf, "terrain_height");
+	// The image owns the buffer.
+	IMB_freeImBuf(ibuf);
+	return image;
+}
+
+/* A jittered grid centered on the terrain, the zone is faded towards the
+ * border of the mesh with the vertex colors. */
+static DerivedMesh *zone_mesh_create()
+{
+	const unsigned int vertcount = (MESH_RESOLUTION + 1) * (MESH_RESOLUTION + 1);
+	const unsigned int facecount = MESH_RESOLUTION * MESH_RESOLUTION * 2;
+	const float step = MESH_SIZE / MESH_RESOLUTION;
+
+	DerivedMesh *dm = CDDM_new(vertcount, 0, facecount, 0, 0);
+	DM_add_tessface_layer(dm, CD_MCOL, CD_CALLOC, NULL);
+	MVert *mvert = dm->getVertArray(dm);
+	MFace *mface = dm->getTessFaceArray(dm);
+	MCol *mcol = (MCol *)dm->getTessFaceDataArray(dm, CD_MCOL);
+
+	for (unsigned int x = 0; x <= MESH_RESOLUTION; ++x) {
+		for (unsigned int y = 0; y <= MESH_RESOLUTION; ++y) {
+			MVert *vert = &mvert[x * (MESH_RESOLUTION + 1) + y];
+			vert->co[0] = x * step - MESH_SIZE / 2.0f;
+			vert->co[1] = y * step - MESH_SIZE / 2.0f;
+			vert->co[2] = 0.0f;
+			if (x != 0 && y != 0 && x != MESH_RESOLUTION && y != MESH_RESOLUTION) {
+				vert->co[0] += sinf(x * 12.9898f + y * 78.233f) * step * 0.25f;
+				vert->co[1] += cosf(x * 39.3468f + y * 11.135f) * step * 0.25f;
+			}
+		}
+	}
+
+	MFace *face = mface;
+	MCol *col = mcol;
+	for (unsigned int x = 0; x < MESH_RESOLUTION; ++x) {
+		for (unsigned int y = 0; y < MESH_RESOLUTION; ++y) {
+			const unsigned int v = x * (MESH_RESOLUTION + 1) + y;
+			const unsigned int quad[2][3] = {{v, v + MESH_RESOLUTION + 1, v + MESH_RESOLUTION + 2},
+			                                 {v, v + MESH_RESOLUTION + 2, v + 1}};
+			for (unsigned short i = 0; i < 2; ++i, ++face, col += 4) {
+				face->v1 = quad[i][0];
+				face->v2 = quad[i][1];
+				face->v3 = quad[i][2];
+				face->v4 = 0;
+				for (unsigned short j = 0; j < 3; ++j) {
+					const float *co = mvert[quad[i][j]].co;
+					const float border = 1.0f - max_ff(fabsf(co[0]), fabsf(co[1])) / (MESH_SIZE / 2.0f);
+					col[j].r = col[j].g = col[j].b = (unsigned char)(min_ff(border * 4.0f, 1.0f) * 255.0f);
+					col[j].a = 255;
+				}
+			}
+		}
+	}
+
+	return dm;
+}
+
+/* A perspective projection of 60 degrees as RAS_OpenGLRasterizer::GetFrustumMatrix. */
+static MT_Matrix4x4 camera_projection()
+{
+	const float frustnear = 0.1f;
+	const float frustfar = 2000.0f;
+	const float top = frustnear * tanf(DEG2RADF(30.0f));
+	const float right = top * 16.0f / 9.0f;
+
+	return MT_Matrix4x4(frustnear / right, 0.0f, 0.0f, 0.0f,
+	                    0.0f, frustnear / top, 0.0f, 0.0f,
+	                    0.0f, 0.0f, -(frustfar + frustnear) / (frustfar - frustnear),
+	                    -2.0f * frustfar * frustnear / (frustfar - frustnear),
+	                    0.0f, 0.0f, -1.0f, 0.0f);
+}
+
+/* A loop around the terrain center, the camera looks ahead and slightly down. */
+static void camera_move(KX_Camera *camera, unsigned int frame)
+{
+	const float t = (float)frame / PATH_FRAMES * 2.0f * (float)M_PI;
+	const float radius = 600.0f + 200.0f * sinf(t * 3.0f);
+	const MT_Point3 position(radius * cosf(t), radius * sinf(t), PATH_HEIGHT);
+
+	/* The camera looks along its -Z axis, a rotation of 80 degrees around X
+	 * makes it look along Y, the yaw follows the path. */
+	const float yaw = t;
+	const float pitch = DEG2RADF(80.0f);
+	const MT_Matrix3x3 rotx(1.0f, 0.0f, 0.0f,
+	                        0.0f, cosf(pitch), -sinf(pitch),
+	                        0.0f, sinf(pitch), cosf(pitch));
+	const MT_Matrix3x3 rotz(cosf(yaw), -sinf(yaw), 0.0f,
+	                        sinf(yaw), cosf(yaw), 0.0f,
+	                        0.0f, 0.0f, 1.0f);
+
+	camera->NodeSetLocalPosition(position);
+	camera->NodeSetLocalOrientation(rotz * rotx);
+	camera->NodeUpdateGS(0.0);
+	// As KX_KetsjiEngine::RenderFrame without stereo.
+	camera->SetModelviewMatrix(MT_Matrix4x4(camera->GetWorldToCamera()));
+}
+
+struct TerrainStats
+{
+	unsigned int frames;
+	double totalTime;
+	double visibleTime;
+	double meshesTime;
+	size_t peakMemory;
+};
+
+static void terrain_run(KX_Terrain *terrain, KX_Camera *camera, CListValue *objects, TerrainStats& stats)
+{
+	memset(&stats, 0, sizeof(stats));
+
+	const double start = PIL_check_seconds_timer();
+	for (unsigned int frame = 0; frame < PATH_FRAMES + MAX_DRAIN_FRAMES; ++frame) {
+		const double framestart = PIL_check_seconds_timer();
+		if (frame < PATH_FRAMES) {
+			camera_move(camera, frame);
+		}
+		// All the vertexes are built before this frame, it builds the last meshes.
+		const bool lastframe = (frame >= PATH_FRAMES && terrain->GetBuildingChunkCount() == 0);
+
+		const double visiblestart = PIL_check_seconds_timer();
+		terrain->CalculateVisibleChunks(camera, objects);
+		const double meshesstart = PIL_check_seconds_timer();
+		terrain->UpdateChunksMeshes();
+		const double meshesend = PIL_check_seconds_timer();
+
+		stats.visibleTime += meshesstart - visiblestart;
+		stats.meshesTime += meshesend - meshesstart;
+		stats.peakMemory = std::max(stats.peakMemory, terrain->GetTotalMemoryUsage());
+		++stats.frames;
+
+		if (lastframe && terrain->GetBuildingChunkCount() == 0) {
+			break;
+		}
+
+		const double frameleft = FRAME_TIME - (PIL_check_seconds_timer() - framestart);
+		if (frameleft > 0.0) {
+			PIL_sleep_ms((int)(frameleft * 1000.0));
+		}
+	}
+	stats.totalTime = PIL_check_seconds_timer() - start;
+}
+
+static void terrain_benchmark(ZoneSetup setup)
+{
+	// As the creator main, the task pools use the threaded allocator lock.
+	BLI_threadapi_init();
+	/* The main thread counts as one thread of the scheduler, at least one
+	 * worker thread builds the vertexes. */
+	TaskScheduler *scheduler = BLI_task_scheduler_create(max_ii(BLI_system_thread_count(), 2));
+
+	RAS_IPolyMaterial *material = new RAS_IPolyMaterial();
+	RAS_MaterialBucket *bucket = new RAS_MaterialBucket(material);
+
+	// The physics is disabled with a minimum physics level above the maximum level.
+	KX_Terrain *terrain = new KX_Terrain(NULL, SG_Callbacks(), bucket, NULL, TERRAIN_MAX_LEVEL, TERRAIN_MAX_LEVEL + 1,
+	                                     false, false, TERRAIN_SUBDIVISION, TERRAIN_WIDTH, 800.0f, 100.0f,
+	                                     TERRAIN_CHUNK_SIZE, 1.0f, 0.0f, 0.0f, 0.0f, false, 0, 0, true,
+	                                     TERRAIN_CACHE_MEMORY, 0, false, "");
+	terrain->SetTaskScheduler(scheduler);
+
+	TerrainZone zone;
+	zone_init_noise(&zone);
+	DerivedMesh *dm = NULL;
+	const char *name = "noise";
+	if (setup == ZONE_IMAGE) {
+		name = "image";
+		zone.flag = TERRAIN_ZONE_ACTIVE | TERRAIN_ZONE_IMAGE;
+		zone.image = zone_image_create();
+		zone.imageheight = 120.0f;
+	}
+	else if (setup == ZONE_MESH) {
+		name = "mesh";
+		zone.flag |= TERRAIN_ZONE_MESH;
+		dm = zone_mesh_create();
+	}
+	terrain->AddTerrainZoneMesh(new KX_TerrainZoneMesh(terrain, &zone, dm));
+
+	RAS_CameraData camdata;
+	KX_Camera *camera = new KX_Camera(NULL, SG_Callbacks(), camdata, true, true);
+	camera->SetProjectionMatrix(camera_projection());
+	CListValue *objects = new CListValue();
+	objects->Add(camera->AddRef());
+
+	KX_Chunk::ResetTime();
+	TerrainStats stats;
+	terrain_run(terrain, camera, objects, stats);
+
+	const unsigned int cacheRequests = KX_ChunkCache::cacheHits + KX_ChunkCache::cacheMisses;
+	printf("Zone %s: %u frames, %u meshes built in %.3f s, %.1f chunks/s\n", name, stats.frames,
+	       KX_Chunk::meshBuilds, stats.totalTime, KX_Chunk::meshBuilds / stats.totalTime);
+	printf("  cache hit rate %.1f%%, peak memory %.1f MB\n",
+	       cacheRequests ? (float)KX_ChunkCache::cacheHits / cacheRequests * 100.0f : 0.0f,
+	       stats.peakMemory / (1024.0 * 1024.0));
+	printf("  main thread: visible chunks %.3f ms/frame, meshes %.3f ms/frame\n",
+	       stats.visibleTime / stats.frames * 1000.0, stats.meshesTime / stats.frames * 1000.0);
+	printf("  per stage: chunk creation %.3f s, vertexes %.3f s, normals %.3f s, polygons %.3f s, mesh vertexes %.3f s\n",
+	       KX_Chunk::chunkCreationTime, KX_Chunk::vertexCreatingTime, KX_Chunk::normalComputingTime,
+	       KX_Chunk::polyAddingTime, KX_Chunk::vertexAddingTime);
+
+	EXPECT_GT(KX_Chunk::meshBuilds, 0);
+	EXPECT_GT(KX_ChunkCache::cacheHits, 0);
+	EXPECT_EQ(0, terrain->GetBuildingChunkCount());
+
+	objects->Release();
+	// The scene graph nodes are freed by the scene in the game engine.
+	SG_Node *node = terrain->GetSGNode();
+	terrain->Release();
+	delete node;
+	camera->Release();
+
+	delete bucket;
+	delete material;
+	BLI_task_scheduler_free(scheduler);
+	BLI_threadapi_exit();
+}
+
+TEST(terrain, Noise)
+{
+	terrain_benchmark(ZONE_NOISE);
+}
+
+TEST(terrain, Image)
+{
+	// As the creator main, the image buffers and their cache use their own locks.
+	IMB_init();
+	BKE_images_init();
+	G.main = BKE_main_new();
+	terrain_benchmark(ZONE_IMAGE);
+	BKE_main_free(G.main);
+	G.main = NULL;
+	BKE_images_exit();
+	IMB_exit();
+}
+
+TEST(terrain, Mesh)
+{
+	terrain_benchmark(ZONE_MESH);
+}
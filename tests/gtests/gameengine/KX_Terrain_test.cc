@@ -0,0 +1,273 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "KX_Terrain.h"
+#include "KX_TerrainDeformation.h"
+#include "KX_Chunk.h"
+#include "KX_ChunkNode.h"
+#include "KX_ChunkNodeMap.h"
+#include "KX_Camera.h"
+#include "KX_PythonInit.h"
+
+#include "EXP_ListValue.h"
+
+#include "RAS_CameraData.h"
+#include "RAS_IPolygonMaterial.h"
+#include "RAS_MaterialBucket.h"
+
+#include "SG_Node.h"
+
+extern "C" {
+#include "BLI_compiler_attrs.h"
+#include "BLI_utildefines.h"
+#include "BLI_math.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
+#include "PIL_time.h"
+}
+
+/* 16 relative positions in width, the chunks of the maximum level are
+ * two relative positions and 32 m wide. */
+#define TERRAIN_WIDTH 16
+#define TERRAIN_MAX_LEVEL 4
+#define TERRAIN_CHUNK_SIZE 16.0f
+#define TERRAIN_SUBDIVISION 16
+#define TERRAIN_CACHE_MEMORY 16
+/* The whole terrain is in the field of the camera, at less than the
+ * distance of the maximum level. */
+#define CAMERA_HEIGHT 300.0f
+#define CAMERA_MAX_DISTANCE 2000.0f
+#define MAX_FRAMES 2000
+
+/* A flat terrain without zones, its chunks are built by a task scheduler
+ * of its own, the camera looks down at the center. */
+class TestTerrain
+{
+public:
+	TaskScheduler *scheduler;
+	RAS_IPolyMaterial *material;
+	RAS_MaterialBucket *bucket;
+	KX_Terrain *terrain;
+	KX_Camera *camera;
+	CListValue *objects;
+
+	TestTerrain()
+	{
+		// As the creator main, the task pools use the threaded allocator lock.
+		BLI_threadapi_init();
+		// At least one worker thread builds the vertexes.
+		scheduler = BLI_task_scheduler_create(max_ii(BLI_system_thread_count(), 2));
+
+		material = new RAS_IPolyMaterial();
+		bucket = new RAS_MaterialBucket(material);
+
+		// The physics is disabled with a minimum physics level above the maximum level.
+		terrain = new KX_Terrain(NULL, SG_Callbacks(), bucket, NULL, TERRAIN_MAX_LEVEL, TERRAIN_MAX_LEVEL + 1,
+		                         false, false, TERRAIN_SUBDIVISION, TERRAIN_WIDTH, CAMERA_MAX_DISTANCE, 100.0f,
+		                         TERRAIN_CHUNK_SIZE, 1.0f, 0.0f, 0.0f, 0.0f, false, 0, 0, true,
+		                         TERRAIN_CACHE_MEMORY, 0, false, "");
+		terrain->SetTaskScheduler(scheduler);
+
+		RAS_CameraData camdata;
+		camera = new KX_Camera(NULL, SG_Callbacks(), camdata, true, true);
+		camera->SetProjectionMatrix(camera_projection());
+		MoveCamera(0.0f, 0.0f);
+
+		objects = new CListValue();
+		objects->Add(camera->AddRef());
+
+		KX_Chunk::ResetTime();
+	}
+
+	~TestTerrain()
+	{
+		objects->Release();
+		// The scene graph nodes are freed by the scene in the game engine.
+		SG_Node *node = terrain->GetSGNode();
+		terrain->Release();
+		delete node;
+		camera->Release();
+
+		delete bucket;
+		delete material;
+		BLI_task_scheduler_free(scheduler);
+		BLI_threadapi_exit();
+	}
+
+	/* A perspective projection of 60 degrees as RAS_OpenGLRasterizer::GetFrustumMatrix. */
+	static MT_Matrix4x4 camera_projection()
+	{
+		const float frustnear = 0.1f;
+		const float frustfar = 4000.0f;
+		const float top = frustnear * tanf(DEG2RADF(30.0f));
+
+		return MT_Matrix4x4(frustnear / top, 0.0f, 0.0f, 0.0f,
+		                    0.0f, frustnear / top, 0.0f, 0.0f,
+		                    0.0f, 0.0f, -(frustfar + frustnear) / (frustfar - frustnear),
+		                    -2.0f * frustfar * frustnear / (frustfar - frustnear),
+		                    0.0f, 0.0f, -1.0f, 0.0f);
+	}
+
+	/* The camera looks down along its -Z axis. */
+	void MoveCamera(float x, float y)
+	{
+		camera->NodeSetLocalPosition(MT_Point3(x, y, CAMERA_HEIGHT));
+		camera->NodeUpdateGS(0.0);
+		// As KX_KetsjiEngine::RenderFrame without stereo.
+		camera->SetModelviewMatrix(MT_Matrix4x4(camera->GetWorldToCamera()));
+	}
+
+	/* Runs frames until two frames in a row build no vertexes nor meshes,
+	 * false if the terrain never settles. */
+	bool Settle()
+	{
+		unsigned int quietFrames = 0;
+		for (unsigned int frame = 0; frame < MAX_FRAMES; ++frame) {
+			const unsigned int meshBuilds = KX_Chunk::meshBuilds;
+			terrain->CalculateVisibleChunks(camera, objects);
+			const bool building = (terrain->GetBuildingChunkCount() > 0);
+			terrain->UpdateChunksMeshes();
+
+			if (building || terrain->GetBuildingChunkCount() > 0 || KX_Chunk::meshBuilds != meshBuilds) {
+				quietFrames = 0;
+				// Let the worker threads build the vertexes.
+				PIL_sleep_ms(1);
+			}
+			else if (++quietFrames == 2) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	/* The real half width of a node. */
+	static float HalfSize(KX_ChunkNode *node)
+	{
+		return TERRAIN_CHUNK_SIZE * node->GetRelativeSize() / 2.0f;
+	}
+};
+
+/* A deformed chunk keeps its vertexes until a worker thread refreshes them,
+ * its mesh is then rebuilt, the other chunks are left untouched. */
+TEST(terrain, RefreshInvalidatedChunks)
+{
+	TestTerrain test;
+	KX_Terrain *terrain = test.terrain;
+	ASSERT_TRUE(test.Settle());
+
+	KX_ChunkNode *node = terrain->GetNodeRelativePosition(1.0f, 1.0f);
+	KX_ChunkNode *farNode = terrain->GetNodeRelativePosition(-5.0f, -5.0f);
+	ASSERT_TRUE(node != NULL && farNode != NULL);
+	KX_Chunk *chunk = node->GetChunk();
+	ASSERT_TRUE(chunk != NULL);
+	EXPECT_TRUE(chunk->GetMeshReady());
+
+	const float farMaxHeight = farNode->GetMaxBoxHeight();
+	const unsigned int refreshes = KX_Chunk::chunkRefreshes;
+	const unsigned int meshBuilds = KX_Chunk::meshBuilds;
+
+	// A brush inside the chunk, far from its borders.
+	const float strength = 5.0f;
+	const MT_Point2& center = node->GetRealPos();
+	terrain->Deform(KX_TerrainDeformation::BRUSH_RAISE, center.x(), center.y(),
+	                TestTerrain::HalfSize(node) * 0.4f, strength, 0.0f);
+	EXPECT_FALSE(chunk->GetInvalidated());
+
+	// The brush is invalidated by the next frame.
+	terrain->CalculateVisibleChunks(test.camera, test.objects);
+	EXPECT_TRUE(chunk->GetInvalidated());
+
+	// The refresh waits with the pending chunks, the vertexes stay usable until it is sent.
+	terrain->UpdateChunksMeshes();
+	EXPECT_FALSE(chunk->GetInvalidated());
+	EXPECT_TRUE(chunk->GetRefreshQueued());
+	EXPECT_TRUE(chunk->GetVertexesReady());
+	EXPECT_GE(terrain->GetBuildingChunkCount(), 1);
+	EXPECT_EQ(refreshes + 1, KX_Chunk::chunkRefreshes);
+	// Nothing is rebuilt on the main thread.
+	EXPECT_EQ(meshBuilds, KX_Chunk::meshBuilds);
+
+	// The next frame sends the refresh to the worker threads.
+	terrain->CalculateVisibleChunks(test.camera, test.objects);
+	EXPECT_FALSE(chunk->GetRefreshQueued());
+
+	ASSERT_TRUE(test.Settle());
+	EXPECT_TRUE(chunk->GetVertexesReady());
+	EXPECT_TRUE(chunk->GetMeshReady());
+	EXPECT_GT(KX_Chunk::meshBuilds, meshBuilds);
+	// Only the deformed chunk was refreshed.
+	EXPECT_EQ(refreshes + 1, KX_Chunk::chunkRefreshes);
+
+	// The refreshed vertexes reach the brush height, the far chunk is not modified.
+	EXPECT_GE(node->GetMaxBoxHeight(), strength - 1e-4f);
+	EXPECT_EQ(farMaxHeight, farNode->GetMaxBoxHeight());
+	EXPECT_NEAR(strength, terrain->GetHeight(center.x(), center.y()), 1e-4f);
+}
+
+/* The nodes leave the node map when they are merged, the remaining nodes
+ * are still found at their grid position. */
+TEST(terrain, MergeNodes)
+{
+	const unsigned int activeNodes = KX_ChunkNode::m_activeNode;
+	TestTerrain test;
+	KX_Terrain *terrain = test.terrain;
+	const KX_ChunkNodeMap& map = terrain->GetNodeMap();
+	ASSERT_TRUE(test.Settle());
+
+	// All the nodes down to the maximum level, 1 + 4 + 16 + 64.
+	EXPECT_EQ(85, map.GetCount());
+	EXPECT_EQ(activeNodes + map.GetCount(), KX_ChunkNode::m_activeNode);
+
+	KX_ChunkNode *node = terrain->GetNodeRelativePosition(1.0f, 1.0f);
+	ASSERT_TRUE(node != NULL);
+	EXPECT_EQ(TERRAIN_MAX_LEVEL, node->GetLevel());
+	const KX_ChunkNode::Point2D gridPos = node->GetGridPos();
+	EXPECT_EQ(node, map.GetNode(node->GetLevel(), gridPos.x, gridPos.y));
+
+	// Away from the terrain, the nodes are merged up to the root.
+	test.MoveCamera(10000.0f, 10000.0f);
+	ASSERT_TRUE(test.Settle());
+	EXPECT_EQ(1, map.GetCount());
+	EXPECT_EQ(activeNodes + 1, KX_ChunkNode::m_activeNode);
+	EXPECT_EQ(NULL, map.GetNode(TERRAIN_MAX_LEVEL, gridPos.x, gridPos.y));
+	EXPECT_TRUE(map.GetNode(1, 0, 0) != NULL);
+
+	// Back to the center, the nodes are created and indexed again.
+	test.MoveCamera(0.0f, 0.0f);
+	ASSERT_TRUE(test.Settle());
+	EXPECT_EQ(85, map.GetCount());
+	node = terrain->GetNodeRelativePosition(1.0f, 1.0f);
+	ASSERT_TRUE(node != NULL);
+	EXPECT_EQ(node, map.GetNode(node->GetLevel(), gridPos.x, gridPos.y));
+}
+
+/* The terrain is built without any active engine nor scene, its chunks use
+ * the given task scheduler, the camera and objects are given by the caller. */
+TEST(terrain, WithoutEngine)
+{
+	ASSERT_EQ(NULL, KX_GetActiveEngine());
+	ASSERT_EQ(NULL, KX_GetActiveScene());
+
+	TestTerrain test;
+	KX_Terrain *terrain = test.terrain;
+	EXPECT_EQ(test.scheduler, terrain->GetTaskScheduler());
+	// The counters are reset by the test terrain.
+	const unsigned int meshBuilds = KX_Chunk::meshBuilds;
+
+	ASSERT_TRUE(test.Settle());
+	EXPECT_GT(KX_Chunk::meshBuilds, meshBuilds);
+	EXPECT_EQ(0, terrain->GetBuildingChunkCount());
+
+	KX_ChunkNode *node = terrain->GetNodeRelativePosition(1.0f, 1.0f);
+	ASSERT_TRUE(node != NULL);
+	EXPECT_EQ(TERRAIN_MAX_LEVEL, node->GetLevel());
+	ASSERT_TRUE(node->GetChunk() != NULL);
+	EXPECT_TRUE(node->GetChunk()->GetVertexesReady());
+	EXPECT_TRUE(node->GetChunk()->GetMeshReady());
+
+	// The time of the measurements does not come from the engine.
+	const double time = KX_Terrain::GetTime();
+	PIL_sleep_ms(2);
+	EXPECT_GT(KX_Terrain::GetTime(), time);
+}